@@ -1,5 +1,13 @@
 #include "Application.h"
 
+namespace
+{
+    //The application's own texture, on everything without a material texture of its own, and the floor's
+    const char* const CrateTexture = "Crate_COLOR.dds";
+    const char* const FloorTexture = "asphalt.dds";
+    const char* const BundledTextures[] = { "Crate_NRM.dds", "Crate_SPEC.dds", "ChainLink.dds", "asphalt_DISP.dds", "asphalt_NORMAL.dds", "asphalt_SPEC.dds" };
+}
+
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
     PAINTSTRUCT ps;
@@ -36,6 +44,9 @@ Application::Application()
 	_pVertexShader = nullptr;
 	_pPixelShader = nullptr;
 	_pVertexLayout = nullptr;
+	_pQuantizedVertexShader = nullptr;
+	_pQuantizedVertexLayout = nullptr;
+	_pMeshDecodeBuffer = nullptr;
 	_pVertexBuffer = nullptr;
 	_pIndexBuffer = nullptr;
     _pVertexBufferPyramid = nullptr;
@@ -44,13 +55,20 @@ Application::Application()
     _pIndexBufferFloor = nullptr;
 	_pConstantBuffer = nullptr;
     _pTextureRV = nullptr;
+    _floorTexture = TextureRegistry::Invalid;
+    _textureBinds = 0;
+    _lastTextureBinds = 0;
     _pSamplerLinear = nullptr;
+    _backfaceCulling = false;
     _camera = nullptr;
     _cameraStatic = nullptr;
     _cameraTopDown = nullptr;
     _cameraFirstPerson = nullptr;
     _cameraThirdPerson = nullptr;
+    scene = {};
     _transparency = nullptr;
+    starObjMeshData = MeshData();
+    carObjMeshData = MeshData();
 }
 
 Application::~Application()
@@ -60,6 +78,27 @@ Application::~Application()
 
 HRESULT Application::Initialise(HINSTANCE hInstance, int nCmdShow)
 {
+    //Meshes and textures are read and imported on the thread pool while the window, device and shaders are being set up,
+    //only creating their buffers and textures is left for after InitDevice. See AssetLoader.h
+    AssetLoader assets;
+
+    //Everything is mapped from one file when the assets have been packed, see Tools/AssetPacker.cpp
+    if (_assetPack.Open("Assets.pack"))
+    {
+        assets.SetPack(&_assetPack);
+        _meshStreamer.SetPack(&_assetPack);
+        _textureStreamer.SetPack(&_assetPack);
+    }
+
+    //Both meshes ask for the 16 byte quantized vertex format (see VertexQuantizer.h), which is only built from an OBJ file.
+    //The legacy .objBinary caches checked in without their OBJs load with full float vertices, DrawMesh takes either
+    assets.AddMesh("star.obj", &starObjMeshData, true, true, true, true);
+    //The car is drawn at its coarsest level of detail as soon as that's read and refined as the rest arrives, see MeshStreamer.h
+    _meshStreamer.Stream("car.obj", &carObjMeshData, true, true, true, true);
+    //The crate texture starts at its mip tail and sharpens as the bigger levels are read, see TextureStreamer.h
+    _textureStreamer.Stream(CrateTexture, &_pTextureRV);
+    assets.Start();
+
     if (FAILED(InitWindow(hInstance, nCmdShow)))
 	{
         return E_FAIL;
@@ -128,9 +167,32 @@ HRESULT Application::Initialise(HINSTANCE hInstance, int nCmdShow)
     // Specular Power
     specularPower = 1.0f;
 
-    // Texture loading
-    CreateDDSTextureFromFile(_pd3dDevice, L"Crate_COLOR.dds", nullptr, &_pTextureRV);
-    _pImmediateContext->PSSetShaderResources(0, 1, &_pTextureRV);
+    //Textures in the arrays are drawn from them rather than from the streamer or the registry
+    LoadTextureArrays();
+
+    //The floor's texture and the meshes' material textures come from the registry, which keeps every texture it holds
+    //under TextureBudgetBytes. The other maps that ship with the game are held in it too, nothing samples them yet so
+    //they're the first to lose mips when it's over. Ones the arrays already hold aren't loaded a second time
+    _textures.SetBudget(TextureBudgetBytes);
+
+    if (!FindArrayTexture(FloorTexture, nullptr))
+        _floorTexture = _textures.Acquire(_pd3dDevice, FloorTexture);
+
+    for (const char* filename : BundledTextures)
+    {
+        if (!FindArrayTexture(filename, nullptr))
+            _bundledTextures.push_back(_textures.Acquire(_pd3dDevice, filename));
+    }
+
+    // Texture and mesh loading
+    _meshStreamer.Start(_pd3dDevice, _textures);
+    _textureStreamer.Start(_pd3dDevice);
+    assets.Finish(_pd3dDevice, _textures);
+
+    //Editing either OBJ while the game is running reloads it in the background, with the same flags as above
+    _meshReloader.Watch("star.obj", &starObjMeshData, true, true, true, true);
+    _meshReloader.Watch("car.obj", &carObjMeshData, true, true, true, true);
+    _meshReloader.Start(_pd3dDevice, _textures);
 
     // Create the sample state
     D3D11_SAMPLER_DESC sampDesc;
@@ -146,9 +208,6 @@ HRESULT Application::Initialise(HINSTANCE hInstance, int nCmdShow)
     _pd3dDevice->CreateSamplerState(&sampDesc, &_pSamplerLinear);
     _pImmediateContext->PSSetSamplers(0, 1, &_pSamplerLinear);
 
-    starObjMeshData = OBJLoader::Load("star.obj", _pd3dDevice);
-    carObjMeshData = OBJLoader::Load("car.obj", _pd3dDevice);
-
     // Speed and acceleration values
     speed = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.005f);
 
@@ -218,6 +277,40 @@ HRESULT Application::InitShadersAndInputLayout()
 	if (FAILED(hr))
         return hr;
 
+    // Compile the vertex shader for QuantizedVertex meshes
+    ID3DBlob* pQuantizedVSBlob = nullptr;
+    hr = CompileShaderFromFile(L"DX11 Framework.fx", "VSQuantized", "vs_4_0", &pQuantizedVSBlob);
+
+    if (FAILED(hr))
+    {
+        MessageBox(nullptr,
+                   L"The FX file cannot be compiled.  Please run this executable from the directory that contains the FX file.", L"Error", MB_OK);
+        return hr;
+    }
+
+    hr = _pd3dDevice->CreateVertexShader(pQuantizedVSBlob->GetBufferPointer(), pQuantizedVSBlob->GetBufferSize(), nullptr, &_pQuantizedVertexShader);
+
+    if (FAILED(hr))
+    {
+        pQuantizedVSBlob->Release();
+        return hr;
+    }
+
+    // Same attributes, 16 bytes instead of 32. The shader decodes them using MeshDecodeBuffer
+    D3D11_INPUT_ELEMENT_DESC quantizedLayout[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    };
+
+    hr = _pd3dDevice->CreateInputLayout(quantizedLayout, ARRAYSIZE(quantizedLayout), pQuantizedVSBlob->GetBufferPointer(),
+                                        pQuantizedVSBlob->GetBufferSize(), &_pQuantizedVertexLayout);
+    pQuantizedVSBlob->Release();
+
+    if (FAILED(hr))
+        return hr;
+
     // Set the input layout
     _pImmediateContext->IASetInputLayout(_pVertexLayout);
 
@@ -555,8 +648,25 @@ HRESULT Application::CompileShaderFromFile(WCHAR* szFileName, LPCSTR szEntryPoin
 #endif
 
     ID3DBlob* pErrorBlob;
-    hr = D3DCompileFromFile(szFileName, nullptr, nullptr, szEntryPoint, szShaderModel, 
-        dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
+
+    //Compiled from the pack's copy if it has one
+    char packedName[MAX_PATH];
+    WideCharToMultiByte(CP_UTF8, 0, szFileName, -1, packedName, sizeof(packedName), nullptr, nullptr);
+    const AssetPackEntry* entry = _assetPack.Find(packedName);
+    const char* source;
+    size_t sourceSize;
+    std::vector<char> sourceBuffer;
+
+    if (entry && _assetPack.Read(*entry, source, sourceSize, sourceBuffer))
+    {
+        hr = D3DCompile(source, sourceSize, packedName, nullptr, nullptr, szEntryPoint, szShaderModel,
+            dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
+    }
+    else
+    {
+        hr = D3DCompileFromFile(szFileName, nullptr, nullptr, szEntryPoint, szShaderModel,
+            dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
+    }
 
     if (FAILED(hr))
     {
@@ -688,6 +798,9 @@ HRESULT Application::InitDevice()
 	bd.CPUAccessFlags = 0;
     hr = _pd3dDevice->CreateBuffer(&bd, nullptr, &_pConstantBuffer);
 
+    bd.ByteWidth = sizeof(MeshDecodeBuffer);
+    hr = _pd3dDevice->CreateBuffer(&bd, nullptr, &_pMeshDecodeBuffer);
+
     // Define the rasterizer state
     D3D11_RASTERIZER_DESC wfdesc;
     ZeroMemory(&wfdesc, sizeof(D3D11_RASTERIZER_DESC));
@@ -695,6 +808,7 @@ HRESULT Application::InitDevice()
     wfdesc.CullMode = D3D11_CULL_NONE; //D3D11_CULL_BACK
     hr = _pd3dDevice->CreateRasterizerState(&wfdesc, &_wireFrame);
     _pImmediateContext->RSSetState(_wireFrame);
+    _backfaceCulling = wfdesc.CullMode == D3D11_CULL_BACK;
 
     // Define the blend state
     D3D11_BLEND_DESC blendDesc;
@@ -725,6 +839,19 @@ HRESULT Application::InitDevice()
 
 void Application::Cleanup()
 {
+    _meshReloader.Stop();
+    _meshStreamer.Stop();
+    _textureStreamer.Stop();
+    _textures.Release(_floorTexture);
+
+    for (size_t texture : _bundledTextures)
+    {
+        _textures.Release(texture);
+    }
+
+    _bundledTextures.clear();
+    _assetPack.Close();
+
     if (_pImmediateContext) _pImmediateContext->ClearState();
     if (_pConstantBuffer) _pConstantBuffer->Release();
     if (_pVertexBuffer) _pVertexBuffer->Release();
@@ -734,6 +861,9 @@ void Application::Cleanup()
     if (_pVertexBufferFloor) _pVertexBufferFloor->Release();
     if (_pIndexBufferFloor) _pIndexBufferFloor->Release();
     if (_pVertexLayout) _pVertexLayout->Release();
+    if (_pQuantizedVertexLayout) _pQuantizedVertexLayout->Release();
+    if (_pQuantizedVertexShader) _pQuantizedVertexShader->Release();
+    if (_pMeshDecodeBuffer) _pMeshDecodeBuffer->Release();
     if (_pVertexShader) _pVertexShader->Release();
     if (_pPixelShader) _pPixelShader->Release();
     if (_pRenderTargetView) _pRenderTargetView->Release();
@@ -744,6 +874,9 @@ void Application::Cleanup()
     if (_depthStencilBuffer) _depthStencilBuffer->Release();
     if (_wireFrame) _wireFrame->Release();
     if (_pTextureRV) _pTextureRV->Release();
+    for (ID3D11ShaderResourceView* textureArray : _textureArrays) textureArray->Release();
+    OBJLoader::Release(starObjMeshData, _textures);
+    OBJLoader::Release(carObjMeshData, _textures);
     if (_pSamplerLinear) _pSamplerLinear->Release();
     if (_camera) _camera->~Camera();
     if (_cameraStatic) _cameraStatic->~Camera();
@@ -755,6 +888,11 @@ void Application::Cleanup()
 
 void Application::Update()
 {
+    _meshReloader.BeginFrame();
+    _meshStreamer.Update(_pImmediateContext);
+    _textureStreamer.Update(_pImmediateContext);
+    _textures.Update(_pd3dDevice);
+
     // Update our time
     static float t = 0.0f;
 
@@ -779,18 +917,24 @@ void Application::Update()
     //
     // Animate the objects
     //
-	XMStoreFloat4x4(&_sun, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixRotationY(t * 0.1f) * XMMatrixRotationX(t * 0.1f) * XMMatrixTranslation(sunPos.x, sunPos.y, sunPos.z)); //sun
-    XMStoreFloat4x4(&_planet1, XMMatrixRotationY(t * 0.3f) * XMMatrixTranslation(planet1Pos.x, planet1Pos.y, planet1Pos.z) * XMMatrixRotationY(t)); //planet1
-    XMStoreFloat4x4(&_planet2, XMMatrixRotationY(t * 0.7f) * XMMatrixTranslation(planet2Pos.x, planet2Pos.y, planet2Pos.z) * XMMatrixRotationY(t * 0.3f)); //planet2
-    XMStoreFloat4x4(&_moon1, XMMatrixRotationZ(t * 5.0f) * XMMatrixScaling(0.2f, 0.2f, 0.2f) * XMMatrixTranslation(2.0f, 0.0f, 0.0f) * XMMatrixRotationY(t) * XMMatrixTranslation(moon1Pos.x, moon1Pos.y, moon1Pos.z) * XMMatrixRotationY(t)); //moon1
-    XMStoreFloat4x4(&_moon2, XMMatrixScaling(0.15f, 0.15f, 0.15f) * XMMatrixTranslation(1.5f, 0.0f, 0.0f) * XMMatrixRotationY(t * 0.8f) * XMMatrixTranslation(moon2Pos.x, moon2Pos.y, moon2Pos.z) * XMMatrixRotationY(t * 0.3f)); //moon2
-    XMStoreFloat4x4(&_floor, XMMatrixTranslation(floorPos.x, floorPos.y, floorPos.z)); //floor
-    XMStoreFloat4x4(&_sphere, XMMatrixTranslation(spherePos.x, spherePos.y, spherePos.z)); //sphere
-    XMStoreFloat4x4(&_car, XMMatrixRotationY(cursorPointXY.x) * XMMatrixScaling(0.05f, 0.05f, 0.05f) * XMMatrixTranslation(carPos.x, carPos.y, carPos.z)); //car
+    SceneTransforms transforms;
+    SceneAnimation::BuildTransforms(t, cursorPointXY.x, scene, transforms);
+    _sun = transforms.Sun;
+    _planet1 = transforms.Planet1;
+    _planet2 = transforms.Planet2;
+    _moon1 = transforms.Moon1;
+    _moon2 = transforms.Moon2;
+    _floor = transforms.Floor;
+    _sphere = transforms.Sphere;
+    _car = transforms.Car;
+
+    //World space bounds for the OBJ meshes, a few dozen flops each
+    starWorldBounds = MeshBounding::TransformBounds(starObjMeshData.Bounds, _sphere.m);
+    carWorldBounds = MeshBounding::TransformBounds(carObjMeshData.Bounds, _car.m);
 
     //Set the person camera views to be locked to the cars position
-    _cameraThirdPerson->setEye(XMFLOAT3(carPos.x, carPos.y + 7.0f, carPos.z));
-    _cameraFirstPerson->setEye(XMFLOAT3(carPos.x, carPos.y + 3.0f, carPos.z));
+    _cameraThirdPerson->setEye(XMFLOAT3(scene.Car.x, scene.Car.y + 7.0f, scene.Car.z));
+    _cameraFirstPerson->setEye(XMFLOAT3(scene.Car.x, scene.Car.y + 3.0f, scene.Car.z));
 
     //
     // User Input
@@ -819,8 +963,8 @@ void Application::Update()
                 _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x + speed.w, _cameraThirdPerson->getEye().y, _cameraThirdPerson->getEye().z));
             }
 
-            carPos.x += speed.w * cos(cursorPointXY.x);
-            carPos.z -= speed.w * sin(cursorPointXY.x);
+            scene.Car.x += speed.w * cos(cursorPointXY.x);
+            scene.Car.z -= speed.w * sin(cursorPointXY.x);
         }
         // Left
         if (GetKeyState('A') & 0x8000)
@@ -834,8 +978,8 @@ void Application::Update()
             {
                 _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x - speed.w, _cameraThirdPerson->getEye().y, _cameraThirdPerson->getEye().z));
             }
-            carPos.x -= speed.w * cos(cursorPointXY.x);
-            carPos.z += speed.w * sin(cursorPointXY.x);
+            scene.Car.x -= speed.w * cos(cursorPointXY.x);
+            scene.Car.z += speed.w * sin(cursorPointXY.x);
         }
         // Up
         if (GetKeyState('Q') & 0x8000)
@@ -849,7 +993,7 @@ void Application::Update()
             {
                 _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x, _cameraThirdPerson->getEye().y + speed.w, _cameraThirdPerson->getEye().z));
             }
-            carPos.y += speed.w;
+            scene.Car.y += speed.w;
         }
         // Down
         if (GetKeyState('E') & 0x8000)
@@ -863,7 +1007,7 @@ void Application::Update()
             {
                 _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x, _cameraThirdPerson->getEye().y - speed.w, _cameraThirdPerson->getEye().z));
             }
-            carPos.y -= speed.w;
+            scene.Car.y -= speed.w;
         }
         // Forward
         if (GetKeyState('W') & 0x8000)
@@ -877,8 +1021,8 @@ void Application::Update()
             {
                 _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x, _cameraThirdPerson->getEye().y, _cameraThirdPerson->getEye().z + speed.w));
             }
-            carPos.z += speed.w * cos(cursorPointXY.x);
-            carPos.x += speed.w * sin(cursorPointXY.x);
+            scene.Car.z += speed.w * cos(cursorPointXY.x);
+            scene.Car.x += speed.w * sin(cursorPointXY.x);
         }
         // Back
         if (GetKeyState('S') & 0x8000)
@@ -892,8 +1036,8 @@ void Application::Update()
             {
                 _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x, _cameraThirdPerson->getEye().y, _cameraThirdPerson->getEye().z - speed.w));
             }
-            carPos.z -= speed.w * cos(cursorPointXY.x);
-            carPos.x -= speed.w * sin(cursorPointXY.x);
+            scene.Car.z -= speed.w * cos(cursorPointXY.x);
+            scene.Car.x -= speed.w * sin(cursorPointXY.x);
         }
 
         //
@@ -987,7 +1131,7 @@ void Application::Update()
             speed.y = 0.0f;
             speed.z = 0.0f;
 
-            carPos = XMFLOAT3(0.0f, 10.0f, 0.0f);
+            scene.Car = { 0.0f, 10.0f, 0.0f };
 
             cursorPointXY.x = 0;
             cursorPointXY.y = 0;
@@ -1002,9 +1146,9 @@ void Application::Update()
         {
             _cameraThirdPerson->setEye(XMFLOAT3(_cameraThirdPerson->getEye().x + speed.x, _cameraThirdPerson->getEye().y + speed.y, _cameraThirdPerson->getEye().z + speed.z));
         }
-        carPos.x += speed.x;
-        carPos.y += speed.y;
-        carPos.z += speed.z;
+        scene.Car.x += speed.x;
+        scene.Car.y += speed.y;
+        scene.Car.z += speed.z;
     }
 
     //
@@ -1020,6 +1164,7 @@ void Application::Update()
         wfdesc.CullMode = D3D11_CULL_NONE; //D3D11_CULL_BACK
         hr = _pd3dDevice->CreateRasterizerState(&wfdesc, &_wireFrame);
         _pImmediateContext->RSSetState(_wireFrame);
+        _backfaceCulling = wfdesc.CullMode == D3D11_CULL_BACK;
     }
     //To Solid
     if (GetKeyState('L') & 0x8000) 
@@ -1031,6 +1176,7 @@ void Application::Update()
         wfdesc.CullMode = D3D11_CULL_NONE; //D3D11_CULL_BACK
         hr = _pd3dDevice->CreateRasterizerState(&wfdesc, &_wireFrame);
         _pImmediateContext->RSSetState(_wireFrame);
+        _backfaceCulling = wfdesc.CullMode == D3D11_CULL_BACK;
     }
 
     // Camera viewpoints
@@ -1098,6 +1244,18 @@ void Application::Draw()
     cb.SpecularPower = specularPower;
     cb.EyePosW = eyePosW;
 
+    //With the arrays every texture is bound here once, each object only picks its array and slice
+    _textureBinds = 0;
+
+    if (!_textureArrays.empty())
+    {
+        _pImmediateContext->PSSetShaderResources(1, (UINT)_textureArrays.size(), &_textureArrays[0]);
+        ++_textureBinds;
+    }
+
+    //Bound every frame, the streamer replaces the view as the crate's bigger mips arrive
+    SetDefaultTexture(cb);
+
 	_pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
 
     //
@@ -1110,6 +1268,7 @@ void Application::Draw()
     _pImmediateContext->IASetIndexBuffer(_pIndexBufferPyramid, DXGI_FORMAT_R16_UINT, 0); 
 
     // Renders a triangle
+    _pImmediateContext->IASetInputLayout(_pVertexLayout);
 	_pImmediateContext->VSSetShader(_pVertexShader, nullptr, 0);
 	_pImmediateContext->VSSetConstantBuffers(0, 1, &_pConstantBuffer);
     _pImmediateContext->PSSetConstantBuffers(0, 1, &_pConstantBuffer);
@@ -1122,13 +1281,17 @@ void Application::Draw()
     _pImmediateContext->DrawIndexed(indexCountPyramid, 0, 0);
 
     //Set buffer to Car
-    _pImmediateContext->IASetVertexBuffers(0, 1, &carObjMeshData.VertexBuffer, &stride, &offset);
-    _pImmediateContext->IASetIndexBuffer(carObjMeshData.IndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+    SetMeshBuffers(carObjMeshData);
 
     world = XMLoadFloat4x4(&_car); //Car
     cb.mWorld = XMMatrixTranspose(world);
     _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
-    _pImmediateContext->DrawIndexed(carObjMeshData.IndexCount, 0, 0);
+
+    DrawMesh(carObjMeshData, carWorldBounds, cb, world, view, projection, true);
+
+    //Back to SimpleVertex for the meshes built in code
+    _pImmediateContext->IASetInputLayout(_pVertexLayout);
+    _pImmediateContext->VSSetShader(_pVertexShader, nullptr, 0);
 
     //
     // Transparent objects
@@ -1165,149 +1328,376 @@ void Application::Draw()
 
     world = XMLoadFloat4x4(&_floor); //Floor
     cb.mWorld = XMMatrixTranspose(world);
+
+    if (!SetArrayTexture(cb, FloorTexture))
+    {
+        ID3D11ShaderResourceView* floorTexture = _textures.Use(_floorTexture);
+        _pImmediateContext->PSSetShaderResources(0, 1, &floorTexture);
+        ++_textureBinds;
+    }
+
     _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
     _pImmediateContext->DrawIndexed(indexCountFloor, 0, 0);
 
+    //Back to the crate, both t0 and the slice and transform left in cb, or the star and the start of the next frame would
+    //sample the asphalt
+    SetDefaultTexture(cb);
+
     //Set buffers to Star
-    _pImmediateContext->IASetVertexBuffers(0, 1, &starObjMeshData.VertexBuffer, &stride, &offset);
-    _pImmediateContext->IASetIndexBuffer(starObjMeshData.IndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+    SetMeshBuffers(starObjMeshData);
 
     world = XMLoadFloat4x4(&_sphere); //Star
     cb.mWorld = XMMatrixTranspose(world);
     _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
-    _pImmediateContext->DrawIndexed(starObjMeshData.IndexCount, 0, 0);
+
+    DrawMesh(starObjMeshData, starWorldBounds, cb, world, view, projection, false);
 
     //
     // Present our back buffer to our front buffer
     //
     _pSwapChain->Present(0, 0);
+    _meshReloader.EndFrame(_pImmediateContext);
+
+    if (_textureBinds != _lastTextureBinds)
+    {
+        char report[64];
+        sprintf_s(report, "Texture binds a frame: %u\n", _textureBinds);
+        OutputDebugStringA(report);
+        _lastTextureBinds = _textureBinds;
+    }
 }
 
-XMFLOAT3 Application::NormalCalc(XMFLOAT3 vec)
+void Application::SetMeshBuffers(MeshData& meshData)
 {
-    float length = sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
-    float x = vec.x / length;
-    float y = vec.y / length;
-    float z = vec.z / length;
+    _pImmediateContext->IASetVertexBuffers(0, 1, &meshData.VertexBuffer, &meshData.VBStride, &meshData.VBOffset);
+    _pImmediateContext->IASetIndexBuffer(meshData.IndexBuffer, meshData.IndexFormat, 0);
 
-    return XMFLOAT3(x,y,z);
+    if (meshData.Quantized)
+    {
+        const VertexQuantization& q = meshData.Quantization;
+
+        //The scales are per 16-bit step, but UNORM inputs reach the shader already divided by 65535
+        const float unormMax = 65535.0f;
+
+        MeshDecodeBuffer decode;
+        decode.PositionScale = XMFLOAT4(q.PositionScale.x * unormMax, q.PositionScale.y * unormMax, q.PositionScale.z * unormMax, 0.0f);
+        decode.PositionOffset = XMFLOAT4(q.PositionOffset.x, q.PositionOffset.y, q.PositionOffset.z, 0.0f);
+        decode.TexCoordScaleOffset = XMFLOAT4(q.TexCoordScale.x * unormMax, q.TexCoordScale.y * unormMax, q.TexCoordOffset.x, q.TexCoordOffset.y);
+
+        _pImmediateContext->UpdateSubresource(_pMeshDecodeBuffer, 0, nullptr, &decode, 0, 0);
+        _pImmediateContext->IASetInputLayout(_pQuantizedVertexLayout);
+        _pImmediateContext->VSSetShader(_pQuantizedVertexShader, nullptr, 0);
+        _pImmediateContext->VSSetConstantBuffers(1, 1, &_pMeshDecodeBuffer);
+    }
+    else
+    {
+        _pImmediateContext->IASetInputLayout(_pVertexLayout);
+        _pImmediateContext->VSSetShader(_pVertexShader, nullptr, 0);
+    }
 }
 
-void Application::XML()
+void Application::DrawMesh(const MeshData& meshData, const MeshBounds& worldBounds, ConstantBuffer& cb, const XMMATRIX& world, const XMMATRIX& view,
+    const XMMATRIX& projection, bool cullClusters)
 {
-    xml_document<> doc;
-    xml_node<>* root_node;
-    std::ifstream theFile("values.xml");
-    std::vector<char> buffer((std::istreambuf_iterator<char>(theFile)), std::istreambuf_iterator<char>());
-    buffer.push_back('\0');
-    doc.parse<0>(&buffer[0]);
-    root_node = doc.first_node("values");
-    // Car position
-    for (xml_node<>* object_node = root_node->first_node("object"); object_node; object_node = object_node->next_sibling())
+    //The clusters only cover the full detail mesh, the simplified levels are drawn whole
+    const MeshLod* lod = SelectLod(meshData, worldBounds);
+
+    if (meshData.Submeshes.empty())
     {
-        // car
-        if (strcmp(object_node->first_attribute("position")->value(), "car_x") == 0)
-        {
-            carPos.x = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "car_y") == 0)
-        {
-            carPos.y = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "car_z") == 0)
-        {
-            carPos.z = atof(object_node->first_attribute("value")->value());
-        }
-        // Sun
-        else if (strcmp(object_node->first_attribute("position")->value(), "sun_x") == 0)
-        {
-            sunPos.x = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "sun_y") == 0)
-        {
-            sunPos.y = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "sun_z") == 0)
-        {
-            sunPos.z = atof(object_node->first_attribute("value")->value());
-        }
-        // Planet1
-        else if (strcmp(object_node->first_attribute("position")->value(), "planet1_x") == 0)
-        {
-            planet1Pos.x = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "planet1_y") == 0)
-        {
-            planet1Pos.y = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "planet1_z") == 0)
-        {
-            planet1Pos.z = atof(object_node->first_attribute("value")->value());
-        }
-        // Planet2
-        else if (strcmp(object_node->first_attribute("position")->value(), "planet2_x") == 0)
-        {
-            planet2Pos.x = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "planet2_y") == 0)
-        {
-            planet2Pos.y = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "planet2_z") == 0)
-        {
-            planet2Pos.z = atof(object_node->first_attribute("value")->value());
-        }
-        // Moon1
-        else if (strcmp(object_node->first_attribute("position")->value(), "moon1_x") == 0)
-        {
-            moon1Pos.x = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "moon1_y") == 0)
-        {
-            moon1Pos.y = atof(object_node->first_attribute("value")->value());
-        }
-        else if (strcmp(object_node->first_attribute("position")->value(), "moon1_z") == 0)
-        {
-            moon1Pos.z = atof(object_node->first_attribute("value")->value());
-        }
-        // Moon2
-        else if (strcmp(object_node->first_attribute("position")->value(), "moon2_x") == 0)
+        if (lod)
+            _pImmediateContext->DrawIndexed(lod->IndexCount, lod->IndexStart, 0);
+        else
+            _pImmediateContext->DrawIndexed(meshData.IndexCount, 0, 0);
+        return;
+    }
+
+    bool cull = cullClusters && !lod && !meshData.Clusters.empty();
+    ClusterCullView cullView;
+
+    if (cull)
+    {
+        //Culling is done in the mesh's model space so the clusters don't need transforming.
+        //Clusters are only backface culled when the rasterizer would drop those triangles anyway. With CULL_NONE open
+        //meshes like the car show their back faces, so only the frustum is tested
+        XMMATRIX worldView = XMMatrixMultiply(world, view);
+        XMFLOAT4X4 modelViewProjection;
+        XMFLOAT4X4 inverseWorldView;
+        XMStoreFloat4x4(&modelViewProjection, XMMatrixMultiply(worldView, projection));
+        XMStoreFloat4x4(&inverseWorldView, XMMatrixInverse(nullptr, worldView));
+
+        MeshClusters::ExtractFrustumPlanes(modelViewProjection.m, cullView.Planes);
+        cullView.CameraPosition = { inverseWorldView._41, inverseWorldView._42, inverseWorldView._43 };
+        cullView.BackfaceCull = _backfaceCulling;
+    }
+
+    //Submeshes are sorted by material with the ones that have none last, so the application's material that's already set
+    //only has to be put back at the end
+    size_t count = OBJLoader::SubmeshesPerLod(meshData);
+    size_t first = (lod ? lod - meshData.Lods.data() : 0) * count;
+    UINT material = MeshNoMaterial;
+
+    for (size_t i = first; i < first + count; ++i)
+    {
+        const MeshSubmesh& submesh = meshData.Submeshes[i];
+
+        if (submesh.Material != material)
         {
-            moon2Pos.x = atof(object_node->first_attribute("value")->value());
+            material = submesh.Material;
+            SetMaterial(meshData, material, cb);
         }
-        else if (strcmp(object_node->first_attribute("position")->value(), "moon2_y") == 0)
+
+        if (cull)
+            DrawVisibleClusters(meshData, cullView, submesh.ClusterStart, submesh.ClusterCount);
+        else
+            _pImmediateContext->DrawIndexed(submesh.IndexCount, submesh.IndexStart, 0);
+    }
+
+    if (material != MeshNoMaterial)
+        SetMaterial(meshData, MeshNoMaterial, cb);
+}
+
+void Application::SetMaterial(const MeshData& meshData, UINT material, ConstantBuffer& cb)
+{
+    ID3D11ShaderResourceView* texture = _pTextureRV;
+    const char* textureName = CrateTexture;
+
+    if (material < meshData.Materials.size())
+    {
+        const MeshMaterial& m = meshData.Materials[material];
+        cb.DiffuseMtrl = XMFLOAT4(m.Diffuse.x, m.Diffuse.y, m.Diffuse.z, m.Opacity);
+        cb.AmbientMtrl = XMFLOAT4(m.Ambient.x, m.Ambient.y, m.Ambient.z, m.Opacity);
+        cb.SpecularMtrl = XMFLOAT4(m.Specular.x, m.Specular.y, m.Specular.z, m.Opacity);
+        cb.SpecularPower = m.SpecularPower > 0.0f ? m.SpecularPower : specularPower;
+
+        if (meshData.MaterialTextures[material] != TextureRegistry::Invalid)
         {
-            moon2Pos.y = atof(object_node->first_attribute("value")->value());
+            texture = _textures.Use(meshData.MaterialTextures[material]);
+            textureName = m.DiffuseMap;
         }
-        else if (strcmp(object_node->first_attribute("position")->value(), "moon2_z") == 0)
+    }
+    else
+    {
+        cb.DiffuseMtrl = diffuseMaterial;
+        cb.AmbientMtrl = ambientMeterial;
+        cb.SpecularMtrl = specularMeterial;
+        cb.SpecularPower = specularPower;
+    }
+
+    if (!SetArrayTexture(cb, textureName))
+    {
+        _pImmediateContext->PSSetShaderResources(0, 1, &texture);
+        ++_textureBinds;
+    }
+
+    _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
+}
+
+bool Application::SetArrayTexture(ConstantBuffer& cb, const char* filename)
+{
+    size_t array;
+    const TextureArrayEntry* entry = FindArrayTexture(filename, &array);
+
+    if (!entry)
+    {
+        cb.TextureSlice = -1.0f;
+        return false;
+    }
+
+    const TextureArrayLayout& layout = _textureArrayLayouts[array];
+    float transform[4];
+    TextureArray::UVTransform(layout, *entry, transform);
+    cb.TextureTransform = XMFLOAT4(transform[0], transform[1], transform[2], transform[3]);
+    cb.TextureTile = XMFLOAT4((float)entry->Width, (float)entry->Height, (float)layout.Gutter, (float)TextureArray::MaxMip(layout, *entry));
+    cb.TextureSlice = (float)entry->Slice;
+    cb.TextureArrayIndex = (float)array;
+    return true;
+}
+
+const TextureArrayEntry* Application::FindArrayTexture(const char* filename, size_t* array)
+{
+    for (size_t i = 0; i < _textureArrayLayouts.size(); ++i)
+    {
+        const TextureArrayEntry* entry = TextureArray::Find(_textureArrayLayouts[i], filename);
+
+        if (entry)
         {
-            moon2Pos.z = atof(object_node->first_attribute("value")->value());
+            if (array) *array = i;
+            return entry;
         }
-        // Floor
-        else if (strcmp(object_node->first_attribute("position")->value(), "floor_x") == 0)
+    }
+
+    return nullptr;
+}
+
+void Application::SetDefaultTexture(ConstantBuffer& cb)
+{
+    if (!SetArrayTexture(cb, CrateTexture))
+    {
+        _pImmediateContext->PSSetShaderResources(0, 1, &_pTextureRV);
+        ++_textureBinds;
+    }
+}
+
+void Application::LoadTextureArrays()
+{
+    std::vector<char> manifest;
+    std::vector<TextureArrayLayout> layouts;
+
+    //The game draws every texture from its own file when there isn't an array
+    if (!ReadText("TextureArray.xml", manifest))
+        return;
+
+    if (!TextureArrayXml::Parse(&manifest[0], layouts))
+    {
+        OutputDebugStringA("TextureArray.xml could not be parsed\n");
+        return;
+    }
+
+    for (const TextureArrayLayout& layout : layouts)
+    {
+        char report[512];
+
+        if (_textureArrays.size() == MaxTextureArrays)
         {
-            floorPos.x = atof(object_node->first_attribute("value")->value());
+            sprintf_s(report, "%s: the shader has no slot left for it, its textures are drawn from their own files\n", layout.File.c_str());
+            OutputDebugStringA(report);
+            continue;
         }
-        else if (strcmp(object_node->first_attribute("position")->value(), "floor_y") == 0)
+
+        const AssetPackEntry* entry = _assetPack.Find(layout.File.c_str());
+        const char* data = nullptr;
+        size_t size = 0;
+        std::vector<char> unpacked;
+        MappedFile file;
+
+        if (!(entry && _assetPack.Read(*entry, data, size, unpacked)) && file.Open(layout.File.c_str()))
         {
-            floorPos.y = atof(object_node->first_attribute("value")->value());
+            data = file.Data();
+            size = file.Size();
         }
-        else if (strcmp(object_node->first_attribute("position")->value(), "floor_z") == 0)
+
+        ID3D11Resource* resource = nullptr;
+        ID3D11ShaderResourceView* view = nullptr;
+        HRESULT hr = data ? CreateDDSTextureFromMemory(_pd3dDevice, (const uint8_t*)data, size, &resource, nullptr) : E_FAIL;
+
+        //The loader gives an array of one slice a plain Texture2D view, and the shader wants an array view either way
+        if (SUCCEEDED(hr))
         {
-            floorPos.z = atof(object_node->first_attribute("value")->value());
+            D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+            desc.Format = layout.Format;
+            desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+            desc.Texture2DArray.MipLevels = layout.MipCount;
+            desc.Texture2DArray.ArraySize = layout.SliceCount;
+            hr = _pd3dDevice->CreateShaderResourceView(resource, &desc, &view);
         }
-        // Sphere
-        else if (strcmp(object_node->first_attribute("position")->value(), "sphere_x") == 0)
+
+        if (resource) resource->Release();
+
+        if (FAILED(hr))
         {
-            spherePos.x = atof(object_node->first_attribute("value")->value());
+            sprintf_s(report, "%s: the texture array could not be created\n", layout.File.c_str());
         }
-        else if (strcmp(object_node->first_attribute("position")->value(), "sphere_y") == 0)
+        else
         {
-            spherePos.y = atof(object_node->first_attribute("value")->value());
+            sprintf_s(report, "%s: %u textures in %u slices of %ux%u, %u mips, bound once a frame\n", layout.File.c_str(), (UINT)layout.Entries.size(),
+                layout.SliceCount, layout.Width, layout.Height, layout.MipCount);
+            _textureArrays.push_back(view);
+            _textureArrayLayouts.push_back(layout);
         }
-        else if (strcmp(object_node->first_attribute("position")->value(), "sphere_z") == 0)
+
+        OutputDebugStringA(report);
+    }
+}
+
+void Application::DrawVisibleClusters(const MeshData& meshData, const ClusterCullView& cullView, size_t firstCluster, size_t clusterCount)
+{
+    UINT start = 0;
+    UINT count = 0;
+
+    for (size_t i = firstCluster; i < firstCluster + clusterCount; ++i)
+    {
+        const MeshCluster& cluster = meshData.Clusters[i];
+
+        if (!MeshClusters::IsClusterVisible(cluster, cullView))
+            continue;
+
+        if (count > 0 && start + count == cluster.IndexStart)
         {
-            spherePos.z = atof(object_node->first_attribute("value")->value());
+            count += cluster.IndexCount;
+            continue;
         }
+
+        if (count > 0)
+            _pImmediateContext->DrawIndexed(count, start, 0);
+
+        start = cluster.IndexStart;
+        count = cluster.IndexCount;
+    }
+
+    if (count > 0)
+        _pImmediateContext->DrawIndexed(count, start, 0);
+}
+
+const MeshLod* Application::SelectLod(const MeshData& meshData, const MeshBounds& worldBounds)
+{
+    if (meshData.Lods.size() < 2)
+        return nullptr;
+
+    //The errors are in model units. TransformBounds scales the radius by the world matrix's biggest scale, so the
+    //ratio of the radii is how much bigger they get
+    float scale = meshData.Bounds.Radius > 0.0f ? worldBounds.Radius / meshData.Bounds.Radius : 1.0f;
+
+    //Measured to the nearest point of the bounding sphere, and kept past the near plane so a camera inside it gets full detail
+    XMFLOAT3 eye = _camera->getEye();
+    XMFLOAT3 center(worldBounds.Center.x, worldBounds.Center.y, worldBounds.Center.z);
+    float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat3(&eye)))) - worldBounds.Radius;
+    distance = distance > 0.01f ? distance : 0.01f;
+
+    size_t lod = MeshSimplifier::SelectLod(meshData.Lods, _camera->getProjectionScale() * scale / distance);
+    return lod > 0 ? &meshData.Lods[lod] : nullptr;
+}
+
+XMFLOAT3 Application::NormalCalc(XMFLOAT3 vec)
+{
+    float length = sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
+    float x = vec.x / length;
+    float y = vec.y / length;
+    float z = vec.z / length;
+
+    return XMFLOAT3(x,y,z);
+}
+
+bool Application::ReadText(const char* filename, std::vector<char>& buffer)
+{
+    const AssetPackEntry* entry = _assetPack.Find(filename);
+    const char* packed;
+    size_t packedSize;
+    std::vector<char> packedBuffer;
+    bool found = true;
+
+    //rapidxml parses in place, so the pack's copy is copied out too
+    if (entry && _assetPack.Read(*entry, packed, packedSize, packedBuffer))
+    {
+        buffer.assign(packed, packed + packedSize);
+    }
+    else
+    {
+        std::ifstream theFile(filename);
+        found = theFile.is_open();
+        buffer.assign(std::istreambuf_iterator<char>(theFile), std::istreambuf_iterator<char>());
+    }
+
+    buffer.push_back('\0');
+    return found;
+}
+
+void Application::XML()
+{
+    std::vector<char> buffer;
+    ReadText("values.xml", buffer);
+
+    if (!SceneConfigXml::Parse(&buffer[0], scene))
+    {
+        OutputDebugStringA("values.xml could not be parsed\n");
     }
 }
\ No newline at end of file
@@ -8,8 +8,16 @@
 #include "resource.h"
 #include "Structures.h"
 #include "OBJLoader.h"
+#include "AssetLoader.h"
+#include "MeshReloader.h"
+#include "MeshStreamer.h"
+#include "TextureArray.h"
+#include "TextureRegistry.h"
+#include "TextureStreamer.h"
 #include "DDSTextureLoader.h"
 #include "Camera.h"
+#include "SceneAnimation.h"
+#include "SceneConfig.h"
 #include "rapidxml.hpp"
 
 using namespace DirectX;
@@ -29,6 +37,9 @@ private:
 	ID3D11VertexShader*     _pVertexShader;
 	ID3D11PixelShader*      _pPixelShader;
 	ID3D11InputLayout*      _pVertexLayout;
+	ID3D11VertexShader*     _pQuantizedVertexShader;	//For meshes loaded with quantized vertices
+	ID3D11InputLayout*      _pQuantizedVertexLayout;
+	ID3D11Buffer*           _pMeshDecodeBuffer;
 	ID3D11Buffer*           _pVertexBuffer;
 	ID3D11Buffer*           _pIndexBuffer;
 	ID3D11Buffer*			_pVertexBufferPyramid;
@@ -53,8 +64,26 @@ private:
 	ID3D11ShaderResourceView* _pTextureRV;
 	ID3D11SamplerState*		_pSamplerLinear;
 
+	AssetPack				_assetPack;		//"Assets.pack" if there is one, assets it doesn't have are loaded from their own files
+
+	//Before the meshes and their loaders, whose material textures it holds, so it's destroyed after them
+	TextureRegistry			_textures;		//Shared, budgeted textures, see TextureRegistry.h
+	size_t					_floorTexture;
+	static const uint64_t	TextureBudgetBytes = 64 * 1024 * 1024;	//GPU memory _textures may use before the least recently used lose mips
+	std::vector<size_t>		_bundledTextures;	//The shipped maps no shader samples yet, held so the budget covers them too
+
 	MeshData				starObjMeshData;
 	MeshData				carObjMeshData;
+	MeshStreamer			_meshStreamer;	//Streams the car in coarsest level of detail first
+	TextureStreamer			_textureStreamer;	//Streams the crate texture in smallest mip first
+	static const size_t		MaxTextureArrays = 4;	//As many as txArrays in DX11 Framework.fx has
+	std::vector<ID3D11ShaderResourceView*> _textureArrays;	//The arrays Tools/TextureArrayCompiler.cpp packed, bound together once a frame
+	std::vector<TextureArrayLayout> _textureArrayLayouts;
+	UINT					_textureBinds;		//PSSetShaderResources calls this frame, reported when it changes
+	UINT					_lastTextureBinds;
+	MeshReloader			_meshReloader;	//Swaps the OBJ meshes for new ones when their files are edited
+	MeshBounds				starWorldBounds;	//The OBJ meshes' bounds moved by their world matrices each Update
+	MeshBounds				carWorldBounds;
 
 	Camera*					_camera;
 	Camera*					_cameraStatic;
@@ -62,14 +91,7 @@ private:
 	Camera*					_cameraFirstPerson;
 	Camera*					_cameraThirdPerson;
 
-	XMFLOAT3				carPos;
-	XMFLOAT3				sunPos;
-	XMFLOAT3				planet1Pos;
-	XMFLOAT3				planet2Pos;
-	XMFLOAT3				moon1Pos;
-	XMFLOAT3				moon2Pos;
-	XMFLOAT3				floorPos;
-	XMFLOAT3				spherePos;
+	SceneConfig				scene;		//Object positions from values.xml, the car's moves with input
 
 	XMFLOAT4				speed;
 
@@ -95,6 +117,39 @@ private:
 
 	XMFLOAT3 NormalCalc(XMFLOAT3 vec);
 
+	//Binds an OBJ mesh's buffers along with the input layout and vertex shader for its vertex format
+	void SetMeshBuffers(MeshData& meshData);
+
+	//Draws each submesh of the level of detail SelectLod picks, only changing the material between submeshes that differ.
+	//cb must hold the mesh's world matrix, its material values are changed and put back. Opaque meshes can cullClusters
+	void DrawMesh(const MeshData& meshData, const MeshBounds& worldBounds, ConstantBuffer& cb, const XMMATRIX& world, const XMMATRIX& view,
+		const XMMATRIX& projection, bool cullClusters);
+
+	//Sets the material's colours and texture, or the application's own ones for MeshNoMaterial
+	void SetMaterial(const MeshData& meshData, UINT material, ConstantBuffer& cb);
+
+	//Draws the clusters in [firstCluster, firstCluster + clusterCount) that the camera can see. Neighbouring visible clusters are drawn together
+	void DrawVisibleClusters(const MeshData& meshData, const ClusterCullView& cullView, size_t firstCluster, size_t clusterCount);
+
+	//Picks the least detailed of a mesh's levels of detail that still looks right from the active camera
+	const MeshLod* SelectLod(const MeshData& meshData, const MeshBounds& worldBounds);
+
+	//Points the shader at the texture's tile in the array and returns true, or returns false if it isn't in the array and
+	//has to be bound itself
+	bool SetArrayTexture(ConstantBuffer& cb, const char* filename);
+
+	//The loaded arrays' entry for filename, and which array it's in if array isn't null. Null if none of them has it
+	const TextureArrayEntry* FindArrayTexture(const char* filename, size_t* array);
+
+	//Draws what follows with the crate texture, the one every object without a texture of its own uses
+	void SetDefaultTexture(ConstantBuffer& cb);
+
+	//Loads TextureArray.xml and the arrays it describes, if there's one
+	void LoadTextureArrays();
+
+	//The contents of an asset from the pack or its own file, followed by a '\0'. Returns false if there's neither
+	bool ReadText(const char* filename, std::vector<char>& buffer);
+
 	void XML();
 
 	UINT _WindowHeight;
@@ -104,6 +159,7 @@ private:
 	ID3D11Texture2D* _depthStencilBuffer;
 
 	ID3D11RasterizerState* _wireFrame;
+	bool _backfaceCulling;		//Whether _wireFrame culls back faces, clusters are only backface culled if it does
 
 public:
 	Application();
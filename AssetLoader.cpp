@@ -0,0 +1,262 @@
+#include "AssetLoader.h"
+#include "DDSTextureLoader.h"
+#include "ThreadPool.h"
+#include <cstdio>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const uint32_t DdsMagic = 0x20534444;		//"DDS "
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+AssetLoader::AssetLoader()
+{
+	_pack = nullptr;
+	_started = false;
+}
+
+AssetLoader::~AssetLoader()
+{
+	//Workers write into the assets, so they have to be done before the assets go
+	if (_started)
+	{
+		for (std::unique_ptr<Asset>& asset : _assets)
+		{
+			asset->Finished.wait();
+		}
+	}
+}
+
+AssetLoader::Asset& AssetLoader::Add(const char* filename)
+{
+	_assets.emplace_back(new Asset());
+	Asset& asset = *_assets.back();
+	asset.Filename = filename;
+	asset.Mesh = nullptr;
+	asset.Texture = nullptr;
+	asset.MeshOptions = 0;
+	asset.TextureData = nullptr;
+	asset.TextureSize = 0;
+	asset.FromPack = false;
+	asset.Loaded = false;
+	asset.LoadMilliseconds = 0.0;
+	asset.CreateMilliseconds = 0.0;
+	asset.WaitMilliseconds = 0.0;
+	asset.Finished = asset.Done.get_future().share();
+	return asset;
+}
+
+void AssetLoader::AddMesh(const char* filename, MeshData* out, bool invertTexCoords, bool optimizeMesh, bool quantizeVertices, bool generateLods)
+{
+	Asset& asset = Add(filename);
+	asset.Mesh = out;
+	asset.MeshOptions = MeshImporter::OptionsFor(invertTexCoords, optimizeMesh, quantizeVertices, generateLods);
+}
+
+void AssetLoader::AddTexture(const char* filename, ID3D11ShaderResourceView** out)
+{
+	Add(filename).Texture = out;
+}
+
+void AssetLoader::SetPack(const AssetPack* pack)
+{
+	_pack = pack;
+}
+
+bool AssetLoader::LoadFromPack(const AssetPack& pack, Asset& asset)
+{
+	const AssetPackEntry* entry = pack.Find(asset.Mesh ? (asset.Filename + "Binary").c_str() : asset.Filename.c_str());
+	const char* data;
+	size_t size;
+
+	if (!entry)
+	{
+		return false;
+	}
+
+	if (asset.Mesh)
+	{
+		return pack.Read(*entry, data, size, asset.Import.PackedData) && MeshImporter::ImportFromMemory(data, size, asset.MeshOptions, asset.Import);
+	}
+
+	if (!pack.Read(*entry, data, size, asset.PackBuffer))
+	{
+		return false;
+	}
+
+	asset.TextureData = data;
+	asset.TextureSize = size;
+	return true;
+}
+
+void AssetLoader::LoadAsset(const AssetPack* pack, Asset& asset)
+{
+	Clock::time_point start = Clock::now();
+
+	asset.FromPack = pack && LoadFromPack(*pack, asset);
+
+	if (asset.Mesh)
+	{
+		asset.Loaded = asset.FromPack || MeshImporter::Import(asset.Filename.c_str(), asset.MeshOptions, asset.Import, ThreadPool::Default());
+	}
+	else
+	{
+		if (!asset.FromPack && asset.TextureFile.Open(asset.Filename.c_str()))
+		{
+			asset.TextureData = asset.TextureFile.Data();
+			asset.TextureSize = asset.TextureFile.Size();
+		}
+
+		if (asset.TextureData && asset.TextureSize >= sizeof(uint32_t))
+		{
+			//Touch every page so the main thread doesn't stall on the disk while it's creating the texture
+			const volatile char* data = asset.TextureData;
+			char touched = 0;
+
+			for (size_t offset = 0; offset < asset.TextureSize; offset += 4096)
+			{
+				touched ^= data[offset];
+			}
+
+			(void)touched;
+			asset.Loaded = *(const uint32_t*)asset.TextureData == DdsMagic;
+		}
+	}
+
+	asset.LoadMilliseconds = MillisecondsSince(start);
+}
+
+HRESULT AssetLoader::CreateAsset(ID3D11Device* device, TextureRegistry& textures, Asset& asset)
+{
+	Clock::time_point start = Clock::now();
+	HRESULT hr = E_FAIL;
+
+	if (asset.Loaded && asset.Mesh)
+	{
+		*asset.Mesh = OBJLoader::CreateMesh(device, asset.Import, &textures);
+		hr = asset.Mesh->VertexBuffer && asset.Mesh->IndexBuffer ? S_OK : E_FAIL;
+	}
+	else if (asset.Loaded && asset.Texture)
+	{
+		hr = CreateDDSTextureFromMemory(device, (const uint8_t*)asset.TextureData, asset.TextureSize, nullptr, asset.Texture);
+	}
+
+	//The GPU has its own copies now
+	asset.Import.Vertices.clear();
+	asset.Import.Vertices.shrink_to_fit();
+	asset.Import.QuantizedVertices.clear();
+	asset.Import.QuantizedVertices.shrink_to_fit();
+	asset.Import.Indices.clear();
+	asset.Import.Indices.shrink_to_fit();
+	asset.Import.ShortIndices.clear();
+	asset.Import.ShortIndices.shrink_to_fit();
+	asset.Import.Cache.Close();
+	asset.Import.PackedData.clear();
+	asset.Import.PackedData.shrink_to_fit();
+	asset.TextureFile.Close();
+	asset.PackBuffer.clear();
+	asset.PackBuffer.shrink_to_fit();
+	asset.TextureData = nullptr;
+	asset.TextureSize = 0;
+
+	asset.CreateMilliseconds = MillisecondsSince(start);
+	return hr;
+}
+
+void AssetLoader::Start(ThreadPool& pool)
+{
+	if (_started)
+	{
+		return;
+	}
+
+	_started = true;
+	_startTime = Clock::now();
+
+	for (std::unique_ptr<Asset>& asset : _assets)
+	{
+		Asset* loading = asset.get();
+		const AssetPack* pack = _pack;
+
+		pool.Submit([loading, pack]()
+		{
+			LoadAsset(pack, *loading);
+			loading->Done.set_value();
+		});
+	}
+}
+
+void AssetLoader::Start()
+{
+	Start(ThreadPool::Default());
+}
+
+HRESULT AssetLoader::Finish(ID3D11Device* device, TextureRegistry& textures)
+{
+	Start();
+
+	HRESULT result = S_OK;
+
+	for (std::unique_ptr<Asset>& asset : _assets)
+	{
+		Clock::time_point waitStart = Clock::now();
+		asset->Finished.wait();
+		asset->WaitMilliseconds = MillisecondsSince(waitStart);
+
+		HRESULT hr = CreateAsset(device, textures, *asset);
+
+		if (FAILED(hr) && SUCCEEDED(result))
+		{
+			result = hr;
+		}
+	}
+
+	Report(MillisecondsSince(_startTime), "in parallel");
+	return result;
+}
+
+HRESULT AssetLoader::LoadSerially(ID3D11Device* device, TextureRegistry& textures)
+{
+	Clock::time_point start = Clock::now();
+	HRESULT result = S_OK;
+
+	for (std::unique_ptr<Asset>& asset : _assets)
+	{
+		LoadAsset(_pack, *asset);
+		HRESULT hr = CreateAsset(device, textures, *asset);
+
+		if (FAILED(hr) && SUCCEEDED(result))
+		{
+			result = hr;
+		}
+	}
+
+	Report(MillisecondsSince(start), "serially");
+	return result;
+}
+
+void AssetLoader::Report(double wallMilliseconds, const char* mode) const
+{
+	char report[512];
+	double serialMilliseconds = 0.0;
+
+	for (const std::unique_ptr<Asset>& asset : _assets)
+	{
+		sprintf_s(report, "%s: %s%s, load %.2f ms, waited %.2f ms, create %.2f ms\n", asset->Filename.c_str(), asset->Loaded ? "loaded" : "FAILED",
+			asset->FromPack ? " from the pack" : "", asset->LoadMilliseconds, asset->WaitMilliseconds, asset->CreateMilliseconds);
+		OutputDebugStringA(report);
+
+		serialMilliseconds += asset->LoadMilliseconds + asset->CreateMilliseconds;
+	}
+
+	//Loading one after another costs every load plus every create
+	sprintf_s(report, "%u assets loaded %s in %.2f ms wall time, %.2f ms of loading and creating (%.2fx)\n", (unsigned int)_assets.size(), mode,
+		wallMilliseconds, serialMilliseconds, wallMilliseconds > 0.0 ? serialMilliseconds / wallMilliseconds : 0.0);
+	OutputDebugStringA(report);
+}
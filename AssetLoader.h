@@ -0,0 +1,93 @@
+#pragma once
+#include <windows.h>
+#include <d3d11_1.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "MeshImporter.h"
+#include "OBJLoader.h"
+
+class ThreadPool;
+
+//Loads a batch of meshes and textures together. Reading, parsing and importing happen on a thread pool as soon as
+//Start is called, which doesn't need the device, so it can be started before the window and device are even created.
+//Finish then creates the buffers and textures on the calling thread, taking each asset as soon as its worker is done
+//and in the order they were added. Every asset's timings are written to the debugger along with the total wall time
+//and what loading them one after another would have cost.
+//
+//	AssetLoader assets;
+//	assets.AddMesh("car.obj", &carMeshData);
+//	assets.AddTexture("Crate_COLOR.dds", &crateTexture);
+//	assets.Start();
+//	...create the device...
+//	assets.Finish(device, textures);
+//
+//With SetPack, assets are looked up in the pack first (meshes by their cache's name, "car.objBinary") and used straight
+//out of its mapping, anything the pack doesn't have is loaded from its own file as before.
+class AssetLoader
+{
+private:
+	struct Asset
+	{
+		std::string Filename;
+		MeshData* Mesh;							//One of these is set
+		ID3D11ShaderResourceView** Texture;
+		uint32_t MeshOptions;
+
+		MeshImport Import;						//Worker results
+		MappedFile TextureFile;
+		const char* TextureData;				//Into TextureFile, the pack's mapping or PackBuffer
+		size_t TextureSize;
+		std::vector<char> PackBuffer;			//A compressed pack entry, decompressed
+		bool FromPack;
+		bool Loaded;
+
+		std::promise<void> Done;
+		std::shared_future<void> Finished;
+		double LoadMilliseconds;				//On the worker
+		double CreateMilliseconds;				//On the main thread
+		double WaitMilliseconds;				//Main thread blocked waiting for the worker
+	};
+
+	std::vector<std::unique_ptr<Asset>> _assets;
+	std::chrono::steady_clock::time_point _startTime;
+	const AssetPack* _pack;
+	bool _started;
+
+	Asset& Add(const char* filename);
+	static void LoadAsset(const AssetPack* pack, Asset& asset);
+	static bool LoadFromPack(const AssetPack& pack, Asset& asset);
+	static HRESULT CreateAsset(ID3D11Device* device, TextureRegistry& textures, Asset& asset);
+	void Report(double wallMilliseconds, const char* mode) const;
+
+public:
+	AssetLoader();
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	//The flags are OBJLoader::Load's. out is written by Finish
+	void AddMesh(const char* filename, MeshData* out, bool invertTexCoords = true, bool optimizeMesh = true, bool quantizeVertices = false, bool generateLods = false);
+
+	//A DDS texture, out is written by Finish
+	void AddTexture(const char* filename, ID3D11ShaderResourceView** out);
+
+	//Looks assets up in pack before their own files. It has to stay open until Finish returns
+	void SetPack(const AssetPack* pack);
+
+	//Queues every asset on the pool
+	void Start(ThreadPool& pool);
+	void Start();
+
+	//Waits for the workers and creates the GPU resources, the meshes' material textures in textures. Returns the first
+	//failure, after creating everything else. Calls Start first if it hasn't been called
+	HRESULT Finish(ID3D11Device* device, TextureRegistry& textures);
+
+	//Loads and creates everything on the calling thread, for comparing against Start/Finish
+	HRESULT LoadSerially(ID3D11Device* device, TextureRegistry& textures);
+};
@@ -0,0 +1,298 @@
+#include "AssetPack.h"
+#include "ContentHash.h"
+#include "Lz4.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//A source once it's been through the compressor
+	struct PackedSource
+	{
+		const AssetPackSource* Source;
+		std::string Name;
+		std::vector<char> Compressed;
+		AssetPackEntry Entry;
+	};
+}
+
+AssetPack::AssetPack()
+{
+	_header = nullptr;
+	_entries = nullptr;
+}
+
+void AssetPack::Close()
+{
+	_file.Close();
+	_header = nullptr;
+	_entries = nullptr;
+}
+
+bool AssetPack::Open(const char* filename)
+{
+	Close();
+
+	if (!_file.Open(filename))
+	{
+		return false;
+	}
+
+	const char* data = _file.Data();
+	uint64_t fileSize = _file.Size();
+
+	if (fileSize < sizeof(AssetPackHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const AssetPackHeader* header = (const AssetPackHeader*)data;
+	uint64_t entriesSize = (uint64_t)header->EntryCount * sizeof(AssetPackEntry);
+
+	bool valid = header->Magic == AssetPackMagic && header->Version == AssetPackVersion && header->FileSize == fileSize;
+	valid = valid && header->TocOffset % AssetPackAlignment == 0 && header->TocOffset >= sizeof(AssetPackHeader) && header->TocOffset <= fileSize;
+	valid = valid && header->TocSize <= fileSize - header->TocOffset && entriesSize <= header->TocSize;
+
+	if (!valid || ContentHash(data + header->TocOffset, (size_t)header->TocSize) != header->TocHash)
+	{
+		Close();
+		return false;
+	}
+
+	const AssetPackEntry* entries = (const AssetPackEntry*)(data + header->TocOffset);
+
+	for (uint32_t i = 0; i < header->EntryCount; ++i)
+	{
+		const AssetPackEntry& entry = entries[i];
+
+		bool named = entry.NameOffset <= fileSize && entry.NameLength <= fileSize - entry.NameOffset;
+		bool inside = entry.Offset % AssetPackAlignment == 0 && entry.Offset <= fileSize && entry.StoredSize <= fileSize - entry.Offset;
+		bool sized = entry.Compression == AssetPackLz4 || (entry.Compression == AssetPackStored && entry.StoredSize == entry.Size);
+		bool sorted = i == 0 || entries[i - 1].NameHash <= entry.NameHash;
+
+		if (!named || !inside || !sized || !sorted)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	_header = header;
+	_entries = entries;
+
+	return true;
+}
+
+std::string AssetPack::EntryName(const AssetPackEntry& entry) const
+{
+	return std::string(_file.Data() + entry.NameOffset, entry.NameLength);
+}
+
+const AssetPackEntry* AssetPack::Find(const char* name) const
+{
+	if (!_header)
+	{
+		return nullptr;
+	}
+
+	std::string normalized = NormalizeName(name);
+	uint64_t hash = ContentHash(normalized.data(), normalized.size());
+
+	const AssetPackEntry* end = _entries + _header->EntryCount;
+	const AssetPackEntry* entry = std::lower_bound(_entries, end, hash, [](const AssetPackEntry& a, uint64_t b) { return a.NameHash < b; });
+
+	//Different names with the same hash are next to each other, so compare names until the hash changes
+	for (; entry != end && entry->NameHash == hash; ++entry)
+	{
+		if (entry->NameLength == normalized.size() && memcmp(_file.Data() + entry->NameOffset, normalized.data(), normalized.size()) == 0)
+		{
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool AssetPack::Read(const AssetPackEntry& entry, const char*& data, size_t& size, std::vector<char>& buffer) const
+{
+	const char* stored = _file.Data() + entry.Offset;
+
+	if (entry.Compression == AssetPackStored)
+	{
+		data = stored;
+		size = (size_t)entry.Size;
+		return true;
+	}
+
+	buffer.resize((size_t)entry.Size);
+
+	if (!Lz4::Decompress(stored, (size_t)entry.StoredSize, buffer.data(), buffer.size()))
+	{
+		return false;
+	}
+
+	data = buffer.data();
+	size = buffer.size();
+
+	return true;
+}
+
+bool AssetPack::Verify(const AssetPackEntry& entry) const
+{
+	const char* data;
+	size_t size;
+	std::vector<char> buffer;
+
+	return Read(entry, data, size, buffer) && ContentHash(data, size) == entry.ContentHash;
+}
+
+std::string AssetPack::NormalizeName(const char* name)
+{
+	std::string normalized = name;
+
+	for (char& c : normalized)
+	{
+		if (c == '\\') c = '/';
+		else if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+	}
+
+	while (normalized.compare(0, 2, "./") == 0)
+	{
+		normalized.erase(0, 2);
+	}
+
+	return normalized;
+}
+
+bool AssetPackBuilder::Write(const char* filename, const std::vector<AssetPackSource>& sources, ThreadPool& pool)
+{
+	std::vector<PackedSource> packed(sources.size());
+
+	pool.ParallelFor(sources.size(), [&](size_t i)
+	{
+		const AssetPackSource& source = sources[i];
+		PackedSource& out = packed[i];
+		out.Source = &source;
+		out.Name = AssetPack::NormalizeName(source.Name.c_str());
+		out.Entry = AssetPackEntry();
+		out.Entry.NameHash = ContentHash(out.Name.data(), out.Name.size());
+		out.Entry.NameLength = (uint32_t)out.Name.size();
+		out.Entry.Compression = AssetPackStored;
+		out.Entry.StoredSize = source.Size;
+		out.Entry.Size = source.Size;
+		out.Entry.ContentHash = ContentHash(source.Data, source.Size);
+
+		if (source.Compress && source.Size > 0)
+		{
+			out.Compressed.resize(Lz4::CompressBound(source.Size));
+			size_t compressedSize = Lz4::Compress(source.Data, source.Size, out.Compressed.data(), out.Compressed.size());
+
+			if (compressedSize > 0 && compressedSize <= source.Size - source.Size / 8)
+			{
+				out.Compressed.resize(compressedSize);
+				out.Entry.Compression = AssetPackLz4;
+				out.Entry.StoredSize = compressedSize;
+			}
+			else
+			{
+				std::vector<char>().swap(out.Compressed);
+			}
+		}
+	});
+
+	std::sort(packed.begin(), packed.end(), [](const PackedSource& a, const PackedSource& b)
+	{
+		return a.Entry.NameHash != b.Entry.NameHash ? a.Entry.NameHash < b.Entry.NameHash : a.Name < b.Name;
+	});
+
+	for (size_t i = 1; i < packed.size(); ++i)
+	{
+		if (packed[i].Name == packed[i - 1].Name)
+		{
+			return false;
+		}
+	}
+
+	//Table of contents, then names, then the data in the same order as the entries
+	AssetPackHeader header = {};
+	header.Magic = AssetPackMagic;
+	header.Version = AssetPackVersion;
+	header.EntryCount = (uint32_t)packed.size();
+	header.TocOffset = AlignUp(sizeof(AssetPackHeader), AssetPackAlignment);
+
+	std::vector<AssetPackEntry> entries(packed.size());
+	std::string names;
+	uint64_t namesOffset = header.TocOffset + sizeof(AssetPackEntry) * entries.size();
+
+	for (size_t i = 0; i < packed.size(); ++i)
+	{
+		packed[i].Entry.NameOffset = namesOffset + names.size();
+		names += packed[i].Name;
+	}
+
+	header.TocSize = sizeof(AssetPackEntry) * entries.size() + names.size();
+	uint64_t offset = AlignUp(header.TocOffset + header.TocSize, AssetPackAlignment);
+
+	for (size_t i = 0; i < packed.size(); ++i)
+	{
+		packed[i].Entry.Offset = offset;
+		entries[i] = packed[i].Entry;
+		offset = AlignUp(offset + packed[i].Entry.StoredSize, AssetPackAlignment);
+	}
+
+	header.FileSize = offset;
+
+	std::vector<char> toc((size_t)header.TocSize);
+
+	if (!entries.empty())
+	{
+		memcpy(toc.data(), entries.data(), sizeof(AssetPackEntry) * entries.size());
+	}
+
+	memcpy(toc.data() + sizeof(AssetPackEntry) * entries.size(), names.data(), names.size());
+	header.TocHash = ContentHash(toc.data(), toc.size());
+
+	//Written to a temporary file first so the game never maps a half written pack
+	std::string temporaryFilename = std::string(filename) + ".tmp";
+	std::ofstream out(temporaryFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+	const char padding[AssetPackAlignment] = {};
+	uint64_t written = 0;
+
+	auto writeAt = [&](uint64_t position, const void* data, size_t size)
+	{
+		out.write(padding, (std::streamsize)(position - written));
+		out.write((const char*)data, (std::streamsize)size);
+		written = position + size;
+	};
+
+	writeAt(0, &header, sizeof(header));
+	writeAt(header.TocOffset, toc.data(), toc.size());
+
+	for (const PackedSource& source : packed)
+	{
+		const void* data = source.Entry.Compression == AssetPackLz4 ? (const void*)source.Compressed.data() : source.Source->Data;
+		writeAt(source.Entry.Offset, data, (size_t)source.Entry.StoredSize);
+	}
+
+	out.write(padding, (std::streamsize)(header.FileSize - written));
+	out.close();
+
+	if (!out.good())
+	{
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFilename, filename, error);
+
+	return !error;
+}
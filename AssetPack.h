@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+class ThreadPool;
+
+//"Assets.pack", every asset the game loads in one file so startup maps one file instead of opening each one. The layout is:
+//	AssetPackHeader
+//	AssetPackEntry[EntryCount], sorted by NameHash
+//	the entries' names, not null terminated
+//	entry data, each entry starting on an AssetPackAlignment boundary
+//Everything is little endian. Entries stored uncompressed are used straight out of the mapped file, and because the
+//alignment is the same as MeshCacheAlignment a mesh cache's sections stay aligned inside the pack.
+
+const uint32_t AssetPackMagic = 0x4B434150;		//"PACK"
+const uint32_t AssetPackVersion = 1;
+const uint32_t AssetPackAlignment = 64;
+
+enum AssetPackCompression : uint32_t
+{
+	AssetPackStored = 0,
+	AssetPackLz4 = 1,		//One LZ4 block, see Lz4.h
+};
+
+struct AssetPackHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t Reserved;
+	uint64_t FileSize;
+	uint64_t TocOffset;			//The entries, followed by the names
+	uint64_t TocSize;
+	uint64_t TocHash;			//ContentHash of the entries and names
+	uint64_t Padding[2];
+};
+
+struct AssetPackEntry
+{
+	uint64_t NameHash;			//ContentHash of the normalized name, see AssetPack::NormalizeName
+	uint64_t NameOffset;		//From the start of the file
+	uint32_t NameLength;
+	uint32_t Compression;		//AssetPackCompression
+	uint64_t Offset;			//From the start of the file
+	uint64_t StoredSize;		//Bytes in the pack
+	uint64_t Size;				//Bytes once decompressed
+	uint64_t ContentHash;		//ContentHash of the decompressed data
+	uint64_t Reserved;
+};
+
+static_assert(sizeof(AssetPackHeader) == 64, "AssetPackHeader is part of the file format");
+static_assert(sizeof(AssetPackEntry) == 64, "AssetPackEntry is part of the file format");
+
+//A mapped pack. Only the table of contents is checked when it's opened, entry data is checked by Verify
+//so opening doesn't have to read the whole file
+class AssetPack
+{
+private:
+	MappedFile _file;
+	const AssetPackHeader* _header;
+	const AssetPackEntry* _entries;
+
+public:
+	AssetPack();
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	//Returns false if the file doesn't exist or isn't a valid pack
+	bool Open(const char* filename);
+	void Close();
+
+	bool IsOpen() const { return _header != nullptr; }
+	uint32_t EntryCount() const { return _header ? _header->EntryCount : 0; }
+	const AssetPackEntry& Entry(uint32_t index) const { return _entries[index]; }
+	std::string EntryName(const AssetPackEntry& entry) const;
+
+	//Looks an asset up by the path it was packed from, e.g. "car.objBinary". Returns null if it isn't in the pack
+	const AssetPackEntry* Find(const char* name) const;
+
+	//Points data at the entry's contents. Stored entries point into the mapped file, compressed ones are
+	//decompressed into buffer, which has to stay around as long as data is used. Returns false if it's corrupt
+	bool Read(const AssetPackEntry& entry, const char*& data, size_t& size, std::vector<char>& buffer) const;
+
+	//Reads the entry and checks it against its ContentHash
+	bool Verify(const AssetPackEntry& entry) const;
+
+	//Names are matched with forward slashes, without a leading "./" and ignoring ASCII case, like the Windows file system
+	static std::string NormalizeName(const char* name);
+};
+
+//One asset to be packed, Data must hold Size bytes until AssetPackBuilder::Write returns
+struct AssetPackSource
+{
+	std::string Name;
+	const void* Data;
+	size_t Size;
+	bool Compress;		//Tried with LZ4 and only kept compressed if that saves at least an eighth
+};
+
+namespace AssetPackBuilder
+{
+	//Compresses the sources across pool and writes the pack. Returns false if two sources have the same name or it couldn't be written
+	bool Write(const char* filename, const std::vector<AssetPackSource>& sources, ThreadPool& pool);
+};
@@ -0,0 +1,162 @@
+//Times the worker side of AssetLoader, loading a batch of assets one after another and then all at once on the thread pool.
+//Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. AssetLoadBench.cpp ../MeshImporter.cpp ../MeshCache.cpp ../MeshCodec.cpp ../MeshStream.cpp ../Lz4.cpp ../ContentHash.cpp ../OBJParser.cpp
+//		../MeshOptimizer.cpp ../MeshClusters.cpp ../MeshSimplifier.cpp ../MeshBounds.cpp ../VertexQuantizer.cpp ../MappedFile.cpp ../ThreadPool.cpp
+//		-pthread -o asset_load_bench
+//
+//Usage (from the repository root): asset_load_bench [file.obj | file.dds ...]
+//Defaults to Application::Initialise's assets plus the other meshes and textures in the repository. Meshes are imported
+//with the options Application uses, from their caches where they're up to date. Each pass starts with a fresh MeshImport so
+//nothing is shared between them, but the files will be in the OS file cache after the first pass, so run it twice to see
+//warm numbers for both.
+
+#include "MappedFile.h"
+#include "MeshImporter.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Asset
+	{
+		std::string Filename;
+		MeshImport Mesh;
+		MappedFile Texture;
+		bool Loaded;
+		double Milliseconds;
+	};
+
+	bool IsTexture(const std::string& filename)
+	{
+		return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".dds") == 0;
+	}
+
+	//The same work as AssetLoader::LoadAsset
+	void Load(Asset& asset, ThreadPool& pool)
+	{
+		Clock::time_point start = Clock::now();
+
+		if (IsTexture(asset.Filename))
+		{
+			asset.Loaded = asset.Texture.Open(asset.Filename.c_str()) && asset.Texture.Size() >= 4;
+
+			if (asset.Loaded)
+			{
+				const volatile char* data = asset.Texture.Data();
+				char touched = 0;
+
+				for (size_t offset = 0; offset < asset.Texture.Size(); offset += 4096)
+				{
+					touched ^= data[offset];
+				}
+
+				(void)touched;
+				asset.Loaded = memcmp(asset.Texture.Data(), "DDS ", 4) == 0;
+			}
+		}
+		else
+		{
+			asset.Loaded = MeshImporter::Import(asset.Filename.c_str(), MeshImporter::OptionsFor(true, true, true, true), asset.Mesh, pool);
+		}
+
+		asset.Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	std::vector<std::unique_ptr<Asset>> MakeAssets(const std::vector<std::string>& filenames)
+	{
+		std::vector<std::unique_ptr<Asset>> assets;
+
+		for (const std::string& filename : filenames)
+		{
+			assets.emplace_back(new Asset());
+			assets.back()->Filename = filename;
+			assets.back()->Loaded = false;
+			assets.back()->Milliseconds = 0.0;
+		}
+
+		return assets;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filenames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		filenames.push_back(argv[i]);
+	}
+
+	if (filenames.empty())
+	{
+		filenames = { "star.obj", "car.obj", "Crate_COLOR.dds", "torusKnot.obj", "sphere.obj", "Crate_NRM.dds", "Crate_SPEC.dds", "ChainLink.dds",
+			"asphalt.dds", "asphalt_NORMAL.dds", "asphalt_SPEC.dds", "asphalt_DISP.dds" };
+	}
+
+	ThreadPool& pool = ThreadPool::Default();
+
+	//One after another, like OBJLoader::Load and CreateDDSTextureFromFile used to be called
+	std::vector<std::unique_ptr<Asset>> serial = MakeAssets(filenames);
+	Clock::time_point start = Clock::now();
+
+	for (std::unique_ptr<Asset>& asset : serial)
+	{
+		Load(*asset, pool);
+	}
+
+	std::chrono::duration<double, std::milli> serialTime = Clock::now() - start;
+
+	//All queued at once, like AssetLoader::Start
+	std::vector<std::unique_ptr<Asset>> parallel = MakeAssets(filenames);
+	std::vector<std::future<void>> done;
+	start = Clock::now();
+
+	for (std::unique_ptr<Asset>& asset : parallel)
+	{
+		std::shared_ptr<std::promise<void>> promise(new std::promise<void>());
+		done.push_back(promise->get_future());
+		Asset* loading = asset.get();
+
+		pool.Submit([loading, promise, &pool]()
+		{
+			Load(*loading, pool);
+			promise->set_value();
+		});
+	}
+
+	for (std::future<void>& future : done)
+	{
+		future.wait();
+	}
+
+	std::chrono::duration<double, std::milli> parallelTime = Clock::now() - start;
+
+	printf("%-22s %10s %12s %12s\n", "asset", "size", "serial ms", "parallel ms");
+
+	for (size_t i = 0; i < filenames.size(); ++i)
+	{
+		const Asset& asset = *parallel[i];
+		size_t size = IsTexture(asset.Filename) ? asset.Texture.Size() : asset.Mesh.VertexCount * asset.Mesh.VertexStride + asset.Mesh.IndexCount * asset.Mesh.IndexSize;
+
+		if (!asset.Loaded || !serial[i]->Loaded)
+		{
+			printf("%-22s could not be loaded\n", asset.Filename.c_str());
+			continue;
+		}
+
+		printf("%-22s %10zu %12.3f %12.3f\n", asset.Filename.c_str(), size, serial[i]->Milliseconds, asset.Milliseconds);
+	}
+
+	printf("%zu assets on %u threads: serial %.3f ms, parallel %.3f ms wall time (%.2fx)\n", filenames.size(), pool.ThreadCount(), serialTime.count(),
+		parallelTime.count(), serialTime.count() / parallelTime.count());
+
+	return 0;
+}
@@ -0,0 +1,253 @@
+//Checks BlockCompression against blocks worked out by hand from the format specifications and measures its quality and
+//speed. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. BlockCompressionBench.cpp ../BlockCompression.cpp -o blockcompression_bench
+//
+//Usage: blockcompression_bench
+//Each known block has to decode to the pixels the specification gives for it, and encoding those pixels, which every
+//format can store exactly, has to decode back to them unchanged. The BC7 block also has to be encoded bit for bit, so a
+//mistake in the mode 6 layout (endpoint order, p-bits, the anchor index) can't hide behind a matching decoder.
+//Then synthetic images are compressed in every format and the PSNR of the channels each one stores has to stay above a
+//floor, with the encode time per megapixel reported alongside.
+//Exits with 1 if any check fails.
+
+#include "BlockCompression.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const char* FormatNames[] = { "BC1", "BC3", "BC5", "BC7" };
+
+	struct KnownBlock
+	{
+		BlockFormat Format;
+		uint8_t Block[16];
+		uint8_t Pixels[64];
+	};
+
+	//Four colour BC1 (c0 > c1) using every index, the same colour block under an eight value alpha block for BC3, two eight
+	//value BC4 blocks for BC5, and a BC7 mode 6 block with distinct p-bits and every index once, the anchor's below 8
+	const KnownBlock KnownBlocks[] =
+	{
+		{ BlockBC1,
+			{ 0x46, 0xE6, 0x3B, 0x19, 0x78, 0xFA, 0x81, 0x27 },
+			{ 231, 203,  49, 255,  162, 147, 106, 255,   93,  91, 164, 255,   24,  36, 222, 255,
+			  162, 147, 106, 255,  162, 147, 106, 255,   93,  91, 164, 255,   93,  91, 164, 255,
+			   24,  36, 222, 255,  231, 203,  49, 255,  231, 203,  49, 255,  162, 147, 106, 255,
+			   93,  91, 164, 255,   24,  36, 222, 255,  162, 147, 106, 255,  231, 203,  49, 255 } },
+		{ BlockBC3,
+			{ 0xF0, 0x10, 0x88, 0xC6, 0xFA, 0x77, 0x39, 0x05, 0x46, 0xE6, 0x3B, 0x19, 0x78, 0xFA, 0x81, 0x27 },
+			{ 231, 203,  49, 240,  162, 147, 106,  16,   93,  91, 164, 208,   24,  36, 222, 176,
+			  162, 147, 106, 144,  162, 147, 106, 112,   93,  91, 164,  80,   93,  91, 164,  48,
+			   24,  36, 222,  48,  231, 203,  49,  80,  231, 203,  49, 112,  162, 147, 106, 144,
+			   93,  91, 164, 176,   24,  36, 222, 208,  162, 147, 106,  16,  231, 203,  49, 240 } },
+		{ BlockBC5,
+			{ 0xC8, 0x28, 0xD0, 0x58, 0x3F, 0x81, 0xC6, 0xFA, 0xFF, 0x00, 0x6D, 0x70, 0x8D, 0x36, 0xA2, 0xB1 },
+			{ 200, 109,   0, 255,  177, 109,   0, 255,  154,   0,   0, 255,  131, 255,   0, 255,
+			  108,  36,   0, 255,   85, 218,   0, 255,   62, 182,   0, 255,   40, 145,   0, 255,
+			   40,  72,   0, 255,  200,  72,   0, 255,  177, 255,   0, 255,  154,   0,   0, 255,
+			  131, 218,   0, 255,  108, 182,   0, 255,   85, 145,   0, 255,   62, 109,   0, 255 } },
+		{ BlockBC7,
+			{ 0x40, 0xC5, 0x9C, 0xA2, 0x25, 0x17, 0xFE, 0x40, 0xF7, 0x80, 0x1C, 0xE7, 0xA5, 0xD2, 0x49, 0x6B },
+			{  63,  69, 162, 229,  231, 181,  11, 129,   20,  40, 200, 254,  132, 115, 100, 188,
+			  188, 152,  49, 154,   33,  49, 188, 246,  119, 106, 111, 195,  218, 172,  23, 137,
+			   89,  86, 138, 213,  162, 135,  73, 170,   50,  60, 173, 236,  201, 161,  38, 147,
+			  145, 124,  88, 180,   76,  77, 150, 221,  175, 144,  61, 162,  106,  97, 123, 203 } },
+	};
+
+	bool CheckKnownBlock(const KnownBlock& known)
+	{
+		const char* name = FormatNames[known.Format];
+		size_t size = BlockCompression::BlockSize(known.Format);
+		uint8_t pixels[64], block[16] = {}, roundTrip[64];
+		bool passed = true;
+
+		if (!BlockCompression::Decode(known.Format, known.Block, pixels) || memcmp(pixels, known.Pixels, sizeof(pixels)) != 0)
+		{
+			printf("%s: the known block didn't decode to its pixels\n", name);
+			passed = false;
+		}
+
+		BlockCompression::Encode(known.Format, known.Pixels, block);
+
+		if (!BlockCompression::Decode(known.Format, block, roundTrip) || memcmp(roundTrip, known.Pixels, sizeof(roundTrip)) != 0)
+		{
+			printf("%s: the known block's pixels didn't survive being encoded again\n", name);
+			passed = false;
+		}
+
+		if (known.Format == BlockBC7 && memcmp(block, known.Block, size) != 0)
+		{
+			printf("%s: the known block's pixels were encoded as", name);
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				printf(" %02X", block[i]);
+			}
+
+			printf("\n");
+			passed = false;
+		}
+
+		return passed;
+	}
+
+	//RGBA8, row by row
+	struct Image
+	{
+		const char* Name;
+		int Width;
+		int Height;
+		std::vector<uint8_t> Pixels;
+	};
+
+	Image MakeImage(const char* name, int size, int kind)
+	{
+		Image image = { name, size, size, std::vector<uint8_t>((size_t)size * size * 4) };
+		uint32_t seed = 12345;
+
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				uint8_t* pixel = &image.Pixels[((size_t)y * size + x) * 4];
+				float u = (float)x / (size - 1), v = (float)y / (size - 1);
+
+				if (kind == 0)
+				{
+					//Smooth gradients in every channel
+					pixel[0] = (uint8_t)(u * 255.0f + 0.5f);
+					pixel[1] = (uint8_t)(v * 255.0f + 0.5f);
+					pixel[2] = (uint8_t)((1.0f - u) * (1.0f - v) * 255.0f + 0.5f);
+					pixel[3] = (uint8_t)((u + v) * 127.5f + 0.5f);
+				}
+				else if (kind == 1)
+				{
+					//Something like a photo: a few shapes with edges, shading and some grain
+					seed = seed * 1664525u + 1013904223u;
+					int grain = (int)(seed >> 28) - 8;
+					float wave = std::sin(u * 20.0f) * std::cos(v * 13.0f);
+					bool inside = (u - 0.4f) * (u - 0.4f) + (v - 0.6f) * (v - 0.6f) < 0.08f;
+					pixel[0] = (uint8_t)std::min(std::max((inside ? 200.0f : 60.0f) + wave * 40.0f + grain, 0.0f), 255.0f);
+					pixel[1] = (uint8_t)std::min(std::max((inside ? 90.0f : 140.0f) + wave * 30.0f + grain, 0.0f), 255.0f);
+					pixel[2] = (uint8_t)std::min(std::max(80.0f + u * 120.0f - wave * 20.0f + grain, 0.0f), 255.0f);
+					pixel[3] = (uint8_t)(inside ? 255 : 128 + (int)(wave * 100.0f));
+				}
+				else
+				{
+					//A bumpy normal map, xyz packed into 0-255
+					float nx = std::sin(u * 25.0f) * 0.5f, ny = std::cos(v * 17.0f) * 0.5f;
+					float nz = std::sqrt(std::max(1.0f - nx * nx - ny * ny, 0.0f));
+					pixel[0] = (uint8_t)((nx + 1.0f) * 127.5f + 0.5f);
+					pixel[1] = (uint8_t)((ny + 1.0f) * 127.5f + 0.5f);
+					pixel[2] = (uint8_t)((nz + 1.0f) * 127.5f + 0.5f);
+					pixel[3] = 255;
+				}
+			}
+		}
+
+		return image;
+	}
+
+	//Compresses image a block at a time and returns the PSNR of the channels format stores
+	double Measure(const Image& image, BlockFormat format, double& milliseconds)
+	{
+		int channels = format == BlockBC1 ? 3 : format == BlockBC5 ? 2 : 4;
+		size_t size = BlockCompression::BlockSize(format);
+		std::vector<uint8_t> blocks((size_t)(image.Width / 4) * (image.Height / 4) * size);
+		uint8_t pixels[64], decoded[64];
+		double squaredError = 0.0;
+		size_t block = 0;
+
+		Clock::time_point start = Clock::now();
+
+		for (int by = 0; by < image.Height; by += 4)
+		{
+			for (int bx = 0; bx < image.Width; bx += 4, ++block)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					memcpy(pixels + row * 16, &image.Pixels[((size_t)(by + row) * image.Width + bx) * 4], 16);
+				}
+
+				BlockCompression::Encode(format, pixels, &blocks[block * size]);
+			}
+		}
+
+		milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		block = 0;
+
+		for (int by = 0; by < image.Height; by += 4)
+		{
+			for (int bx = 0; bx < image.Width; bx += 4, ++block)
+			{
+				BlockCompression::Decode(format, &blocks[block * size], decoded);
+
+				for (int row = 0; row < 4; ++row)
+				{
+					const uint8_t* source = &image.Pixels[((size_t)(by + row) * image.Width + bx) * 4];
+
+					for (int i = 0; i < 16; ++i)
+					{
+						int c = i % 4;
+
+						if (c < channels)
+						{
+							double d = (double)source[i] - decoded[row * 16 + i];
+							squaredError += d * d;
+						}
+					}
+				}
+			}
+		}
+
+		double meanSquaredError = squaredError / ((double)image.Width * image.Height * channels);
+		return meanSquaredError == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+	}
+}
+
+int main()
+{
+	bool passed = true;
+
+	for (const KnownBlock& known : KnownBlocks)
+	{
+		passed = CheckKnownBlock(known) && passed;
+	}
+
+	printf("known blocks: %s\n", passed ? "every check passed" : "FAILED");
+
+	const int size = 256;
+	Image images[] = { MakeImage("gradient", size, 0), MakeImage("photo", size, 1), MakeImage("normals", size, 2) };
+
+	//Floors in dB for each image and format, a few below what the encoder reaches so only a real loss of quality trips them
+	const double floors[3][4] =
+	{
+		{ 42.0, 43.0, 60.0, 48.0 },
+		{ 38.0, 39.0, 46.0, 38.0 },
+		{ 38.0, 39.0, 54.0, 41.0 },
+	};
+
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int format = BlockBC1; format <= BlockBC7; ++format)
+		{
+			double milliseconds;
+			double psnr = Measure(images[i], (BlockFormat)format, milliseconds);
+			bool good = psnr >= floors[i][format];
+			passed = good && passed;
+
+			printf("%-8s %s | PSNR %5.2f dB (floor %5.2f) | %7.2f ms a megapixel%s\n", images[i].Name, FormatNames[format], psnr, floors[i][format],
+				milliseconds * 1e6 / ((double)size * size), good ? "" : "  BELOW THE FLOOR");
+		}
+	}
+
+	printf("%s\n", passed ? "every check passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+//Checks and times MeshBounding. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. BoundsBench.cpp ../OBJParser.cpp ../MeshBounds.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o bounds_bench
+//
+//Usage (from the repository root): bounds_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary, torusKnot.objBinary and sphere.objBinary, see MeshInput.h. For each mesh it reports the box,
+//the sphere compared with the sphere around the box, the time to compute them and the time to transform them by a world
+//matrix. Every vertex is checked to be inside both volumes, before and after the transform.
+
+#include "MeshBounds.h"
+#include "MeshInput.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	bool Contains(const MeshBounds& bounds, const MeshFloat3& p)
+	{
+		//A little slack for rounding
+		float slack = 1e-5f * (bounds.Radius + 1.0f);
+		float dx = p.x - bounds.Center.x, dy = p.y - bounds.Center.y, dz = p.z - bounds.Center.z;
+
+		return p.x >= bounds.Min.x - slack && p.y >= bounds.Min.y - slack && p.z >= bounds.Min.z - slack &&
+			p.x <= bounds.Max.x + slack && p.y <= bounds.Max.y + slack && p.z <= bounds.Max.z + slack &&
+			std::sqrt(dx * dx + dy * dy + dz * dz) <= bounds.Radius + slack;
+	}
+
+	MeshFloat3 Transform(const MeshFloat3& p, const float m[4][4])
+	{
+		return { p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0], p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1],
+			p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2] };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+		inputs.push_back("sphere.objBinary");
+	}
+
+	//Like the car's world matrix in Application::Update, a rotation, a scale and a translation, plus some squash
+	const float angle = 0.7f;
+	const float world[4][4] = {
+		{ 0.05f * std::cos(angle), 0.0f, -0.05f * std::sin(angle), 0.0f },
+		{ 0.0f, 0.03f, 0.0f, 0.0f },
+		{ 0.05f * std::sin(angle), 0.0f, 0.05f * std::cos(angle), 0.0f },
+		{ 10.0f, -2.0f, 4.0f, 1.0f } };
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+
+		const int runs = 200;
+		MeshBounds bounds;
+		auto start = Clock::now();
+
+		for (int run = 0; run < runs; ++run)
+		{
+			bounds = MeshBounding::ComputeBounds(vertices.data(), vertices.size());
+		}
+
+		std::chrono::duration<double, std::micro> computeTime = Clock::now() - start;
+
+		MeshBounds worldBounds;
+		const int transforms = 1000000;
+		volatile float sink = 0.0f;
+		start = Clock::now();
+
+		for (int run = 0; run < transforms; ++run)
+		{
+			worldBounds = MeshBounding::TransformBounds(bounds, world);
+			sink = sink + worldBounds.Radius;
+		}
+
+		std::chrono::duration<double, std::nano> transformTime = Clock::now() - start;
+
+		size_t outside = 0;
+
+		for (const MeshVertex& vertex : vertices)
+		{
+			if (!Contains(bounds, vertex.Pos) || !Contains(worldBounds, Transform(vertex.Pos, world)))
+			{
+				++outside;
+			}
+		}
+
+		//The sphere around the box, for comparison
+		MeshFloat3 boxCenter = { (bounds.Min.x + bounds.Max.x) * 0.5f, (bounds.Min.y + bounds.Max.y) * 0.5f, (bounds.Min.z + bounds.Max.z) * 0.5f };
+		float boxSphere = 0.0f;
+
+		for (const MeshVertex& vertex : vertices)
+		{
+			float dx = vertex.Pos.x - boxCenter.x, dy = vertex.Pos.y - boxCenter.y, dz = vertex.Pos.z - boxCenter.z;
+			boxSphere = std::max(boxSphere, std::sqrt(dx * dx + dy * dy + dz * dz));
+		}
+
+		float dx = bounds.Max.x - bounds.Min.x, dy = bounds.Max.y - bounds.Min.y, dz = bounds.Max.z - bounds.Min.z;
+
+		printf("%s: %zu vertices\n", input.c_str(), vertices.size());
+		printf("  box (%g %g %g) - (%g %g %g), half diagonal %g\n", bounds.Min.x, bounds.Min.y, bounds.Min.z, bounds.Max.x, bounds.Max.y, bounds.Max.z,
+			0.5f * std::sqrt(dx * dx + dy * dy + dz * dz));
+		printf("  sphere radius %g (sphere around the box %g, %.1f%% smaller)\n", bounds.Radius, boxSphere, 100.0f * (1.0f - bounds.Radius / boxSphere));
+		printf("  compute %.2f us (%.2f ns per vertex) | transform %.1f ns | vertices outside %zu\n", computeTime.count() / runs,
+			computeTime.count() * 1000.0 / runs / vertices.size(), transformTime.count() / transforms, outside);
+	}
+
+	return 0;
+}
@@ -0,0 +1,252 @@
+//Measures MeshClusters culling over a camera orbit. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. ClusterCullBench.cpp ../OBJParser.cpp ../MeshOptimizer.cpp ../MeshClusters.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o clustercull_bench
+//
+//Usage (from the repository root): clustercull_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary and torusKnot.objBinary, see MeshInput.h. Each mesh goes through the same optimization and
+//clustering as OBJLoader, then a camera circles it once from far away (all of it on screen, only backface culling
+//helps) and once from close up (most of it off screen), then both again frustum culling only ("fr"), as Application does
+//while the rasterizer doesn't cull back faces either. For every orbit it reports the triangles submitted without
+//culling, submitted after cluster culling, and actually visible (inside the frustum, and front facing if culled), plus the
+//number of draws once adjacent visible clusters are merged. A triangle that's visible but was culled is an error.
+
+#include "MeshClusters.h"
+#include "MeshInput.h"
+#include "MeshOptimizer.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef float Matrix[4][4];
+
+	MeshFloat3 Subtract(const MeshFloat3& a, const MeshFloat3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	float Dot(const MeshFloat3& a, const MeshFloat3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	MeshFloat3 Cross(const MeshFloat3& a, const MeshFloat3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	MeshFloat3 Normalize(const MeshFloat3& a)
+	{
+		float length = std::sqrt(Dot(a, a));
+		return { a.x / length, a.y / length, a.z / length };
+	}
+
+	//Same as XMMatrixLookAtLH and XMMatrixPerspectiveFovLH
+	void LookAt(const MeshFloat3& eye, const MeshFloat3& at, Matrix out)
+	{
+		MeshFloat3 z = Normalize(Subtract(at, eye));
+		MeshFloat3 x = Normalize(Cross({ 0.0f, 1.0f, 0.0f }, z));
+		MeshFloat3 y = Cross(z, x);
+
+		float m[4][4] = {
+			{ x.x, y.x, z.x, 0.0f },
+			{ x.y, y.y, z.y, 0.0f },
+			{ x.z, y.z, z.z, 0.0f },
+			{ -Dot(x, eye), -Dot(y, eye), -Dot(z, eye), 1.0f } };
+
+		memcpy(out, m, sizeof(m));
+	}
+
+	void Perspective(float fovY, float aspect, float nearZ, float farZ, Matrix out)
+	{
+		float h = 1.0f / std::tan(fovY * 0.5f);
+		float range = farZ / (farZ - nearZ);
+
+		float m[4][4] = {
+			{ h / aspect, 0.0f, 0.0f, 0.0f },
+			{ 0.0f, h, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, range, 1.0f },
+			{ 0.0f, 0.0f, -range * nearZ, 0.0f } };
+
+		memcpy(out, m, sizeof(m));
+	}
+
+	void Multiply(const Matrix a, const Matrix b, Matrix out)
+	{
+		for (int r = 0; r < 4; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				out[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c] + a[r][3] * b[3][c];
+			}
+		}
+	}
+
+	//Front facing (by the vertex normals, like the clusters) if the view backface culls, and not entirely outside any one
+	//frustum plane
+	bool IsTriangleVisible(const MeshVertex& a, const MeshVertex& b, const MeshVertex& c, const ClusterCullView& view)
+	{
+		MeshFloat3 normal = Cross(Subtract(b.Pos, a.Pos), Subtract(c.Pos, a.Pos));
+		MeshFloat3 vertexNormals = { a.Normal.x + b.Normal.x + c.Normal.x, a.Normal.y + b.Normal.y + c.Normal.y, a.Normal.z + b.Normal.z + c.Normal.z };
+
+		if (Dot(normal, vertexNormals) < 0.0f)
+		{
+			normal = { -normal.x, -normal.y, -normal.z };
+		}
+
+		if (view.BackfaceCull && Dot(normal, Subtract(view.CameraPosition, a.Pos)) <= 0.0f)
+		{
+			return false;
+		}
+
+		for (int p = 0; p < 6; ++p)
+		{
+			const float* plane = view.Planes[p];
+			auto outside = [plane](const MeshFloat3& v) { return plane[0] * v.x + plane[1] * v.y + plane[2] * v.z + plane[3] < 0.0f; };
+
+			if (outside(a.Pos) && outside(b.Pos) && outside(c.Pos))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void Orbit(const char* label, const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<MeshCluster>& clusters,
+		const MeshFloat3& center, float distance, bool backfaceCull)
+	{
+		const int steps = 72;
+		const float pi = 3.14159265f;
+		const float elevation = 20.0f * pi / 180.0f;
+
+		size_t triangles = indices.size() / 3;
+		size_t submitted = 0;
+		size_t culledSubmitted = 0;
+		size_t visible = 0;
+		size_t draws = 0;
+		size_t missed = 0;
+		double cullSeconds = 0.0;
+
+		Matrix projection;
+		Perspective(60.0f * pi / 180.0f, 16.0f / 9.0f, 0.01f * distance, 100.0f * distance, projection);
+
+		std::vector<bool> clusterVisible(clusters.size());
+
+		for (int step = 0; step < steps; ++step)
+		{
+			float angle = 2.0f * pi * step / steps;
+			ClusterCullView view;
+			view.CameraPosition = { center.x + distance * std::cos(elevation) * std::cos(angle), center.y + distance * std::sin(elevation),
+				center.z + distance * std::cos(elevation) * std::sin(angle) };
+			view.BackfaceCull = backfaceCull;
+
+			Matrix viewMatrix;
+			Matrix viewProjection;
+			LookAt(view.CameraPosition, center, viewMatrix);
+			Multiply(viewMatrix, projection, viewProjection);
+			MeshClusters::ExtractFrustumPlanes(viewProjection, view.Planes);
+
+			auto start = std::chrono::steady_clock::now();
+			bool previousVisible = false;
+
+			for (size_t i = 0; i < clusters.size(); ++i)
+			{
+				clusterVisible[i] = MeshClusters::IsClusterVisible(clusters[i], view);
+
+				if (clusterVisible[i])
+				{
+					culledSubmitted += clusters[i].IndexCount / 3;
+					if (!previousVisible) ++draws;
+				}
+
+				previousVisible = clusterVisible[i];
+			}
+
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			cullSeconds += elapsed.count();
+			submitted += triangles;
+
+			for (size_t i = 0; i < clusters.size(); ++i)
+			{
+				for (uint32_t index = clusters[i].IndexStart; index < clusters[i].IndexStart + clusters[i].IndexCount; index += 3)
+				{
+					if (IsTriangleVisible(vertices[indices[index]], vertices[indices[index + 1]], vertices[indices[index + 2]], view))
+					{
+						++visible;
+						if (!clusterVisible[i]) ++missed;
+					}
+				}
+			}
+		}
+
+		printf("  %-8s | submitted %8.0f | after culling %8.0f (%5.1f%%) | visible %8.0f (%5.1f%%) | draws %5.1f | cull %6.2f us%s\n",
+			label, (double)submitted / steps, (double)culledSubmitted / steps, 100.0 * culledSubmitted / submitted,
+			(double)visible / steps, 100.0 * visible / submitted, (double)draws / steps, cullSeconds / steps * 1e6,
+			missed ? "  VISIBLE TRIANGLES CULLED" : "");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+	}
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		MeshOptimizer::OptimizeOverdraw(indices, vertices);
+
+		float acmrBefore = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()).Acmr;
+
+		std::vector<MeshCluster> clusters;
+		MeshClusters::BuildClusters(vertices, indices, clusters);
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		float acmrAfter = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()).Acmr;
+
+		MeshFloat3 minimum = vertices[0].Pos;
+		MeshFloat3 maximum = vertices[0].Pos;
+
+		for (const MeshVertex& vertex : vertices)
+		{
+			minimum = { std::fmin(minimum.x, vertex.Pos.x), std::fmin(minimum.y, vertex.Pos.y), std::fmin(minimum.z, vertex.Pos.z) };
+			maximum = { std::fmax(maximum.x, vertex.Pos.x), std::fmax(maximum.y, vertex.Pos.y), std::fmax(maximum.z, vertex.Pos.z) };
+		}
+
+		MeshFloat3 center = { (minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f };
+		float radius = std::sqrt(Dot(Subtract(maximum, center), Subtract(maximum, center)));
+
+		size_t cullable = 0;
+
+		for (const MeshCluster& cluster : clusters)
+		{
+			if (cluster.ConeCutoff < 1.0f) ++cullable;
+		}
+
+		printf("%s: %zu triangles in %zu clusters (%.1f triangles each, %zu can be backface culled), ACMR %.3f -> %.3f\n", input.c_str(),
+			indices.size() / 3, clusters.size(), (double)indices.size() / 3 / clusters.size(), cullable, acmrBefore, acmrAfter);
+
+		Orbit("far", vertices, indices, clusters, center, radius * 3.0f, true);
+		Orbit("close", vertices, indices, clusters, center, radius * 1.1f, true);
+
+		//What the game does while its rasterizer doesn't cull back faces
+		Orbit("far fr", vertices, indices, clusters, center, radius * 3.0f, false);
+		Orbit("close fr", vertices, indices, clusters, center, radius * 1.1f, false);
+	}
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+//Measures the LOD chain MeshSimplifier::GenerateLods builds. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. LodBench.cpp ../OBJParser.cpp ../MeshOptimizer.cpp ../MeshClusters.cpp ../MeshSimplifier.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o lod_bench
+//
+//Usage (from the repository root): lod_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary and torusKnot.objBinary, see MeshInput.h. Each mesh goes through the same import steps as
+//OBJLoader, then for every level it reports the triangle count, the error GenerateLods recorded, the error actually
+//measured (the furthest any original vertex is from the level's surface, by brute force), the ACMR, the open edges
+//(borders shrink as they're simplified, holes or seams splitting apart would add more than LOD 0 has) and how far from a 1280x720, 90 degree camera the level is
+//picked, in multiples of the mesh's bounding radius.
+
+#include "MeshClusters.h"
+#include "MeshInput.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	MeshFloat3 Subtract(const MeshFloat3& a, const MeshFloat3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	float Dot(const MeshFloat3& a, const MeshFloat3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	//Squared distance from p to the triangle abc, from Ericson's Real-Time Collision Detection
+	float DistanceSquared(const MeshFloat3& p, const MeshFloat3& a, const MeshFloat3& b, const MeshFloat3& c)
+	{
+		MeshFloat3 ab = Subtract(b, a), ac = Subtract(c, a), ap = Subtract(p, a);
+		float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		MeshFloat3 closest;
+
+		if (d1 <= 0.0f && d2 <= 0.0f) closest = a;
+		else
+		{
+			MeshFloat3 bp = Subtract(p, b);
+			float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+			MeshFloat3 cp = Subtract(p, c);
+			float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+			float vc = d1 * d4 - d3 * d2, vb = d5 * d2 - d1 * d6, va = d3 * d6 - d5 * d4;
+
+			if (d3 >= 0.0f && d4 <= d3) closest = b;
+			else if (d6 >= 0.0f && d5 <= d6) closest = c;
+			else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) { float v = d1 / (d1 - d3); closest = { a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v }; }
+			else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) { float w = d2 / (d2 - d6); closest = { a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w }; }
+			else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			{
+				float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+				closest = { b.x + (c.x - b.x) * w, b.y + (c.y - b.y) * w, b.z + (c.z - b.z) * w };
+			}
+			else
+			{
+				float denominator = 1.0f / (va + vb + vc);
+				float v = vb * denominator, w = vc * denominator;
+				closest = { a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w };
+			}
+		}
+
+		MeshFloat3 offset = Subtract(p, closest);
+		return Dot(offset, offset);
+	}
+
+	float MeasureError(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, const MeshLod& lod)
+	{
+		float worst = 0.0f;
+
+		for (const MeshVertex& vertex : vertices)
+		{
+			float best = 1e30f;
+
+			for (uint32_t i = lod.IndexStart; i < lod.IndexStart + lod.IndexCount && best > worst; i += 3)
+			{
+				best = std::min(best, DistanceSquared(vertex.Pos, vertices[indices[i]].Pos, vertices[indices[i + 1]].Pos, vertices[indices[i + 2]].Pos));
+			}
+
+			worst = std::max(worst, best);
+		}
+
+		return std::sqrt(worst);
+	}
+
+	//Edges between positions that only one triangle uses
+	size_t CountOpenEdges(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, const MeshLod& lod)
+	{
+		auto key = [&vertices](uint32_t index)
+		{
+			const MeshFloat3& p = vertices[index].Pos;
+			return std::make_tuple(p.x, p.y, p.z);
+		};
+
+		std::vector<std::pair<std::tuple<float, float, float>, std::tuple<float, float, float>>> edges;
+
+		for (uint32_t i = lod.IndexStart; i < lod.IndexStart + lod.IndexCount; i += 3)
+		{
+			for (int e = 0; e < 3; ++e)
+			{
+				auto a = key(indices[i + e]), b = key(indices[i + (e + 1) % 3]);
+				edges.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+		size_t open = 0;
+
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t end = i;
+			while (end < edges.size() && edges[end] == edges[i]) ++end;
+			if (end - i == 1) ++open;
+			i = end;
+		}
+
+		return open;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+	}
+
+	//Camera::getProjectionScale for the framework's 90 degree field of view at 720 pixels high
+	const float projectionScale = 720.0f * 0.5f / std::tan(3.14159265f / 4.0f);
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		MeshOptimizer::OptimizeOverdraw(indices, vertices);
+
+		std::vector<MeshCluster> clusters;
+		MeshClusters::BuildClusters(vertices, indices, clusters);
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<MeshLod> lods;
+		MeshSimplifier::GenerateLods(vertices, indices, lods);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		MeshFloat3 minimum = vertices[0].Pos;
+		MeshFloat3 maximum = vertices[0].Pos;
+
+		for (const MeshVertex& vertex : vertices)
+		{
+			minimum = { std::min(minimum.x, vertex.Pos.x), std::min(minimum.y, vertex.Pos.y), std::min(minimum.z, vertex.Pos.z) };
+			maximum = { std::max(maximum.x, vertex.Pos.x), std::max(maximum.y, vertex.Pos.y), std::max(maximum.z, vertex.Pos.z) };
+		}
+
+		MeshFloat3 extent = Subtract(maximum, minimum);
+		float radius = 0.5f * std::sqrt(Dot(extent, extent));
+
+		printf("%s: %zu vertices, radius %g, %zu levels in %.2f ms\n", input.c_str(), vertices.size(), radius, lods.size(), elapsed.count());
+
+		for (size_t level = 0; level < lods.size(); ++level)
+		{
+			const MeshLod& lod = lods[level];
+			std::vector<uint32_t> levelIndices(indices.begin() + lod.IndexStart, indices.begin() + lod.IndexStart + lod.IndexCount);
+			float acmr = MeshOptimizer::AnalyzeVertexCache(levelIndices, vertices.size()).Acmr;
+			float measured = MeasureError(vertices, indices, lod);
+			size_t openEdges = CountOpenEdges(vertices, indices, lod);
+
+			printf("  LOD %zu | %6u triangles | error %9.5f recorded %9.5f measured (%6.3f%% of radius) | ACMR %5.3f | open edges %4zu | from %7.1f radii\n",
+				level, lod.IndexCount / 3, lod.Error, measured, 100.0f * measured / radius, acmr, openEdges,
+				lod.Error * projectionScale / MeshSimplifier::DefaultMaxPixelError / radius);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+//Compression ratio and decode speed of MeshCodec, with round trip checks. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. MeshCodecBench.cpp ../MeshCodec.cpp ../Lz4.cpp ../OBJParser.cpp ../MeshOptimizer.cpp ../VertexQuantizer.cpp
+//		../MappedFile.cpp ../ThreadPool.cpp -pthread -o meshcodec_bench
+//
+//Usage (from the repository root): meshcodec_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary, star.objBinary, sphere.objBinary and torusKnot.objBinary, see MeshInput.h. Each mesh is
+//welded and ordered the way MeshImporter does it, then its float vertices, quantized vertices and indices are encoded.
+//Sizes are compared against the raw buffers and against plain LZ4 of them; decode speed is raw bytes out per second.
+//Before that, buffers of random bytes of awkward sizes are round tripped to check the SSE2 and scalar paths agree.
+//Exits with 1 if anything didn't decode back to exactly what went in.
+
+#include "MeshCodec.h"
+#include "MeshInput.h"
+#include "Lz4.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const int DecodeRuns = 50;
+
+	struct Result
+	{
+		size_t RawSize;
+		size_t Lz4Size;
+		size_t EncodedSize;
+		double EncodeMilliseconds;
+		double DecodeMilliseconds;		//Best of DecodeRuns
+		bool RoundTrip;
+	};
+
+	//stride == wordSize means an index buffer
+	Result Measure(const void* data, size_t count, size_t stride, size_t wordSize)
+	{
+		bool indices = stride == wordSize;
+		Result result;
+		result.RawSize = count * stride;
+
+		std::vector<char> lz4(Lz4::CompressBound(result.RawSize));
+		result.Lz4Size = Lz4::Compress(data, result.RawSize, lz4.data(), lz4.size());
+
+		std::vector<char> encoded;
+		Clock::time_point start = Clock::now();
+
+		if (indices)
+		{
+			MeshCodec::EncodeIndices(data, count, stride, encoded);
+		}
+		else
+		{
+			MeshCodec::EncodeVertices(data, count, stride, wordSize, encoded);
+		}
+
+		result.EncodeMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		result.EncodedSize = encoded.size();
+
+		//One guard byte past the end to catch the decoder writing too far
+		std::vector<char> decoded(result.RawSize + 1, 0x5A);
+		result.DecodeMilliseconds = 1e30;
+		result.RoundTrip = true;
+
+		for (int run = 0; run < DecodeRuns; ++run)
+		{
+			start = Clock::now();
+			bool ok = indices ? MeshCodec::DecodeIndices(encoded.data(), encoded.size(), decoded.data()) :
+				MeshCodec::DecodeVertices(encoded.data(), encoded.size(), decoded.data());
+			result.DecodeMilliseconds = std::min(result.DecodeMilliseconds, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			result.RoundTrip = result.RoundTrip && ok && decoded[result.RawSize] == 0x5A;
+		}
+
+		result.RoundTrip = result.RoundTrip && (result.RawSize == 0 || memcmp(decoded.data(), data, result.RawSize) == 0);
+		return result;
+	}
+
+	void Print(const std::string& name, const char* stream, const Result& result)
+	{
+		printf("%-22s %-10s %10zu %10zu %10zu %7.2fx %9.3f %9.3f %8.2f  %s\n", name.c_str(), stream, result.RawSize, result.Lz4Size,
+			result.EncodedSize, result.EncodedSize > 0 ? (double)result.RawSize / result.EncodedSize : 0.0, result.EncodeMilliseconds,
+			result.DecodeMilliseconds, result.DecodeMilliseconds > 0.0 ? result.RawSize / result.DecodeMilliseconds / 1e6 : 0.0,
+			result.RoundTrip ? "ok" : "FAILED");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs = { "car.objBinary", "star.objBinary", "sphere.objBinary", "torusKnot.objBinary" };
+	}
+
+	bool allOk = true;
+
+	//Counts either side of the 16 element blocks, and strides that do and don't take the SSE2 vertex path
+	std::mt19937 random(12345);
+	const size_t counts[] = { 0, 1, 15, 16, 17, 31, 100, 1000 };
+	const size_t layouts[][2] = { { 32, 4 }, { 32, 2 }, { 16, 2 }, { 16, 4 }, { 12, 4 }, { 6, 2 }, { 2, 2 }, { 4, 4 } };
+	unsigned int roundTrips = 0;
+
+	for (size_t count : counts)
+	{
+		for (const size_t* layout : layouts)
+		{
+			//Small random steps so the delta filter is the one picked, as well as bytes that are random throughout
+			for (int smooth = 0; smooth < 2; ++smooth)
+			{
+				std::vector<uint8_t> data(count * layout[0]);
+
+				for (size_t i = 0; i < data.size(); ++i)
+				{
+					data[i] = smooth && i >= layout[0] ? (uint8_t)(data[i - layout[0]] + random() % 3) : (uint8_t)random();
+				}
+
+				if (!Measure(data.data(), count, layout[0], layout[1]).RoundTrip)
+				{
+					printf("Round trip of %zu elements of %zu bytes in %zu byte words FAILED\n", count, layout[0], layout[1]);
+					allOk = false;
+				}
+
+				++roundTrips;
+			}
+		}
+	}
+
+	printf("%u random round trips %s\n\n", roundTrips, allOk ? "ok" : "FAILED");
+	printf("%-22s %-10s %10s %10s %10s %8s %9s %9s %8s\n", "mesh", "stream", "raw", "lz4", "encoded", "ratio", "encode ms", "decode ms", "GB/s");
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%-22s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		//The same steps MeshImporter runs before writing a cache
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		VertexQuantization quantization = VertexQuantizer::ComputeQuantization(vertices);
+		std::vector<QuantizedVertex> quantized;
+		VertexQuantizer::Quantize(vertices, quantization, quantized);
+
+		Result results[3];
+		results[0] = Measure(vertices.data(), vertices.size(), sizeof(MeshVertex), sizeof(float));
+		results[1] = Measure(quantized.data(), quantized.size(), sizeof(QuantizedVertex), sizeof(uint16_t));
+
+		if (vertices.size() <= MaxShortIndexedVertices)
+		{
+			std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+			results[2] = Measure(shortIndices.data(), shortIndices.size(), sizeof(uint16_t), sizeof(uint16_t));
+		}
+		else
+		{
+			results[2] = Measure(indices.data(), indices.size(), sizeof(uint32_t), sizeof(uint32_t));
+		}
+
+		Print(input, "vertices", results[0]);
+		Print(input, "quantized", results[1]);
+		Print(input, "indices", results[2]);
+
+		for (const Result& result : results)
+		{
+			allOk = allOk && result.RoundTrip;
+		}
+	}
+
+	return allOk ? 0 : 1;
+}
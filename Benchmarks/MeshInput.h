@@ -0,0 +1,47 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include "OBJParser.h"
+
+//Loads either an OBJ or one of the original raw "<count><count><vertices><indices>" binary dumps into ObjData.
+//The checked in .objBinary files were written before vertices were welded, so every face corner in them is its
+//own vertex, which makes them a faithful stand-in for the un-indexed OBJ data.
+inline bool LoadMeshInput(const std::string& filename, ObjData& data)
+{
+	if (filename.size() < 6 || filename.compare(filename.size() - 6, 6, "Binary") != 0)
+	{
+		return OBJParser::ParseFile(filename.c_str(), data);
+	}
+
+	std::ifstream in(filename, std::ios::binary);
+	unsigned int numVertices = 0;
+	unsigned int numIndices = 0;
+	in.read((char*)&numVertices, sizeof(unsigned int));
+	in.read((char*)&numIndices, sizeof(unsigned int));
+
+	if (!in.good())
+	{
+		return false;
+	}
+
+	std::vector<MeshVertex> vertices(numVertices);
+	std::vector<unsigned short> indices(numIndices);
+	in.read((char*)vertices.data(), sizeof(MeshVertex) * numVertices);
+	in.read((char*)indices.data(), sizeof(unsigned short) * numIndices);
+
+	data.Clear();
+
+	for (unsigned int i = 0; i < numIndices; ++i)
+	{
+		const MeshVertex& vertex = vertices[indices[i]];
+		uint32_t index = (uint32_t)data.Positions.size();
+
+		data.Positions.push_back(vertex.Pos);
+		data.Normals.push_back(vertex.Normal);
+		data.TexCoords.push_back(vertex.TexC);
+		data.Corners.push_back({ index, index, index });
+	}
+
+	return true;
+}
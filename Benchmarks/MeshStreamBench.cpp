@@ -0,0 +1,240 @@
+//Measures streaming a progressive mesh cache in a stage at a time against loading it whole, and checks every stage is a
+//mesh that can be drawn on its own. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. MeshStreamBench.cpp ../MeshStream.cpp ../MeshImporter.cpp ../MeshCache.cpp ../MeshCodec.cpp ../Lz4.cpp ../ContentHash.cpp
+//		../OBJParser.cpp ../MeshOptimizer.cpp ../MeshClusters.cpp ../MeshSimplifier.cpp ../MeshBounds.cpp ../VertexQuantizer.cpp
+//		../MappedFile.cpp ../ThreadPool.cpp -pthread -o meshstream_bench
+//
+//Usage: meshstream_bench [--size <megabytes>] [file.obj ...]
+//Defaults to a synthetic torus OBJ of --size megabytes (16 unless given) written to the temp directory. Each mesh is imported
+//with the options Application uses plus MeshOptionProgressive, which writes its cache if it isn't up to date. Then it's loaded
+//whole (the payload hash reads every byte) and streamed (the header and section table, then each stage checked by
+//MeshStream::CheckStage), and the time until each stage could be drawn is printed. Finally a byte of the last stage is
+//corrupted in a copy of the cache, which has to fail that stage and only that one, as does a submesh's cluster range running
+//past the clusters for the full detail stages. The cache opened from memory for a load with other options has to be refused.
+//The cache will be in the OS file cache after the import, so these are warm numbers.
+//Exits with 1 if any check fails.
+
+#include "MappedFile.h"
+#include "MeshImporter.h"
+#include "SyntheticMesh.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	//Every stage of a streamed import has to pass, in order
+	bool CheckStages(const MeshImport& mesh, const char* filename)
+	{
+		for (size_t stage = 0; stage < mesh.Stages.size(); ++stage)
+		{
+			if (!MeshStream::CheckStage(mesh, stage))
+			{
+				printf("%s: stage %zu isn't a valid mesh\n", filename, stage);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Measure(const std::string& filename, uint32_t options, ThreadPool& pool)
+	{
+		const char* name = filename.c_str();
+
+		//Builds the progressive cache if it isn't there yet
+		{
+			MeshImport build;
+			Clock::time_point start = Clock::now();
+
+			if (!MeshImporter::ImportStreaming(name, options, build, pool) || build.Stages.empty())
+			{
+				printf("%s: couldn't be imported as a progressive mesh\n", name);
+				return false;
+			}
+
+			printf("%s: imported in %.3f ms, %u vertices, %u indices, %zu stages\n", name, MillisecondsSince(start), build.VertexCount, build.IndexCount,
+				build.Stages.size());
+
+			if (!CheckStages(build, name))
+			{
+				return false;
+			}
+		}
+
+		//Whole, from the cache
+		MeshImport whole;
+		Clock::time_point start = Clock::now();
+		bool loaded = MeshImporter::Import(name, options | MeshOptionProgressive, whole, pool);
+		double wholeMilliseconds = MillisecondsSince(start);
+
+		if (!loaded)
+		{
+			printf("%s: the progressive cache couldn't be loaded whole\n", name);
+			return false;
+		}
+
+		//Streamed, the time each stage could be drawn at
+		MeshImport streamed;
+		start = Clock::now();
+
+		if (!MeshImporter::ImportStreaming(name, options, streamed, pool) || streamed.Stages.size() != whole.Stages.size())
+		{
+			printf("%s: the progressive cache couldn't be streamed\n", name);
+			return false;
+		}
+
+		double openMilliseconds = MillisecondsSince(start);
+		printf("%s: whole load %.3f ms, streaming open %.3f ms\n", name, wholeMilliseconds, openMilliseconds);
+		printf("  %5s %4s %10s %10s %12s %12s\n", "stage", "lod", "triangles", "vertices", "bytes", "drawable ms");
+
+		for (size_t stage = 0; stage < streamed.Stages.size(); ++stage)
+		{
+			if (!MeshStream::CheckStage(streamed, stage))
+			{
+				printf("%s: streamed stage %zu isn't a valid mesh\n", name, stage);
+				return false;
+			}
+
+			MeshStreamRange range = MeshStream::StageRange(streamed, stage);
+			size_t bytes = (size_t)range.VertexCount * streamed.VertexStride + (size_t)range.IndexCount * streamed.IndexSize;
+			printf("  %5zu %4u %10u %10u %12zu %12.3f\n", stage, streamed.Stages[stage].Lod, range.IndexCount / 3, streamed.Stages[stage].VertexCount, bytes,
+				MillisecondsSince(start));
+		}
+
+		//A damaged last stage mustn't stop the ones before it from being used
+		std::string cacheFilename = filename + "Binary";
+		MappedFile cache;
+
+		if (!cache.Open(cacheFilename.c_str()))
+		{
+			printf("%s: couldn't map %s\n", name, cacheFilename.c_str());
+			return false;
+		}
+
+		std::vector<char> damaged(cache.Data(), cache.Data() + cache.Size());
+		MeshStreamRange last = MeshStream::StageRange(streamed, streamed.Stages.size() - 1);
+		const MeshCacheSection* indices = streamed.Cache.FindSection(MeshSectionIndices);
+		size_t offset = (size_t)indices->Offset + (size_t)last.IndexStart * streamed.IndexSize;
+		damaged[offset] ^= 0x5A;
+
+		MeshImport corrupt;
+
+		if (!MeshImporter::ImportFromMemory(damaged.data(), damaged.size(), options, corrupt, true) || corrupt.Stages.size() != streamed.Stages.size())
+		{
+			printf("%s: the damaged copy couldn't be opened for streaming\n", name);
+			return false;
+		}
+
+		for (size_t stage = 0; stage < corrupt.Stages.size(); ++stage)
+		{
+			if (MeshStream::CheckStage(corrupt, stage) != (stage + 1 < corrupt.Stages.size()))
+			{
+				printf("%s: damaging the last stage changed whether stage %zu passes\n", name, stage);
+				return false;
+			}
+		}
+
+		//The submesh table isn't hashed either, a cluster range running past the clusters has to fail the full detail stages
+		std::vector<char> badClusters(cache.Data(), cache.Data() + cache.Size());
+		const MeshCacheSection* submeshes = streamed.Cache.FindSection(MeshSectionSubmeshes);
+		MeshSubmesh* firstSubmesh = (MeshSubmesh*)&badClusters[(size_t)submeshes->Offset];
+		firstSubmesh->ClusterCount = (uint32_t)streamed.Clusters.size() + 1;
+		MeshImport clustersPastEnd;
+
+		if (!MeshImporter::ImportFromMemory(badClusters.data(), badClusters.size(), options, clustersPastEnd, true))
+		{
+			printf("%s: the copy with bad cluster ranges couldn't be opened for streaming\n", name);
+			return false;
+		}
+
+		for (size_t stage = 0; stage < clustersPastEnd.Stages.size(); ++stage)
+		{
+			if (MeshStream::CheckStage(clustersPastEnd, stage) != (clustersPastEnd.Stages[stage].Lod != 0))
+			{
+				printf("%s: a submesh's clusters past the end weren't caught by stage %zu alone\n", name, stage);
+				return false;
+			}
+		}
+
+		//Like a pack entry, the cache in memory has no source to rebuild from, and asked for with other options it's the wrong data
+		MeshImport otherOptions;
+
+		if (MeshImporter::ImportFromMemory(cache.Data(), cache.Size(), options ^ MeshOptionInvertTexCoords, otherOptions, true) ||
+			MeshImporter::ImportFromMemory(cache.Data(), cache.Size(), options ^ MeshOptionInvertTexCoords, otherOptions))
+		{
+			printf("%s: the cache was used for a load with other options\n", name);
+			return false;
+		}
+
+		printf("%s: every stage is valid, a damaged last stage and bad cluster ranges are caught, other options are refused\n", name);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filenames;
+	size_t megabytes = 16;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			megabytes = (size_t)atoi(argv[++i]);
+		}
+		else
+		{
+			filenames.push_back(argv[i]);
+		}
+	}
+
+	std::string synthetic;
+
+	if (filenames.empty())
+	{
+		synthetic = (std::filesystem::temp_directory_path() / "meshstream_bench.obj").string();
+		std::ofstream out(synthetic, std::ios::binary);
+		out << MakeSyntheticObj(megabytes * 1024 * 1024);
+
+		if (!out.good())
+		{
+			printf("Couldn't write %s\n", synthetic.c_str());
+			return 1;
+		}
+
+		filenames.push_back(synthetic);
+	}
+
+	//Application's mesh options, see Application::Initialise
+	uint32_t options = MeshImporter::OptionsFor(true, true, true, true);
+	ThreadPool& pool = ThreadPool::Default();
+	bool passed = true;
+
+	for (const std::string& filename : filenames)
+	{
+		passed = Measure(filename, options, pool) && passed;
+	}
+
+	if (!synthetic.empty())
+	{
+		std::error_code error;
+		std::filesystem::remove(synthetic, error);
+		std::filesystem::remove(synthetic + "Binary", error);
+	}
+
+	return passed ? 0 : 1;
+}
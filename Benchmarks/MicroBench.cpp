@@ -0,0 +1,545 @@
+//Microbenchmarks of the engine's CPU-side hot paths, with JSON results and a baseline to compare against.
+//Build it with the Makefile in this directory (make microbench), or on its own, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. MicroBench.cpp ../OBJParser.cpp ../DDSFormat.cpp ../SceneConfig.cpp ../MappedFile.cpp ../ThreadPool.cpp
+//		-pthread -o microbench
+//Camera::update and SceneAnimation::BuildTransforms need DirectXMath, add -DBENCH_DIRECTXMATH ../Camera.cpp ../SceneAnimation.cpp
+//and its include directory to have them too.
+//
+//Usage (from the repository root): microbench [--filter text] [--samples N] [--json results.json]
+//	[--baseline baseline.json] [--threshold percent] [--noise-ns ns] [--min-batch-ms ms]
+//Each case is run in batches of about 10 ms, and the median and fastest batch of N (9 by default) are reported per
+//operation. --json writes the results, and --baseline compares them with a file written that way earlier on the same
+//machine. A case is a regression when its median is more than threshold percent (10 by default) and more than noise-ns
+//nanoseconds (2 by default) slower than the baseline's, and both its batch and the baseline's took at least min-batch-ms
+//(5 by default), even after measuring it twice more; the exit code is 1 if there were any. Medians because the fastest
+//batch swings by tens of percent from run to run on calls of a few nanoseconds, the noise floor because a percentage of
+//one is still less than the clock can tell apart, and the batch length because shorter batches are mostly timer and
+//scheduling. Cases are:
+//	obj.parse		OBJParser::ParseBuffer on synthetic OBJ text, the parse half of OBJLoader::Load
+//	obj.index		OBJParser::CreateIndices on the checked in meshes, the other half
+//	dds.header		DDSFormat::ParseHeader and the format lookup, per texture in the repository
+//	dds.surface		DDSFormat::GetSurfaceInfo over the mip chains of common formats and sizes
+//	dds.initdata	DDSFormat::FillInitData, the layout of each texture's mip chain
+//	dds.read		A texture file read into a heap copy, then parsed and laid out, as DDSTextureLoader used to
+//	dds.map			The same from a MappedFile, as it does now. Both touch every page, like the upload would
+//	xml.scene		values.xml copied and parsed by SceneConfigXml::Parse, as Application::XML does
+//	camera.update	Camera::update, both look at and look to
+//	scene.transforms	SceneAnimation::BuildTransforms, the per-object matrices from Application::Update
+
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "MeshInput.h"
+#include "OBJParser.h"
+#include "SceneConfig.h"
+#include "SyntheticMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef BENCH_DIRECTXMATH
+#include "Camera.h"
+#include "SceneAnimation.h"
+#endif
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	//How long one batch of calls should take at least
+	const double BatchMilliseconds = 10.0;
+
+	//How many times a case that looks slower than its baseline is measured again
+	const int Retries = 2;
+
+	//Keeps the results from being optimized away
+	volatile size_t Sink;
+
+	struct Case
+	{
+		std::string Name;
+		size_t Bytes;						//Input processed per call, 0 if throughput means nothing for it
+		std::function<size_t()> Run;
+	};
+
+	struct Result
+	{
+		std::string Name;
+		uint64_t Iterations;				//Per batch
+		double MedianNanoseconds;			//Per call
+		double MinNanoseconds;
+		double BytesPerSecond;				//At the median, 0 without Case::Bytes
+		double MedianBatchMilliseconds;
+	};
+
+	//What a regression is judged against, read from an earlier run's JSON
+	struct BaselineResult
+	{
+		double MedianNanoseconds;
+		double BatchMilliseconds;			//0 if the file doesn't say
+	};
+
+	double BatchNanoseconds(const Case& benchmark, uint64_t iterations)
+	{
+		size_t sink = 0;
+		Clock::time_point start = Clock::now();
+
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			sink += benchmark.Run();
+		}
+
+		double nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		Sink = Sink + sink;
+		return nanoseconds;
+	}
+
+	Result Measure(const Case& benchmark, int samples)
+	{
+		//Doubles the batch until it's long enough for the clock, which also warms the caches
+		uint64_t iterations = 1;
+
+		while (BatchNanoseconds(benchmark, iterations) < BatchMilliseconds * 1e6 && iterations < (1ull << 40))
+		{
+			iterations *= 2;
+		}
+
+		std::vector<double> perCall;
+
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			perCall.push_back(BatchNanoseconds(benchmark, iterations) / iterations);
+		}
+
+		std::sort(perCall.begin(), perCall.end());
+
+		Result result;
+		result.Name = benchmark.Name;
+		result.Iterations = iterations;
+		result.MedianNanoseconds = perCall[perCall.size() / 2];
+		result.MinNanoseconds = perCall.front();
+		result.BytesPerSecond = benchmark.Bytes > 0 ? benchmark.Bytes / (result.MedianNanoseconds * 1e-9) : 0.0;
+		result.MedianBatchMilliseconds = result.MedianNanoseconds * iterations * 1e-6;
+		return result;
+	}
+
+	bool ReadFile(const std::string& filename, std::vector<char>& out)
+	{
+		std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+		if (!file)
+		{
+			return false;
+		}
+
+		out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	//Names are written without anything that would need escaping
+	bool WriteJson(const std::string& filename, const std::vector<Result>& results)
+	{
+		FILE* file = fopen(filename.c_str(), "w");
+
+		if (!file)
+		{
+			return false;
+		}
+
+		fprintf(file, "{\n\t\"benchmarks\": [\n");
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Result& result = results[i];
+			fprintf(file, "\t\t{ \"name\": \"%s\", \"iterations\": %llu, \"median_ns\": %.3f, \"min_ns\": %.3f, \"batch_ms\": %.3f, "
+				"\"bytes_per_second\": %.0f }%s\n", result.Name.c_str(), (unsigned long long)result.Iterations, result.MedianNanoseconds,
+				result.MinNanoseconds, result.MedianBatchMilliseconds, result.BytesPerSecond, i + 1 < results.size() ? "," : "");
+		}
+
+		fprintf(file, "\t]\n}\n");
+		return fclose(file) == 0;
+	}
+
+	//Batches shorter than minimumBatchMilliseconds on either side aren't judged. A baseline that doesn't give its batch
+	//length is taken to be long enough
+	bool IsLongEnough(const Result& result, const BaselineResult& base, double minimumBatchMilliseconds)
+	{
+		return result.MedianBatchMilliseconds >= minimumBatchMilliseconds && (base.BatchMilliseconds == 0.0 || base.BatchMilliseconds >= minimumBatchMilliseconds);
+	}
+
+	bool IsRegression(const Result& result, const BaselineResult& base, double threshold, double noiseNanoseconds, double minimumBatchMilliseconds)
+	{
+		double slower = result.MedianNanoseconds - base.MedianNanoseconds;
+		return IsLongEnough(result, base, minimumBatchMilliseconds) && slower > base.MedianNanoseconds * threshold / 100.0 && slower > noiseNanoseconds;
+	}
+
+	//The number after key within [position, end), or nullptr if it isn't there
+	const char* FindValue(const char* position, const char* end, const char* key)
+	{
+		const char* found = strstr(position, key);
+		return found && found < end ? found + strlen(key) : nullptr;
+	}
+
+	//Only reads what WriteJson writes: each "name" and its "median_ns" and "batch_ms", up to the object's closing brace.
+	//Entries without a median are skipped
+	bool ReadBaseline(const std::string& filename, std::map<std::string, BaselineResult>& out)
+	{
+		std::vector<char> text;
+
+		if (!ReadFile(filename, text))
+		{
+			return false;
+		}
+
+		text.push_back('\0');
+		const char* position = text.data();
+		const char nameKey[] = "\"name\": \"";
+
+		while ((position = strstr(position, nameKey)) != nullptr)
+		{
+			position += sizeof(nameKey) - 1;
+			const char* nameEnd = strchr(position, '"');
+			const char* objectEnd = nameEnd ? strchr(nameEnd, '}') : nullptr;
+
+			if (!objectEnd)
+			{
+				break;
+			}
+
+			const char* median = FindValue(nameEnd, objectEnd, "\"median_ns\": ");
+			const char* batch = FindValue(nameEnd, objectEnd, "\"batch_ms\": ");
+
+			if (median)
+			{
+				out[std::string(position, nameEnd)] = { atof(median), batch ? atof(batch) : 0.0 };
+			}
+
+			position = objectEnd;
+		}
+
+		return true;
+	}
+
+	void AddObjCases(std::vector<Case>& cases)
+	{
+		//Generated so they don't depend on OBJ files being checked in, the same sizes as OBJParserBench
+		const size_t sizes[] = { 1 << 20, 10 << 20 };
+		const char* names[] = { "obj.parse/1MB", "obj.parse/10MB" };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			std::string* text = new std::string(MakeSyntheticObj(sizes[i]));
+			ObjData* data = new ObjData();
+
+			cases.push_back({ names[i], text->size(), [text, data]()
+			{
+				OBJParser::ParseBuffer(text->data(), text->size(), *data);
+				return data->Corners.size();
+			} });
+		}
+
+		for (const char* mesh : { "car.objBinary", "torusKnot.objBinary" })
+		{
+			ObjData* data = new ObjData();
+
+			if (!LoadMeshInput(mesh, *data))
+			{
+				printf("%s could not be loaded, skipping its cases\n", mesh);
+				delete data;
+				continue;
+			}
+
+			std::vector<MeshVertex>* vertices = new std::vector<MeshVertex>();
+			std::vector<uint32_t>* indices = new std::vector<uint32_t>();
+
+			cases.push_back({ std::string("obj.index/") + mesh, 0, [data, vertices, indices]()
+			{
+				OBJParser::CreateIndices(*data, *vertices, *indices);
+				return vertices->size();
+			} });
+		}
+	}
+
+	//Parses a whole texture file and lays out its mip chain, then reads a byte of every page of it
+	size_t LayOutTexture(const uint8_t* data, size_t size)
+	{
+		const DDS_HEADER* header;
+		const uint8_t* bitData;
+		size_t bitSize;
+
+		if (!DDSFormat::ParseHeader(data, size, &header, &bitData, &bitSize))
+		{
+			return 0;
+		}
+
+		const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+		DXGI_FORMAT format = dxt10 ? dxt10->dxgiFormat : DDSFormat::GetDXGIFormat(header->ddspf);
+		size_t mipCount = std::max<uint32_t>(header->mipMapCount, 1);
+		size_t arraySize = dxt10 ? std::max<uint32_t>(dxt10->arraySize, 1) : 1;
+		std::vector<DDSSubresource> initData(mipCount * arraySize);
+		size_t width, height, depth, skipMip;
+
+		DDSFormat::FillInitData(header->width, header->height, std::max<uint32_t>(header->depth, 1), mipCount, arraySize, format, 0,
+			bitSize, bitData, width, height, depth, skipMip, initData.data());
+
+		size_t touched = 0;
+
+		for (size_t offset = 0; offset < size; offset += 4096)
+		{
+			touched += data[offset];
+		}
+
+		return touched + width;
+	}
+
+	void AddDdsCases(std::vector<Case>& cases)
+	{
+		for (const char* texture : { "Crate_COLOR.dds", "Crate_NRM.dds", "ChainLink.dds", "asphalt.dds" })
+		{
+			std::vector<char>* file = new std::vector<char>();
+			const DDS_HEADER* header;
+			const uint8_t* bitData;
+			size_t bitSize;
+
+			if (!ReadFile(texture, *file) || !DDSFormat::ParseHeader((const uint8_t*)file->data(), file->size(), &header, &bitData, &bitSize))
+			{
+				printf("%s could not be loaded, skipping its cases\n", texture);
+				delete file;
+				continue;
+			}
+
+			cases.push_back({ std::string("dds.header/") + texture, 0, [file]()
+			{
+				const DDS_HEADER* header;
+				const uint8_t* bitData;
+				size_t bitSize;
+				DDSFormat::ParseHeader((const uint8_t*)file->data(), file->size(), &header, &bitData, &bitSize);
+
+				const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+				DXGI_FORMAT format = dxt10 ? dxt10->dxgiFormat : DDSFormat::GetDXGIFormat(header->ddspf);
+				return (size_t)format + bitSize;
+			} });
+
+			const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+			DXGI_FORMAT format = dxt10 ? dxt10->dxgiFormat : DDSFormat::GetDXGIFormat(header->ddspf);
+			size_t mipCount = std::max<uint32_t>(header->mipMapCount, 1);
+			size_t arraySize = dxt10 ? std::max<uint32_t>(dxt10->arraySize, 1) : 1;
+			std::vector<DDSSubresource>* initData = new std::vector<DDSSubresource>(mipCount * arraySize);
+
+			cases.push_back({ std::string("dds.initdata/") + texture, 0, [header, bitData, bitSize, format, mipCount, arraySize, initData]()
+			{
+				size_t width, height, depth, skipMip;
+				DDSFormat::FillInitData(header->width, header->height, std::max<uint32_t>(header->depth, 1), mipCount, arraySize, format, 0,
+					bitSize, bitData, width, height, depth, skipMip, initData->data());
+				return width + (*initData)[0].slicePitch;
+			} });
+		}
+
+		//What CreateDDSTextureFromFile does before handing the mips to Direct3D, from a copy and from the mapping
+		for (const char* texture : { "Crate_COLOR.dds", "ChainLink.dds" })
+		{
+			std::string filename = texture;
+
+			cases.push_back({ std::string("dds.read/") + texture, 0, [filename]()
+			{
+				std::vector<char> file;
+				return ReadFile(filename, file) ? LayOutTexture((const uint8_t*)file.data(), file.size()) : 0;
+			} });
+
+			cases.push_back({ std::string("dds.map/") + texture, 0, [filename]()
+			{
+				MappedFile file;
+				return file.Open(filename.c_str()) ? LayOutTexture((const uint8_t*)file.Data(), file.Size()) : 0;
+			} });
+		}
+
+		//Every mip of square and wide textures up to 4096, in the formats the game's textures and BC compression use
+		cases.push_back({ "dds.surface", 0, []()
+		{
+			const DXGI_FORMAT formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_BC1_UNORM,
+				DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_R16G16B16A16_FLOAT };
+			size_t total = 0;
+
+			for (DXGI_FORMAT format : formats)
+			{
+				for (size_t width = 4096, height = 4096; width > 0; width >>= 1, height >>= 1)
+				{
+					size_t numBytes, rowBytes, numRows;
+					DDSFormat::GetSurfaceInfo(width, height, format, &numBytes, &rowBytes, &numRows);
+					total += numBytes + rowBytes + numRows;
+					DDSFormat::GetSurfaceInfo(width, std::max<size_t>(height / 4, 1), format, &numBytes, &rowBytes, &numRows);
+					total += numBytes;
+				}
+			}
+
+			return total;
+		} });
+	}
+
+	void AddXmlCases(std::vector<Case>& cases)
+	{
+		std::vector<char>* text = new std::vector<char>();
+
+		if (!ReadFile("values.xml", *text))
+		{
+			printf("values.xml could not be loaded, skipping its cases\n");
+			delete text;
+			return;
+		}
+
+		std::vector<char>* buffer = new std::vector<char>();
+
+		cases.push_back({ "xml.scene", text->size(), [text, buffer]()
+		{
+			//Parsing is in place, so like Application::XML every call starts from a copy
+			buffer->assign(text->begin(), text->end());
+			buffer->push_back('\0');
+
+			SceneConfig config = {};
+			SceneConfigXml::Parse(buffer->data(), config);
+			return (size_t)config.Car.y;
+		} });
+	}
+
+#ifdef BENCH_DIRECTXMATH
+	void AddMathCases(std::vector<Case>& cases)
+	{
+		Camera* camera = new Camera(XMFLOAT3(0.0f, 10.0f, -10.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), 1280.0f, 720.0f, 0.01f, 100.0f);
+
+		cases.push_back({ "camera.update", 0, [camera]()
+		{
+			camera->setTypeAt(!camera->getTypeAt());
+			camera->update();
+			return (size_t)(camera->getView()._41 + camera->getProjection()._22);
+		} });
+
+		SceneConfig* scene = new SceneConfig();
+		*scene = { { 0.0f, 10.0f, 0.0f }, { 0.0f, 5.0f, 0.0f }, { 5.0f, 0.0f, 0.0f }, { 10.0f, 0.0f, 0.0f }, { 5.0f, 0.0f, 0.0f },
+			{ 10.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+		float* t = new float(0.0f);
+
+		cases.push_back({ "scene.transforms", 0, [scene, t]()
+		{
+			SceneTransforms transforms;
+			*t += 0.016f;
+			SceneAnimation::BuildTransforms(*t, *t * 0.5f, *scene, transforms);
+			return (size_t)(transforms.Moon1._41 + transforms.Car._43);
+		} });
+	}
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+	std::string jsonFilename;
+	std::string baselineFilename;
+	double threshold = 10.0;
+	double noiseNanoseconds = 2.0;
+	double minimumBatchMilliseconds = 5.0;
+	int samples = 9;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (i + 1 < argc && argument == "--filter") filter = argv[++i];
+		else if (i + 1 < argc && argument == "--json") jsonFilename = argv[++i];
+		else if (i + 1 < argc && argument == "--baseline") baselineFilename = argv[++i];
+		else if (i + 1 < argc && argument == "--threshold") threshold = atof(argv[++i]);
+		else if (i + 1 < argc && argument == "--noise-ns") noiseNanoseconds = atof(argv[++i]);
+		else if (i + 1 < argc && argument == "--min-batch-ms") minimumBatchMilliseconds = atof(argv[++i]);
+		else if (i + 1 < argc && argument == "--samples") samples = std::max(1, atoi(argv[++i]));
+		else
+		{
+			printf("Usage: microbench [--filter text] [--samples N] [--json results.json] [--baseline baseline.json] [--threshold percent] "
+				"[--noise-ns ns] [--min-batch-ms ms]\n");
+			return 2;
+		}
+	}
+
+	std::map<std::string, BaselineResult> baseline;
+
+	if (!baselineFilename.empty() && !ReadBaseline(baselineFilename, baseline))
+	{
+		printf("%s could not be read\n", baselineFilename.c_str());
+		return 2;
+	}
+
+	//The inputs each case needs live as long as the process
+	std::vector<Case> cases;
+	AddObjCases(cases);
+	AddDdsCases(cases);
+	AddXmlCases(cases);
+#ifdef BENCH_DIRECTXMATH
+	AddMathCases(cases);
+#else
+	printf("Built without DirectXMath, skipping camera.update and scene.transforms\n");
+#endif
+
+	std::vector<Result> results;
+	int regressions = 0;
+	printf("%-28s %12s %12s %12s  %s\n", "case", "median ns", "min ns", "MB/s", "median against the baseline");
+
+	for (const Case& benchmark : cases)
+	{
+		if (!filter.empty() && benchmark.Name.find(filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		Result result = Measure(benchmark, samples);
+		char comparison[64] = "";
+		std::map<std::string, BaselineResult>::const_iterator base = baseline.find(result.Name);
+
+		if (base != baseline.end() && base->second.MedianNanoseconds > 0.0)
+		{
+			//A slowdown has to show up every time, so a burst of load from elsewhere during one measurement doesn't count
+			for (int retry = 0; retry < Retries && IsRegression(result, base->second, threshold, noiseNanoseconds, minimumBatchMilliseconds); ++retry)
+			{
+				Result again = Measure(benchmark, samples);
+
+				if (again.MedianNanoseconds < result.MedianNanoseconds)
+				{
+					result = again;
+				}
+			}
+
+			double change = (result.MedianNanoseconds / base->second.MedianNanoseconds - 1.0) * 100.0;
+			double slower = result.MedianNanoseconds - base->second.MedianNanoseconds;
+			bool regressed = IsRegression(result, base->second, threshold, noiseNanoseconds, minimumBatchMilliseconds);
+			const char* verdict = regressed ? " REGRESSED" : change <= threshold ? "" :
+				!IsLongEnough(result, base->second, minimumBatchMilliseconds) ? " batch too short" : " under the noise floor";
+
+			snprintf(comparison, sizeof(comparison), "%+.1f%% (%+.1f ns)%s", change, slower, verdict);
+			regressions += regressed ? 1 : 0;
+		}
+		else if (!baseline.empty())
+		{
+			snprintf(comparison, sizeof(comparison), "new");
+		}
+
+		results.push_back(result);
+		printf("%-28s %12.1f %12.1f %12.1f  %s\n", result.Name.c_str(), result.MedianNanoseconds, result.MinNanoseconds,
+			result.BytesPerSecond / 1e6, comparison);
+	}
+
+	if (!jsonFilename.empty() && !WriteJson(jsonFilename, results))
+	{
+		printf("%s could not be written\n", jsonFilename.c_str());
+		return 2;
+	}
+
+	if (!baseline.empty())
+	{
+		printf("%d of %zu cases more than %.1f%% and %.1f ns slower than the baseline\n", regressions, results.size(), threshold, noiseNanoseconds);
+	}
+
+	return regressions > 0 ? 1 : 0;
+}
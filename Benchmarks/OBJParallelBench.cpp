@@ -0,0 +1,226 @@
+//Thread scaling benchmark for OBJParser::ParseFileParallel. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. OBJParallelBench.cpp ../OBJParser.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o objparallel_bench
+//
+//Usage: objparallel_bench [size in MB | file.obj]
+//First checks the o/g/usemtl grouping and the mtllib and .mtl parsing on small hand written files. Then generates a
+//synthetic OBJ of the given size (200 MB by default, its faces split into groups and materials) unless a file is given,
+//and parses it serially and with 2/4/8/16 threads. Every parallel result, groups included, is checked against the serial one.
+//Exits with 1 if any check fails.
+
+#include "OBJParser.h"
+#include "SyntheticMesh.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+	template<typename Function>
+	double BestSeconds(int runs, Function function)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() < best) best = elapsed.count();
+		}
+
+		return best;
+	}
+
+	template<typename T>
+	bool SameContents(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+	}
+
+	bool SameGroup(const ObjGroup& a, const ObjGroup& b)
+	{
+		return a.Name == b.Name && a.Material == b.Material && a.FirstCorner == b.FirstCorner && a.CornerCount == b.CornerCount;
+	}
+
+	bool SameData(const ObjData& a, const ObjData& b)
+	{
+		return SameContents(a.Positions, b.Positions) && SameContents(a.TexCoords, b.TexCoords) &&
+			SameContents(a.Normals, b.Normals) && SameContents(a.Corners, b.Corners) &&
+			std::equal(a.Groups.begin(), a.Groups.end(), b.Groups.begin(), b.Groups.end(), SameGroup) &&
+			a.MaterialLibraries == b.MaterialLibraries;
+	}
+
+	bool CheckGroups(ThreadPool& pool)
+	{
+		const char obj[] =
+			"mtllib car.mtl\n"
+			"mtllib textures/extra.mtl\n"
+			"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+			"f 1 2 3\n"
+			"o body\n"
+			"usemtl paint\n"
+			"f 1 2 3 4\n"
+			"g windows\n"
+			"usemtl glass\n"
+			"f 1 2 3\n"
+			"usemtl glass\n"
+			"f 1 3 4\n"
+			"g body\n"
+			"usemtl paint\n"
+			"f 2 3 4\n"
+			"usemtl unused\n"
+			"g tyres\n"
+			"f 1 2 4\n";
+
+		//Faces before any o/g or usemtl line have neither, the quad is two triangles, a repeated usemtl doesn't start a
+		//new group, a group that comes back later is a run of its own and a name set with no faces after it is left out
+		const ObjGroup expected[] =
+		{
+			{ "", "", 0, 3 },
+			{ "body", "paint", 3, 6 },
+			{ "windows", "glass", 9, 6 },
+			{ "body", "paint", 15, 3 },
+			{ "tyres", "unused", 18, 3 },
+		};
+
+		ObjData serial, parallel;
+		OBJParser::ParseBuffer(obj, sizeof(obj) - 1, serial);
+		OBJParser::ParseBufferParallel(obj, sizeof(obj) - 1, parallel, pool);
+
+		if (!std::equal(serial.Groups.begin(), serial.Groups.end(), std::begin(expected), std::end(expected), SameGroup) ||
+			serial.MaterialLibraries != std::vector<std::string>{ "car.mtl", "textures/extra.mtl" })
+		{
+			printf("groups: the o/g/usemtl/mtllib lines weren't read as expected\n");
+			return false;
+		}
+
+		if (!SameData(serial, parallel))
+		{
+			printf("groups: the parallel parse doesn't match the serial one\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Near(const MeshFloat3& a, float x, float y, float z)
+	{
+		return std::fabs(a.x - x) < 1e-6f && std::fabs(a.y - y) < 1e-6f && std::fabs(a.z - z) < 1e-6f;
+	}
+
+	bool CheckMaterials()
+	{
+		const char mtl[] =
+			"# before any newmtl, so it belongs to nothing\n"
+			"Kd 0 0 0\n"
+			"newmtl paint\n"
+			"Ka 0.1 0.2 0.3\n"
+			"Kd 0.5\n"
+			"Ks 1 0.5 0.25\n"
+			"Ns 32\n"
+			"map_Kd -s 1 1 1 textures/paint.dds\n"
+			"newmtl glass\n"
+			"\tTr 0.75\r\n"
+			"newmtl window frame\n"
+			"d 0.5\n"
+			"map_Kd frame.dds\n";
+
+		std::vector<ObjMaterial> materials;
+		OBJParser::ParseMaterialBuffer(mtl, sizeof(mtl) - 1, materials);
+
+		//Anything a material doesn't set keeps the MTL defaults
+		bool passed = materials.size() == 3 &&
+			materials[0].Name == "paint" && Near(materials[0].Ambient, 0.1f, 0.2f, 0.3f) && Near(materials[0].Diffuse, 0.5f, 0.5f, 0.5f) &&
+			Near(materials[0].Specular, 1.0f, 0.5f, 0.25f) && materials[0].SpecularPower == 32.0f && materials[0].Opacity == 1.0f &&
+			materials[0].DiffuseMap == "textures/paint.dds" &&
+			materials[1].Name == "glass" && Near(materials[1].Ambient, 0.2f, 0.2f, 0.2f) && Near(materials[1].Diffuse, 0.8f, 0.8f, 0.8f) &&
+			Near(materials[1].Specular, 1.0f, 1.0f, 1.0f) && materials[1].SpecularPower == 0.0f && std::fabs(materials[1].Opacity - 0.25f) < 1e-6f &&
+			materials[1].DiffuseMap.empty() &&
+			materials[2].Name == "window frame" && materials[2].Opacity == 0.5f && materials[2].DiffuseMap == "frame.dds";
+
+		if (!passed)
+		{
+			printf("materials: the .mtl records weren't read as expected\n");
+		}
+
+		return passed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string filename = "synthetic_parallel.obj";
+	bool generated = true;
+	size_t megabytes = 200;
+
+	if (argc > 1)
+	{
+		char* numberEnd = nullptr;
+		unsigned long requested = strtoul(argv[1], &numberEnd, 10);
+
+		if (numberEnd && *numberEnd == '\0' && requested > 0)
+		{
+			megabytes = requested;
+		}
+		else
+		{
+			filename = argv[1];
+			generated = false;
+		}
+	}
+
+	ThreadPool checkPool(3);
+	bool passed = CheckGroups(checkPool);
+	passed = CheckMaterials() && passed;
+
+	if (generated)
+	{
+		std::string text = MakeSyntheticObj(megabytes << 20, 64);
+		std::ofstream out(filename, std::ios::binary);
+		out.write(text.data(), text.size());
+	}
+
+	std::ifstream sizeCheck(filename, std::ios::binary | std::ios::ate);
+	double fileMegabytes = (double)sizeCheck.tellg() / (1024.0 * 1024.0);
+	sizeCheck.close();
+
+	printf("%s: %.1f MB, %u hardware threads\n", filename.c_str(), fileMegabytes, std::thread::hardware_concurrency());
+
+	const int runs = 3;
+	ObjData serial;
+	double serialSeconds = BestSeconds(runs, [&]() { OBJParser::ParseFile(filename.c_str(), serial); });
+
+	printf("%7s %10s %10s %8s\n", "threads", "seconds", "MB/s", "speedup");
+	printf("%7d %10.3f %10.1f %8.2f\n", 1, serialSeconds, fileMegabytes / serialSeconds, 1.0);
+
+	const unsigned int threadCounts[] = { 2, 4, 8, 16 };
+
+	for (unsigned int threads : threadCounts)
+	{
+		//The calling thread joins in, so the pool only needs the rest
+		ThreadPool pool(threads - 1);
+		ObjData parallel;
+
+		double seconds = BestSeconds(runs, [&]() { OBJParser::ParseFileParallel(filename.c_str(), parallel, pool); });
+
+		bool same = SameData(serial, parallel);
+		passed = same && passed;
+
+		printf("%7u %10.3f %10.1f %8.2f%s\n", threads, seconds, fileMegabytes / seconds, serialSeconds / seconds, same ? "" : "  MISMATCH");
+	}
+
+	if (generated)
+	{
+		std::remove(filename.c_str());
+	}
+
+	printf("%zu groups, %s\n", serial.Groups.size(), passed ? "every check passed" : "FAILED");
+	return passed ? 0 : 1;
+}
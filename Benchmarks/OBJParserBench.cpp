@@ -0,0 +1,143 @@
+//Headless throughput benchmark for OBJParser. Doesn't need D3D so it builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. OBJParserBench.cpp ../OBJParser.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o objparser_bench
+//
+//Usage: objparser_bench [file.obj ...]
+//With no arguments it generates a car.obj sized mesh (~1 MB) and one 10x larger, otherwise it times the given files.
+//Each input is parsed with the old ifstream/substr tokenizer and with the mapped in-place parser.
+
+#include "OBJParser.h"
+#include "SyntheticMesh.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	//The tokenizer OBJLoader::Load used before OBJParser, kept here as the baseline
+	size_t LegacyParse(const char* filename)
+	{
+		std::ifstream inFile(filename);
+		std::vector<MeshFloat3> verts;
+		std::vector<MeshFloat3> normals;
+		std::vector<MeshFloat2> texCoords;
+		std::vector<unsigned short> vertIndices;
+		std::vector<unsigned short> normalIndices;
+		std::vector<unsigned short> textureIndices;
+		std::string input;
+
+		while (inFile >> input)
+		{
+			if (input.compare("v") == 0)
+			{
+				MeshFloat3 vert;
+				inFile >> vert.x >> vert.y >> vert.z;
+				verts.push_back(vert);
+			}
+			else if (input.compare("vt") == 0)
+			{
+				MeshFloat2 texCoord;
+				inFile >> texCoord.x >> texCoord.y;
+				texCoord.y = 1.0f - texCoord.y;
+				texCoords.push_back(texCoord);
+			}
+			else if (input.compare("vn") == 0)
+			{
+				MeshFloat3 normal;
+				inFile >> normal.x >> normal.y >> normal.z;
+				normals.push_back(normal);
+			}
+			else if (input.compare("f") == 0)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					inFile >> input;
+					size_t slash = input.find("/");
+					size_t secondSlash = input.find("/", slash + 1);
+
+					vertIndices.push_back((unsigned short)(atoi(input.substr(0, slash).c_str()) - 1));
+					textureIndices.push_back((unsigned short)(atoi(input.substr(slash + 1, secondSlash - slash - 1).c_str()) - 1));
+					normalIndices.push_back((unsigned short)(atoi(input.substr(secondSlash + 1).c_str()) - 1));
+				}
+			}
+		}
+
+		return vertIndices.size();
+	}
+
+	size_t FileSize(const char* filename)
+	{
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		return file.good() ? (size_t)file.tellg() : 0;
+	}
+
+	template<typename Function>
+	double BestSeconds(int runs, Function function)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() < best) best = elapsed.count();
+		}
+
+		return best;
+	}
+
+	void BenchmarkFile(const char* filename, int runs)
+	{
+		double megabytes = FileSize(filename) / (1024.0 * 1024.0);
+
+		ObjData data;
+		size_t corners = 0;
+
+		double legacySeconds = BestSeconds(runs, [&]() { corners = LegacyParse(filename); });
+		double mappedSeconds = BestSeconds(runs, [&]() { OBJParser::ParseFile(filename, data); });
+
+		if (corners != data.Corners.size())
+		{
+			printf("  warning: legacy parser saw %zu face corners, OBJParser saw %zu\n", corners, data.Corners.size());
+		}
+
+		printf("%-28s %8.2f MB  %8zu tris | ifstream %8.1f MB/s | mapped %8.1f MB/s | %5.1fx\n",
+			filename, megabytes, data.Corners.size() / 3,
+			megabytes / legacySeconds, megabytes / mappedSeconds, legacySeconds / mappedSeconds);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int runs = 5;
+
+	if (argc > 1)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			BenchmarkFile(argv[i], runs);
+		}
+
+		return 0;
+	}
+
+	const size_t sizes[] = { 1 << 20, 10 << 20 };
+	const char* names[] = { "synthetic_car_sized.obj", "synthetic_10x.obj" };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		std::string text = MakeSyntheticObj(sizes[i]);
+
+		std::ofstream out(names[i], std::ios::binary);
+		out.write(text.data(), text.size());
+		out.close();
+
+		BenchmarkFile(names[i], runs);
+		std::remove(names[i]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+//Headless overdraw metric for MeshOptimizer::OptimizeOverdraw. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. OverdrawBench.cpp ../OBJParser.cpp ../MeshOptimizer.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o overdraw_bench
+//
+//Usage (from the repository root): overdraw_bench [-views N] [-threshold T] [file.obj | file.objBinary ...]
+//Defaults to car.objBinary and torusKnot.objBinary, see MeshInput.h. Each mesh is drawn by a small software rasterizer
+//from N views spread around it (16 by default) and the average overdraw and ACMR are reported for the file order,
+//the vertex cache order and the overdraw order at a range of thresholds, or just at T if one is given.
+
+#include "MeshInput.h"
+#include "MeshOptimizer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	void Report(const char* label, const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, uint32_t views, double milliseconds)
+	{
+		VertexCacheStats cache = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+		OverdrawStats overdraw = MeshOptimizer::AnalyzeOverdraw(indices, vertices, views);
+
+		printf("  %-16s | ACMR %6.3f | overdraw %6.3f | %8.2f ms\n", label, cache.Acmr, overdraw.Overdraw, milliseconds);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+	std::vector<float> thresholds = { 1.0f, 1.05f, 1.1f, 1.25f, 1.5f, 2.0f };
+	uint32_t views = MeshOptimizer::DefaultOverdrawViews;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-views") == 0 && i + 1 < argc)
+		{
+			views = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc)
+		{
+			thresholds.assign(1, (float)atof(argv[++i]));
+		}
+		else
+		{
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+	}
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+
+		printf("%s: %zu vertices, %zu triangles, %u views\n", input.c_str(), vertices.size(), indices.size() / 3, views);
+		Report("file order", indices, vertices, views, 0.0);
+
+		auto start = std::chrono::steady_clock::now();
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		std::chrono::duration<double, std::milli> cacheMs = std::chrono::steady_clock::now() - start;
+
+		Report("vertex cache", indices, vertices, views, cacheMs.count());
+
+		for (float threshold : thresholds)
+		{
+			std::vector<uint32_t> sorted = indices;
+
+			start = std::chrono::steady_clock::now();
+			MeshOptimizer::OptimizeOverdraw(sorted, vertices, threshold);
+			std::chrono::duration<double, std::milli> overdrawMs = std::chrono::steady_clock::now() - start;
+
+			char label[32];
+			snprintf(label, sizeof(label), "overdraw %.2f", threshold);
+			Report(label, sorted, vertices, views, overdrawMs.count());
+		}
+	}
+
+	return 0;
+}
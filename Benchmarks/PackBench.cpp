@@ -0,0 +1,223 @@
+//Compares startup reads of loose asset files against one mapped AssetPack, cold (out of the OS file cache) and warm.
+//Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. PackBench.cpp ../AssetPack.cpp ../Lz4.cpp ../ContentHash.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o pack_bench
+//
+//Usage (from the repository root): pack_bench [file ...]
+//Defaults to every asset the game loads plus the other textures and meshes in the repository. Two packs of those files
+//are written to the temporary directory, one stored and one with LZ4, then each way of loading is timed:
+//	loose		every file opened and read into its own heap buffer, like DDSTextureLoader's LoadTextureDataFromFile
+//	pack		one pack mapped, every entry found by name and its pages touched where it lies in the mapping
+//	pack lz4	the same, decompressing the entries that were compressed
+//Cold runs drop the files from the OS file cache first with posix_fadvise, which needs Linux and only works on files
+//that aren't dirty; elsewhere they're skipped. Times are the best of several runs.
+
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const int Runs = 5;
+
+	//Keeps the loads from being optimized away
+	volatile unsigned int Sink;
+
+	//Returns false if the OS can't be asked to forget a file
+	bool DropFromFileCache(const std::string& filename)
+	{
+#ifdef __linux__
+		int file = open(filename.c_str(), O_RDONLY);
+
+		if (file < 0)
+		{
+			return false;
+		}
+
+		//Dirty pages can't be dropped, and the packs were only just written
+		fdatasync(file);
+		bool dropped = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(file);
+		return dropped;
+#else
+		(void)filename;
+		return false;
+#endif
+	}
+
+	//Something depending on every page so none of the reads can be skipped
+	unsigned int Touch(const char* data, size_t size)
+	{
+		const volatile char* bytes = data;
+		unsigned int touched = 0;
+
+		for (size_t offset = 0; offset < size; offset += 4096)
+		{
+			touched += (unsigned char)bytes[offset];
+		}
+
+		return touched;
+	}
+
+	unsigned int LoadLoose(const std::vector<std::string>& filenames)
+	{
+		unsigned int touched = 0;
+
+		for (const std::string& filename : filenames)
+		{
+			std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+			std::vector<char> data((size_t)file.tellg());
+			file.seekg(0);
+			file.read(data.data(), data.size());
+			touched += Touch(data.data(), data.size());
+		}
+
+		return touched;
+	}
+
+	unsigned int LoadPack(const std::string& packFilename, const std::vector<std::string>& filenames)
+	{
+		AssetPack pack;
+		unsigned int touched = 0;
+
+		if (!pack.Open(packFilename.c_str()))
+		{
+			return 0;
+		}
+
+		for (const std::string& filename : filenames)
+		{
+			const AssetPackEntry* entry = pack.Find(filename.c_str());
+			const char* data;
+			size_t size;
+			std::vector<char> buffer;
+
+			if (entry && pack.Read(*entry, data, size, buffer))
+			{
+				touched += Touch(data, size);
+			}
+		}
+
+		return touched;
+	}
+
+	template <typename Load>
+	double BestOf(Load load, const std::vector<std::string>& dropFirst, bool& cold)
+	{
+		double best = 1e30;
+
+		for (int run = 0; run < Runs; ++run)
+		{
+			for (const std::string& filename : dropFirst)
+			{
+				cold = DropFromFileCache(filename) && cold;
+			}
+
+			Clock::time_point start = Clock::now();
+			Sink = Sink + load();
+			double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			best = std::min(best, milliseconds);
+		}
+
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filenames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		filenames.push_back(argv[i]);
+	}
+
+	if (filenames.empty())
+	{
+		filenames = { "values.xml", "DX11 Framework.fx", "star.objBinary", "car.objBinary", "Crate_COLOR.dds", "torusKnot.objBinary", "sphere.objBinary",
+			"Crate_NRM.dds", "Crate_SPEC.dds", "ChainLink.dds", "asphalt.dds", "asphalt_NORMAL.dds", "asphalt_SPEC.dds", "asphalt_DISP.dds" };
+	}
+
+	std::vector<std::unique_ptr<MappedFile>> files;
+	std::vector<AssetPackSource> stored;
+	std::vector<AssetPackSource> compressed;
+	uint64_t totalSize = 0;
+
+	for (const std::string& filename : filenames)
+	{
+		files.emplace_back(new MappedFile());
+
+		if (!files.back()->Open(filename.c_str()))
+		{
+			printf("%s could not be opened\n", filename.c_str());
+			return 1;
+		}
+
+		stored.push_back({ filename, files.back()->Data(), files.back()->Size(), false });
+		compressed.push_back({ filename, files.back()->Data(), files.back()->Size(), true });
+		totalSize += files.back()->Size();
+	}
+
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string storedPack = (directory / "pack_bench_stored.pack").string();
+	std::string compressedPack = (directory / "pack_bench_lz4.pack").string();
+	ThreadPool& pool = ThreadPool::Default();
+
+	if (!AssetPackBuilder::Write(storedPack.c_str(), stored, pool) || !AssetPackBuilder::Write(compressedPack.c_str(), compressed, pool))
+	{
+		printf("The packs could not be written\n");
+		return 1;
+	}
+
+	files.clear();
+
+	std::error_code error;
+	printf("%zu files, %llu bytes. Stored pack %llu bytes, LZ4 pack %llu bytes\n", filenames.size(), (unsigned long long)totalSize,
+		(unsigned long long)std::filesystem::file_size(storedPack, error), (unsigned long long)std::filesystem::file_size(compressedPack, error));
+
+	bool cold = true;
+	double looseCold = BestOf([&]() { return LoadLoose(filenames); }, filenames, cold);
+	double storedCold = BestOf([&]() { return LoadPack(storedPack, filenames); }, { storedPack }, cold);
+	double compressedCold = BestOf([&]() { return LoadPack(compressedPack, filenames); }, { compressedPack }, cold);
+
+	bool warm = true;
+	double looseWarm = BestOf([&]() { return LoadLoose(filenames); }, {}, warm);
+	double storedWarm = BestOf([&]() { return LoadPack(storedPack, filenames); }, {}, warm);
+	double compressedWarm = BestOf([&]() { return LoadPack(compressedPack, filenames); }, {}, warm);
+
+	printf("%-10s %12s %12s\n", "", "cold ms", "warm ms");
+
+	if (cold)
+	{
+		printf("%-10s %12.3f %12.3f\n", "loose", looseCold, looseWarm);
+		printf("%-10s %12.3f %12.3f\n", "pack", storedCold, storedWarm);
+		printf("%-10s %12.3f %12.3f\n", "pack lz4", compressedCold, compressedWarm);
+	}
+	else
+	{
+		printf("%-10s %12s %12.3f\n", "loose", "-", looseWarm);
+		printf("%-10s %12s %12.3f\n", "pack", "-", storedWarm);
+		printf("%-10s %12s %12.3f\n", "pack lz4", "-", compressedWarm);
+		printf("Cold runs need posix_fadvise, which isn't available here\n");
+	}
+
+	std::filesystem::remove(storedPack, error);
+	std::filesystem::remove(compressedPack, error);
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+//Test inputs shared by the benchmarks, so they don't depend on large assets being checked in
+
+//Writes a torus with positions, texture coordinates and normals, roughly bytes long. With rowsPerGroup the faces are
+//split into runs of that many rows, each starting with an "o" or "g" line and a "usemtl" line, cycling through a few
+//names so the same group and material come back later in the file
+inline std::string MakeSyntheticObj(size_t bytes, int rowsPerGroup = 0)
+{
+	//Each grid cell produces about 150 bytes of text (a vertex, uv, normal and two faces)
+	int side = (int)std::sqrt((double)bytes / 150.0);
+	if (side < 4) side = 4;
+
+	std::ostringstream out;
+	out.precision(6);
+	out << std::fixed;
+	out << "# synthetic torus " << side << "x" << side << "\n";
+
+	if (rowsPerGroup > 0)
+	{
+		out << "mtllib synthetic.mtl\n";
+	}
+
+	const float pi = 3.14159265f;
+
+	for (int i = 0; i < side; ++i)
+	{
+		for (int j = 0; j < side; ++j)
+		{
+			float u = (float)i / side * 2.0f * pi;
+			float v = (float)j / side * 2.0f * pi;
+			float nx = std::cos(u) * std::cos(v);
+			float ny = std::sin(v);
+			float nz = std::sin(u) * std::cos(v);
+
+			out << "v " << std::cos(u) * 3.0f + nx << " " << ny << " " << std::sin(u) * 3.0f + nz << "\n";
+			out << "vt " << (float)i / side << " " << (float)j / side << "\n";
+			out << "vn " << nx << " " << ny << " " << nz << "\n";
+		}
+	}
+
+	for (int i = 0; i < side; ++i)
+	{
+		if (rowsPerGroup > 0 && i % rowsPerGroup == 0)
+		{
+			int group = i / rowsPerGroup;
+			out << (group % 2 ? "g" : "o") << " part" << group % 5 << "\n";
+			out << "usemtl material" << group % 3 << "\n";
+		}
+
+		for (int j = 0; j < side; ++j)
+		{
+			int a = i * side + j + 1;
+			int b = ((i + 1) % side) * side + j + 1;
+			int c = ((i + 1) % side) * side + (j + 1) % side + 1;
+			int d = i * side + (j + 1) % side + 1;
+
+			out << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " " << c << "/" << c << "/" << c << "\n";
+			out << "f " << a << "/" << a << "/" << a << " " << c << "/" << c << "/" << c << " " << d << "/" << d << "/" << d << "\n";
+		}
+	}
+
+	return out.str();
+}
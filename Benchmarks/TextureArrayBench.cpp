@@ -0,0 +1,573 @@
+//Checks the Texture2DArray layouts TextureArray builds and counts the texture binds they save. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. TextureArrayBench.cpp ../TextureArray.cpp ../DDSFormat.cpp ../MappedFile.cpp -o texturearray_bench
+//
+//Usage (from the repository root): texturearray_bench [file.dds ...]
+//Defaults to every checked in texture. They're grouped into arrays the way Tools/TextureArrayCompiler.cpp does it, then
+//every level of every slice is compared with the texture's own box filtered mip chain, texel by texel, and the bytes are
+//compared with the textures' own files. Small copies of them (their mips of 64 texels and under) are tiled into shared
+//slices, where each level is checked the same way with the gutter wrapped around, and solid coloured tiles check that no
+//texel a clamped sample can reach at any level a tile is drawn from (see TextureArray::EdgeInset) holds any of another
+//tile. The manifest has to read back the same, and with the default textures the checked in TextureArray.xml and its
+//arrays have to match what they pack into now. Then the scene Application draws, in its order but with every bundled
+//texture on some object, is counted for texture binds a frame: one for each change of texture drawing them separately,
+//against the arrays' one.
+//Exits with 1 if any check fails.
+
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "TextureArray.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const uint32_t Gutter = 4;
+	const uint32_t TileSlice = 256;
+
+	struct SceneDraw
+	{
+		const char* Object;
+		const char* Texture;
+	};
+
+	//Application::Draw's objects in the order it draws them, the car split into a draw per material
+	const SceneDraw Scene[] =
+	{
+		{ "sun", "Crate_COLOR.dds" },
+		{ "planet1", "Crate_SPEC.dds" },
+		{ "car body", "Crate_COLOR.dds" },
+		{ "car windows", "ChainLink.dds" },
+		{ "car tyres", "asphalt_DISP.dds" },
+		{ "planet2", "asphalt_SPEC.dds" },
+		{ "moon1", "Crate_NRM.dds" },
+		{ "moon2", "asphalt_NORMAL.dds" },
+		{ "floor", "asphalt.dds" },
+		{ "star", "Crate_COLOR.dds" },
+	};
+
+	struct Texture
+	{
+		TextureArrayEntry Entry;
+		DXGI_FORMAT Format;
+		std::vector<uint8_t> Texels;
+	};
+
+	struct BuiltArray
+	{
+		TextureArrayLayout Layout;
+		std::vector<size_t> Textures;		//Into the textures it was built from, in entry order
+		std::vector<uint8_t> Texels;
+	};
+
+	uint32_t LevelSize(uint32_t size, uint32_t mip)
+	{
+		return std::max(size >> mip, 1u);
+	}
+
+	uint32_t FullMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t count = 1;
+
+		for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+		{
+			++count;
+		}
+
+		return count;
+	}
+
+	//A straightforward 2x2 box filter to check Compose's mips against, rounding odd sizes down the way D3D does
+	std::vector<uint8_t> Half(const std::vector<uint8_t>& texels, uint32_t width, uint32_t height)
+	{
+		uint32_t halfWidth = std::max(width / 2, 1u), halfHeight = std::max(height / 2, 1u);
+		std::vector<uint8_t> half((size_t)halfWidth * halfHeight * 4);
+
+		for (uint32_t y = 0; y < halfHeight; ++y)
+		{
+			for (uint32_t x = 0; x < halfWidth; ++x)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					uint32_t sum = 0;
+
+					for (uint32_t i = 0; i < 4; ++i)
+					{
+						uint32_t sx = std::min(x * 2 + i % 2, width - 1), sy = std::min(y * 2 + i / 2, height - 1);
+						sum += texels[((size_t)sy * width + sx) * 4 + c];
+					}
+
+					half[((size_t)y * halfWidth + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+				}
+			}
+		}
+
+		return half;
+	}
+
+	size_t LevelOffset(const TextureArrayLayout& layout, uint32_t slice, uint32_t mip)
+	{
+		size_t sliceBytes = 0, levelOffset = 0;
+
+		for (uint32_t level = 0; level < layout.MipCount; ++level)
+		{
+			levelOffset += level < mip ? (size_t)LevelSize(layout.Width, level) * LevelSize(layout.Height, level) * 4 : 0;
+			sliceBytes += (size_t)LevelSize(layout.Width, level) * LevelSize(layout.Height, level) * 4;
+		}
+
+		return sliceBytes * slice + levelOffset;
+	}
+
+	const uint8_t* ArrayTexel(const BuiltArray& array, uint32_t slice, uint32_t mip, uint32_t x, uint32_t y)
+	{
+		return &array.Texels[LevelOffset(array.Layout, slice, mip) + ((size_t)y * LevelSize(array.Layout.Width, mip) + x) * 4];
+	}
+
+	BuiltArray Build(const std::vector<Texture>& textures, const TextureArrayGroup& group, const char* file)
+	{
+		BuiltArray array;
+		std::vector<const uint8_t*> tops;
+		array.Layout = {};
+		array.Layout.File = file;
+		array.Layout.Format = group.Format;
+		array.Textures = group.Textures;
+
+		for (size_t i : group.Textures)
+		{
+			array.Layout.Entries.push_back(textures[i].Entry);
+			tops.push_back(textures[i].Texels.data());
+		}
+
+		if (TextureArray::Pack(group.Tiled ? Gutter : 0, TileSlice, array.Layout))
+		{
+			TextureArray::Compose(array.Layout, tops, array.Texels);
+		}
+		else
+		{
+			array.Layout.Entries.clear();
+		}
+
+		return array;
+	}
+
+	//Every level a texture's placed in on its own, gutter included (wrapped around), then the whole slice for the rest
+	bool CheckLevels(const BuiltArray& array, const std::vector<Texture>& textures)
+	{
+		const TextureArrayLayout& layout = array.Layout;
+		uint32_t placedMips = layout.MipCount;
+
+		if (layout.Gutter > 0)
+		{
+			placedMips = std::min((uint32_t)std::log2(layout.Gutter) + 1, layout.MipCount);
+		}
+
+		for (size_t i = 0; i < layout.Entries.size(); ++i)
+		{
+			const TextureArrayEntry& entry = layout.Entries[i];
+			std::vector<uint8_t> level = textures[array.Textures[i]].Texels;
+
+			for (uint32_t mip = 0; mip < placedMips; ++mip)
+			{
+				uint32_t width = LevelSize(entry.Width, mip), height = LevelSize(entry.Height, mip), gutter = layout.Gutter >> mip;
+
+				if (mip > 0)
+				{
+					level = Half(level, LevelSize(entry.Width, mip - 1), LevelSize(entry.Height, mip - 1));
+				}
+
+				for (int y = -(int)gutter; y < (int)(height + gutter); ++y)
+				{
+					for (int x = -(int)gutter; x < (int)(width + gutter); ++x)
+					{
+						const uint8_t* expected = &level[((size_t)((y + height) % height) * width + (x + width) % width) * 4];
+						const uint8_t* actual = ArrayTexel(array, entry.Slice, mip, (entry.X >> mip) + x, (entry.Y >> mip) + y);
+
+						if (memcmp(expected, actual, 4) != 0)
+						{
+							printf("%s: mip %u texel %d,%d doesn't match the texture\n", entry.Name.c_str(), mip, x, y);
+							return false;
+						}
+					}
+				}
+			}
+
+			//The transform has to take the centre of the texture's first texel to the centre of its tile's first texel
+			float transform[4];
+			TextureArray::UVTransform(layout, entry, transform);
+			float u = (0.5f / entry.Width * transform[0] + transform[2]) * layout.Width;
+			float v = (0.5f / entry.Height * transform[1] + transform[3]) * layout.Height;
+
+			if (u < entry.X + 0.49f || u > entry.X + 0.51f || v < entry.Y + 0.49f || v > entry.Y + 0.51f)
+			{
+				printf("%s: the uv transform misses the tile\n", entry.Name.c_str());
+				return false;
+			}
+		}
+
+		for (uint32_t slice = 0; slice < layout.SliceCount; ++slice)
+		{
+			for (uint32_t mip = placedMips; mip < layout.MipCount; ++mip)
+			{
+				uint32_t width = LevelSize(layout.Width, mip - 1), height = LevelSize(layout.Height, mip - 1);
+				std::vector<uint8_t> above(ArrayTexel(array, slice, mip - 1, 0, 0), ArrayTexel(array, slice, mip - 1, 0, 0) + (size_t)width * height * 4);
+				std::vector<uint8_t> expected = Half(above, width, height);
+
+				if (memcmp(expected.data(), ArrayTexel(array, slice, mip, 0, 0), expected.size()) != 0)
+				{
+					printf("%s: slice %u mip %u isn't the box filtered level above it\n", layout.File.c_str(), slice, mip);
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//Packs the tiles again as solid colours and checks every texel a sample clamped by EdgeInset filters from, at every
+	//level each tile is drawn from, is its own colour. Bilinear filtering reads the texels within one of the coordinate
+	bool CheckBleeding(const BuiltArray& array)
+	{
+		const TextureArrayLayout& layout = array.Layout;
+		std::vector<std::vector<uint8_t>> solid(layout.Entries.size());
+		std::vector<const uint8_t*> tops;
+		BuiltArray colours = array;
+
+		for (size_t i = 0; i < layout.Entries.size(); ++i)
+		{
+			solid[i].assign((size_t)layout.Entries[i].Width * layout.Entries[i].Height * 4, (uint8_t)(i * 30 + 20));
+			tops.push_back(solid[i].data());
+		}
+
+		TextureArray::Compose(layout, tops, colours.Texels);
+
+		for (size_t i = 0; i < layout.Entries.size(); ++i)
+		{
+			const TextureArrayEntry& entry = layout.Entries[i];
+
+			for (uint32_t mip = 0; mip <= TextureArray::MaxMip(layout, entry); ++mip)
+			{
+				double scale = 1.0 / (1u << mip), inset = TextureArray::EdgeInset(layout.Gutter, mip);
+				int x0 = (int)std::floor((entry.X + inset) * scale - 0.5), x1 = (int)std::floor((entry.X + entry.Width - inset) * scale - 0.5) + 1;
+				int y0 = (int)std::floor((entry.Y + inset) * scale - 0.5), y1 = (int)std::floor((entry.Y + entry.Height - inset) * scale - 0.5) + 1;
+
+				for (int y = y0; y <= y1; ++y)
+				{
+					for (int x = x0; x <= x1; ++x)
+					{
+						if (*ArrayTexel(colours, entry.Slice, mip, (uint32_t)x, (uint32_t)y) != (uint8_t)(i * 30 + 20))
+						{
+							printf("%s: mip %u texel %d,%d is filtered from another tile\n", entry.Name.c_str(), mip, x, y);
+							return false;
+						}
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool SameLayouts(const std::vector<TextureArrayLayout>& read, const std::vector<TextureArrayLayout>& layouts, const char* what)
+	{
+		if (read.size() != layouts.size())
+		{
+			printf("%s: has %zu arrays, not %zu\n", what, read.size(), layouts.size());
+			return false;
+		}
+
+		for (size_t l = 0; l < read.size(); ++l)
+		{
+			const TextureArrayLayout& a = read[l];
+			const TextureArrayLayout& b = layouts[l];
+
+			if (a.File != b.File || a.Format != b.Format || a.Width != b.Width || a.Height != b.Height || a.SliceCount != b.SliceCount ||
+				a.MipCount != b.MipCount || a.Gutter != b.Gutter || a.Entries.size() != b.Entries.size())
+			{
+				printf("%s: %s isn't the same\n", what, b.File.c_str());
+				return false;
+			}
+
+			for (size_t i = 0; i < a.Entries.size(); ++i)
+			{
+				const TextureArrayEntry& ea = a.Entries[i];
+				const TextureArrayEntry& eb = b.Entries[i];
+
+				if (ea.Name != eb.Name || ea.Slice != eb.Slice || ea.X != eb.X || ea.Y != eb.Y || ea.Width != eb.Width || ea.Height != eb.Height)
+				{
+					printf("%s: %s isn't the same\n", what, eb.Name.c_str());
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool CheckManifest(const std::vector<TextureArrayLayout>& layouts)
+	{
+		std::string text = TextureArrayXml::Write(layouts);
+		std::vector<char> buffer(text.begin(), text.end());
+		buffer.push_back('\0');
+		std::vector<TextureArrayLayout> read;
+
+		if (!TextureArrayXml::Parse(buffer.data(), read))
+		{
+			printf("manifest: didn't read back\n");
+			return false;
+		}
+
+		if (!SameLayouts(read, layouts, "manifest"))
+		{
+			return false;
+		}
+
+		//Lookups ignore directories and case, the way materials name their textures
+		if (!TextureArray::Find(read[0], ("textures\\" + read[0].Entries[0].Name).c_str()) || TextureArray::Find(read[0], "missing.dds"))
+		{
+			printf("manifest: Find didn't find the right textures\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	//The checked in TextureArray.xml and arrays Application loads have to be what packing the textures gives now, or
+	//they're stale and Benchmarks/Makefile's texture_arrays target has to be run again
+	bool CheckShipped(const std::vector<BuiltArray>& arrays)
+	{
+		MappedFile file;
+		std::vector<TextureArrayLayout> layouts, shipped;
+
+		if (!file.Open("TextureArray.xml"))
+		{
+			printf("shipped: there's no TextureArray.xml\n");
+			return false;
+		}
+
+		std::vector<char> text(file.Data(), file.Data() + file.Size());
+		text.push_back('\0');
+		file.Close();
+
+		for (const BuiltArray& array : arrays)
+		{
+			layouts.push_back(array.Layout);
+		}
+
+		if (!TextureArrayXml::Parse(text.data(), shipped) || !SameLayouts(shipped, layouts, "shipped TextureArray.xml"))
+		{
+			return false;
+		}
+
+		//Each array's texels are the end of its file, after the DDS headers
+		for (const BuiltArray& array : arrays)
+		{
+			if (!file.Open(array.Layout.File.c_str()) || file.Size() < array.Texels.size() ||
+				memcmp(file.Data() + file.Size() - array.Texels.size(), array.Texels.data(), array.Texels.size()) != 0)
+			{
+				printf("shipped: %s is missing or stale\n", array.Layout.File.c_str());
+				return false;
+			}
+
+			file.Close();
+		}
+
+		printf("shipped: TextureArray.xml and its %zu arrays are up to date\n", arrays.size());
+		return true;
+	}
+
+	//Texture binds a frame drawing the scene with a texture each, only binding when the texture changes, and with the
+	//arrays, which Application binds together in one call
+	void CountBinds(const std::vector<TextureArrayLayout>& layouts)
+	{
+		const char* bound = nullptr;
+		unsigned int separate = 0, arrays = 1, missing = 0;
+
+		for (const SceneDraw& draw : Scene)
+		{
+			if (!bound || strcmp(bound, draw.Texture) != 0)
+			{
+				++separate;
+				bound = draw.Texture;
+			}
+
+			//Textures that aren't in an array still need their own bind
+			bool found = false;
+
+			for (const TextureArrayLayout& layout : layouts)
+			{
+				found = found || TextureArray::Find(layout, draw.Texture);
+			}
+
+			if (!found)
+			{
+				++missing;
+				printf("binds: %s's %s isn't in an array\n", draw.Object, draw.Texture);
+			}
+		}
+
+		printf("binds: %zu draws with %u changes of texture, %u binds a frame drawn separately, %u with the arrays\n",
+			sizeof(Scene) / sizeof(Scene[0]), separate, separate, arrays + missing);
+	}
+
+	//The bytes of a texture's full mip chain
+	uint64_t FullChainBytes(uint32_t width, uint32_t height)
+	{
+		uint64_t bytes = 0;
+
+		for (uint32_t mip = 0; mip < FullMipCount(width, height); ++mip)
+		{
+			bytes += (uint64_t)LevelSize(width, mip) * LevelSize(height, mip) * 4;
+		}
+
+		return bytes;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filenames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		filenames.push_back(argv[i]);
+	}
+
+	if (filenames.empty())
+	{
+		filenames = { "Crate_COLOR.dds", "Crate_NRM.dds", "Crate_SPEC.dds", "ChainLink.dds", "asphalt.dds", "asphalt_DISP.dds", "asphalt_NORMAL.dds",
+			"asphalt_SPEC.dds" };
+	}
+
+	std::vector<Texture> textures, small;
+	uint64_t fileBytes = 0, fullChainBytes = 0;
+	bool passed = true;
+
+	for (const std::string& filename : filenames)
+	{
+		MappedFile file;
+		Texture texture;
+		texture.Entry = {};
+		texture.Entry.Name = filename;
+
+		if (!file.Open(filename.c_str()) || !TextureArray::ReadTexels((const uint8_t*)file.Data(), file.Size(), texture.Format, texture.Entry.Width,
+			texture.Entry.Height, texture.Texels))
+		{
+			printf("%s: couldn't be read as an 8 bit texture\n", filename.c_str());
+			passed = false;
+			continue;
+		}
+
+		fileBytes += file.Size();
+		fullChainBytes += FullChainBytes(texture.Entry.Width, texture.Entry.Height);
+
+		//A mip of 64 texels or under of each one, to tile
+		Texture tile = texture;
+		tile.Entry.Name = "small_" + filename;
+
+		while (tile.Entry.Width > 64 || tile.Entry.Height > 64)
+		{
+			tile.Texels = Half(tile.Texels, tile.Entry.Width, tile.Entry.Height);
+			tile.Entry.Width = std::max(tile.Entry.Width / 2, 1u);
+			tile.Entry.Height = std::max(tile.Entry.Height / 2, 1u);
+		}
+
+		textures.push_back(texture);
+		small.push_back(tile);
+	}
+
+	if (textures.empty())
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+
+	for (int tiled = 0; tiled < 2; ++tiled)
+	{
+		const std::vector<Texture>& set = tiled ? small : textures;
+		std::vector<TextureArrayEntry> entries;
+		std::vector<DXGI_FORMAT> formats;
+
+		for (const Texture& texture : set)
+		{
+			entries.push_back(texture.Entry);
+			formats.push_back(texture.Format);
+		}
+
+		Clock::time_point start = Clock::now();
+		std::vector<TextureArrayGroup> groups = TextureArray::Group(entries, formats, Gutter, TileSlice);
+		std::vector<BuiltArray> arrays;
+		std::vector<TextureArrayLayout> layouts;
+		size_t arrayBytes = 0;
+
+		for (const TextureArrayGroup& group : groups)
+		{
+			arrays.push_back(Build(set, group, ("TextureArray" + std::to_string(arrays.size()) + ".dds").c_str()));
+			arrayBytes += arrays.back().Texels.size();
+			layouts.push_back(arrays.back().Layout);
+
+			if (layouts.back().Entries.empty())
+			{
+				printf("pack: %s failed\n", layouts.back().File.c_str());
+				return 1;
+			}
+		}
+
+		double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		for (const BuiltArray& array : arrays)
+		{
+			const TextureArrayLayout& layout = array.Layout;
+			printf("%s %s: %zu textures in %u slices of %ux%u, %u mips, gutter %u, %zu bytes\n", tiled ? "tiles" : "pack ", layout.File.c_str(),
+				layout.Entries.size(), layout.SliceCount, layout.Width, layout.Height, layout.MipCount, layout.Gutter, array.Texels.size());
+
+			passed = CheckLevels(array, set) && passed;
+
+			if (layout.Gutter > 0)
+			{
+				passed = CheckBleeding(array) && passed;
+
+				for (const TextureArrayEntry& entry : layout.Entries)
+				{
+					printf("tiles %s: %ux%u drawn from mips 0-%u of %u\n", entry.Name.c_str(), entry.Width, entry.Height, TextureArray::MaxMip(layout, entry),
+						FullMipCount(entry.Width, entry.Height) - 1);
+				}
+			}
+		}
+
+		if (!tiled)
+		{
+			printf("pack: %zu bytes in %zu arrays against %llu in their own files, %llu with full mip chains, %.1f ms\n", arrayBytes, arrays.size(),
+				(unsigned long long)fileBytes, (unsigned long long)fullChainBytes, milliseconds);
+
+			//Every texture gets its own full chain, so the arrays can't be bigger than the textures would be with theirs
+			if (arrayBytes > fullChainBytes)
+			{
+				printf("pack: the arrays are bigger than the textures with full mip chains\n");
+				passed = false;
+			}
+
+			passed = CheckManifest(layouts) && passed;
+
+			if (argc == 1)
+			{
+				passed = CheckShipped(arrays) && passed;
+			}
+
+			CountBinds(layouts);
+		}
+		else if (arrays.size() != 1 || !arrays[0].Layout.Gutter)
+		{
+			printf("tiles: the small textures weren't tiled into one array\n");
+			passed = false;
+		}
+	}
+
+	printf("%s\n", passed ? "every check passed" : "FAILED");
+	return passed ? 0 : 1;
+}
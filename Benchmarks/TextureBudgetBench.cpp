@@ -0,0 +1,209 @@
+//Checks TextureBudget's accounting and eviction policy without a GPU, and measures what a Plan costs. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. TextureBudgetBench.cpp ../TextureBudget.cpp ../DDSFormat.cpp ../MappedFile.cpp -o texturebudget_bench
+//
+//Usage (from the repository root): texturebudget_bench [file.dds ...]
+//Defaults to the checked in textures. For each one the mip sizes TextureBudget::MipBytes works out from the header have to
+//add up to the pixel data in the file. Then a set of synthetic textures is put through the policy: over budget the least
+//recently used lose their biggest levels first, never go below their smallest level, and come back once the budget
+//grows. Then Plan is timed with thousands of textures, a different third of them drawn each frame.
+//Exits with 1 if any check fails.
+
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "TextureBudget.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	bool CheckFile(const char* filename)
+	{
+		MappedFile file;
+		const DDS_HEADER* header;
+		const uint8_t* bitData;
+		size_t bitSize;
+
+		if (!file.Open(filename) || !DDSFormat::ParseHeader((const uint8_t*)file.Data(), file.Size(), &header, &bitData, &bitSize))
+		{
+			printf("%s: couldn't be read as a DDS file\n", filename);
+			return false;
+		}
+
+		std::vector<uint64_t> mipBytes = TextureBudget::MipBytes(header);
+		uint64_t total = 0;
+
+		for (uint64_t bytes : mipBytes)
+		{
+			total += bytes;
+		}
+
+		printf("%s: %ux%u, %zu levels, %llu bytes by the header, %zu in the file\n", filename, header->width, header->height, mipBytes.size(),
+			(unsigned long long)total, bitSize);
+
+		if (mipBytes.empty() || total != bitSize)
+		{
+			printf("%s: the mip sizes don't match the file\n", filename);
+			return false;
+		}
+
+		return true;
+	}
+
+	//A square RGBA8 texture with a full mip chain, as MipBytes would give it
+	std::vector<uint64_t> SquareMips(uint32_t size)
+	{
+		std::vector<uint64_t> mipBytes;
+
+		for (; size > 0; size /= 2)
+		{
+			mipBytes.push_back((uint64_t)size * size * 4);
+		}
+
+		return mipBytes;
+	}
+
+	bool Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			printf("policy: %s\n", what);
+		}
+
+		return condition;
+	}
+
+	bool CheckPolicy()
+	{
+		TextureBudget budget;
+		std::vector<TextureBudgetChange> changes;
+
+		size_t a = budget.Add(SquareMips(1024));
+		size_t b = budget.Add(SquareMips(1024));
+		size_t c = budget.Add(SquareMips(1024));
+		uint64_t full = budget.ResidentBytes(a);
+		bool passed = true;
+
+		budget.Plan(changes);
+		passed = Expect(changes.empty() && budget.ResidentBytes() == full * 3, "no budget should keep everything") && passed;
+
+		//a and c are drawn, b isn't, so b goes first
+		budget.NextFrame();
+		budget.Touch(a);
+		budget.Touch(c);
+		budget.SetBudget(full * 5 / 2);
+		budget.Plan(changes);
+
+		passed = Expect(budget.ResidentBytes() <= full * 5 / 2, "over budget after a plan") && passed;
+		passed = Expect(budget.FirstMip(b) == 1 && budget.FirstMip(a) == 0 && budget.FirstMip(c) == 0, "the least recently used texture should lose one level") && passed;
+		passed = Expect(changes.size() == 1 && changes[0].Id == b && changes[0].FirstMip == 1, "only b should have changed") && passed;
+
+		//The same plan again changes nothing
+		budget.Plan(changes);
+		passed = Expect(changes.empty(), "a second plan on the same frame changed something") && passed;
+
+		//b goes first, then a, and c (used last) keeps the most
+		budget.NextFrame();
+		budget.Touch(c);
+		budget.SetBudget(full + full / 8);
+		budget.Plan(changes);
+
+		passed = Expect(budget.ResidentBytes() <= full + full / 8, "over a tight budget") && passed;
+		passed = Expect(budget.FirstMip(c) <= budget.FirstMip(a) && budget.FirstMip(a) <= budget.FirstMip(b), "recently used textures should keep the most") && passed;
+
+		//A budget nothing fits in leaves every texture at its smallest level
+		budget.SetBudget(1);
+		budget.Plan(changes);
+
+		for (size_t id : { a, b, c })
+		{
+			passed = Expect(budget.FirstMip(id) == budget.MipCount(id) - 1, "a texture went below its smallest level or stayed above it") && passed;
+		}
+
+		//Room again brings them all back
+		budget.SetBudget(full * 3);
+		budget.Plan(changes);
+		passed = Expect(changes.size() == 3 && budget.ResidentBytes() == full * 3, "the textures didn't come back once they fit") && passed;
+
+		//Removed ids are reused, and a new texture is planned like the others
+		budget.Remove(b);
+		size_t d = budget.Add(SquareMips(512));
+		passed = Expect(d == b && budget.FirstMip(d) == 0, "a removed id wasn't reused") && passed;
+
+		budget.SetBudget(full * 2);
+		budget.Plan(changes);
+		passed = Expect(budget.ResidentBytes() <= full * 2, "over budget with a new texture") && passed;
+
+		printf("policy: %s\n", passed ? "every check passed" : "FAILED");
+		return passed;
+	}
+
+	void MeasurePlan(size_t count)
+	{
+		TextureBudget budget;
+		std::vector<TextureBudgetChange> changes;
+		uint64_t total = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			budget.Add(SquareMips(64u << (i % 5)));
+			total += budget.ResidentBytes(i);
+		}
+
+		//Every frame a different third of the textures is drawn and the budget is half of what they'd need
+		budget.SetBudget(total / 2);
+		const int frames = 100;
+		size_t changed = 0;
+		Clock::time_point start = Clock::now();
+
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (size_t i = frame % 3; i < count; i += 3)
+			{
+				budget.Touch(i);
+			}
+
+			budget.Plan(changes);
+			budget.NextFrame();
+			changed += changes.size();
+		}
+
+		double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+		printf("plan: %zu textures, %.3f ms a frame, %.1f changes a frame\n", count, milliseconds, (double)changed / frames);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filenames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		filenames.push_back(argv[i]);
+	}
+
+	if (filenames.empty())
+	{
+		filenames = { "Crate_COLOR.dds", "Crate_NRM.dds", "Crate_SPEC.dds", "ChainLink.dds", "asphalt.dds", "asphalt_DISP.dds", "asphalt_NORMAL.dds",
+			"asphalt_SPEC.dds" };
+	}
+
+	bool passed = true;
+
+	for (const std::string& filename : filenames)
+	{
+		passed = CheckFile(filename.c_str()) && passed;
+	}
+
+	passed = CheckPolicy() && passed;
+
+	for (size_t count : { 100, 1000, 10000 })
+	{
+		MeasurePlan(count);
+	}
+
+	return passed ? 0 : 1;
+}
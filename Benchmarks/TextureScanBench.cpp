@@ -0,0 +1,468 @@
+//Checks DDSFormat::GetMetadata and TextureInventory against what's actually in DDS files, and times scanning thousands of
+//them. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. TextureScanBench.cpp ../TextureInventory.cpp ../DDSFormat.cpp ../ThreadPool.cpp ../MappedFile.cpp -pthread -o texturescan_bench
+//
+//Usage (from the repository root): texturescan_bench [-n files] [file.dds ...]
+//Defaults to the checked in textures and 5000 files. Each texture's metadata from its headers alone has to describe the
+//same mip chain FillInitData finds in the whole file, ending exactly where the file does. Then a temporary directory is
+//filled with synthetic textures, 2D, 1D, array, cube and volume, legacy and DX10 headers, uncompressed and block compressed,
+//with a few truncated or not DDS at all. Only the headers are written, the files are extended to their full size
+//without writing the pixels (sparse where the file system allows). Every entry a scan returns has to match what was
+//written, and the scan is timed on one thread and on every hardware thread. The directory is removed afterwards.
+//Exits with 1 if any check fails.
+
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "TextureInventory.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	//D3D11_RESOURCE_MISC_TEXTURECUBE
+	const uint32_t MiscTextureCube = 0x4;
+
+	struct Expected
+	{
+		std::string Path;
+		TextureInventoryStatus Status;
+		DDSMetadata Metadata;
+	};
+
+	bool CheckFile(const char* filename)
+	{
+		MappedFile file;
+		const DDS_HEADER* header;
+		const uint8_t* bitData;
+		size_t bitSize;
+		DDSMetadata metadata;
+
+		if (!file.Open(filename) || !DDSFormat::ParseHeader((const uint8_t*)file.Data(), file.Size(), &header, &bitData, &bitSize) ||
+			!DDSFormat::GetMetadataFromFile(filename, metadata))
+		{
+			printf("%s: couldn't be read as a DDS file\n", filename);
+			return false;
+		}
+
+		std::vector<DDSSubresource> subresources(metadata.mipLevels * metadata.arraySize);
+		size_t width, height, depth, skipMip;
+
+		if (DDSFormat::FillInitData(metadata.width, metadata.height, metadata.depth, metadata.mipLevels, metadata.arraySize, metadata.format, 0,
+			bitSize, bitData, width, height, depth, skipMip, subresources.data()) != DDS_LAYOUT_OK)
+		{
+			printf("%s: the metadata's mip chain doesn't fit the file\n", filename);
+			return false;
+		}
+
+		const DDSSubresource& last = subresources.back();
+		printf("%s: %zux%zu, format %u, %zu levels, %llu bytes by the headers, %zu in the file\n", filename, metadata.width, metadata.height,
+			(unsigned int)metadata.format, metadata.mipLevels, (unsigned long long)metadata.totalBytes, bitSize);
+
+		if (metadata.totalBytes != bitSize || last.data + last.slicePitch * metadata.depth != bitData + bitSize || width != header->width)
+		{
+			printf("%s: the metadata doesn't describe the file\n", filename);
+			return false;
+		}
+
+		return true;
+	}
+
+	//Worked out separately from GetSurfaceInfo, for the formats the synthetic files use
+	uint64_t TotalBytes(const DDSMetadata& metadata)
+	{
+		bool blocks = (metadata.format >= DXGI_FORMAT_BC1_TYPELESS && metadata.format <= DXGI_FORMAT_BC5_SNORM) ||
+			(metadata.format >= DXGI_FORMAT_BC6H_TYPELESS && metadata.format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+		bool halfBlocks = (metadata.format >= DXGI_FORMAT_BC1_TYPELESS && metadata.format <= DXGI_FORMAT_BC1_UNORM_SRGB) ||
+			(metadata.format >= DXGI_FORMAT_BC4_TYPELESS && metadata.format <= DXGI_FORMAT_BC4_SNORM);
+		uint64_t texelBytes = metadata.format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : metadata.format == DXGI_FORMAT_R8_UNORM ? 1 : 4;
+		uint64_t total = 0;
+
+		for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+		{
+			uint64_t width = std::max<size_t>(metadata.width >> mip, 1), height = std::max<size_t>(metadata.height >> mip, 1);
+			uint64_t depth = std::max<size_t>(metadata.depth >> mip, 1);
+			uint64_t bytes = blocks ? ((width + 3) / 4) * ((height + 3) / 4) * (halfBlocks ? 8 : 16) : width * height * texelBytes;
+			total += bytes * depth * metadata.arraySize;
+		}
+
+		return total;
+	}
+
+	//The i'th synthetic texture's headers, a different kind in turn, and what a scan should make of them
+	std::vector<uint8_t> MakeHeaders(size_t i, Expected& expected)
+	{
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = 0x1 | DDS_HEIGHT | DDS_WIDTH | 0x1000 | 0x20000;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.caps = 0x1000;
+
+		DDS_HEADER_DXT10 dxt10 = {};
+		bool dx10 = false;
+		DDSMetadata& metadata = expected.Metadata;
+		metadata = {};
+		metadata.width = (size_t)16 << (i % 7);
+		metadata.height = (size_t)16 << (i / 7 % 6);
+		metadata.depth = 1;
+		metadata.arraySize = 1;
+		metadata.dimension = DDS_DIMENSION_TEXTURE2D;
+		expected.Status = TextureInventoryOk;
+
+		switch (i % 8)
+		{
+		case 0:
+			//Legacy BGRA8 with a full mip chain, like the checked in textures
+			header.ddspf.flags = DDS_RGB | 0x1;
+			header.ddspf.RGBBitCount = 32;
+			header.ddspf.RBitMask = 0x00ff0000;
+			header.ddspf.GBitMask = 0x0000ff00;
+			header.ddspf.BBitMask = 0x000000ff;
+			header.ddspf.ABitMask = 0xff000000;
+			metadata.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+			for (size_t size = std::max(metadata.width, metadata.height); size > 0; size >>= 1)
+			{
+				++metadata.mipLevels;
+			}
+			break;
+
+		case 1:
+			//Legacy DXT1, one level
+			header.ddspf.flags = DDS_FOURCC;
+			header.ddspf.fourCC = MAKEFOURCC('D', 'X', 'T', '1');
+			metadata.format = DXGI_FORMAT_BC1_UNORM;
+			metadata.mipLevels = 1;
+			break;
+
+		case 2:
+			//Legacy cube map of DXT5
+			header.ddspf.flags = DDS_FOURCC;
+			header.ddspf.fourCC = MAKEFOURCC('D', 'X', 'T', '5');
+			header.caps2 = DDS_CUBEMAP_ALLFACES;
+			metadata.height = metadata.width;
+			metadata.format = DXGI_FORMAT_BC3_UNORM;
+			metadata.mipLevels = 4;
+			metadata.arraySize = 6;
+			metadata.isCubeMap = true;
+			break;
+
+		case 3:
+			//Legacy volume of R8
+			header.flags |= DDS_HEADER_FLAGS_VOLUME;
+			header.ddspf.flags = 0x20000;
+			header.ddspf.RGBBitCount = 8;
+			header.ddspf.RBitMask = 0xff;
+			metadata.width = metadata.height = 32;
+			metadata.depth = 8 + i % 24;
+			metadata.format = DXGI_FORMAT_R8_UNORM;
+			metadata.mipLevels = 5;
+			metadata.dimension = DDS_DIMENSION_TEXTURE3D;
+			break;
+
+		case 4:
+			//DX10 BC7 array
+			dx10 = true;
+			metadata.format = DXGI_FORMAT_BC7_UNORM_SRGB;
+			metadata.mipLevels = 3;
+			metadata.arraySize = 2 + i % 5;
+			break;
+
+		case 5:
+			//DX10 array of cube maps in half floats
+			dx10 = true;
+			dxt10.miscFlag = MiscTextureCube;
+			metadata.height = metadata.width;
+			metadata.format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+			metadata.mipLevels = 2;
+			metadata.arraySize = 6 * 2;
+			metadata.isCubeMap = true;
+			break;
+
+		case 6:
+			//DX10 1D BC4 strip, which isn't really a thing, but the sizes still have to add up
+			dx10 = true;
+			header.flags &= ~DDS_HEIGHT;
+			metadata.height = 1;
+			metadata.format = DXGI_FORMAT_BC4_UNORM;
+			metadata.mipLevels = 1;
+			metadata.dimension = DDS_DIMENSION_TEXTURE1D;
+			break;
+
+		default:
+			//DX10 BC5 normal map with an odd size
+			dx10 = true;
+			metadata.width += 3;
+			metadata.height += 5;
+			metadata.format = DXGI_FORMAT_BC5_UNORM;
+			metadata.mipLevels = 6;
+			break;
+		}
+
+		header.width = (uint32_t)metadata.width;
+		header.height = (uint32_t)metadata.height;
+		header.depth = metadata.dimension == DDS_DIMENSION_TEXTURE3D ? (uint32_t)metadata.depth : 0;
+		header.mipMapCount = (uint32_t)metadata.mipLevels;
+
+		if (dx10)
+		{
+			header.ddspf.flags = DDS_FOURCC;
+			header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+			dxt10.dxgiFormat = metadata.format;
+			dxt10.resourceDimension = metadata.dimension;
+			dxt10.arraySize = (uint32_t)(metadata.isCubeMap ? metadata.arraySize / 6 : metadata.arraySize);
+		}
+
+		metadata.totalBytes = TotalBytes(metadata);
+
+		std::vector<uint8_t> headers((const uint8_t*)&DDS_MAGIC, (const uint8_t*)&DDS_MAGIC + sizeof(DDS_MAGIC));
+		headers.insert(headers.end(), (const uint8_t*)&header, (const uint8_t*)&header + sizeof(header));
+
+		if (dx10)
+		{
+			headers.insert(headers.end(), (const uint8_t*)&dxt10, (const uint8_t*)&dxt10 + sizeof(dxt10));
+		}
+
+		return headers;
+	}
+
+	bool MakeDirectory(const std::filesystem::path& directory, size_t count, std::vector<Expected>& expected)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			Expected file;
+			std::vector<uint8_t> headers = MakeHeaders(i, file);
+			uint64_t size = headers.size() + file.Metadata.totalBytes;
+
+			//Every so often a file that was cut short, and one that only has a .dds name
+			if (i % 97 == 13)
+			{
+				size -= 1;
+				file.Status = TextureInventoryTruncated;
+			}
+			else if (i % 101 == 17)
+			{
+				headers[0] = 'X';
+				file.Metadata = {};
+				file.Status = TextureInventoryUnsupported;
+			}
+
+			std::filesystem::path directoryPath = directory / ("set" + std::to_string(i % 40)) / (i % 3 == 0 ? "mips" : "");
+			std::filesystem::path path = directoryPath / ("texture" + std::to_string(i) + (i % 10 == 0 ? ".DDS" : ".dds"));
+			std::error_code error;
+			std::filesystem::create_directories(directoryPath, error);
+
+			{
+				std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+				out.write((const char*)headers.data(), (std::streamsize)headers.size());
+
+				if (!out.good())
+				{
+					return false;
+				}
+			}
+
+			std::filesystem::resize_file(path, size, error);
+
+			if (error)
+			{
+				return false;
+			}
+
+			file.Path = path.string();
+			expected.push_back(file);
+		}
+
+		//Files a scan has to leave alone
+		std::ofstream((directory / "set0" / "readme.txt").string()) << "not a texture";
+		std::ofstream((directory / "set1" / "texture.dds.bak").string()) << "not a texture either";
+
+		std::sort(expected.begin(), expected.end(), [](const Expected& a, const Expected& b) { return a.Path < b.Path; });
+		return true;
+	}
+
+	bool Same(const DDSMetadata& a, const DDSMetadata& b)
+	{
+		return a.width == b.width && a.height == b.height && a.depth == b.depth && a.arraySize == b.arraySize && a.mipLevels == b.mipLevels &&
+			a.format == b.format && (a.dimension == b.dimension || a.totalBytes == 0) && a.isCubeMap == b.isCubeMap && a.totalBytes == b.totalBytes;
+	}
+
+	bool CheckScan(const std::vector<TextureInventoryEntry>& entries, const std::vector<Expected>& expected)
+	{
+		if (entries.size() != expected.size())
+		{
+			printf("scan: found %zu textures, %zu were written\n", entries.size(), expected.size());
+			return false;
+		}
+
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			if (entries[i].Path != expected[i].Path || entries[i].Status != expected[i].Status || !Same(entries[i].Metadata, expected[i].Metadata))
+			{
+				printf("scan: %s doesn't match what was written\n", expected[i].Path.c_str());
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool CheckRejects()
+	{
+		//What DDSTextureLoader refuses, GetMetadata has to refuse too
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = DDS_HEIGHT | DDS_WIDTH;
+		header.width = header.height = 64;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		struct Reject
+		{
+			const char* Name;
+			DXGI_FORMAT Format;
+			uint32_t Dimension;
+			uint32_t ArraySize;
+			uint32_t Caps2;
+		};
+
+		const Reject rejects[] =
+		{
+			{ "no array slices", DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 0, 0 },
+			{ "a palette format", DXGI_FORMAT_P8, DDS_DIMENSION_TEXTURE2D, 1, 0 },
+			{ "an unknown format", DXGI_FORMAT_UNKNOWN, DDS_DIMENSION_TEXTURE2D, 1, 0 },
+			{ "a buffer", DXGI_FORMAT_BC1_UNORM, 1, 1, 0 },
+			{ "a 1D texture 64 high", DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE1D, 1, 0 },
+			{ "a volume without the volume flag", DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE3D, 1, 0 },
+		};
+
+		for (const Reject& reject : rejects)
+		{
+			uint8_t buffer[sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)];
+			DDS_HEADER_DXT10 dxt10 = {};
+			dxt10.dxgiFormat = reject.Format;
+			dxt10.resourceDimension = reject.Dimension;
+			dxt10.arraySize = reject.ArraySize;
+			memcpy(buffer, &header, sizeof(header));
+			memcpy(buffer + sizeof(header), &dxt10, sizeof(dxt10));
+			DDSMetadata metadata;
+
+			if (DDSFormat::GetMetadata((const DDS_HEADER*)buffer, metadata))
+			{
+				printf("rejects: %s was accepted\n", reject.Name);
+				return false;
+			}
+		}
+
+		//A legacy cube map missing a face, and a mip count no texture can have
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', 'T', '1');
+		header.caps2 = (DDS_CUBEMAP_ALLFACES & ~DDS_CUBEMAP_NEGATIVEZ) | DDS_CUBEMAP;
+		DDSMetadata metadata;
+
+		if (DDSFormat::GetMetadata(&header, metadata))
+		{
+			printf("rejects: a cube map with five faces was accepted\n");
+			return false;
+		}
+
+		header.caps2 = 0;
+		header.mipMapCount = 0xffffffff;
+
+		if (DDSFormat::GetMetadata(&header, metadata))
+		{
+			printf("rejects: 4 billion mips were accepted\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	double TimeScan(const std::string& directory, ThreadPool& pool, std::vector<TextureInventoryEntry>& entries, bool& found)
+	{
+		double best = 1e30;
+
+		//Best of a few, the first one also warms the file system's caches
+		for (int run = 0; run < 5; ++run)
+		{
+			Clock::time_point start = Clock::now();
+			found = TextureInventory::Scan({ directory }, pool, entries);
+			best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filenames;
+	size_t count = 5000;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-n" && i + 1 < argc) count = (size_t)atoi(argv[++i]);
+		else filenames.push_back(argument);
+	}
+
+	if (filenames.empty())
+	{
+		filenames = { "Crate_COLOR.dds", "Crate_NRM.dds", "Crate_SPEC.dds", "ChainLink.dds", "asphalt.dds", "asphalt_DISP.dds", "asphalt_NORMAL.dds",
+			"asphalt_SPEC.dds" };
+	}
+
+	bool passed = true;
+
+	for (const std::string& filename : filenames)
+	{
+		passed = CheckFile(filename.c_str()) && passed;
+	}
+
+	passed = CheckRejects() && passed;
+
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / ("texturescan_bench_" + std::to_string(Clock::now().time_since_epoch().count()));
+	std::vector<Expected> expected;
+
+	if (!MakeDirectory(directory, count, expected))
+	{
+		printf("scan: couldn't write the synthetic textures to %s\n", directory.string().c_str());
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+		return 1;
+	}
+
+	uint64_t totalBytes = 0;
+
+	for (const Expected& file : expected)
+	{
+		totalBytes += file.Metadata.totalBytes;
+	}
+
+	ThreadPool serial(1), parallel;
+	std::vector<TextureInventoryEntry> serialEntries, parallelEntries;
+	bool serialFound, parallelFound;
+	double serialMilliseconds = TimeScan(directory.string(), serial, serialEntries, serialFound);
+	double parallelMilliseconds = TimeScan(directory.string(), parallel, parallelEntries, parallelFound);
+
+	printf("scan: %zu textures, %.1f MB of pixels, %.2f ms on 1 thread, %.2f ms on %u (%.1fx), %.2f us a texture\n", expected.size(),
+		totalBytes / (1024.0 * 1024.0), serialMilliseconds, parallelMilliseconds, parallel.ThreadCount(), serialMilliseconds / parallelMilliseconds,
+		1000.0 * parallelMilliseconds / std::max<size_t>(expected.size(), 1));
+
+	passed = serialFound && parallelFound && CheckScan(serialEntries, expected) && CheckScan(parallelEntries, expected) && passed;
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	printf("%s\n", passed ? "every check passed" : "FAILED");
+	return passed ? 0 : 1;
+}
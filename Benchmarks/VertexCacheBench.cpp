@@ -0,0 +1,72 @@
+//Reports what MeshOptimizer does to post-transform vertex cache efficiency. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. VertexCacheBench.cpp ../OBJParser.cpp ../MeshOptimizer.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o vertexcache_bench
+//
+//Usage (from the repository root): vertexcache_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary and torusKnot.objBinary, see MeshInput.h. Each mesh is welded the way OBJLoader does,
+//then ACMR/ATVR are reported for FIFO caches of a few sizes, in file order and after OptimizeVertexCache.
+
+#include "MeshInput.h"
+#include "MeshOptimizer.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+	}
+
+	const uint32_t cacheSizes[] = { 8, 16, 32 };
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+
+		std::vector<uint32_t> optimized = indices;
+		std::vector<MeshVertex> optimizedVertices = vertices;
+
+		auto start = std::chrono::steady_clock::now();
+		MeshOptimizer::OptimizeVertexCache(optimized, vertices.size());
+		std::chrono::duration<double, std::milli> cacheMs = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		MeshOptimizer::OptimizeVertexFetch(optimizedVertices, optimized);
+		std::chrono::duration<double, std::milli> fetchMs = std::chrono::steady_clock::now() - start;
+
+		printf("%s: %zu vertices, %zu triangles, vertex cache pass %.2f ms, vertex fetch pass %.2f ms\n",
+			input.c_str(), vertices.size(), indices.size() / 3, cacheMs.count(), fetchMs.count());
+		printf("  %5s | %8s %8s | %8s %8s\n", "cache", "ACMR", "ATVR", "ACMR", "ATVR");
+		printf("  %5s | %17s | %17s\n", "", "file order", "optimized");
+
+		for (uint32_t cacheSize : cacheSizes)
+		{
+			VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), cacheSize);
+			VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(optimized, optimizedVertices.size(), cacheSize);
+
+			printf("  %5u | %8.3f %8.3f | %8.3f %8.3f\n", cacheSize, before.Acmr, before.Atvr, after.Acmr, after.Atvr);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+//Headless benchmark for OBJParser::CreateIndices. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. VertexDedupBench.cpp ../OBJParser.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o vertexdedup_bench
+//
+//Usage (from the repository root): vertexdedup_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary and torusKnot.objBinary, see MeshInput.h.
+//Reports the vertex count and indexing time without dedup (the old behaviour), with the std::map keyed dedup the
+//old code had commented out, and with the hash table.
+
+#include "MeshInput.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct MapKey
+	{
+		MeshVertex Vertex;
+
+		bool operator<(const MapKey& other) const
+		{
+			return memcmp(&Vertex, &other.Vertex, sizeof(MeshVertex)) < 0;
+		}
+	};
+
+	//What OBJLoader did before: expand every corner and give it its own vertex
+	size_t IndexWithoutDedup(const ObjData& data, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+	{
+		std::vector<MeshFloat3> expandedVertices;
+		std::vector<MeshFloat3> expandedNormals;
+		std::vector<MeshFloat2> expandedTexCoords;
+
+		for (const ObjFaceCorner& corner : data.Corners)
+		{
+			expandedVertices.push_back(data.Positions[corner.Position]);
+			expandedTexCoords.push_back(data.TexCoords[corner.TexCoord]);
+			expandedNormals.push_back(data.Normals[corner.Normal]);
+		}
+
+		outVertices.clear();
+		outIndices.clear();
+
+		for (size_t i = 0; i < expandedVertices.size(); ++i)
+		{
+			outVertices.push_back({ expandedVertices[i], expandedNormals[i], expandedTexCoords[i] });
+			outIndices.push_back((uint32_t)i);
+		}
+
+		return outVertices.size();
+	}
+
+	size_t IndexWithMap(const ObjData& data, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+	{
+		std::map<MapKey, uint32_t> vertToIndexMap;
+
+		outVertices.clear();
+		outIndices.clear();
+
+		for (const ObjFaceCorner& corner : data.Corners)
+		{
+			MapKey key = { { data.Positions[corner.Position], data.Normals[corner.Normal], data.TexCoords[corner.TexCoord] } };
+			auto result = vertToIndexMap.insert(std::make_pair(key, (uint32_t)outVertices.size()));
+
+			if (result.second)
+			{
+				outVertices.push_back(key.Vertex);
+			}
+
+			outIndices.push_back(result.first->second);
+		}
+
+		return outVertices.size();
+	}
+
+	template<typename Function>
+	double BestMilliseconds(int runs, Function function)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() < best) best = elapsed.count();
+		}
+
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+	}
+
+	const int runs = 10;
+
+	printf("%-22s %9s | %9s %9s | %9s %9s | %9s %9s\n", "mesh", "corners", "old verts", "old ms", "map verts", "map ms", "hash verts", "hash ms");
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%-22s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		size_t oldVertices = 0;
+		size_t mapVertices = 0;
+
+		double oldMs = BestMilliseconds(runs, [&]() { oldVertices = IndexWithoutDedup(data, vertices, indices); });
+		double mapMs = BestMilliseconds(runs, [&]() { mapVertices = IndexWithMap(data, vertices, indices); });
+		double hashMs = BestMilliseconds(runs, [&]() { OBJParser::CreateIndices(data, vertices, indices); });
+
+		printf("%-22s %9zu | %9zu %9.3f | %9zu %9.3f | %9zu %9.3f  (%.1f%% fewer vertices)\n",
+			input.c_str(), data.Corners.size(), oldVertices, oldMs, mapVertices, mapMs, vertices.size(), hashMs,
+			100.0 * (1.0 - (double)vertices.size() / oldVertices));
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+//Error report for VertexQuantizer. Builds anywhere, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. VertexQuantizeBench.cpp ../OBJParser.cpp ../VertexQuantizer.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o vertexquantize_bench
+//
+//Usage (from the repository root): vertexquantize_bench [file.obj | file.objBinary ...]
+//Defaults to car.objBinary, star.objBinary, sphere.objBinary and torusKnot.objBinary, see MeshInput.h. Prints the vertex
+//buffer size before and after quantizing and the largest position, normal and texture coordinate error.
+
+#include "MeshInput.h"
+#include "VertexQuantizer.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		inputs.push_back("car.objBinary");
+		inputs.push_back("star.objBinary");
+		inputs.push_back("sphere.objBinary");
+		inputs.push_back("torusKnot.objBinary");
+	}
+
+	printf("%-22s %8s %9s %9s | %10s %9s %9s %10s | %7s\n", "mesh", "vertices", "float KB", "packed KB",
+		"pos error", "of bounds", "normal", "uv error", "ms");
+
+	for (const std::string& input : inputs)
+	{
+		ObjData data;
+
+		if (!LoadMeshInput(input, data))
+		{
+			printf("%-22s could not be loaded\n", input.c_str());
+			continue;
+		}
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		OBJParser::CreateIndices(data, vertices, indices);
+
+		auto start = std::chrono::steady_clock::now();
+		VertexQuantization quantization = VertexQuantizer::ComputeQuantization(vertices);
+		std::vector<QuantizedVertex> quantized;
+		VertexQuantizer::Quantize(vertices, quantization, quantized);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		QuantizationError error = VertexQuantizer::MeasureError(vertices, quantized, quantization);
+
+		printf("%-22s %8zu %9.1f %9.1f | %10.6f %8.5f%% %8.4fdeg %10.7f | %7.3f\n", input.c_str(), vertices.size(),
+			vertices.size() * sizeof(MeshVertex) / 1024.0, quantized.size() * sizeof(QuantizedVertex) / 1024.0,
+			error.MaxPosition, error.MaxPositionRelative * 100.0f, error.MaxNormalDegrees, error.MaxTexCoord, elapsed.count());
+	}
+
+	return 0;
+}
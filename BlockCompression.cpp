@@ -0,0 +1,734 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//A block's pixels a channel at a time, which is the layout the palette match works on
+	struct Block
+	{
+		float Channels[4][16];
+	};
+
+	//How far towards the second endpoint each palette entry is
+	const float ColourWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	const float SingleWeights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//Least squares refinements after the principal axis, each only kept if it lowers the error
+	const int Refinements = 2;
+
+	Block Load(const uint8_t* pixels, const int* channels, int channelCount)
+	{
+		Block block;
+
+		for (int c = 0; c < channelCount; ++c)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				block.Channels[c][i] = pixels[i * 4 + channels[c]];
+			}
+		}
+
+		return block;
+	}
+
+	//Picks each pixel's closest palette entry and returns the block's total squared error
+	float MatchPalette(const Block& block, int channelCount, const float (*palette)[4], int paletteSize, uint8_t* indices)
+	{
+		float total = 0.0f;
+
+#ifdef BLOCK_COMPRESSION_SSE2
+		for (int group = 0; group < 16; group += 4)
+		{
+			__m128 pixels[4];
+
+			for (int c = 0; c < channelCount; ++c)
+			{
+				pixels[c] = _mm_loadu_ps(&block.Channels[c][group]);
+			}
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+
+			for (int p = 0; p < paletteSize; ++p)
+			{
+				__m128 distance = _mm_setzero_ps();
+
+				for (int c = 0; c < channelCount; ++c)
+				{
+					__m128 d = _mm_sub_ps(pixels[c], _mm_set1_ps(palette[p][c]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(d, d));
+				}
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			float errors[4];
+			int32_t chosen[4];
+			_mm_storeu_ps(errors, best);
+			_mm_storeu_si128((__m128i*)chosen, bestIndex);
+
+			for (int i = 0; i < 4; ++i)
+			{
+				indices[group + i] = (uint8_t)chosen[i];
+				total += errors[i];
+			}
+		}
+#else
+		for (int i = 0; i < 16; ++i)
+		{
+			float best = FLT_MAX;
+
+			for (int p = 0; p < paletteSize; ++p)
+			{
+				float distance = 0.0f;
+
+				for (int c = 0; c < channelCount; ++c)
+				{
+					float d = block.Channels[c][i] - palette[p][c];
+					distance += d * d;
+				}
+
+				if (distance < best)
+				{
+					best = distance;
+					indices[i] = (uint8_t)p;
+				}
+			}
+
+			total += best;
+		}
+#endif
+
+		return total;
+	}
+
+	//The ends of the line through the block's colours along their principal axis, found by power iteration
+	void PrincipalEndpoints(const Block& block, int channelCount, float* e0, float* e1)
+	{
+		float mean[4] = {}, axis[4] = {}, covariance[4][4] = {};
+
+		for (int c = 0; c < channelCount; ++c)
+		{
+			float minimum = FLT_MAX, maximum = -FLT_MAX;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				mean[c] += block.Channels[c][i] / 16.0f;
+				minimum = std::min(minimum, block.Channels[c][i]);
+				maximum = std::max(maximum, block.Channels[c][i]);
+			}
+
+			axis[c] = maximum - minimum;
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int a = 0; a < channelCount; ++a)
+			{
+				for (int b = 0; b < channelCount; ++b)
+				{
+					covariance[a][b] += (block.Channels[a][i] - mean[a]) * (block.Channels[b][i] - mean[b]);
+				}
+			}
+		}
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+
+			for (int a = 0; a < channelCount; ++a)
+			{
+				for (int b = 0; b < channelCount; ++b)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+
+				length += next[a] * next[a];
+			}
+
+			//A flat block, or one the starting guess is perpendicular to, keeps the guess
+			if (length < 1e-12f)
+			{
+				break;
+			}
+
+			for (int c = 0; c < channelCount; ++c)
+			{
+				axis[c] = next[c] / sqrtf(length);
+			}
+		}
+
+		float length = 0.0f;
+
+		for (int c = 0; c < channelCount; ++c)
+		{
+			length += axis[c] * axis[c];
+		}
+
+		float minimum = 0.0f, maximum = 0.0f;
+
+		if (length > 1e-12f)
+		{
+			for (int c = 0; c < channelCount; ++c)
+			{
+				axis[c] /= sqrtf(length);
+			}
+
+			minimum = FLT_MAX;
+			maximum = -FLT_MAX;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float t = 0.0f;
+
+				for (int c = 0; c < channelCount; ++c)
+				{
+					t += (block.Channels[c][i] - mean[c]) * axis[c];
+				}
+
+				minimum = std::min(minimum, t);
+				maximum = std::max(maximum, t);
+			}
+		}
+
+		for (int c = 0; c < channelCount; ++c)
+		{
+			e0[c] = std::min(std::max(mean[c] + minimum * axis[c], 0.0f), 255.0f);
+			e1[c] = std::min(std::max(mean[c] + maximum * axis[c], 0.0f), 255.0f);
+		}
+	}
+
+	//The endpoints that best fit the pixels for the indices they were given. Returns false if the indices don't pin them down
+	bool LeastSquaresEndpoints(const Block& block, int channelCount, const uint8_t* indices, const float* weights, float* e0, float* e1)
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float b = weights[indices[i]];
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+
+			for (int c = 0; c < channelCount; ++c)
+			{
+				ax[c] += a * block.Channels[c][i];
+				bx[c] += b * block.Channels[c][i];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+
+		if (fabsf(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (int c = 0; c < channelCount; ++c)
+		{
+			e0[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+			e1[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+		}
+
+		return true;
+	}
+
+	int Quantize(float value, int maximum)
+	{
+		return std::min(std::max((int)(value * maximum / 255.0f + 0.5f), 0), maximum);
+	}
+
+	uint16_t To565(const float* colour)
+	{
+		return (uint16_t)((Quantize(colour[0], 31) << 11) | (Quantize(colour[1], 63) << 5) | Quantize(colour[2], 31));
+	}
+
+	void Expand565(uint16_t colour, int* out)
+	{
+		int r = colour >> 11, g = (colour >> 5) & 63, b = colour & 31;
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	//The four colour palette, what the GPU uses for BC1 when c0 > c1 and always for BC3
+	void ColourPalette(uint16_t c0, uint16_t c1, float (*palette)[4])
+	{
+		int a[3], b[3];
+		Expand565(c0, a);
+		Expand565(c1, b);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[0][c] = (float)a[c];
+			palette[1][c] = (float)b[c];
+			palette[2][c] = (float)((2 * a[c] + b[c]) / 3);
+			palette[3][c] = (float)((a[c] + 2 * b[c]) / 3);
+		}
+	}
+
+	void EncodeColour(const Block& block, uint8_t* out)
+	{
+		float e0[4], e1[4], palette[4][4];
+		uint8_t indices[16], bestIndices[16];
+		uint16_t best0 = 0, best1 = 0;
+		float bestError = FLT_MAX;
+
+		PrincipalEndpoints(block, 3, e0, e1);
+
+		for (int iteration = 0; iteration <= Refinements; ++iteration)
+		{
+			uint16_t c0 = To565(e0), c1 = To565(e1);
+			ColourPalette(c0, c1, palette);
+			float error = MatchPalette(block, 3, palette, 4, indices);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				best0 = c0;
+				best1 = c1;
+				memcpy(bestIndices, indices, 16);
+			}
+
+			if (error == 0.0f || !LeastSquaresEndpoints(block, 3, indices, ColourWeights, e0, e1))
+			{
+				break;
+			}
+		}
+
+		//c0 > c1 picks the four colour palette in BC1, swapping the endpoints swaps the palette's ends and middles
+		if (best0 < best1)
+		{
+			std::swap(best0, best1);
+
+			for (uint8_t& index : bestIndices)
+			{
+				index ^= 1;
+			}
+		}
+		else if (best0 == best1)
+		{
+			memset(bestIndices, 0, 16);
+		}
+
+		uint32_t bits = 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			bits |= (uint32_t)bestIndices[i] << (i * 2);
+		}
+
+		memcpy(out, &best0, 2);
+		memcpy(out + 2, &best1, 2);
+		memcpy(out + 4, &bits, 4);
+	}
+
+	//The eight value BC4 palette, used when a0 > a1
+	void SinglePalette(int a0, int a1, float (*palette)[4])
+	{
+		palette[0][0] = (float)a0;
+		palette[1][0] = (float)a1;
+
+		for (int i = 2; i < 8; ++i)
+		{
+			palette[i][0] = (float)(((8 - i) * a0 + (i - 1) * a1) / 7);
+		}
+	}
+
+	void EncodeSingle(const Block& block, uint8_t* out)
+	{
+		float e0[4] = { 0.0f }, e1[4] = { 255.0f }, palette[8][4];
+		uint8_t indices[16], bestIndices[16];
+		int best0 = 0, best1 = 0;
+		float bestError = FLT_MAX;
+
+		//One channel's principal axis is just its range, highest first
+		for (int i = 0; i < 16; ++i)
+		{
+			e0[0] = std::max(e0[0], block.Channels[0][i]);
+			e1[0] = std::min(e1[0], block.Channels[0][i]);
+		}
+
+		for (int iteration = 0; iteration <= Refinements; ++iteration)
+		{
+			int a0 = Quantize(e0[0], 255), a1 = Quantize(e1[0], 255);
+			SinglePalette(a0, a1, palette);
+			float error = MatchPalette(block, 1, palette, 8, indices);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				best0 = a0;
+				best1 = a1;
+				memcpy(bestIndices, indices, 16);
+			}
+
+			if (error == 0.0f || !LeastSquaresEndpoints(block, 1, indices, SingleWeights, e0, e1))
+			{
+				break;
+			}
+		}
+
+		//a0 > a1 picks the eight value palette, swapping them reverses it
+		if (best0 < best1)
+		{
+			std::swap(best0, best1);
+
+			for (uint8_t& index : bestIndices)
+			{
+				index = index < 2 ? index ^ 1 : 9 - index;
+			}
+		}
+		else if (best0 == best1)
+		{
+			memset(bestIndices, 0, 16);
+		}
+
+		uint64_t bits = 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			bits |= (uint64_t)bestIndices[i] << (i * 3);
+		}
+
+		out[0] = (uint8_t)best0;
+		out[1] = (uint8_t)best1;
+
+		for (int i = 0; i < 6; ++i)
+		{
+			out[2 + i] = (uint8_t)(bits >> (i * 8));
+		}
+	}
+
+	//A 7 bit endpoint and the p-bit under it that together come closest to colour
+	void QuantizeBC7(const float* colour, int* quantized, int& pBit)
+	{
+		float bestError = FLT_MAX;
+
+		for (int p = 0; p < 2; ++p)
+		{
+			int candidate[4];
+			float error = 0.0f;
+
+			for (int c = 0; c < 4; ++c)
+			{
+				candidate[c] = std::min(std::max((int)((colour[c] - p) / 2.0f + 0.5f), 0), 127);
+				float d = (float)((candidate[c] << 1) | p) - colour[c];
+				error += d * d;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	void BC7Palette(const int* q0, int p0, const int* q1, int p1, float (*palette)[4])
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				palette[i][c] = (float)(((64 - BC7Weights[i]) * a + BC7Weights[i] * b + 32) >> 6);
+			}
+		}
+	}
+
+	struct BitWriter
+	{
+		uint8_t* Out;
+		int Position;
+
+		void Write(uint32_t value, int bits)
+		{
+			for (int b = 0; b < bits; ++b, ++Position)
+			{
+				Out[Position >> 3] |= (uint8_t)(((value >> b) & 1) << (Position & 7));
+			}
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t* In;
+		int Position;
+
+		uint32_t Read(int bits)
+		{
+			uint32_t value = 0;
+
+			for (int b = 0; b < bits; ++b, ++Position)
+			{
+				value |= (uint32_t)((In[Position >> 3] >> (Position & 7)) & 1) << b;
+			}
+
+			return value;
+		}
+	};
+
+	void EncodeBC7(const Block& block, uint8_t* out)
+	{
+		float e0[4], e1[4], palette[16][4], weights[16];
+		uint8_t indices[16], bestIndices[16];
+		int q0[4], q1[4], p0, p1, best0[4] = {}, best1[4] = {}, bestP0 = 0, bestP1 = 0;
+		float bestError = FLT_MAX;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			weights[i] = BC7Weights[i] / 64.0f;
+		}
+
+		PrincipalEndpoints(block, 4, e0, e1);
+
+		for (int iteration = 0; iteration <= Refinements; ++iteration)
+		{
+			QuantizeBC7(e0, q0, p0);
+			QuantizeBC7(e1, q1, p1);
+			BC7Palette(q0, p0, q1, p1, palette);
+			float error = MatchPalette(block, 4, palette, 16, indices);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(best0, q0, sizeof(q0));
+				memcpy(best1, q1, sizeof(q1));
+				bestP0 = p0;
+				bestP1 = p1;
+				memcpy(bestIndices, indices, 16);
+			}
+
+			if (error == 0.0f || !LeastSquaresEndpoints(block, 4, indices, weights, e0, e1))
+			{
+				break;
+			}
+		}
+
+		//The first pixel's index is stored without its top bit, so it has to be in the first half
+		if (bestIndices[0] >= 8)
+		{
+			std::swap(best0, best1);
+			std::swap(bestP0, bestP1);
+
+			for (uint8_t& index : bestIndices)
+			{
+				index = 15 - index;
+			}
+		}
+
+		memset(out, 0, 16);
+		BitWriter writer = { out, 0 };
+		writer.Write(1 << 6, 7);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Write(best0[c], 7);
+			writer.Write(best1[c], 7);
+		}
+
+		writer.Write(bestP0, 1);
+		writer.Write(bestP1, 1);
+		writer.Write(bestIndices[0], 3);
+
+		for (int i = 1; i < 16; ++i)
+		{
+			writer.Write(bestIndices[i], 4);
+		}
+	}
+
+	void DecodeColour(const uint8_t* block, bool alwaysFourColours, uint8_t* pixels)
+	{
+		uint16_t c0, c1;
+		uint32_t bits;
+		memcpy(&c0, block, 2);
+		memcpy(&c1, block + 2, 2);
+		memcpy(&bits, block + 4, 4);
+
+		int palette[4][4], a[3], b[3];
+		Expand565(c0, a);
+		Expand565(c1, b);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[0][c] = a[c];
+			palette[1][c] = b[c];
+
+			if (alwaysFourColours || c0 > c1)
+			{
+				palette[2][c] = (2 * a[c] + b[c]) / 3;
+				palette[3][c] = (a[c] + 2 * b[c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (a[c] + b[c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = alwaysFourColours || c0 > c1 ? 255 : 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const int* colour = palette[(bits >> (i * 2)) & 3];
+
+			for (int c = 0; c < 4; ++c)
+			{
+				pixels[i * 4 + c] = (uint8_t)colour[c];
+			}
+		}
+	}
+
+	void DecodeSingle(const uint8_t* block, uint8_t* pixels, int channel)
+	{
+		int a0 = block[0], a1 = block[1], palette[8];
+		uint64_t bits = 0;
+
+		for (int i = 0; i < 6; ++i)
+		{
+			bits |= (uint64_t)block[2 + i] << (i * 8);
+		}
+
+		palette[0] = a0;
+		palette[1] = a1;
+
+		if (a0 > a1)
+		{
+			for (int i = 2; i < 8; ++i)
+			{
+				palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 2; i < 6; ++i)
+			{
+				palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+			}
+
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			pixels[i * 4 + channel] = (uint8_t)palette[(bits >> (i * 3)) & 7];
+		}
+	}
+
+	bool DecodeBC7(const uint8_t* block, uint8_t* pixels)
+	{
+		if ((block[0] & 0x7F) != 0x40)
+		{
+			return false;
+		}
+
+		BitReader reader = { block, 7 };
+		int q0[4], q1[4];
+
+		for (int c = 0; c < 4; ++c)
+		{
+			q0[c] = (int)reader.Read(7);
+			q1[c] = (int)reader.Read(7);
+		}
+
+		int p0 = (int)reader.Read(1), p1 = (int)reader.Read(1);
+		float palette[16][4];
+		BC7Palette(q0, p0, q1, p1, palette);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			uint32_t index = reader.Read(i == 0 ? 3 : 4);
+
+			for (int c = 0; c < 4; ++c)
+			{
+				pixels[i * 4 + c] = (uint8_t)palette[index][c];
+			}
+		}
+
+		return true;
+	}
+}
+
+size_t BlockCompression::BlockSize(BlockFormat format)
+{
+	return format == BlockBC1 ? 8 : 16;
+}
+
+void BlockCompression::Encode(BlockFormat format, const uint8_t* pixels, uint8_t* block)
+{
+	static const int Rgba[4] = { 0, 1, 2, 3 };
+	static const int Alpha[1] = { 3 };
+	static const int Red[1] = { 0 };
+	static const int Green[1] = { 1 };
+
+	switch (format)
+	{
+	case BlockBC1:
+		EncodeColour(Load(pixels, Rgba, 3), block);
+		break;
+
+	case BlockBC3:
+		EncodeSingle(Load(pixels, Alpha, 1), block);
+		EncodeColour(Load(pixels, Rgba, 3), block + 8);
+		break;
+
+	case BlockBC5:
+		EncodeSingle(Load(pixels, Red, 1), block);
+		EncodeSingle(Load(pixels, Green, 1), block + 8);
+		break;
+
+	case BlockBC7:
+		EncodeBC7(Load(pixels, Rgba, 4), block);
+		break;
+	}
+}
+
+bool BlockCompression::Decode(BlockFormat format, const uint8_t* block, uint8_t* pixels)
+{
+	switch (format)
+	{
+	case BlockBC1:
+		DecodeColour(block, false, pixels);
+		return true;
+
+	case BlockBC3:
+		DecodeColour(block + 8, true, pixels);
+		DecodeSingle(block, pixels, 3);
+		return true;
+
+	case BlockBC5:
+		for (int i = 0; i < 16; ++i)
+		{
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = 255;
+		}
+
+		DecodeSingle(block, pixels, 0);
+		DecodeSingle(block + 8, pixels, 1);
+		return true;
+
+	case BlockBC7:
+		return DecodeBC7(block, pixels);
+	}
+
+	return false;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//The block compressed texture formats the texture compiler writes, see Tools/TextureCompiler.cpp
+enum BlockFormat
+{
+	BlockBC1,		//RGB, 8 bytes a block
+	BlockBC3,		//RGBA, a BC4 alpha block then a BC1 colour block
+	BlockBC5,		//Two BC4 blocks, red and green, for normal maps
+	BlockBC7,		//RGBA, mode 6 only: one subset, 7 bit endpoints with a p-bit each and 16 weights
+};
+
+//Encodes and decodes single 4x4 blocks. Endpoints are found along each block's principal axis and refined by least squares;
+//every candidate pair is scored by matching all 16 pixels to its palette, which is done four pixels at a time with SSE2.
+//Pixels are 16 RGBA8 values, row by row. Doesn't use D3D so the compiler runs anywhere.
+namespace BlockCompression
+{
+	//8 for BC1, 16 for the rest
+	size_t BlockSize(BlockFormat format);
+
+	void Encode(BlockFormat format, const uint8_t* pixels, uint8_t* block);
+
+	//BC5 decodes to red and green with blue 0, BC1 and BC3 to what a D3D10 GPU samples. Returns false for a BC7 block in a
+	//mode other than 6, which Encode never writes
+	bool Decode(BlockFormat format, const uint8_t* block, uint8_t* pixels);
+};
@@ -9,6 +9,7 @@ Camera::Camera(XMFLOAT3 position, XMFLOAT3 at, XMFLOAT3 up, FLOAT windowWidth, F
 	_windowHeight = windowHeight;
 	_nearDepth = nearDepth;
 	_farDepth = farDepth;
+	_typeAt = true;
 	update();
 }
 
@@ -88,6 +89,12 @@ bool Camera::getTypeAt()
 	return _typeAt;
 }
 
+FLOAT Camera::getProjectionScale()
+{
+	//_22 of a perspective projection is 1 / tan(fovY / 2), which maps onto half the window's height
+	return _projection._22 * _windowHeight * 0.5f;
+}
+
 void Camera::Reshape(FLOAT windowWidth, FLOAT windowHeight, FLOAT nearDepth, FLOAT farDepth)
 {
 	_windowWidth = windowWidth;
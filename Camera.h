@@ -1,10 +1,16 @@
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
 #include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <directxmath.h>
 #include <directxcolors.h>
+#else
+//Only DirectXMath is used, so the benchmarks can build it elsewhere, see Benchmarks/Makefile
+#include <DirectXMath.h>
+typedef float FLOAT;
+#endif
 
 using namespace DirectX;
 
@@ -44,5 +50,9 @@ public:
 	XMFLOAT4X4 getViewProjection();
 	bool getTypeAt();
 
+	//How many pixels tall something 1 unit tall looks from 1 unit away, divide by the distance for anything further.
+	//Used to turn errors in world units into errors on screen
+	FLOAT getProjectionScale();
+
 	void Reshape(FLOAT widowWidth, FLOAT windowHeight, FLOAT nearDepth, FLOAT farDepth);
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "ContentHash.h"
+#include <cstring>
+
+namespace
+{
+	const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t Prime3 = 0x165667B19E3779F9ull;
+
+	inline uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	inline uint64_t Read64(const unsigned char* p)
+	{
+		uint64_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Round(uint64_t lane, uint64_t input)
+	{
+		lane += input * Prime2;
+		lane = RotateLeft(lane, 31);
+		return lane * Prime1;
+	}
+
+	inline uint64_t Avalanche(uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= Prime2;
+		hash ^= hash >> 29;
+		hash *= Prime3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+}
+
+uint64_t ContentHash(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	const unsigned char* end = p + size;
+
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		uint64_t lanes[4] = { seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1 };
+
+		while (end - p >= 32)
+		{
+			lanes[0] = Round(lanes[0], Read64(p));
+			lanes[1] = Round(lanes[1], Read64(p + 8));
+			lanes[2] = Round(lanes[2], Read64(p + 16));
+			lanes[3] = Round(lanes[3], Read64(p + 24));
+			p += 32;
+		}
+
+		hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+
+		for (uint64_t lane : lanes)
+		{
+			hash = (hash ^ Round(0, lane)) * Prime1 + Prime3;
+		}
+	}
+	else
+	{
+		hash = seed + Prime3;
+	}
+
+	hash += (uint64_t)size;
+
+	//Whatever is left over is folded in 8 bytes, then 1 byte, at a time
+	while (end - p >= 8)
+	{
+		hash ^= Round(0, Read64(p));
+		hash = RotateLeft(hash, 27) * Prime1 + Prime3;
+		p += 8;
+	}
+
+	while (p < end)
+	{
+		hash ^= (*p) * Prime3;
+		hash = RotateLeft(hash, 11) * Prime1;
+		++p;
+	}
+
+	return Avalanche(hash);
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//Fast non-cryptographic 64-bit hash, used to detect changed asset contents and corrupted caches.
+//Reads 32 bytes per step in 4 independent lanes so it runs at several GB/s.
+uint64_t ContentHash(const void* data, size_t size, uint64_t seed = 0);
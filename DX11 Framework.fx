@@ -8,6 +8,7 @@
 // Texture Buffer Variables
 //--------------------------------------------------------------------------------------
 Texture2D txDiffuse : register(t0);
+Texture2DArray txArrays[4] : register(t1); // The arrays Tools/TextureArrayCompiler.cpp packed, see TextureArray.h and Application::MaxTextureArrays
 SamplerState samLinear : register(s0);
 
 //--------------------------------------------------------------------------------------
@@ -30,6 +31,19 @@ cbuffer ConstantBuffer : register( b0 )
     float3 EyePosW;
     float3 LightVecW;
     float buffer;
+    float4 TextureTransform;    // xy scale, zw offset to the texture's tile in its array
+    float4 TextureTile;         // The tile's width and height in texels, the array's gutter (0 for a slice to itself) and the last mip to sample
+    float TextureSlice;         // Negative for txDiffuse
+    float TextureArrayIndex;    // Which of txArrays
+    float2 TexturePadding;
+}
+
+// Only used by VSQuantized, see MeshDecodeBuffer in Structures.h
+cbuffer MeshDecode : register( b1 )
+{
+    float4 PositionScale;
+    float4 PositionOffset;
+    float4 TexCoordScaleOffset;     // xy scale, zw offset
 }
 //--------------------------------------------------------------------------------------
 
@@ -111,9 +125,9 @@ struct VS_OUTPUT
 //}
 
 //------------------------------------------------------------------------------------
-// Vertex Shader - Implements Gouraud Shading using Diffuse lighting only
+// Shared by both vertex shaders
 //------------------------------------------------------------------------------------
-VS_OUTPUT VS(float4 Pos : POSITION, float3 NormalL : NORMAL, float2 Tex : TEXCOORD)
+VS_OUTPUT TransformVertex(float4 Pos, float3 NormalL, float2 Tex)
 {
     VS_OUTPUT output = (VS_OUTPUT)0;
 
@@ -132,12 +146,79 @@ VS_OUTPUT VS(float4 Pos : POSITION, float3 NormalL : NORMAL, float2 Tex : TEXCOO
     return output;
 }
 
+//------------------------------------------------------------------------------------
+// Vertex Shader - Implements Gouraud Shading using Diffuse lighting only
+//------------------------------------------------------------------------------------
+VS_OUTPUT VS(float4 Pos : POSITION, float3 NormalL : NORMAL, float2 Tex : TEXCOORD)
+{
+    return TransformVertex(Pos, NormalL, Tex);
+}
+
+//------------------------------------------------------------------------------------
+// Vertex Shader - Same as above for meshes with QuantizedVertex vertices (VertexQuantizer.h)
+//------------------------------------------------------------------------------------
+// Inverse of the octahedral mapping, must match DecodeOctahedral in VertexQuantizer.cpp
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+VS_OUTPUT VSQuantized(float4 PosQ : POSITION, float2 NormalQ : NORMAL, float2 TexQ : TEXCOORD)
+{
+    // The input layout has already turned the 16-bit values into 0..1 (or -1..1 for the normal)
+    float4 pos = float4(PosQ.xyz * PositionScale.xyz + PositionOffset.xyz, 1.0f);
+    float2 tex = TexQ * TexCoordScaleOffset.xy + TexCoordScaleOffset.zw;
+
+    return TransformVertex(pos, DecodeOctahedral(NormalQ), tex);
+}
+
 //--------------------------------------------------------------------------------------
 // Pixel Shader
 //--------------------------------------------------------------------------------------
+// ps_4_0 can only index resources with literals
+float4 SampleArray(float3 uvw, float2 dx, float2 dy)
+{
+    switch ((uint)TextureArrayIndex)
+    {
+    case 0: return txArrays[0].SampleGrad(samLinear, uvw, dx, dy);
+    case 1: return txArrays[1].SampleGrad(samLinear, uvw, dx, dy);
+    case 2: return txArrays[2].SampleGrad(samLinear, uvw, dx, dy);
+    default: return txArrays[3].SampleGrad(samLinear, uvw, dx, dy);
+    }
+}
+
+float4 SampleDiffuse(float2 tex)
+{
+    if (TextureSlice < 0.0f)
+        return txDiffuse.Sample(samLinear, tex);
+
+    // Outside the switch and the branch below, so the gradients are what Sample would use
+    float2 dx = ddx(tex), dy = ddy(tex);
+
+    // A slice to itself, which the sampler wraps and picks the mip of as it would the texture's own view
+    if (TextureTile.z == 0.0f)
+        return SampleArray(float3(tex, TextureSlice), dx, dy);
+
+    // A tile is wrapped here rather than by the sampler, with the gradients from the unwrapped coordinates so the mip
+    // doesn't jump where frac does. Its gutter covers the filter's reach at the first levels, after that the coordinates
+    // are kept in from the edges by what it no longer covers, as TextureArray::EdgeInset works out, for the coarser of the
+    // two levels filtered. The level is held at the last one that leaves any of the tile
+    float2 dxTexels = dx * TextureTile.xy, dyTexels = dy * TextureTile.xy;
+    float lod = 0.5f * log2(max(dot(dxTexels, dxTexels), dot(dyTexels, dyTexels)));
+    float level = clamp(floor(lod) + 1.0f, 0.0f, TextureTile.w);
+    float inset = max(1.5f * exp2(level) - TextureTile.z, 0.0f);
+    float2 texel = clamp(frac(tex) * TextureTile.xy, inset, TextureTile.xy - inset);
+    float2 uv = texel / TextureTile.xy * TextureTransform.xy + TextureTransform.zw;
+    float gradientScale = exp2(min(TextureTile.w - lod, 0.0f));
+    return SampleArray(float3(uv, TextureSlice), dx * TextureTransform.xy * gradientScale, dy * TextureTransform.xy * gradientScale);
+}
+
 float4 PS( VS_OUTPUT input ) : SV_Target
 {
-	float4 textureColour = txDiffuse.Sample(samLinear, input.Tex); 
+	float4 textureColour = SampleDiffuse(input.Tex); 
 
     float3 toEye = normalize(EyePosW - input.PosW.xyz);
 
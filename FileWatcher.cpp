@@ -0,0 +1,129 @@
+#include "FileWatcher.h"
+#include <filesystem>
+
+FileWatcher::FileWatcher()
+{
+	_interval = std::chrono::milliseconds(250);
+	_settle = std::chrono::milliseconds(200);
+	_stopping = false;
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+void FileWatcher::Describe(WatchedFile& file)
+{
+	std::error_code error;
+	std::filesystem::path path(file.Filename);
+
+	uint64_t size = std::filesystem::file_size(path, error);
+	std::filesystem::file_time_type modifiedTime;
+
+	if (!error)
+	{
+		modifiedTime = std::filesystem::last_write_time(path, error);
+	}
+
+	file.Exists = !error;
+	file.Size = file.Exists ? size : 0;
+	file.ModifiedTime = file.Exists ? (int64_t)modifiedTime.time_since_epoch().count() : 0;
+}
+
+void FileWatcher::Watch(const std::string& filename)
+{
+	WatchedFile file;
+	file.Filename = filename;
+	file.Changing = false;
+	Describe(file);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_files.push_back(file);
+}
+
+void FileWatcher::Start(ChangedCallback changed, std::chrono::milliseconds interval, std::chrono::milliseconds settle)
+{
+	if (_thread.joinable())
+	{
+		return;
+	}
+
+	_changed = changed;
+	_interval = interval;
+	_settle = settle;
+	_stopping = false;
+	_thread = std::thread(&FileWatcher::ThreadLoop, this);
+}
+
+void FileWatcher::Stop()
+{
+	if (!_thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+
+	_wake.notify_all();
+	_thread.join();
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::vector<std::string> changed;
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (WatchedFile& file : _files)
+	{
+		WatchedFile current = file;
+		Describe(current);
+
+		//Any difference restarts the wait, so a file that's being written in pieces is only reported after the last one
+		if (current.Exists != file.Exists || current.Size != file.Size || current.ModifiedTime != file.ModifiedTime)
+		{
+			file.Exists = current.Exists;
+			file.Size = current.Size;
+			file.ModifiedTime = current.ModifiedTime;
+			file.Changing = true;
+			file.ChangedAt = now;
+		}
+		else if (file.Changing && now - file.ChangedAt >= _settle)
+		{
+			file.Changing = false;
+
+			//Deleting a file isn't something to reload, it's usually the first half of an editor saving it
+			if (file.Exists)
+			{
+				changed.push_back(file.Filename);
+			}
+		}
+	}
+
+	return changed;
+}
+
+void FileWatcher::ThreadLoop()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			if (_wake.wait_for(lock, _interval, [this]() { return _stopping; }))
+			{
+				return;
+			}
+		}
+
+		//Outside the lock so the callback can Watch more files
+		for (const std::string& filename : Poll())
+		{
+			_changed(filename);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Tells you when files change, from its own thread. It polls each file's size and modification time, which for a
+//handful of assets costs next to nothing and works the same on every platform, unlike the OS change notifications.
+//A change is only reported once the file has stayed the same for the settle time, so a file an editor or exporter is
+//still writing isn't read half done. Files that don't exist yet are reported when they appear.
+//
+//	FileWatcher watcher;
+//	watcher.Watch("car.obj");
+//	watcher.Start([](const std::string& filename) { ...runs on the watcher's thread... });
+class FileWatcher
+{
+public:
+	typedef std::function<void(const std::string& filename)> ChangedCallback;
+
+private:
+	struct WatchedFile
+	{
+		std::string Filename;
+		bool Exists;
+		uint64_t Size;
+		int64_t ModifiedTime;
+		bool Changing;								//Differs from what was last reported, waiting to settle
+		std::chrono::steady_clock::time_point ChangedAt;
+	};
+
+	std::vector<WatchedFile> _files;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::thread _thread;
+	ChangedCallback _changed;
+	std::chrono::milliseconds _interval;
+	std::chrono::milliseconds _settle;
+	bool _stopping;
+
+	static void Describe(WatchedFile& file);
+	void ThreadLoop();
+
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	//Changes from now on are reported. Can be called before or after Start, from any thread
+	void Watch(const std::string& filename);
+
+	//Starts polling every interval. changed is called on the watcher's thread, one file at a time
+	void Start(ChangedCallback changed, std::chrono::milliseconds interval = std::chrono::milliseconds(250),
+		std::chrono::milliseconds settle = std::chrono::milliseconds(200));
+
+	//Waits for the thread, including a callback that's running
+	void Stop();
+
+	//Checks every file once on the calling thread instead, for when there's no thread running. Returns the files
+	//that have changed and settled since the last check
+	std::vector<std::string> Poll();
+};
@@ -0,0 +1,292 @@
+#include "Lz4.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const size_t MinMatch = 4;
+	const size_t LastLiterals = 5;		//The block always ends with at least this many literals
+	const size_t MatchSearchLimit = 12;	//and the last match starts at least this far from the end
+	const size_t MaxOffset = 65535;
+	const int HashBits = 16;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	//Lengths of 15 or more spill into extra bytes of 255 until one is less
+	inline uint8_t* WriteLength(uint8_t* op, size_t length)
+	{
+		while (length >= 255)
+		{
+			*op++ = 255;
+			length -= 255;
+		}
+
+		*op++ = (uint8_t)length;
+		return op;
+	}
+
+	inline bool ReadLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+	{
+		uint8_t byte;
+
+		do
+		{
+			if (ip >= end) return false;
+			byte = *ip++;
+			length += byte;
+		} while (byte == 255);
+
+		return true;
+	}
+
+	uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+	{
+		uint8_t* token = op++;
+		*token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+
+		if (literalLength >= 15) op = WriteLength(op, literalLength - 15);
+
+		if (literalLength > 0) memcpy(op, literals, literalLength);
+		op += literalLength;
+
+		//The last sequence is only literals
+		if (matchLength == 0)
+		{
+			return op;
+		}
+
+		*op++ = (uint8_t)offset;
+		*op++ = (uint8_t)(offset >> 8);
+
+		size_t length = matchLength - MinMatch;
+		*token |= (uint8_t)(length >= 15 ? 15 : length);
+
+		if (length >= 15) op = WriteLength(op, length - 15);
+
+		return op;
+	}
+}
+
+size_t Lz4::CompressBound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+size_t Lz4::Compress(const void* source, size_t size, void* destination, size_t capacity)
+{
+	if (capacity < CompressBound(size))
+	{
+		return 0;
+	}
+
+	const uint8_t* in = (const uint8_t*)source;
+	const uint8_t* end = in + size;
+	const uint8_t* ip = in;
+	const uint8_t* anchor = in;
+	uint8_t* op = (uint8_t*)destination;
+
+	if (size > MatchSearchLimit)
+	{
+		//Positions of the last 4 bytes seen with each hash
+		std::vector<uint32_t> table((size_t)1 << HashBits, 0);
+		const uint8_t* searchEnd = end - MatchSearchLimit;
+		const uint8_t* matchEnd = end - LastLiterals;
+
+		while (ip < searchEnd)
+		{
+			uint32_t sequence = Read32(ip);
+			uint32_t hash = Hash(sequence);
+			const uint8_t* candidate = in + table[hash];
+			table[hash] = (uint32_t)(ip - in);
+
+			if (candidate >= ip || (size_t)(ip - candidate) > MaxOffset || Read32(candidate) != sequence)
+			{
+				//Steps get bigger the longer it goes without a match, so incompressible data goes through quickly
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			//Take in any equal bytes just before, then extend forwards
+			while (ip > anchor && candidate > in && ip[-1] == candidate[-1])
+			{
+				--ip;
+				--candidate;
+			}
+
+			size_t length = MinMatch;
+			while (ip + length < matchEnd && ip[length] == candidate[length]) ++length;
+
+			op = WriteSequence(op, anchor, ip - anchor, ip - candidate, length);
+			ip += length;
+			anchor = ip;
+
+			if (ip < searchEnd)
+			{
+				table[Hash(Read32(ip - 2))] = (uint32_t)(ip - 2 - in);
+			}
+		}
+	}
+
+	op = WriteSequence(op, anchor, end - anchor, 0, 0);
+
+	return op - (uint8_t*)destination;
+}
+
+bool Lz4::Decompress(const void* source, size_t size, void* destination, size_t decompressedSize)
+{
+	const uint8_t* ip = (const uint8_t*)source;
+	const uint8_t* end = ip + size;
+	uint8_t* out = (uint8_t*)destination;
+	uint8_t* op = out;
+	uint8_t* outEnd = out + decompressedSize;
+
+	while (ip < end)
+	{
+		uint8_t token = *ip++;
+		size_t literalLength = token >> 4;
+		size_t offset;
+
+		if (literalLength < 15 && (size_t)(end - ip) >= 32 && (size_t)(outEnd - op) >= 32)
+		{
+			//Far enough from both ends that a few literals can be copied as 16 bytes, the match's offset follows them
+			memcpy(op, ip, 16);
+			op += literalLength;
+			ip += literalLength;
+			offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+
+			//And a short match at least 8 back as a fixed 18 bytes
+			if ((token & 15) < 15 && offset >= 8 && offset <= (size_t)(op - out))
+			{
+				const uint8_t* match = op - offset;
+				memcpy(op, match, 8);
+				memcpy(op + 8, match + 8, 8);
+				memcpy(op + 16, match + 16, 2);
+				op += (token & 15) + MinMatch;
+				continue;
+			}
+		}
+		else
+		{
+			if (literalLength == 15 && !ReadLength(ip, end, literalLength)) return false;
+			if (literalLength > (size_t)(end - ip) || literalLength > (size_t)(outEnd - op)) return false;
+
+			//Copied 16 bytes at a time when there's room, writing past the run is fine as the next copy overwrites it
+			if ((size_t)(end - ip) >= literalLength + 16 && (size_t)(outEnd - op) >= literalLength + 16)
+			{
+				uint8_t* literalEnd = op + literalLength;
+				const uint8_t* from = ip;
+
+				do
+				{
+					memcpy(op, from, 16);
+					op += 16;
+					from += 16;
+				} while (op < literalEnd);
+
+				op = literalEnd;
+			}
+			else if (literalLength > 0)
+			{
+				memcpy(op, ip, literalLength);
+				op += literalLength;
+			}
+
+			ip += literalLength;
+
+			if (ip == end)
+			{
+				break;
+			}
+
+			if (end - ip < 2) return false;
+
+			offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+		}
+
+		if (offset == 0 || offset > (size_t)(op - out)) return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(ip, end, matchLength)) return false;
+		matchLength += MinMatch;
+
+		if (matchLength > (size_t)(outEnd - op)) return false;
+
+		const uint8_t* match = op - offset;
+		uint8_t* matchEnd = op + matchLength;
+
+		if (offset >= 16 && (size_t)(outEnd - op) >= matchLength + 16)
+		{
+			//16 byte steps never read bytes this match hasn't written yet when it's at least 16 back
+			do
+			{
+				memcpy(op, match, 16);
+				op += 16;
+				match += 16;
+			} while (op < matchEnd);
+
+			op = matchEnd;
+		}
+		else if (offset >= 8 && (size_t)(outEnd - op) >= matchLength + 8)
+		{
+			do
+			{
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			} while (op < matchEnd);
+
+			op = matchEnd;
+		}
+		else if (offset >= matchLength)
+		{
+			memcpy(op, match, matchLength);
+			op += matchLength;
+		}
+		else if ((size_t)(outEnd - op) >= matchLength + 8)
+		{
+			//A short repeating pattern, e.g. a run of one byte. Once the first 8 bytes are written a byte at a time, the
+			//pattern repeated a whole number of times is at least 8 bytes back and the rest can go 8 bytes at a time
+			size_t period = (8 + offset - 1) / offset * offset;
+
+			for (size_t i = 0; i < 8; ++i)
+			{
+				op[i] = match[i];
+			}
+
+			op += 8;
+			match = op - period;
+
+			while (op < matchEnd)
+			{
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			}
+
+			op = matchEnd;
+		}
+		else
+		{
+			//Overlapping, e.g. a run of one repeated byte, has to go forwards a byte at a time
+			for (size_t i = 0; i < matchLength; ++i)
+			{
+				*op++ = *match++;
+			}
+		}
+	}
+
+	return op == outEnd;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+//The LZ4 block format (no frame header), so packs can also be read by any LZ4 implementation. Compression is the
+//simple greedy single hash table kind, which is fast and good enough for assets packed offline; decompression is the
+//part that runs at startup and is bounds checked so a corrupt pack can't write outside the output.
+namespace Lz4
+{
+	//The most Compress can write for size bytes of input
+	size_t CompressBound(size_t size);
+
+	//Returns the compressed size, or 0 if capacity is less than CompressBound(size)
+	size_t Compress(const void* source, size_t size, void* destination, size_t capacity);
+
+	//decompressedSize must be exact. Returns false if the data is corrupt or doesn't decompress to exactly that size
+	bool Decompress(const void* source, size_t size, void* destination, size_t decompressedSize);
+};
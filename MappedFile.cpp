@@ -0,0 +1,165 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	_data = nullptr;
+	_size = 0;
+
+#ifdef _WIN32
+	_fileHandle = INVALID_HANDLE_VALUE;
+	_mappingHandle = nullptr;
+#else
+	_fileDescriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+	_fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	return MapOpenedFile();
+}
+
+bool MappedFile::Open(const wchar_t* filename)
+{
+	Close();
+
+	_fileHandle = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	return MapOpenedFile();
+}
+
+bool MappedFile::MapOpenedFile()
+{
+	if (_fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(_fileHandle, &fileSize))
+	{
+		Close();
+		return false;
+	}
+
+	_size = (size_t)fileSize.QuadPart;
+
+	//Windows refuses to map a zero byte file, which is still a valid (empty) file for us
+	if (_size == 0)
+	{
+		return true;
+	}
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!_mappingHandle)
+	{
+		Close();
+		return false;
+	}
+
+	_data = (const char*)MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+	if (!_data)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data) UnmapViewOfFile(_data);
+	if (_mappingHandle) CloseHandle(_mappingHandle);
+	if (_fileHandle != INVALID_HANDLE_VALUE) CloseHandle(_fileHandle);
+
+	_data = nullptr;
+	_size = 0;
+	_mappingHandle = nullptr;
+	_fileHandle = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return _fileHandle != INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+	_fileDescriptor = open(filename, O_RDONLY);
+
+	if (_fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+
+	if (fstat(_fileDescriptor, &fileStat) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	_size = (size_t)fileStat.st_size;
+
+	if (_size == 0)
+	{
+		return true;
+	}
+
+	void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+
+	if (mapping == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	//We always read the whole file front to back
+	madvise(mapping, _size, MADV_SEQUENTIAL);
+
+	_data = (const char*)mapping;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data) munmap((void*)_data, _size);
+	if (_fileDescriptor >= 0) close(_fileDescriptor);
+
+	_data = nullptr;
+	_size = 0;
+	_fileDescriptor = -1;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return _fileDescriptor >= 0;
+}
+
+#endif
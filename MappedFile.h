@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+
+//Read-only view of a whole file mapped into memory. Works on both Windows and POSIX so the
+//asset parsing code that uses it can also be built and benchmarked headless on Linux.
+class MappedFile
+{
+private:
+	const char* _data;
+	size_t _size;
+
+#ifdef _WIN32
+	void* _fileHandle;
+	void* _mappingHandle;
+
+	bool MapOpenedFile();
+#else
+	int _fileDescriptor;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//Maps the file, returns false if it could not be opened. An empty file opens successfully with a null Data()
+	bool Open(const char* filename);
+#ifdef _WIN32
+	bool Open(const wchar_t* filename);
+#endif
+	void Close();
+
+	bool IsOpen() const;
+	const char* Data() const { return _data; }
+	size_t Size() const { return _size; }
+};
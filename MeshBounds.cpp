@@ -0,0 +1,209 @@
+#include "MeshBounds.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_BOUNDS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	inline float DistanceSquared(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	//The box, and which vertex sits at each end of each axis
+	void FindExtremes(const MeshVertex* vertices, size_t count, MeshBounds& bounds, uint32_t minIndex[3], uint32_t maxIndex[3])
+	{
+#ifdef MESH_BOUNDS_SSE2
+		//x, y, z and the normal's x come in together. The 4th lane is ignored
+		__m128 minimum = _mm_loadu_ps(&vertices[0].Pos.x);
+		__m128 maximum = minimum;
+		__m128i minimumIndex = _mm_setzero_si128();
+		__m128i maximumIndex = _mm_setzero_si128();
+		__m128i index = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi32(1);
+
+		for (size_t i = 1; i < count; ++i)
+		{
+			index = _mm_add_epi32(index, one);
+			__m128 p = _mm_loadu_ps(&vertices[i].Pos.x);
+			__m128i less = _mm_castps_si128(_mm_cmplt_ps(p, minimum));
+			__m128i greater = _mm_castps_si128(_mm_cmpgt_ps(p, maximum));
+
+			minimum = _mm_min_ps(minimum, p);
+			maximum = _mm_max_ps(maximum, p);
+			minimumIndex = _mm_or_si128(_mm_and_si128(less, index), _mm_andnot_si128(less, minimumIndex));
+			maximumIndex = _mm_or_si128(_mm_and_si128(greater, index), _mm_andnot_si128(greater, maximumIndex));
+		}
+
+		float minimumValues[4], maximumValues[4];
+		uint32_t minimumIndices[4], maximumIndices[4];
+		_mm_storeu_ps(minimumValues, minimum);
+		_mm_storeu_ps(maximumValues, maximum);
+		_mm_storeu_si128((__m128i*)minimumIndices, minimumIndex);
+		_mm_storeu_si128((__m128i*)maximumIndices, maximumIndex);
+
+		bounds.Min = { minimumValues[0], minimumValues[1], minimumValues[2] };
+		bounds.Max = { maximumValues[0], maximumValues[1], maximumValues[2] };
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			minIndex[axis] = minimumIndices[axis];
+			maxIndex[axis] = maximumIndices[axis];
+		}
+#else
+		bounds.Min = bounds.Max = vertices[0].Pos;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			minIndex[axis] = maxIndex[axis] = 0;
+		}
+
+		for (size_t i = 1; i < count; ++i)
+		{
+			const float* p = &vertices[i].Pos.x;
+			float* minimum = &bounds.Min.x;
+			float* maximum = &bounds.Max.x;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (p[axis] < minimum[axis]) { minimum[axis] = p[axis]; minIndex[axis] = (uint32_t)i; }
+				if (p[axis] > maximum[axis]) { maximum[axis] = p[axis]; maxIndex[axis] = (uint32_t)i; }
+			}
+		}
+#endif
+	}
+
+	//Squared distance of the furthest vertex from center
+	float FurthestDistanceSquared(const MeshVertex* vertices, size_t count, const MeshFloat3& center)
+	{
+#ifdef MESH_BOUNDS_SSE2
+		__m128 c = _mm_setr_ps(center.x, center.y, center.z, 0.0f);
+		__m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		__m128 furthest = _mm_setzero_ps();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			__m128 d = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&vertices[i].Pos.x), c), mask);
+			__m128 d2 = _mm_mul_ps(d, d);
+			d2 = _mm_add_ps(d2, _mm_shuffle_ps(d2, d2, _MM_SHUFFLE(2, 3, 0, 1)));
+			d2 = _mm_add_ps(d2, _mm_shuffle_ps(d2, d2, _MM_SHUFFLE(1, 0, 3, 2)));
+			furthest = _mm_max_ps(furthest, d2);
+		}
+
+		return _mm_cvtss_f32(furthest);
+#else
+		float furthest = 0.0f;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			furthest = std::max(furthest, DistanceSquared(vertices[i].Pos, center));
+		}
+
+		return furthest;
+#endif
+	}
+}
+
+MeshBounds MeshBounding::ComputeBounds(const MeshVertex* vertices, size_t count)
+{
+	MeshBounds bounds = {};
+
+	if (count == 0)
+	{
+		return bounds;
+	}
+
+	uint32_t minIndex[3];
+	uint32_t maxIndex[3];
+	FindExtremes(vertices, count, bounds, minIndex, maxIndex);
+
+	//Start with the axis whose end points are furthest apart
+	int widest = 0;
+	float widestDistance = -1.0f;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float distance = DistanceSquared(vertices[minIndex[axis]].Pos, vertices[maxIndex[axis]].Pos);
+
+		if (distance > widestDistance)
+		{
+			widest = axis;
+			widestDistance = distance;
+		}
+	}
+
+	const MeshFloat3& a = vertices[minIndex[widest]].Pos;
+	const MeshFloat3& b = vertices[maxIndex[widest]].Pos;
+	MeshFloat3 center = { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f };
+	float radius = std::sqrt(widestDistance) * 0.5f;
+	float radiusSquared = radius * radius;
+
+	//Grow the sphere just enough to take in each point that's outside it, moving the centre towards the point.
+	//Growing is rare after the first few points, so this stays scalar
+	for (size_t i = 0; i < count; ++i)
+	{
+		const MeshFloat3& p = vertices[i].Pos;
+		float distanceSquared = DistanceSquared(p, center);
+
+		if (distanceSquared > radiusSquared)
+		{
+			float distance = std::sqrt(distanceSquared);
+			float newRadius = (radius + distance) * 0.5f;
+			float move = (newRadius - radius) / distance;
+
+			center = { center.x + (p.x - center.x) * move, center.y + (p.y - center.y) * move, center.z + (p.z - center.z) * move };
+			radius = newRadius;
+			radiusSquared = radius * radius;
+		}
+	}
+
+	//Rounding while growing can leave a point a hair outside, so the radius is always the real furthest distance
+	float ritterRadius = std::sqrt(FurthestDistanceSquared(vertices, count, center));
+
+	MeshFloat3 boxCenter = { (bounds.Min.x + bounds.Max.x) * 0.5f, (bounds.Min.y + bounds.Max.y) * 0.5f, (bounds.Min.z + bounds.Max.z) * 0.5f };
+	float boxRadius = std::sqrt(FurthestDistanceSquared(vertices, count, boxCenter));
+
+	bounds.Center = ritterRadius <= boxRadius ? center : boxCenter;
+	bounds.Radius = std::min(ritterRadius, boxRadius);
+
+	return bounds;
+}
+
+MeshBounds MeshBounding::TransformBounds(const MeshBounds& bounds, const float m[4][4])
+{
+	MeshBounds out;
+
+	//Arvo: each output axis takes the furthest reach of the box along it, which is the extents times |M|
+	float center[3] = { (bounds.Min.x + bounds.Max.x) * 0.5f, (bounds.Min.y + bounds.Max.y) * 0.5f, (bounds.Min.z + bounds.Max.z) * 0.5f };
+	float extent[3] = { (bounds.Max.x - bounds.Min.x) * 0.5f, (bounds.Max.y - bounds.Min.y) * 0.5f, (bounds.Max.z - bounds.Min.z) * 0.5f };
+	float* minimum = &out.Min.x;
+	float* maximum = &out.Max.x;
+
+	for (int column = 0; column < 3; ++column)
+	{
+		float c = m[3][column] + center[0] * m[0][column] + center[1] * m[1][column] + center[2] * m[2][column];
+		float e = extent[0] * std::fabs(m[0][column]) + extent[1] * std::fabs(m[1][column]) + extent[2] * std::fabs(m[2][column]);
+		minimum[column] = c - e;
+		maximum[column] = c + e;
+	}
+
+	const MeshFloat3& s = bounds.Center;
+	out.Center = { s.x * m[0][0] + s.y * m[1][0] + s.z * m[2][0] + m[3][0], s.x * m[0][1] + s.y * m[1][1] + s.z * m[2][1] + m[3][1],
+		s.x * m[0][2] + s.y * m[1][2] + s.z * m[2][2] + m[3][2] };
+
+	float scaleSquared = 0.0f;
+
+	for (int row = 0; row < 3; ++row)
+	{
+		scaleSquared = std::max(scaleSquared, m[row][0] * m[row][0] + m[row][1] * m[row][1] + m[row][2] * m[row][2]);
+	}
+
+	out.Radius = bounds.Radius * std::sqrt(scaleSquared);
+
+	return out;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "MeshTypes.h"
+
+//An axis aligned box and a sphere around a mesh. Both are kept because each is tighter for different shapes,
+//a long thin mesh fits a box far better than a sphere, but a sphere is cheaper to test and to transform
+struct MeshBounds
+{
+	MeshFloat3 Min;
+	MeshFloat3 Max;
+	MeshFloat3 Center;			//Sphere
+	float Radius;
+};
+
+static_assert(sizeof(MeshBounds) == 40, "MeshBounds is part of the mesh cache format");
+
+namespace MeshBounding
+{
+	//The box is exact. The sphere is Ritter's: seeded with the furthest apart pair of the points at the ends of each
+	//axis and grown to take in any point outside it, or the sphere around the box's centre if that's smaller.
+	//Positions are processed 1 per SSE register where SSE2 is available
+	MeshBounds ComputeBounds(const MeshVertex* vertices, size_t count);
+
+	//Bounds of the mesh after a row-vector (DirectXMath style) world transform. The box is the box around the transformed
+	//box (Arvo's method) and the radius is scaled by the largest scale in the matrix, so both stay conservative under
+	//rotation and non-uniform scale
+	MeshBounds TransformBounds(const MeshBounds& bounds, const float world[4][4]);
+};
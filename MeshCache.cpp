@@ -0,0 +1,266 @@
+#include "MeshCache.h"
+#include "ContentHash.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+	inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+MeshCacheView::MeshCacheView()
+{
+	_data = nullptr;
+	_header = nullptr;
+	_sections = nullptr;
+}
+
+void MeshCacheView::Close()
+{
+	_file.Close();
+	_data = nullptr;
+	_header = nullptr;
+	_sections = nullptr;
+}
+
+MeshCacheStatus MeshCacheView::Open(const char* cacheFilename, const char* sourceFilename, uint32_t options, bool verifyPayload)
+{
+	Close();
+
+	if (!_file.Open(cacheFilename))
+	{
+		return MeshCacheMissing;
+	}
+
+	MeshCacheStatus status = Validate(_file.Data(), _file.Size(), verifyPayload);
+
+	if (status != MeshCacheValid)
+	{
+		Close();
+		return status;
+	}
+
+	//A cache built with other options is the wrong data whether or not its source is around
+	if (!MeshCache::OptionsMatch(_header->Options, options))
+	{
+		Close();
+		return MeshCacheStale;
+	}
+
+	//With the source file around we make sure the cache still matches it. Size and modification time
+	//are checked first, the file is only hashed if those changed (e.g. it was touched or copied)
+	MeshCacheSource source;
+
+	if (sourceFilename && MeshCache::DescribeSource(sourceFilename, source, false))
+	{
+		if (source.Size != _header->SourceSize || source.ModifiedTime != _header->SourceModifiedTime)
+		{
+			if (!MeshCache::DescribeSource(sourceFilename, source, true) || source.Hash != _header->SourceHash)
+			{
+				Close();
+				return MeshCacheStale;
+			}
+		}
+	}
+
+	return MeshCacheValid;
+}
+
+MeshCacheStatus MeshCacheView::OpenMemory(const void* data, size_t size, bool verifyPayload)
+{
+	Close();
+
+	MeshCacheStatus status = Validate((const char*)data, size, verifyPayload);
+
+	if (status != MeshCacheValid)
+	{
+		Close();
+	}
+
+	return status;
+}
+
+MeshCacheStatus MeshCacheView::Validate(const char* data, uint64_t fileSize, bool verifyPayload)
+{
+	if (fileSize < sizeof(uint32_t))
+	{
+		return MeshCacheCorrupt;
+	}
+
+	uint32_t magic;
+	memcpy(&magic, data, sizeof(magic));
+
+	if (magic != MeshCacheMagic)
+	{
+		return MeshCacheLegacy;
+	}
+
+	if (fileSize < sizeof(MeshCacheHeader))
+	{
+		return MeshCacheCorrupt;
+	}
+
+	const MeshCacheHeader* header = (const MeshCacheHeader*)data;
+	uint64_t tableEnd = sizeof(MeshCacheHeader) + (uint64_t)header->SectionCount * sizeof(MeshCacheSection);
+
+	if (header->Version != MeshCacheVersion || header->FileSize != fileSize || tableEnd > fileSize)
+	{
+		return MeshCacheCorrupt;
+	}
+
+	const MeshCacheSection* sections = (const MeshCacheSection*)(data + sizeof(MeshCacheHeader));
+
+	for (uint32_t i = 0; i < header->SectionCount; ++i)
+	{
+		const MeshCacheSection& section = sections[i];
+
+		bool aligned = section.Offset % MeshCacheAlignment == 0;
+		bool inside = section.Offset >= tableEnd && section.Offset <= fileSize && section.Size <= fileSize - section.Offset;
+		bool sized = section.ElementSize != 0 && section.Size / section.ElementSize == section.Count && section.Size % section.ElementSize == 0;
+
+		if (!aligned || !inside || !sized)
+		{
+			return MeshCacheCorrupt;
+		}
+	}
+
+	if (verifyPayload && ContentHash(data + sizeof(MeshCacheHeader), fileSize - sizeof(MeshCacheHeader)) != header->PayloadHash)
+	{
+		return MeshCacheCorrupt;
+	}
+
+	_data = data;
+	_header = header;
+	_sections = sections;
+
+	return MeshCacheValid;
+}
+
+const MeshCacheSection* MeshCacheView::FindSection(uint32_t type) const
+{
+	if (!_header)
+	{
+		return nullptr;
+	}
+
+	for (uint32_t i = 0; i < _header->SectionCount; ++i)
+	{
+		if (_sections[i].Type == type)
+		{
+			return &_sections[i];
+		}
+	}
+
+	return nullptr;
+}
+
+bool MeshCache::OptionsMatch(uint32_t cacheOptions, uint32_t options)
+{
+	//A progressive cache only differs in its vertex order, so it's fine for loads that didn't ask for one but not the other way round
+	uint32_t ignored = MeshOptionCompressStreams | MeshOptionProgressive;
+	bool progressiveMissing = (options & MeshOptionProgressive) && !(cacheOptions & MeshOptionProgressive);
+
+	return (cacheOptions & ~ignored) == (options & ~ignored) && !progressiveMissing;
+}
+
+bool MeshCache::DescribeSource(const char* sourceFilename, MeshCacheSource& outSource, bool computeHash)
+{
+	std::error_code error;
+	std::filesystem::path path(sourceFilename);
+
+	uint64_t size = std::filesystem::file_size(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	std::filesystem::file_time_type modifiedTime = std::filesystem::last_write_time(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	outSource.Size = size;
+	outSource.ModifiedTime = (int64_t)modifiedTime.time_since_epoch().count();
+	outSource.Hash = 0;
+
+	if (computeHash)
+	{
+		MappedFile file;
+
+		if (!file.Open(sourceFilename))
+		{
+			return false;
+		}
+
+		outSource.Hash = ContentHash(file.Data(), file.Size());
+	}
+
+	return true;
+}
+
+bool MeshCache::Write(const char* cacheFilename, const MeshCacheSource& source, uint32_t options, const std::vector<MeshCacheSectionData>& sections)
+{
+	MeshCacheHeader header = {};
+	header.Magic = MeshCacheMagic;
+	header.Version = MeshCacheVersion;
+	header.Options = options;
+	header.SectionCount = (uint32_t)sections.size();
+	header.SourceSize = source.Size;
+	header.SourceModifiedTime = source.ModifiedTime;
+	header.SourceHash = source.Hash;
+
+	//Lay the sections out one after another, each on an aligned offset
+	std::vector<MeshCacheSection> table(sections.size());
+	uint64_t offset = AlignUp(sizeof(MeshCacheHeader) + sizeof(MeshCacheSection) * sections.size(), MeshCacheAlignment);
+
+	for (size_t i = 0; i < sections.size(); ++i)
+	{
+		table[i].Type = sections[i].Type;
+		table[i].ElementSize = sections[i].ElementSize;
+		table[i].Count = sections[i].Count;
+		table[i].Offset = offset;
+		table[i].Size = sections[i].Count * sections[i].ElementSize;
+
+		offset = AlignUp(offset + table[i].Size, MeshCacheAlignment);
+	}
+
+	header.FileSize = offset;
+
+	std::vector<char> file((size_t)header.FileSize, 0);
+	memcpy(file.data() + sizeof(MeshCacheHeader), table.data(), sizeof(MeshCacheSection) * table.size());
+
+	for (size_t i = 0; i < sections.size(); ++i)
+	{
+		if (table[i].Size > 0)
+		{
+			memcpy(file.data() + table[i].Offset, sections[i].Data, (size_t)table[i].Size);
+		}
+	}
+
+	header.PayloadHash = ContentHash(file.data() + sizeof(MeshCacheHeader), file.size() - sizeof(MeshCacheHeader));
+	memcpy(file.data(), &header, sizeof(MeshCacheHeader));
+
+	//Written to a temporary file first so a reader never sees a half written cache
+	std::string temporaryFilename = std::string(cacheFilename) + ".tmp";
+	std::ofstream out(temporaryFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write(file.data(), file.size());
+	out.close();
+
+	if (!out.good())
+	{
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFilename, cacheFilename, error);
+
+	return !error;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MappedFile.h"
+#include "MeshTypes.h"
+
+//The "<file>.objBinary" mesh cache. The layout is:
+//	MeshCacheHeader
+//	MeshCacheSection[SectionCount]
+//	section data, each section starting on a MeshCacheAlignment boundary
+//Everything is little endian and naturally aligned, so a mapped cache can be handed to CreateBuffer as it is.
+
+const uint32_t MeshCacheMagic = 0x4853454D;		//"MESH"
+const uint32_t MeshCacheVersion = 6;		//2 added MeshSectionClusters, 3 MeshSectionLods, 4 MeshSectionBounds, 5 submeshes and materials, 6 encoded streams
+const uint32_t MeshCacheAlignment = 64;
+
+//What each section holds. Sections a reader doesn't know about are skipped
+enum MeshCacheSectionType : uint32_t
+{
+	MeshSectionVertices = 1,	//MeshVertex[]
+	MeshSectionIndices = 2,		//uint16_t[] or uint32_t[], see the section's ElementSize
+	MeshSectionQuantizedVertices = 3,	//QuantizedVertex[], written instead of MeshSectionVertices
+	MeshSectionQuantization = 4,		//One VertexQuantization for decoding the above
+	MeshSectionClusters = 5,			//MeshCluster[]
+	MeshSectionLods = 6,				//MeshLod[], ranges of MeshSectionIndices starting with the full detail mesh
+	MeshSectionBounds = 7,				//One MeshBounds
+	MeshSectionSubmeshes = 8,			//MeshSubmesh[], one set per level of detail
+	MeshSectionMaterials = 9,			//MeshMaterial[], left out if the OBJ had no material libraries
+	MeshSectionEncodedVertices = 10,	//MeshCodec stream of the vertices, written instead of MeshSectionVertices or MeshSectionQuantizedVertices
+	MeshSectionEncodedIndices = 11,		//MeshCodec stream of the indices, written instead of MeshSectionIndices
+	MeshSectionStreamStages = 12,		//MeshStreamStage[], coarsest first, see MeshStream.h
+};
+
+//Options the mesh was imported with. A cache written with different options is treated as stale
+enum MeshCacheOptions : uint32_t
+{
+	MeshOptionInvertTexCoords = 1 << 0,
+	MeshOptionOptimizeVertexCache = 1 << 1,	//Triangles and vertices were reordered by MeshOptimizer
+	MeshOptionOptimizeOverdraw = 1 << 2,	//and then triangle clusters sorted to reduce overdraw
+	MeshOptionQuantizeVertices = 1 << 3,	//Vertices are stored as QuantizedVertex
+	MeshOptionGenerateLods = 1 << 4,		//Simplified levels of detail follow the mesh in the index buffer
+	MeshOptionCompressStreams = 1 << 5,		//Vertices and indices are stored with MeshCodec. Readers take either, so it doesn't make a cache stale
+	MeshOptionProgressive = 1 << 6,			//Vertices are ordered so the levels of detail can be streamed coarsest first, see MeshStream.h.
+											//Overrides MeshOptionCompressStreams. Such a cache still does for loads that don't ask for it
+};
+
+struct MeshCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Options;			//MeshCacheOptions the mesh was imported with
+	uint32_t SectionCount;
+	uint64_t FileSize;
+	uint64_t SourceSize;		//Size, modification time and hash of the file the cache was made from
+	int64_t SourceModifiedTime;
+	uint64_t SourceHash;
+	uint64_t PayloadHash;		//ContentHash of everything after the header
+	uint64_t Reserved;
+};
+
+struct MeshCacheSection
+{
+	uint32_t Type;
+	uint32_t ElementSize;
+	uint64_t Count;
+	uint64_t Offset;			//From the start of the file
+	uint64_t Size;				//In bytes
+};
+
+static_assert(sizeof(MeshCacheHeader) == 64, "MeshCacheHeader is part of the file format");
+static_assert(sizeof(MeshCacheSection) == 32, "MeshCacheSection is part of the file format");
+
+//Identifies the source file a cache was built from
+struct MeshCacheSource
+{
+	uint64_t Size;
+	int64_t ModifiedTime;
+	uint64_t Hash;
+};
+
+//A section to be written, Data must hold Count * ElementSize bytes
+struct MeshCacheSectionData
+{
+	uint32_t Type;
+	uint32_t ElementSize;
+	uint64_t Count;
+	const void* Data;
+};
+
+enum MeshCacheStatus
+{
+	MeshCacheValid,
+	MeshCacheMissing,		//No cache file
+	MeshCacheLegacy,		//An unversioned cache from before MeshCacheHeader existed
+	MeshCacheCorrupt,		//Truncated, bad checksum or a newer/older version
+	MeshCacheStale,			//The source file or the import options have changed since it was written
+};
+
+//A validated cache, pointing straight into the mapped file or the memory it was opened on
+class MeshCacheView
+{
+private:
+	MappedFile _file;
+	const char* _data;
+	const MeshCacheHeader* _header;
+	const MeshCacheSection* _sections;
+
+	//Checks the header, section table and (if verifyPayload is set) payload hash, and points the view at data if they're fine
+	MeshCacheStatus Validate(const char* data, uint64_t size, bool verifyPayload);
+
+public:
+	MeshCacheView();
+
+	//Maps and validates the cache and checks it was built with options. If sourceFilename exists the cache is also checked
+	//against it, if it doesn't (pre-baked assets shipped without their sources) the cache is trusted to match it.
+	//Without verifyPayload only the header and section table are read, which leaves checking the data to the caller, see MeshStream::CheckStage
+	MeshCacheStatus Open(const char* cacheFilename, const char* sourceFilename, uint32_t options, bool verifyPayload = true);
+
+	//Validates a cache that's already in memory, e.g. an entry of a mapped AssetPack. There's no source file to compare
+	//with so it's trusted like a shipped one. The data isn't copied and has to outlive the view
+	MeshCacheStatus OpenMemory(const void* data, size_t size, bool verifyPayload = true);
+	void Close();
+
+	const MeshCacheHeader& Header() const { return *_header; }
+
+	//Returns null if the cache has no section of that type
+	const MeshCacheSection* FindSection(uint32_t type) const;
+	const void* SectionData(const MeshCacheSection& section) const { return _data + section.Offset; }
+};
+
+namespace MeshCache
+{
+	//Fills in the size and modification time of a file, and its ContentHash if computeHash is set.
+	//Returns false if the file doesn't exist
+	bool DescribeSource(const char* sourceFilename, MeshCacheSource& outSource, bool computeHash);
+
+	//Whether a cache written with cacheOptions serves a load asking for options. Stream compression doesn't matter and
+	//a progressive cache serves loads that didn't ask for one
+	bool OptionsMatch(uint32_t cacheOptions, uint32_t options);
+
+	bool Write(const char* cacheFilename, const MeshCacheSource& source, uint32_t options, const std::vector<MeshCacheSectionData>& sections);
+};
@@ -0,0 +1,308 @@
+#include "MeshClusters.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Once a cluster has MinClusterTriangles it stops growing into triangles facing more than about 30 degrees away from
+	//it, the tighter the normal cone the more often the whole cluster faces away from the camera
+	const float SplitConeDot = 0.85f;
+
+	inline MeshFloat3 Subtract(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	inline float Dot(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline MeshFloat3 Normalize(const MeshFloat3& a)
+	{
+		float length = std::sqrt(Dot(a, a));
+		return length > 0.0f ? MeshFloat3{ a.x / length, a.y / length, a.z / length } : MeshFloat3{ 0.0f, 0.0f, 0.0f };
+	}
+
+	//Unit face normal, flipped if needed to agree with the vertex normals
+	MeshFloat3 FaceNormal(const MeshVertex& a, const MeshVertex& b, const MeshVertex& c)
+	{
+		MeshFloat3 ab = Subtract(b.Pos, a.Pos);
+		MeshFloat3 ac = Subtract(c.Pos, a.Pos);
+		MeshFloat3 normal = { ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x };
+		MeshFloat3 vertexNormals = { a.Normal.x + b.Normal.x + c.Normal.x, a.Normal.y + b.Normal.y + c.Normal.y, a.Normal.z + b.Normal.z + c.Normal.z };
+
+		if (Dot(normal, vertexNormals) < 0.0f)
+		{
+			normal = { -normal.x, -normal.y, -normal.z };
+		}
+
+		return Normalize(normal);
+	}
+
+	MeshCluster FinishCluster(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusterVertices,
+		size_t firstTriangle, size_t endTriangle, const MeshFloat3& normalSum)
+	{
+		MeshCluster cluster;
+		cluster.IndexStart = (uint32_t)(firstTriangle * 3);
+		cluster.IndexCount = (uint32_t)((endTriangle - firstTriangle) * 3);
+
+		MeshFloat3 minimum = vertices[clusterVertices[0]].Pos;
+		MeshFloat3 maximum = minimum;
+
+		for (uint32_t vertex : clusterVertices)
+		{
+			const MeshFloat3& p = vertices[vertex].Pos;
+			minimum = { std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z) };
+			maximum = { std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z) };
+		}
+
+		cluster.Center = { (minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f };
+
+		float radiusSquared = 0.0f;
+
+		for (uint32_t vertex : clusterVertices)
+		{
+			MeshFloat3 offset = Subtract(vertices[vertex].Pos, cluster.Center);
+			radiusSquared = std::max(radiusSquared, Dot(offset, offset));
+		}
+
+		cluster.Radius = std::sqrt(radiusSquared);
+
+		//The cone has to hold every face normal, a spread of 90 degrees or more means some triangle always faces the camera
+		cluster.ConeAxis = Normalize(normalSum);
+		float minimumDot = Dot(cluster.ConeAxis, cluster.ConeAxis) > 0.0f ? 1.0f : -1.0f;
+
+		for (size_t t = firstTriangle; t < endTriangle && minimumDot > 0.0f; ++t)
+		{
+			MeshFloat3 normal = FaceNormal(vertices[indices[t * 3]], vertices[indices[t * 3 + 1]], vertices[indices[t * 3 + 2]]);
+
+			//Degenerate triangles have no facing and don't draw anything
+			if (Dot(normal, normal) > 0.0f)
+			{
+				minimumDot = std::min(minimumDot, Dot(normal, cluster.ConeAxis));
+			}
+		}
+
+		cluster.ConeCutoff = minimumDot > 0.0f ? std::sqrt(std::max(0.0f, 1.0f - minimumDot * minimumDot)) : 1.0f;
+
+		return cluster;
+	}
+}
+
+void MeshClusters::BuildClusters(const std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshCluster>& outClusters)
+{
+	outClusters.clear();
+
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//Which triangles use each vertex
+	std::vector<uint32_t> firstTriangle(vertices.size() + 1, 0);
+
+	for (uint32_t index : indices)
+	{
+		++firstTriangle[index + 1];
+	}
+
+	for (size_t v = 0; v < vertices.size(); ++v)
+	{
+		firstTriangle[v + 1] += firstTriangle[v];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		adjacency[filled[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<MeshFloat3> faceNormals(triangleCount);
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		faceNormals[t] = FaceNormal(vertices[indices[t * 3]], vertices[indices[t * 3 + 1]], vertices[indices[t * 3 + 2]]);
+	}
+
+	std::vector<bool> assigned(triangleCount, false);
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	std::vector<uint32_t> clusterVertices;
+	std::vector<uint32_t> clusterTriangles;
+	size_t seedCursor = 0;
+
+	while (output.size() < indices.size())
+	{
+		//Seeds are taken in the incoming order, so clusters come out roughly in the order the vertex cache and overdraw
+		//passes left the triangles in
+		while (assigned[seedCursor]) ++seedCursor;
+
+		clusterVertices.clear();
+		clusterTriangles.clear();
+		MeshFloat3 normalSum = { 0.0f, 0.0f, 0.0f };
+		uint32_t triangle = (uint32_t)seedCursor;
+
+		for (;;)
+		{
+			assigned[triangle] = true;
+			clusterTriangles.push_back(triangle);
+
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = indices[triangle * 3 + corner];
+
+				if (std::find(clusterVertices.begin(), clusterVertices.end(), vertex) == clusterVertices.end())
+				{
+					clusterVertices.push_back(vertex);
+				}
+			}
+
+			const MeshFloat3& normal = faceNormals[triangle];
+			normalSum = { normalSum.x + normal.x, normalSum.y + normal.y, normalSum.z + normal.z };
+
+			if (clusterTriangles.size() >= MaxClusterTriangles)
+			{
+				break;
+			}
+
+			//Grow into the neighbouring triangle that adds the fewest vertices, and of those the one facing most like the
+			//cluster. Triangles turning too far away are left for another cluster so the normal cone stays tight
+			MeshFloat3 axis = Normalize(normalSum);
+			float bestScore = -1e30f;
+			int best = -1;
+
+			for (uint32_t vertex : clusterVertices)
+			{
+				for (uint32_t a = firstTriangle[vertex]; a < firstTriangle[vertex + 1]; ++a)
+				{
+					uint32_t candidate = adjacency[a];
+
+					if (assigned[candidate])
+					{
+						continue;
+					}
+
+					uint32_t newVertices = 0;
+
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						if (std::find(clusterVertices.begin(), clusterVertices.end(), indices[candidate * 3 + corner]) == clusterVertices.end())
+						{
+							++newVertices;
+						}
+					}
+
+					float facing = Dot(faceNormals[candidate], axis);
+
+					if (clusterVertices.size() + newVertices > MaxClusterVertices || (facing < SplitConeDot && clusterTriangles.size() >= MinClusterTriangles))
+					{
+						continue;
+					}
+
+					float score = facing - (float)newVertices;
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						best = (int)candidate;
+					}
+				}
+			}
+
+			if (best < 0)
+			{
+				break;
+			}
+
+			triangle = (uint32_t)best;
+		}
+
+		//Order the cluster's own triangles for the vertex cache, the clusters were built from cache ordered triangles but
+		//growing them jumps around
+		std::vector<uint32_t> localIndices;
+		localIndices.reserve(clusterTriangles.size() * 3);
+
+		for (uint32_t t : clusterTriangles)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = indices[t * 3 + corner];
+				localIndices.push_back((uint32_t)(std::find(clusterVertices.begin(), clusterVertices.end(), vertex) - clusterVertices.begin()));
+			}
+		}
+
+		MeshOptimizer::OptimizeVertexCache(localIndices, clusterVertices.size());
+
+		size_t firstIndex = output.size();
+
+		for (uint32_t local : localIndices)
+		{
+			output.push_back(clusterVertices[local]);
+		}
+
+		outClusters.push_back(FinishCluster(vertices, output, clusterVertices, firstIndex / 3, output.size() / 3, normalSum));
+	}
+
+	indices.swap(output);
+}
+
+void MeshClusters::ExtractFrustumPlanes(const float m[4][4], float outPlanes[6][4])
+{
+	//With row vectors clip = v * M, so each clip space bound is a combination of M's columns
+	for (int i = 0; i < 4; ++i)
+	{
+		outPlanes[0][i] = m[i][3] + m[i][0];	//Left
+		outPlanes[1][i] = m[i][3] - m[i][0];	//Right
+		outPlanes[2][i] = m[i][3] + m[i][1];	//Bottom
+		outPlanes[3][i] = m[i][3] - m[i][1];	//Top
+		outPlanes[4][i] = m[i][2];				//Near
+		outPlanes[5][i] = m[i][3] - m[i][2];	//Far
+	}
+
+	for (int p = 0; p < 6; ++p)
+	{
+		float length = std::sqrt(outPlanes[p][0] * outPlanes[p][0] + outPlanes[p][1] * outPlanes[p][1] + outPlanes[p][2] * outPlanes[p][2]);
+
+		if (length > 0.0f)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				outPlanes[p][i] /= length;
+			}
+		}
+	}
+}
+
+bool MeshClusters::IsClusterVisible(const MeshCluster& cluster, const ClusterCullView& view)
+{
+	const MeshFloat3& c = cluster.Center;
+
+	for (int p = 0; p < 6; ++p)
+	{
+		const float* plane = view.Planes[p];
+
+		if (plane[0] * c.x + plane[1] * c.y + plane[2] * c.z + plane[3] < -cluster.Radius)
+		{
+			return false;
+		}
+	}
+
+	if (!view.BackfaceCull || cluster.ConeCutoff >= 1.0f)
+	{
+		return true;
+	}
+
+	//Every triangle faces away if the direction to every point of the sphere is within 90 degrees - spread of the axis,
+	//i.e. dot(p - camera, axis) >= cutoff * |p - camera|. Taking the worst point of the sphere for each side keeps it conservative
+	MeshFloat3 toCenter = Subtract(c, view.CameraPosition);
+	float distance = std::sqrt(Dot(toCenter, toCenter));
+
+	return Dot(toCenter, cluster.ConeAxis) - cluster.Radius < cluster.ConeCutoff * (distance + cluster.Radius);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MeshTypes.h"
+
+//A run of triangles in a mesh's index buffer that is small and flat enough to be culled as one, either because
+//it's outside the view frustum or because every triangle in it faces away from the camera
+struct MeshCluster
+{
+	uint32_t IndexStart;		//Into the mesh's index buffer, always a multiple of 3
+	uint32_t IndexCount;
+	MeshFloat3 Center;			//Bounding sphere, in model space
+	float Radius;
+	MeshFloat3 ConeAxis;		//Average facing of the triangles
+	float ConeCutoff;			//Sine of the angle between ConeAxis and the furthest facing, 1 or more if the cluster can't be backface culled
+};
+
+static_assert(sizeof(MeshCluster) == 40, "MeshCluster is part of the mesh cache format");
+
+//What a mesh is culled against, in the mesh's own model space so clusters don't need transforming
+struct ClusterCullView
+{
+	float Planes[6][4];			//ax + by + cz + d >= 0 inside, normalized
+	MeshFloat3 CameraPosition;
+	bool BackfaceCull;			//Also cull clusters facing away. Only when the rasterizer culls back faces too, otherwise they're meant to be seen
+};
+
+namespace MeshClusters
+{
+	//Limits per cluster. Small enough that culling is worthwhile, big enough that a draw covers a useful amount of work
+	const uint32_t MaxClusterVertices = 64;
+	const uint32_t MaxClusterTriangles = 124;
+
+	//A cluster won't stop growing because of a sharp corner until it has at least this many triangles, so it doesn't end
+	//up with lots of tiny clusters on curved surfaces
+	const uint32_t MinClusterTriangles = 8;
+
+	//Groups connected triangles into clusters and rewrites the index buffer so each cluster is one contiguous range, with
+	//its own triangles in vertex cache order. Clusters are seeded in the incoming triangle order, so run this after
+	//MeshOptimizer's vertex cache and overdraw passes to mostly keep their ordering.
+	//Which way a triangle faces is decided by the vertex normals, so it doesn't depend on the winding convention
+	void BuildClusters(const std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshCluster>& outClusters);
+
+	//Pulls the frustum planes out of a row-vector (DirectXMath style) model * view * projection matrix, which puts them
+	//in model space. Depth is assumed to be 0..1 like D3D
+	void ExtractFrustumPlanes(const float modelViewProjection[4][4], float outPlanes[6][4]);
+
+	//Conservative, a cluster that's culled has no visible triangles. Without view.BackfaceCull only the frustum is tested
+	bool IsClusterVisible(const MeshCluster& cluster, const ClusterCullView& view);
+};
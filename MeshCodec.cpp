@@ -0,0 +1,364 @@
+#include "MeshCodec.h"
+#include "Lz4.h"
+#include <cstring>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	inline uint32_t ReadWord(const uint8_t* p, size_t wordSize)
+	{
+		if (wordSize == 2)
+		{
+			uint16_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline void WriteWord(uint8_t* p, size_t wordSize, uint32_t value)
+	{
+		if (wordSize == 2)
+		{
+			uint16_t narrow = (uint16_t)value;
+			memcpy(p, &narrow, sizeof(narrow));
+		}
+		else
+		{
+			memcpy(p, &value, sizeof(value));
+		}
+	}
+
+	//Moves the sign to the lowest bit so small differences either way have zero high bytes
+	inline uint32_t ZigzagEncode(uint32_t difference, size_t wordSize)
+	{
+		uint32_t signBit = wordSize == 2 ? 15 : 31;
+		uint32_t sign = (difference >> signBit) & 1;
+		uint32_t mask = wordSize == 2 ? 0xFFFF : 0xFFFFFFFF;
+		return ((difference << 1) ^ (0u - sign)) & mask;
+	}
+
+	inline uint32_t ZigzagDecode(uint32_t value)
+	{
+		return (value >> 1) ^ (0u - (value & 1));
+	}
+
+	//Appends the header and LZ4 compressed data to out, replacing what's there if it's smaller or out is empty
+	void Compress(const MeshCodecHeader& header, const void* data, size_t size, std::vector<char>& out)
+	{
+		std::vector<char> compressed(sizeof(MeshCodecHeader) + Lz4::CompressBound(size));
+		memcpy(compressed.data(), &header, sizeof(header));
+		size_t compressedSize = Lz4::Compress(data, size, compressed.data() + sizeof(MeshCodecHeader), compressed.size() - sizeof(MeshCodecHeader));
+		compressed.resize(sizeof(MeshCodecHeader) + compressedSize);
+
+		if (out.empty() || compressed.size() < out.size())
+		{
+			out.swap(compressed);
+		}
+	}
+
+	void Encode(MeshCodecStream stream, const void* elements, size_t count, size_t stride, size_t wordSize, std::vector<char>& out)
+	{
+		const uint8_t* in = (const uint8_t*)elements;
+		size_t size = count * stride;
+		std::vector<uint8_t> planes(size);
+
+		//Plane b holds byte b of every element's differences
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (size_t word = 0; word < stride; word += wordSize)
+			{
+				uint32_t value = ReadWord(in + i * stride + word, wordSize);
+				uint32_t previous = i > 0 ? ReadWord(in + (i - 1) * stride + word, wordSize) : 0;
+				uint32_t encoded = ZigzagEncode(value - previous, wordSize);
+
+				for (size_t byte = 0; byte < wordSize; ++byte)
+				{
+					planes[(word + byte) * count + i] = (uint8_t)(encoded >> (byte * 8));
+				}
+			}
+		}
+
+		MeshCodecHeader header;
+		header.Magic = MeshCodecMagic;
+		header.Stream = stream;
+		header.Filter = MeshCodecDeltaPlanes;
+		header.Count = (uint32_t)count;
+		header.Stride = (uint16_t)stride;
+		header.WordSize = (uint16_t)wordSize;
+
+		out.clear();
+		Compress(header, planes.data(), size, out);
+
+		header.Filter = MeshCodecRaw;
+		Compress(header, elements, size, out);
+	}
+
+	//Element i starts as the planes' bytes and ends as previous element + zigzag decoded difference
+	void UnfilterScalar(const uint8_t* planes, uint8_t* out, size_t first, size_t count, size_t stride, size_t wordSize)
+	{
+		for (size_t i = first; i < count; ++i)
+		{
+			for (size_t word = 0; word < stride; word += wordSize)
+			{
+				uint32_t encoded = 0;
+
+				for (size_t byte = 0; byte < wordSize; ++byte)
+				{
+					encoded |= (uint32_t)planes[(word + byte) * count + i] << (byte * 8);
+				}
+
+				uint32_t previous = i > 0 ? ReadWord(out + (i - 1) * stride + word, wordSize) : 0;
+				WriteWord(out + i * stride + word, wordSize, previous + ZigzagDecode(encoded));
+			}
+		}
+	}
+
+#ifdef MESH_CODEC_SSE2
+	//One round of pairing rows up, written out so the compiler keeps everything in registers instead of looping over arrays
+#define MESH_CODEC_UNPACK_ROUND(width, in, out) \
+		out##0 = _mm_unpacklo_##width(in##0, in##1); out##8 = _mm_unpackhi_##width(in##0, in##1); \
+		out##1 = _mm_unpacklo_##width(in##2, in##3); out##9 = _mm_unpackhi_##width(in##2, in##3); \
+		out##2 = _mm_unpacklo_##width(in##4, in##5); out##10 = _mm_unpackhi_##width(in##4, in##5); \
+		out##3 = _mm_unpacklo_##width(in##6, in##7); out##11 = _mm_unpackhi_##width(in##6, in##7); \
+		out##4 = _mm_unpacklo_##width(in##8, in##9); out##12 = _mm_unpackhi_##width(in##8, in##9); \
+		out##5 = _mm_unpacklo_##width(in##10, in##11); out##13 = _mm_unpackhi_##width(in##10, in##11); \
+		out##6 = _mm_unpacklo_##width(in##12, in##13); out##14 = _mm_unpackhi_##width(in##12, in##13); \
+		out##7 = _mm_unpacklo_##width(in##14, in##15); out##15 = _mm_unpackhi_##width(in##14, in##15);
+
+	//rows[r] byte c ends up in rows[c] byte r
+	inline void Transpose16x16(__m128i rows[16])
+	{
+		__m128i r0 = rows[0], r1 = rows[1], r2 = rows[2], r3 = rows[3], r4 = rows[4], r5 = rows[5], r6 = rows[6], r7 = rows[7];
+		__m128i r8 = rows[8], r9 = rows[9], r10 = rows[10], r11 = rows[11], r12 = rows[12], r13 = rows[13], r14 = rows[14], r15 = rows[15];
+		__m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+
+		MESH_CODEC_UNPACK_ROUND(epi8, r, t)
+		MESH_CODEC_UNPACK_ROUND(epi16, t, r)
+		MESH_CODEC_UNPACK_ROUND(epi32, r, t)
+		MESH_CODEC_UNPACK_ROUND(epi64, t, r)
+
+		//After four rounds of pairing the rows come out in bit reversed order
+		rows[0] = r0; rows[1] = r8; rows[2] = r4; rows[3] = r12; rows[4] = r2; rows[5] = r10; rows[6] = r6; rows[7] = r14;
+		rows[8] = r1; rows[9] = r9; rows[10] = r5; rows[11] = r13; rows[12] = r3; rows[13] = r11; rows[14] = r7; rows[15] = r15;
+	}
+
+#undef MESH_CODEC_UNPACK_ROUND
+
+	inline __m128i ZigzagDecode16(__m128i value)
+	{
+		__m128i sign = _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi16(1)));
+		return _mm_xor_si128(_mm_srli_epi16(value, 1), sign);
+	}
+
+	inline __m128i ZigzagDecode32(__m128i value)
+	{
+		__m128i sign = _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi32(1)));
+		return _mm_xor_si128(_mm_srli_epi32(value, 1), sign);
+	}
+
+	//Vertices a multiple of 16 bytes: 16 planes x 16 vertices are transposed into 16 byte slices of 16 vertices,
+	//then each slice is added to the same slice of the vertex before. Returns how many vertices it did
+	template <size_t WordSize>
+	size_t UnfilterVertices(const uint8_t* planes, uint8_t* out, size_t count, size_t stride)
+	{
+		const size_t slices = stride / 16;
+		const size_t blocks = count / 16;
+		__m128i previous[16] = {};
+		__m128i rows[16];
+
+		for (size_t block = 0; block < blocks; ++block)
+		{
+			size_t first = block * 16;
+
+			for (size_t slice = 0; slice < slices; ++slice)
+			{
+				for (size_t row = 0; row < 16; ++row)
+				{
+					rows[row] = _mm_loadu_si128((const __m128i*)(planes + (slice * 16 + row) * count + first));
+				}
+
+				Transpose16x16(rows);
+
+				__m128i running = previous[slice];
+
+				for (size_t i = 0; i < 16; ++i)
+				{
+					if (WordSize == 2)
+					{
+						running = _mm_add_epi16(running, ZigzagDecode16(rows[i]));
+					}
+					else
+					{
+						running = _mm_add_epi32(running, ZigzagDecode32(rows[i]));
+					}
+
+					_mm_storeu_si128((__m128i*)(out + (first + i) * stride + slice * 16), running);
+				}
+
+				previous[slice] = running;
+			}
+		}
+
+		return blocks * 16;
+	}
+
+	//Indices: the planes are interleaved back into 16 indices, which are added up with a prefix sum inside each register
+	size_t UnfilterIndices(const uint8_t* planes, uint8_t* out, size_t count, size_t indexSize)
+	{
+		const size_t blocks = count / 16;
+
+		if (indexSize == 2)
+		{
+			__m128i running = _mm_setzero_si128();
+
+			for (size_t block = 0; block < blocks; ++block)
+			{
+				size_t first = block * 16;
+				__m128i low = _mm_loadu_si128((const __m128i*)(planes + first));
+				__m128i high = _mm_loadu_si128((const __m128i*)(planes + count + first));
+				__m128i values[2] = { _mm_unpacklo_epi8(low, high), _mm_unpackhi_epi8(low, high) };
+
+				for (int half = 0; half < 2; ++half)
+				{
+					__m128i x = ZigzagDecode16(values[half]);
+					x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+					x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+					x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+					x = _mm_add_epi16(x, running);
+					_mm_storeu_si128((__m128i*)(out + (first + half * 8) * 2), x);
+
+					//Every lane gets the last index for the next 8
+					running = _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+					running = _mm_shuffle_epi32(running, _MM_SHUFFLE(3, 3, 3, 3));
+				}
+			}
+		}
+		else
+		{
+			__m128i running = _mm_setzero_si128();
+
+			for (size_t block = 0; block < blocks; ++block)
+			{
+				size_t first = block * 16;
+				__m128i byte0 = _mm_loadu_si128((const __m128i*)(planes + first));
+				__m128i byte1 = _mm_loadu_si128((const __m128i*)(planes + count + first));
+				__m128i byte2 = _mm_loadu_si128((const __m128i*)(planes + count * 2 + first));
+				__m128i byte3 = _mm_loadu_si128((const __m128i*)(planes + count * 3 + first));
+				__m128i low = _mm_unpacklo_epi8(byte0, byte1), high = _mm_unpacklo_epi8(byte2, byte3);
+				__m128i low2 = _mm_unpackhi_epi8(byte0, byte1), high2 = _mm_unpackhi_epi8(byte2, byte3);
+				__m128i values[4] = { _mm_unpacklo_epi16(low, high), _mm_unpackhi_epi16(low, high), _mm_unpacklo_epi16(low2, high2), _mm_unpackhi_epi16(low2, high2) };
+
+				for (int quarter = 0; quarter < 4; ++quarter)
+				{
+					__m128i x = ZigzagDecode32(values[quarter]);
+					x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+					x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+					x = _mm_add_epi32(x, running);
+					_mm_storeu_si128((__m128i*)(out + (first + quarter * 4) * 4), x);
+					running = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+				}
+			}
+		}
+
+		return blocks * 16;
+	}
+#endif
+
+	bool Decode(MeshCodecStream stream, const void* data, size_t size, void* destination)
+	{
+		MeshCodecHeader header;
+
+		if (!MeshCodec::ReadHeader(data, size, header) || header.Stream != stream)
+		{
+			return false;
+		}
+
+		size_t count = header.Count;
+		size_t stride = header.Stride;
+		size_t wordSize = header.WordSize;
+
+		//LZ4 can't expand more than 255 times, so a corrupt count can't ask for a huge buffer
+		if ((uint64_t)count * stride > (uint64_t)(size - sizeof(MeshCodecHeader)) * 255 + 16)
+		{
+			return false;
+		}
+
+		const char* compressed = (const char*)data + sizeof(MeshCodecHeader);
+		size_t compressedSize = size - sizeof(MeshCodecHeader);
+
+		if (header.Filter == MeshCodecRaw)
+		{
+			return Lz4::Decompress(compressed, compressedSize, destination, count * stride);
+		}
+
+		//Not a vector, which would clear it first only for it to be overwritten
+		std::unique_ptr<uint8_t[]> planes(new uint8_t[count * stride]);
+
+		if (!Lz4::Decompress(compressed, compressedSize, planes.get(), count * stride))
+		{
+			return false;
+		}
+
+		uint8_t* out = (uint8_t*)destination;
+		size_t done = 0;
+
+#ifdef MESH_CODEC_SSE2
+		if (stride % 16 == 0)
+		{
+			done = wordSize == 2 ? UnfilterVertices<2>(planes.get(), out, count, stride) : UnfilterVertices<4>(planes.get(), out, count, stride);
+		}
+		else if (stride == wordSize)
+		{
+			done = UnfilterIndices(planes.get(), out, count, wordSize);
+		}
+#endif
+
+		//Whatever's left over after the last full block of 16
+		UnfilterScalar(planes.get(), out, done, count, stride, wordSize);
+
+		return true;
+	}
+}
+
+void MeshCodec::EncodeVertices(const void* vertices, size_t count, size_t stride, size_t wordSize, std::vector<char>& out)
+{
+	Encode(MeshCodecVertices, vertices, count, stride, wordSize, out);
+}
+
+void MeshCodec::EncodeIndices(const void* indices, size_t count, size_t indexSize, std::vector<char>& out)
+{
+	Encode(MeshCodecIndices, indices, count, indexSize, indexSize, out);
+}
+
+bool MeshCodec::ReadHeader(const void* data, size_t size, MeshCodecHeader& outHeader)
+{
+	if (size < sizeof(MeshCodecHeader))
+	{
+		return false;
+	}
+
+	memcpy(&outHeader, data, sizeof(MeshCodecHeader));
+
+	bool words = outHeader.WordSize == 2 || outHeader.WordSize == 4;
+	bool filter = outHeader.Filter == MeshCodecRaw || outHeader.Filter == MeshCodecDeltaPlanes;
+	return outHeader.Magic == MeshCodecMagic && words && filter && outHeader.Stride != 0 && outHeader.Stride % outHeader.WordSize == 0;
+}
+
+bool MeshCodec::DecodeVertices(const void* data, size_t size, void* destination)
+{
+	return Decode(MeshCodecVertices, data, size, destination);
+}
+
+bool MeshCodec::DecodeIndices(const void* data, size_t size, void* destination)
+{
+	return Decode(MeshCodecIndices, data, size, destination);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Compresses vertex and index buffers for the mesh cache. Both are turned into streams that compress well before going
+//through LZ4 (see Lz4.h):
+//	vertices	each 2 or 4 byte word minus the same word of the vertex before, zigzag encoded so small negative
+//				differences are small too, then split into byte planes (byte 0 of every vertex, then byte 1...)
+//	indices		each index minus the one before, zigzag encoded and split into byte planes the same way
+//After MeshOptimizer's vertex fetch ordering neighbouring vertices are close and indices mostly count up, so the high
+//byte planes are nearly all zeros. Decoding undoes the planes, zigzag and differences 16 vertices at a time with SSE2.
+//Data the filter doesn't help (e.g. unindexed meshes full of repeated vertices, which LZ4 finds as they are) is stored
+//as plain LZ4 instead, whichever is smaller.
+//
+//An encoded stream starts with a MeshCodecHeader so a decoder can check it's what it expects.
+
+const uint32_t MeshCodecMagic = 0x4344434D;		//"MCDC"
+
+enum MeshCodecStream : uint16_t
+{
+	MeshCodecVertices = 1,
+	MeshCodecIndices = 2,
+};
+
+enum MeshCodecFilter : uint16_t
+{
+	MeshCodecRaw = 0,			//LZ4 of the data as it is
+	MeshCodecDeltaPlanes = 1,	//LZ4 of the zigzag encoded differences in byte planes
+};
+
+struct MeshCodecHeader
+{
+	uint32_t Magic;
+	uint16_t Stream;			//MeshCodecStream
+	uint16_t Filter;			//MeshCodecFilter
+	uint32_t Count;				//Vertices or indices
+	uint16_t Stride;			//Bytes per vertex or index
+	uint16_t WordSize;			//Bytes differenced together, 2 or 4
+};
+
+static_assert(sizeof(MeshCodecHeader) == 16, "MeshCodecHeader is part of the mesh cache format");
+
+namespace MeshCodec
+{
+	//wordSize is the size of the vertex's components, 4 for MeshVertex's floats and 2 for QuantizedVertex.
+	//stride must be a multiple of it
+	void EncodeVertices(const void* vertices, size_t count, size_t stride, size_t wordSize, std::vector<char>& out);
+
+	//indexSize is 2 or 4
+	void EncodeIndices(const void* indices, size_t count, size_t indexSize, std::vector<char>& out);
+
+	//Reads the header of an encoded stream, returns false if it isn't one
+	bool ReadHeader(const void* data, size_t size, MeshCodecHeader& outHeader);
+
+	//Decodes into destination, which has to hold Count * Stride bytes of the stream's header.
+	//Returns false if the data is corrupt or isn't that kind of stream
+	bool DecodeVertices(const void* data, size_t size, void* destination);
+	bool DecodeIndices(const void* data, size_t size, void* destination);
+};
@@ -0,0 +1,724 @@
+#include "MeshImporter.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "MeshCodec.h"
+#include "MeshOptimizer.h"
+#include "OBJParser.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	void AppendLog(std::string& log, const char* format, ...)
+	{
+		char line[512];
+		va_list arguments;
+		va_start(arguments, format);
+		vsnprintf(line, sizeof(line), format, arguments);
+		va_end(arguments);
+		log += line;
+	}
+
+	//Copies as much of value as fits, always null terminated
+	void CopyString(char* destination, size_t size, const std::string& value)
+	{
+		size_t length = std::min(value.size(), size - 1);
+		memcpy(destination, value.data(), length);
+		destination[length] = '\0';
+	}
+
+	//"<filename>Binary" unless it's been given a name
+	std::string CacheFilenameFor(const char* filename, const char* cacheFilename)
+	{
+		return cacheFilename ? std::string(cacheFilename) : std::string(filename) + "Binary";
+	}
+
+	//Everything up to and including the last slash
+	std::string DirectoryOf(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+	}
+
+	//Meshes without submeshes (legacy caches) get one per level covering all of it
+	void AddWholeMeshSubmeshes(MeshImport& out)
+	{
+		if (!out.Submeshes.empty())
+		{
+			return;
+		}
+
+		size_t levelCount = std::max<size_t>(out.Lods.size(), 1);
+
+		for (size_t level = 0; level < levelCount; ++level)
+		{
+			MeshSubmesh submesh = {};
+			submesh.IndexStart = out.Lods.empty() ? 0 : out.Lods[level].IndexStart;
+			submesh.IndexCount = out.Lods.empty() ? out.IndexCount : out.Lods[level].IndexCount;
+			submesh.ClusterCount = level == 0 ? (uint32_t)out.Clusters.size() : 0;
+			submesh.Material = MeshNoMaterial;
+			out.Submeshes.push_back(submesh);
+		}
+	}
+
+	//Reads the OBJ's material libraries into out.Materials. Texture names are made relative to the OBJ's directory.
+	//The cache is only checked against the OBJ file, so re-export the OBJ (or delete its cache) after changing a .mtl
+	void LoadMaterials(const ObjData& objData, MeshImport& out, const char* filename)
+	{
+		for (const std::string& library : objData.MaterialLibraries)
+		{
+			std::vector<ObjMaterial> materials;
+
+			if (!OBJParser::ParseMaterialFile((out.Directory + library).c_str(), materials))
+			{
+				AppendLog(out.Log, "%s: couldn't open material library %s\n", filename, library.c_str());
+				continue;
+			}
+
+			std::string libraryDirectory = DirectoryOf(library);
+
+			for (const ObjMaterial& material : materials)
+			{
+				MeshMaterial meshMaterial = {};
+				CopyString(meshMaterial.Name, sizeof(meshMaterial.Name), material.Name);
+				CopyString(meshMaterial.DiffuseMap, sizeof(meshMaterial.DiffuseMap), material.DiffuseMap.empty() ? material.DiffuseMap : libraryDirectory + material.DiffuseMap);
+				meshMaterial.Ambient = material.Ambient;
+				meshMaterial.Diffuse = material.Diffuse;
+				meshMaterial.Specular = material.Specular;
+				meshMaterial.SpecularPower = material.SpecularPower;
+				meshMaterial.Opacity = material.Opacity;
+				out.Materials.push_back(meshMaterial);
+			}
+		}
+	}
+
+	//The triangles of one submesh while it's being imported
+	struct SubmeshBuild
+	{
+		std::string Name;
+		uint32_t Material;
+		std::vector<uint32_t> Indices;
+		std::vector<MeshCluster> Clusters;
+		std::vector<MeshLod> Lods;
+	};
+
+	//Groups with the same name and material become one submesh, in file order. Submeshes are sorted by material so the
+	//renderer only changes state between materials
+	void GatherSubmeshes(const ObjData& objData, const std::vector<uint32_t>& indices, const std::vector<MeshMaterial>& materials, std::vector<SubmeshBuild>& outSubmeshes)
+	{
+		for (const ObjGroup& group : objData.Groups)
+		{
+			uint32_t material = MeshNoMaterial;
+
+			for (size_t i = 0; i < materials.size() && material == MeshNoMaterial; ++i)
+			{
+				if (group.Material == materials[i].Name)
+				{
+					material = (uint32_t)i;
+				}
+			}
+
+			SubmeshBuild* submesh = nullptr;
+
+			for (SubmeshBuild& existing : outSubmeshes)
+			{
+				if (existing.Material == material && existing.Name == group.Name)
+				{
+					submesh = &existing;
+					break;
+				}
+			}
+
+			if (!submesh)
+			{
+				outSubmeshes.emplace_back();
+				submesh = &outSubmeshes.back();
+				submesh->Name = group.Name;
+				submesh->Material = material;
+			}
+
+			submesh->Indices.insert(submesh->Indices.end(), indices.begin() + group.FirstCorner, indices.begin() + group.FirstCorner + group.CornerCount);
+		}
+
+		//Faces before any group line, or files without faces in groups at all
+		if (outSubmeshes.empty())
+		{
+			outSubmeshes.emplace_back();
+			outSubmeshes.back().Material = MeshNoMaterial;
+			outSubmeshes.back().Indices = indices;
+		}
+
+		std::stable_sort(outSubmeshes.begin(), outSubmeshes.end(), [](const SubmeshBuild& a, const SubmeshBuild& b) { return a.Material < b.Material; });
+	}
+
+	//Decodes a MeshSectionEncodedVertices stream of vertexStride byte vertices into out's vectors
+	bool DecodeVertices(const MeshCacheView& cache, uint32_t vertexStride, MeshImport& out)
+	{
+		const MeshCacheSection* section = cache.FindSection(MeshSectionEncodedVertices);
+		MeshCodecHeader header;
+
+		if (!section || !MeshCodec::ReadHeader(cache.SectionData(*section), (size_t)section->Size, header) || header.Stride != vertexStride)
+		{
+			return false;
+		}
+
+		if (vertexStride == sizeof(QuantizedVertex))
+		{
+			out.QuantizedVertices.resize(header.Count);
+			out.VertexData = out.QuantizedVertices.data();
+		}
+		else
+		{
+			out.Vertices.resize(header.Count);
+			out.VertexData = out.Vertices.data();
+		}
+
+		out.VertexCount = header.Count;
+		return MeshCodec::DecodeVertices(cache.SectionData(*section), (size_t)section->Size, (void*)out.VertexData);
+	}
+
+	//Decodes a MeshSectionEncodedIndices stream into out's vectors
+	bool DecodeIndices(const MeshCacheView& cache, MeshImport& out)
+	{
+		const MeshCacheSection* section = cache.FindSection(MeshSectionEncodedIndices);
+		MeshCodecHeader header;
+
+		if (!section || !MeshCodec::ReadHeader(cache.SectionData(*section), (size_t)section->Size, header))
+		{
+			return false;
+		}
+
+		if (header.Stride == sizeof(uint32_t))
+		{
+			out.Indices.resize(header.Count);
+			out.IndexData = out.Indices.data();
+		}
+		else if (header.Stride == sizeof(uint16_t))
+		{
+			out.ShortIndices.resize(header.Count);
+			out.IndexData = out.ShortIndices.data();
+		}
+		else
+		{
+			return false;
+		}
+
+		out.IndexSize = header.Stride;
+		out.IndexCount = header.Count;
+		return MeshCodec::DecodeIndices(cache.SectionData(*section), (size_t)section->Size, (void*)out.IndexData);
+	}
+
+	//Uses the cache's sections in place, or decodes them if they're encoded. Returns false if a section the options need is missing
+	bool ImportFromCache(MeshImport& out, bool quantizeVertices)
+	{
+		const MeshCacheView& cache = out.Cache;
+		const MeshCacheSection* indices = cache.FindSection(MeshSectionIndices);
+		const MeshCacheSection* clusters = cache.FindSection(MeshSectionClusters);
+		const MeshCacheSection* lods = cache.FindSection(MeshSectionLods);
+		const MeshCacheSection* bounds = cache.FindSection(MeshSectionBounds);
+		const MeshCacheSection* submeshes = cache.FindSection(MeshSectionSubmeshes);
+		const MeshCacheSection* materials = cache.FindSection(MeshSectionMaterials);
+		const MeshCacheSection* stages = cache.FindSection(MeshSectionStreamStages);
+		const MeshCacheSection* vertices = cache.FindSection(quantizeVertices ? MeshSectionQuantizedVertices : MeshSectionVertices);
+		const MeshCacheSection* quantization = cache.FindSection(MeshSectionQuantization);
+		uint32_t vertexStride = quantizeVertices ? sizeof(QuantizedVertex) : sizeof(MeshVertex);
+
+		if (quantizeVertices && (!quantization || quantization->Size != sizeof(VertexQuantization)))
+		{
+			return false;
+		}
+
+		//Plain sections are used in place, encoded ones are decoded into the owned vectors
+		if (vertices && vertices->ElementSize == vertexStride)
+		{
+			out.VertexData = cache.SectionData(*vertices);
+			out.VertexCount = (uint32_t)vertices->Count;
+		}
+		else if (!DecodeVertices(cache, vertexStride, out))
+		{
+			return false;
+		}
+
+		if (indices && (indices->ElementSize == sizeof(uint32_t) || indices->ElementSize == sizeof(uint16_t)))
+		{
+			out.IndexData = cache.SectionData(*indices);
+			out.IndexSize = indices->ElementSize;
+			out.IndexCount = (uint32_t)indices->Count;
+		}
+		else if (!DecodeIndices(cache, out))
+		{
+			return false;
+		}
+
+		out.VertexStride = vertexStride;
+		out.Quantized = quantizeVertices;
+
+		if (quantizeVertices)
+		{
+			out.Quantization = *(const VertexQuantization*)cache.SectionData(*quantization);
+		}
+
+		if (clusters && clusters->ElementSize == sizeof(MeshCluster))
+		{
+			const MeshCluster* clusterData = (const MeshCluster*)cache.SectionData(*clusters);
+			out.Clusters.assign(clusterData, clusterData + clusters->Count);
+		}
+
+		if (lods && lods->ElementSize == sizeof(MeshLod) && lods->Count > 0)
+		{
+			const MeshLod* lodData = (const MeshLod*)cache.SectionData(*lods);
+			out.Lods.assign(lodData, lodData + lods->Count);
+		}
+
+		if (bounds && bounds->Size == sizeof(MeshBounds))
+		{
+			out.Bounds = *(const MeshBounds*)cache.SectionData(*bounds);
+		}
+
+		if (submeshes && submeshes->ElementSize == sizeof(MeshSubmesh))
+		{
+			const MeshSubmesh* submeshData = (const MeshSubmesh*)cache.SectionData(*submeshes);
+			out.Submeshes.assign(submeshData, submeshData + submeshes->Count);
+		}
+
+		if (materials && materials->ElementSize == sizeof(MeshMaterial))
+		{
+			const MeshMaterial* materialData = (const MeshMaterial*)cache.SectionData(*materials);
+			out.Materials.assign(materialData, materialData + materials->Count);
+		}
+
+		if (stages && stages->ElementSize == sizeof(MeshStreamStage))
+		{
+			const MeshStreamStage* stageData = (const MeshStreamStage*)cache.SectionData(*stages);
+			out.Stages.assign(stageData, stageData + stages->Count);
+		}
+
+		AddWholeMeshSubmeshes(out);
+
+		return true;
+	}
+
+	//Empties what a cache that couldn't be used left in out, before the mesh is imported some other way
+	void ResetImport(MeshImport& out)
+	{
+		out.Cache.Close();
+		out.VertexData = nullptr;
+		out.VertexStride = 0;
+		out.VertexCount = 0;
+		out.IndexData = nullptr;
+		out.IndexSize = 0;
+		out.IndexCount = 0;
+		out.Quantized = false;
+		out.Clusters.clear();
+		out.Lods.clear();
+		out.Submeshes.clear();
+		out.Materials.clear();
+		out.Stages.clear();
+		out.Vertices.clear();
+		out.QuantizedVertices.clear();
+		out.Indices.clear();
+		out.ShortIndices.clear();
+	}
+}
+
+MeshImport::MeshImport()
+{
+	VertexData = nullptr;
+	VertexStride = 0;
+	VertexCount = 0;
+	IndexData = nullptr;
+	IndexSize = 0;
+	IndexCount = 0;
+	Quantized = false;
+	Quantization = VertexQuantization();
+	Bounds = MeshBounds();
+}
+
+uint32_t MeshImporter::OptionsFor(bool invertTexCoords, bool optimizeMesh, bool quantizeVertices, bool generateLods, bool compressStreams)
+{
+	return (invertTexCoords ? MeshOptionInvertTexCoords : 0u) | (optimizeMesh ? MeshOptionOptimizeVertexCache | MeshOptionOptimizeOverdraw : 0u) |
+		(quantizeVertices ? MeshOptionQuantizeVertices : 0u) | (generateLods ? MeshOptionGenerateLods : 0u) | (compressStreams ? MeshOptionCompressStreams : 0u);
+}
+
+bool MeshImporter::ImportLegacyBinary(const char* binaryFilename, MeshImport& out)
+{
+	MappedFile binaryFile;
+
+	return binaryFile.Open(binaryFilename) && ImportLegacyMemory(binaryFile.Data(), binaryFile.Size(), out);
+}
+
+bool MeshImporter::ImportLegacyMemory(const void* data, size_t size, MeshImport& out)
+{
+	const char* bytes = (const char*)data;
+	unsigned int numVertices;
+	unsigned int numIndices;
+
+	//Read in array sizes
+	if (size < sizeof(unsigned int) * 2)
+	{
+		return false;
+	}
+
+	memcpy(&numVertices, bytes, sizeof(unsigned int));
+	memcpy(&numIndices, bytes + sizeof(unsigned int), sizeof(unsigned int));
+	bytes += sizeof(unsigned int) * 2;
+	size -= sizeof(unsigned int) * 2;
+
+	//The index width was never stored in these files, it was always decided from the vertex count
+	size_t indexSize = numVertices > MaxShortIndexedVertices ? sizeof(uint32_t) : sizeof(uint16_t);
+	size_t vertexBytes = sizeof(MeshVertex) * (size_t)numVertices;
+	size_t indexBytes = indexSize * (size_t)numIndices;
+
+	if (vertexBytes > size || indexBytes > size - vertexBytes)
+	{
+		return false;
+	}
+
+	out.Vertices.resize(numVertices);
+	memcpy(out.Vertices.data(), bytes, vertexBytes);
+	bytes += vertexBytes;
+
+	if (indexSize == sizeof(uint32_t))
+	{
+		out.Indices.resize(numIndices);
+		memcpy(out.Indices.data(), bytes, indexBytes);
+		out.IndexData = out.Indices.data();
+	}
+	else
+	{
+		out.ShortIndices.resize(numIndices);
+		memcpy(out.ShortIndices.data(), bytes, indexBytes);
+		out.IndexData = out.ShortIndices.data();
+	}
+
+	out.VertexData = out.Vertices.data();
+	out.VertexStride = sizeof(MeshVertex);
+	out.VertexCount = numVertices;
+	out.IndexSize = (uint32_t)indexSize;
+	out.IndexCount = numIndices;
+	out.Bounds = MeshBounding::ComputeBounds(out.Vertices.data(), out.Vertices.size());
+	AddWholeMeshSubmeshes(out);
+
+	return true;
+}
+
+bool MeshImporter::ImportFromMemory(const void* data, size_t size, uint32_t options, MeshImport& out, bool streaming)
+{
+	bool quantizeVertices = (options & MeshOptionQuantizeVertices) != 0;
+
+	//Skipping the hash is only safe for a cache whose stages can each be checked before they're used
+	if (streaming && out.Cache.OpenMemory(data, size, false) == MeshCacheValid && MeshCache::OptionsMatch(out.Cache.Header().Options, options) &&
+		out.Cache.FindSection(MeshSectionStreamStages) && ImportFromCache(out, quantizeVertices))
+	{
+		return true;
+	}
+
+	ResetImport(out);
+	MeshCacheStatus status = out.Cache.OpenMemory(data, size);
+
+	if (status == MeshCacheValid)
+	{
+		//There's no source to rebuild from, but a pack built with other options is still the wrong data for this load
+		if (!MeshCache::OptionsMatch(out.Cache.Header().Options, options))
+		{
+			AppendLog(out.Log, "pack entry was built with options %#x, %#x were asked for\n", out.Cache.Header().Options, options);
+			out.Cache.Close();
+			return false;
+		}
+
+		return ImportFromCache(out, quantizeVertices);
+	}
+
+	return status == MeshCacheLegacy && ImportLegacyMemory(data, size, out);
+}
+
+bool MeshImporter::ImportStreaming(const char* filename, uint32_t options, MeshImport& out, ThreadPool& pool, const char* cacheFilename)
+{
+	options |= MeshOptionProgressive;
+
+	std::string binaryFilename = CacheFilenameFor(filename, cacheFilename);
+	out.Directory = DirectoryOf(filename);
+
+	//Only the header and section table are read here, each stage's data is checked as it's streamed in
+	if (out.Cache.Open(binaryFilename.c_str(), filename, options, false) == MeshCacheValid && out.Cache.FindSection(MeshSectionStreamStages) &&
+		ImportFromCache(out, (options & MeshOptionQuantizeVertices) != 0))
+	{
+		return true;
+	}
+
+	ResetImport(out);
+	return Import(filename, options, out, pool, cacheFilename);
+}
+
+//WARNING: This code makes a big assumption -- that your models have texture coordinates AND normals which they should have anyway (else you can't do texturing and lighting!)
+//If your .obj file has no lines beginning with "vt" or "vn", then you'll need to change the Export settings in your modelling software so that it exports the texture coordinates
+//and normals. If you still have no "vt" lines, you'll need to do some texture unwrapping, also known as UV unwrapping.
+bool MeshImporter::Import(const char* filename, uint32_t options, MeshImport& out, ThreadPool& pool, const char* cacheFilename)
+{
+	std::string binaryFilename = CacheFilenameFor(filename, cacheFilename);
+	out.Directory = DirectoryOf(filename);
+
+	bool invertTexCoords = (options & MeshOptionInvertTexCoords) != 0;
+	bool optimizeMesh = (options & MeshOptionOptimizeVertexCache) != 0;
+	bool quantizeVertices = (options & MeshOptionQuantizeVertices) != 0;
+	bool generateLods = (options & MeshOptionGenerateLods) != 0;
+	bool progressive = (options & MeshOptionProgressive) != 0;
+
+	//If the binary cache exists and still matches the OBJ file and options, the vertex and index sections are
+	//handed to CreateBuffer straight out of the mapped file without any copying
+	MeshCacheStatus status = out.Cache.Open(binaryFilename.c_str(), filename, options);
+
+	if (status == MeshCacheValid && ImportFromCache(out, quantizeVertices))
+	{
+		return true;
+	}
+
+	ResetImport(out);
+
+	//The OBJ file is memory mapped and parsed in place, see OBJParser.cpp
+	MappedFile objFile;
+
+	if (!objFile.Open(filename))
+	{
+		//Caches from before the versioned format are still used when there's no OBJ file to rebuild them from
+		return status == MeshCacheLegacy && ImportLegacyBinary(binaryFilename.c_str(), out);
+	}
+
+	MeshCacheSource source;
+	MeshCache::DescribeSource(filename, source, false);
+	source.Hash = ContentHash(objFile.Data(), objFile.Size());
+
+	//Big files are split up and parsed across the thread pool, small ones are just parsed on this thread
+	ObjData objData;
+	OBJParser::ParseBufferParallel(objFile.Data(), objFile.Size(), objData, pool, invertTexCoords);
+	objFile.Close();
+
+	//DirectX uses 1 index buffer, OBJ is optimized for storage and not rendering and so uses 3 smaller index buffers.....great...
+	//CreateIndices merges them into 1 index buffer, welding identical vertices together as it goes.
+	std::vector<MeshVertex>& meshVertices = out.Vertices;
+	std::vector<uint32_t>& meshIndices = out.Indices;
+
+	OBJParser::CreateIndices(objData, meshVertices, meshIndices);
+
+	if (meshIndices.empty())
+	{
+		return false;
+	}
+
+	//Faces come out in file order, which hardly ever reuses vertices while they're still in the post-transform cache
+	VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(meshIndices, meshVertices.size());
+
+	LoadMaterials(objData, out, filename);
+
+	//Each submesh goes through the import steps on its own so its triangles stay one range of the index buffer. They
+	//only share read-only vertices, so they're done in parallel
+	std::vector<SubmeshBuild> submeshes;
+	GatherSubmeshes(objData, meshIndices, out.Materials, submeshes);
+
+	pool.ParallelFor(submeshes.size(), [&](size_t i)
+	{
+		SubmeshBuild& submesh = submeshes[i];
+
+		if (optimizeMesh)
+		{
+			MeshOptimizer::OptimizeVertexCache(submesh.Indices, meshVertices.size());
+
+			//Then the cache ordered triangles are grouped into clusters which are sorted so the outward facing ones draw first.
+			//Benchmarks/OverdrawBench.cpp shows what other thresholds trade
+			MeshOptimizer::OptimizeOverdraw(submesh.Indices, meshVertices, MeshOptimizer::DefaultOverdrawThreshold);
+		}
+
+		//Small patches of triangles with a bounding sphere and normal cone each, so the renderer can skip the ones that are
+		//off screen or facing away. Each becomes a contiguous range of the index buffer
+		MeshClusters::BuildClusters(meshVertices, submesh.Indices, submesh.Clusters);
+
+		//Simplified copies of the submesh go on the end of its indices and share the mesh's vertices. The errors are in model
+		//units, the renderer turns them into pixels to pick a level, see Application::SelectLod
+		if (generateLods)
+		{
+			MeshSimplifier::GenerateLods(meshVertices, submesh.Indices, submesh.Lods);
+		}
+	});
+
+	//Level by level, each level being every submesh's version of it in submesh order
+	size_t levelCount = 1;
+
+	for (const SubmeshBuild& submesh : submeshes)
+	{
+		levelCount = std::max(levelCount, submesh.Lods.size());
+	}
+
+	meshIndices.clear();
+
+	for (size_t level = 0; level < levelCount; ++level)
+	{
+		MeshLod lod = { (uint32_t)meshIndices.size(), 0, 0.0f };
+
+		for (const SubmeshBuild& submesh : submeshes)
+		{
+			//Submeshes too small to simplify as far as the others use their last level again
+			MeshLod range = { 0, (uint32_t)submesh.Indices.size(), 0.0f };
+
+			if (!submesh.Lods.empty())
+			{
+				range = submesh.Lods[std::min(level, submesh.Lods.size() - 1)];
+			}
+
+			MeshSubmesh entry = {};
+			entry.IndexStart = (uint32_t)meshIndices.size();
+			entry.IndexCount = range.IndexCount;
+			entry.Material = submesh.Material;
+			CopyString(entry.Name, sizeof(entry.Name), submesh.Name);
+
+			if (level == 0)
+			{
+				entry.ClusterStart = (uint32_t)out.Clusters.size();
+				entry.ClusterCount = (uint32_t)submesh.Clusters.size();
+
+				for (MeshCluster cluster : submesh.Clusters)
+				{
+					cluster.IndexStart += entry.IndexStart;
+					out.Clusters.push_back(cluster);
+				}
+			}
+
+			meshIndices.insert(meshIndices.end(), submesh.Indices.begin() + range.IndexStart, submesh.Indices.begin() + range.IndexStart + range.IndexCount);
+			out.Submeshes.push_back(entry);
+			lod.Error = std::max(lod.Error, range.Error);
+		}
+
+		lod.IndexCount = (uint32_t)meshIndices.size() - lod.IndexStart;
+
+		if (generateLods)
+		{
+			out.Lods.push_back(lod);
+		}
+	}
+
+	if (optimizeMesh)
+	{
+		std::vector<uint32_t> fullDetail(meshIndices.begin(), meshIndices.begin() + (out.Lods.empty() ? meshIndices.size() : out.Lods[0].IndexCount));
+		VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(fullDetail, meshVertices.size());
+		AppendLog(out.Log, "%s: %u submeshes, %u materials, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", filename, (unsigned int)submeshes.size(),
+			(unsigned int)out.Materials.size(), before.Acmr, after.Acmr, before.Atvr, after.Atvr);
+	}
+
+	for (size_t level = 1; level < out.Lods.size(); ++level)
+	{
+		AppendLog(out.Log, "%s: LOD %u, %u triangles, error %g\n", filename, (unsigned int)level, out.Lods[level].IndexCount / 3, out.Lods[level].Error);
+	}
+
+	//A progressive mesh's vertices have to be in the order its levels use them coarsest first, which is still each level's
+	//first use order, so vertex fetch walks forwards through every level but the full detail one's jumps between stages
+	if (progressive)
+	{
+		MeshStream::OrderVertices(meshVertices, meshIndices, out.Lods, out.Stages);
+	}
+	else if (optimizeMesh)
+	{
+		MeshOptimizer::OptimizeVertexFetch(meshVertices, meshIndices);
+	}
+
+	//Taken from the full precision vertices, quantizing moves them by less than half a 16-bit step
+	out.Bounds = MeshBounding::ComputeBounds(meshVertices.data(), meshVertices.size());
+
+	uint32_t numMeshVertices = (uint32_t)meshVertices.size();
+	uint32_t numMeshIndices = (uint32_t)meshIndices.size();
+
+	//Only meshes with too many vertices for a 16-bit index pay for 32-bit indices, everything else is narrowed to halve the index bandwidth
+	out.IndexData = meshIndices.data();
+	out.IndexSize = sizeof(uint32_t);
+	out.IndexCount = numMeshIndices;
+
+	if (numMeshVertices <= MaxShortIndexedVertices)
+	{
+		out.ShortIndices.assign(meshIndices.begin(), meshIndices.end());
+		out.IndexData = out.ShortIndices.data();
+		out.IndexSize = sizeof(uint16_t);
+	}
+
+	//Output data into the binary cache, the next time this runs it will load that instead which is much quicker than parsing the OBJ file
+	std::vector<MeshCacheSectionData> sections;
+	//An encoded stream can only be decoded whole, so a progressive cache is left uncompressed for its stages to be read one at a time
+	bool compressStreams = (options & MeshOptionCompressStreams) != 0 && !progressive;
+	std::vector<char> encodedIndices;
+	std::vector<char> encodedVertices;
+
+	if (compressStreams)
+	{
+		MeshCodec::EncodeIndices(out.IndexData, numMeshIndices, out.IndexSize, encodedIndices);
+		sections.push_back({ MeshSectionEncodedIndices, 1, encodedIndices.size(), encodedIndices.data() });
+	}
+	else
+	{
+		sections.push_back({ MeshSectionIndices, out.IndexSize, numMeshIndices, out.IndexData });
+	}
+	sections.push_back({ MeshSectionClusters, sizeof(MeshCluster), out.Clusters.size(), out.Clusters.data() });
+	sections.push_back({ MeshSectionBounds, sizeof(MeshBounds), 1, &out.Bounds });
+	sections.push_back({ MeshSectionSubmeshes, sizeof(MeshSubmesh), out.Submeshes.size(), out.Submeshes.data() });
+
+	if (!out.Materials.empty())
+	{
+		sections.push_back({ MeshSectionMaterials, sizeof(MeshMaterial), out.Materials.size(), out.Materials.data() });
+	}
+
+	if (!out.Lods.empty())
+	{
+		sections.push_back({ MeshSectionLods, sizeof(MeshLod), out.Lods.size(), out.Lods.data() });
+	}
+
+	if (quantizeVertices)
+	{
+		//Halves the vertex buffer, the error report shows what that costs in precision
+		out.Quantization = VertexQuantizer::ComputeQuantization(meshVertices);
+		VertexQuantizer::Quantize(meshVertices, out.Quantization, out.QuantizedVertices);
+
+		QuantizationError error = VertexQuantizer::MeasureError(meshVertices, out.QuantizedVertices, out.Quantization);
+		AppendLog(out.Log, "%s: quantized vertices, max position error %g (%.5f%% of the bounds), max normal error %.4f degrees, max uv error %g\n",
+			filename, error.MaxPosition, error.MaxPositionRelative * 100.0f, error.MaxNormalDegrees, error.MaxTexCoord);
+
+		sections.push_back({ MeshSectionQuantizedVertices, sizeof(QuantizedVertex), numMeshVertices, out.QuantizedVertices.data() });
+		sections.push_back({ MeshSectionQuantization, sizeof(VertexQuantization), 1, &out.Quantization });
+
+		out.VertexData = out.QuantizedVertices.data();
+		out.VertexStride = sizeof(QuantizedVertex);
+		out.Quantized = true;
+	}
+	else
+	{
+		//MeshVertex has the same layout as SimpleVertex, so the vector can be used as the buffer data directly
+		sections.push_back({ MeshSectionVertices, sizeof(MeshVertex), numMeshVertices, meshVertices.data() });
+
+		out.VertexData = meshVertices.data();
+		out.VertexStride = sizeof(MeshVertex);
+	}
+
+	out.VertexCount = numMeshVertices;
+
+	if (progressive)
+	{
+		MeshStream::HashStages(out);
+		sections.push_back({ MeshSectionStreamStages, sizeof(MeshStreamStage), out.Stages.size(), out.Stages.data() });
+	}
+
+	//The vertex section is swapped for its encoded stream, words are the floats or the quantized vertex's shorts
+	if (compressStreams)
+	{
+		MeshCodec::EncodeVertices(out.VertexData, numMeshVertices, out.VertexStride, quantizeVertices ? sizeof(uint16_t) : sizeof(float), encodedVertices);
+
+		for (MeshCacheSectionData& section : sections)
+		{
+			if (section.Type == MeshSectionVertices || section.Type == MeshSectionQuantizedVertices)
+			{
+				section = { MeshSectionEncodedVertices, 1, encodedVertices.size(), encodedVertices.data() };
+			}
+		}
+	}
+
+	MeshCache::Write(binaryFilename.c_str(), source, options, sections);
+
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MeshBounds.h"
+#include "MeshCache.h"
+#include "MeshClusters.h"
+#include "MeshMaterials.h"
+#include "MeshSimplifier.h"
+#include "MeshStream.h"
+#include "MeshTypes.h"
+#include "VertexQuantizer.h"
+
+class ThreadPool;
+
+//Everything needed to create a mesh's GPU buffers, prepared without touching D3D so it can be done on any thread.
+//The vertex and index pointers point either into the mapped cache or into the vectors below, so a MeshImport
+//has to outlive the buffers being created from it
+struct MeshImport
+{
+	MeshCacheView Cache;
+
+	const void* VertexData;
+	uint32_t VertexStride;			//sizeof(MeshVertex) or sizeof(QuantizedVertex)
+	uint32_t VertexCount;
+	const void* IndexData;
+	uint32_t IndexSize;				//2 or 4 bytes
+	uint32_t IndexCount;			//Including any levels of detail after the full mesh
+
+	bool Quantized;
+	VertexQuantization Quantization;
+	std::vector<MeshCluster> Clusters;
+	std::vector<MeshLod> Lods;
+	std::vector<MeshSubmesh> Submeshes;		//At least one per level of detail, see MeshSubmesh
+	std::vector<MeshMaterial> Materials;
+	std::vector<MeshStreamStage> Stages;	//Coarsest first, empty unless it was imported with MeshOptionProgressive
+	MeshBounds Bounds;
+
+	//The OBJ file's directory with a trailing slash (or empty), which material texture names are relative to
+	std::string Directory;
+
+	//What importing reported (vertex cache stats, quantization error and so on), one line each
+	std::string Log;
+
+	//Owned data for meshes that didn't come straight out of the cache, or whose cache streams were encoded
+	std::vector<MeshVertex> Vertices;
+	std::vector<QuantizedVertex> QuantizedVertices;
+	std::vector<uint32_t> Indices;
+	std::vector<uint16_t> ShortIndices;
+
+	//A compressed AssetPack entry decompressed for ImportFromMemory, which Cache then points into
+	std::vector<char> PackedData;
+
+	MeshImport();
+	MeshImport(const MeshImport&) = delete;
+	MeshImport& operator=(const MeshImport&) = delete;
+};
+
+namespace MeshImporter
+{
+	//The MeshCacheOptions matching OBJLoader::Load's parameters. compressStreams writes the cache's vertices and indices with MeshCodec
+	uint32_t OptionsFor(bool invertTexCoords, bool optimizeMesh, bool quantizeVertices, bool generateLods, bool compressStreams = false);
+
+	//Loads "<filename>Binary" if it's up to date, otherwise parses filename and its .mtl files, runs the import steps the
+	//options ask for on each submesh and writes a new cache. Caches from before the versioned format are used when there's no OBJ file to rebuild them from.
+	//Big OBJ files are parsed across pool. cacheFilename replaces "<filename>Binary" if it's set. Returns false if there was nothing to load
+	bool Import(const char* filename, uint32_t options, MeshImport& out, ThreadPool& pool, const char* cacheFilename = nullptr);
+
+	//Like Import with MeshOptionProgressive added, but a cache with stream stages is only opened, not read or hashed, so
+	//its levels can be read in coarsest first with MeshStream::CheckStage. Anything else is imported and checked whole,
+	//rebuilding the cache as a progressive one when there's an OBJ file to rebuild it from
+	bool ImportStreaming(const char* filename, uint32_t options, MeshImport& out, ThreadPool& pool, const char* cacheFilename = nullptr);
+
+	//Uses a mesh cache that's already in memory, e.g. an AssetPack entry, in place. Caches from before the versioned
+	//format are copied out. Returns false if it's corrupt or was built with other options (see MeshCache::OptionsMatch).
+	//streaming opens a cache with stream stages without hashing it, as ImportStreaming does
+	bool ImportFromMemory(const void* data, size_t size, uint32_t options, MeshImport& out, bool streaming = false);
+
+	//Reads one of the unversioned "<vertex count><index count><vertices><indices>" caches
+	bool ImportLegacyBinary(const char* binaryFilename, MeshImport& out);
+	bool ImportLegacyMemory(const void* data, size_t size, MeshImport& out);
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include "MeshTypes.h"
+
+//Submesh material for faces that had no usemtl, or one the .mtl files didn't define. The renderer draws those with its own defaults
+const uint32_t MeshNoMaterial = 0xFFFFFFFF;
+
+//A material from a .mtl file, fixed size so it can go in the mesh cache as it is
+struct MeshMaterial
+{
+	char Name[64];
+	char DiffuseMap[128];		//map_Kd, relative to the OBJ file's directory. Empty if there isn't one
+	MeshFloat3 Ambient;			//Ka
+	MeshFloat3 Diffuse;			//Kd
+	MeshFloat3 Specular;		//Ks
+	float SpecularPower;		//Ns
+	float Opacity;				//d, or 1 - Tr
+	float Reserved;
+};
+
+//A range of a mesh's index buffer drawn with one material. All submeshes share the mesh's vertex and index buffers, and
+//they're sorted by material so drawing them in order only changes state between materials.
+//A mesh with levels of detail has one set of submeshes per level, level n's are [n * count, (n + 1) * count)
+struct MeshSubmesh
+{
+	uint32_t IndexStart;
+	uint32_t IndexCount;
+	uint32_t ClusterStart;		//Range of the mesh's clusters covering this submesh, only in the full detail level
+	uint32_t ClusterCount;
+	uint32_t Material;			//Into the mesh's materials, or MeshNoMaterial
+	char Name[44];				//From the OBJ's "o" or "g" line
+};
+
+static_assert(sizeof(MeshMaterial) == 240, "MeshMaterial is part of the mesh cache format");
+static_assert(sizeof(MeshSubmesh) == 64, "MeshSubmesh is part of the mesh cache format");
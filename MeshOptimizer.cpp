@@ -0,0 +1,543 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	//Tuning values from Forsyth's article. The cache modelled when scoring is bigger than real hardware on purpose,
+	//that way the ordering is good for any cache up to this size rather than tuned to one
+	const int ScoringCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriangleScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	//Vertices with more triangles than this left all get the same valence boost
+	const uint32_t MaxScoredValence = 32;
+
+	struct ScoreTables
+	{
+		float Cache[ScoringCacheSize];
+		float Valence[MaxScoredValence + 1];
+
+		ScoreTables()
+		{
+			for (int i = 0; i < ScoringCacheSize; ++i)
+			{
+				//The 3 vertices of the triangle just added get a fixed score, so the next triangle doesn't
+				//just reuse them and then leave a long thin strip behind
+				if (i < 3)
+				{
+					Cache[i] = LastTriangleScore;
+				}
+				else
+				{
+					Cache[i] = std::pow(1.0f - (float)(i - 3) / (ScoringCacheSize - 3), CacheDecayPower);
+				}
+			}
+
+			//Vertices with only a few triangles left are boosted so they get finished off instead of being left as lone triangles
+			Valence[0] = 0.0f;
+
+			for (uint32_t i = 1; i <= MaxScoredValence; ++i)
+			{
+				Valence[i] = ValenceBoostScale * std::pow((float)i, -ValenceBoostPower);
+			}
+		}
+	};
+
+	inline float VertexScore(const ScoreTables& tables, int cachePosition, uint32_t remainingTriangles)
+	{
+		//Nothing left to draw with it
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = cachePosition >= 0 ? tables.Cache[cachePosition] : 0.0f;
+		return score + tables.Valence[remainingTriangles < MaxScoredValence ? remainingTriangles : MaxScoredValence];
+	}
+
+	//The same FIFO model AnalyzeVertexCache uses, but it can be emptied part way through a mesh
+	struct FifoCache
+	{
+		std::vector<uint32_t> LoadedAt;
+		uint32_t Time;
+		uint32_t Size;
+
+		FifoCache(size_t vertexCount, uint32_t size) : LoadedAt(vertexCount, 0), Time(size + 1), Size(size) {}
+
+		void Reset() { Time += Size + 1; }
+
+		//Returns how many of the triangle's vertices had to be transformed
+		uint32_t AddTriangle(const uint32_t* triangle)
+		{
+			uint32_t misses = 0;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				if (Time - LoadedAt[triangle[i]] > Size)
+				{
+					LoadedAt[triangle[i]] = Time++;
+					++misses;
+				}
+			}
+
+			return misses;
+		}
+	};
+
+	struct OverdrawCluster
+	{
+		size_t Start;			//First and one past the last triangle
+		size_t End;
+		float SortKey;
+	};
+
+	inline MeshFloat3 Subtract(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	inline MeshFloat3 Cross(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	inline float Dot(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline MeshFloat3 Normalize(const MeshFloat3& a)
+	{
+		float length = std::sqrt(Dot(a, a));
+		return length > 0.0f ? MeshFloat3{ a.x / length, a.y / length, a.z / length } : MeshFloat3{ 0.0f, 0.0f, 0.0f };
+	}
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats = { 0, 0.0f, 0.0f };
+
+	//A vertex is in the FIFO if fewer than cacheSize misses have happened since it was loaded
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+
+	for (uint32_t index : indices)
+	{
+		if (time - loadedAt[index] > cacheSize)
+		{
+			loadedAt[index] = time++;
+			++stats.VerticesTransformed;
+		}
+	}
+
+	size_t triangleCount = indices.size() / 3;
+	stats.Acmr = triangleCount ? (float)stats.VerticesTransformed / triangleCount : 0.0f;
+	stats.Atvr = vertexCount ? (float)stats.VerticesTransformed / vertexCount : 0.0f;
+
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	static const ScoreTables tables;
+
+	//Which triangles use each vertex. The first Remaining[v] entries of a vertex's range are the ones not yet emitted
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		++remaining[indices[i]];
+	}
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+	}
+
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		adjacency[filled[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		vertexScore[v] = VertexScore(tables, -1, remaining[v]);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output(triangleCount * 3);
+
+	//Room for the scoring cache plus the 3 vertices pushed in by a new triangle
+	uint32_t cache[ScoringCacheSize + 3];
+	uint32_t newCache[ScoringCacheSize + 3];
+	int cacheCount = 0;
+
+	int bestTriangle = -1;
+	size_t inputCursor = 0;
+
+	for (size_t outputTriangle = 0; outputTriangle < triangleCount; ++outputTriangle)
+	{
+		//Nothing in the cache is connected to anything left, so carry on from the next triangle in the original order
+		if (bestTriangle < 0)
+		{
+			while (emitted[inputCursor]) ++inputCursor;
+			bestTriangle = (int)inputCursor;
+		}
+
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		output[outputTriangle * 3 + 0] = triangle[0];
+		output[outputTriangle * 3 + 1] = triangle[1];
+		output[outputTriangle * 3 + 2] = triangle[2];
+		emitted[bestTriangle] = true;
+
+		int newCount = 0;
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = triangle[corner];
+
+			//Swap the triangle out of the vertex's remaining range
+			uint32_t* begin = &adjacency[firstTriangle[vertex]];
+			uint32_t* last = begin + remaining[vertex] - 1;
+
+			for (uint32_t* it = begin; it <= last; ++it)
+			{
+				if (*it == (uint32_t)bestTriangle)
+				{
+					*it = *last;
+					*last = (uint32_t)bestTriangle;
+					--remaining[vertex];
+					break;
+				}
+			}
+
+			//Degenerate triangles can name the same vertex twice, it only goes in the cache once
+			if (newCount == 0 || (newCache[0] != vertex && (newCount < 2 || newCache[1] != vertex)))
+			{
+				newCache[newCount++] = vertex;
+			}
+		}
+
+		//Most recently used first, everything else in the cache moves back
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			uint32_t vertex = cache[i];
+
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+			{
+				newCache[newCount++] = vertex;
+			}
+		}
+
+		//Anything past the end of the scoring cache has just been evicted
+		for (int i = ScoringCacheSize; i < newCount; ++i)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScore[newCache[i]] = VertexScore(tables, -1, remaining[newCache[i]]);
+		}
+
+		cacheCount = newCount < ScoringCacheSize ? newCount : ScoringCacheSize;
+
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			cache[i] = newCache[i];
+			cachePosition[cache[i]] = i;
+			vertexScore[cache[i]] = VertexScore(tables, i, remaining[cache[i]]);
+		}
+
+		//Only triangles touching the cache had their score change, the best of them is drawn next
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			uint32_t vertex = cache[i];
+			const uint32_t* triangles = &adjacency[firstTriangle[vertex]];
+
+			for (uint32_t t = 0; t < remaining[vertex]; ++t)
+			{
+				const uint32_t* candidate = &indices[triangles[t] * 3];
+				float score = vertexScore[candidate[0]] + vertexScore[candidate[1]] + vertexScore[candidate[2]];
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = (int)triangles[t];
+				}
+			}
+		}
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	FifoCache cache(vertices.size(), DefaultCacheSize);
+
+	//Hard boundaries: a triangle that misses on all 3 vertices has nothing to do with what came before it, so the
+	//vertex cache optimizer has started a new patch and splitting there costs nothing
+	std::vector<size_t> hardBoundaries;
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		if (cache.AddTriangle(&indices[t * 3]) == 3 || t == 0)
+		{
+			hardBoundaries.push_back(t);
+		}
+	}
+
+	hardBoundaries.push_back(triangleCount);
+
+	//Soft boundaries: each patch is split again as soon as the part of it so far, drawn from an empty cache, has an ACMR
+	//within threshold of the whole patch's. Smaller clusters sort better but restart the cache more often
+	std::vector<OverdrawCluster> clusters;
+
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+	{
+		size_t start = hardBoundaries[h];
+		size_t end = hardBoundaries[h + 1];
+
+		cache.Reset();
+		uint32_t patchMisses = 0;
+
+		for (size_t t = start; t < end; ++t)
+		{
+			patchMisses += cache.AddTriangle(&indices[t * 3]);
+		}
+
+		float targetAcmr = threshold * patchMisses / (float)(end - start);
+
+		cache.Reset();
+		size_t clusterStart = start;
+		uint32_t misses = 0;
+
+		for (size_t t = start; t < end; ++t)
+		{
+			misses += cache.AddTriangle(&indices[t * 3]);
+
+			if (t + 1 < end && misses <= targetAcmr * (float)(t + 1 - clusterStart))
+			{
+				clusters.push_back({ clusterStart, t + 1, 0.0f });
+				clusterStart = t + 1;
+				misses = 0;
+				cache.Reset();
+			}
+		}
+
+		clusters.push_back({ clusterStart, end, 0.0f });
+	}
+
+	MeshFloat3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+
+	for (const MeshVertex& vertex : vertices)
+	{
+		meshCentroid.x += vertex.Pos.x;
+		meshCentroid.y += vertex.Pos.y;
+		meshCentroid.z += vertex.Pos.z;
+	}
+
+	float inverseCount = vertices.empty() ? 0.0f : 1.0f / vertices.size();
+	meshCentroid = { meshCentroid.x * inverseCount, meshCentroid.y * inverseCount, meshCentroid.z * inverseCount };
+
+	//A cluster that's further out along its own average normal is more likely to be in front of the rest of the mesh
+	for (OverdrawCluster& cluster : clusters)
+	{
+		MeshFloat3 centroid = { 0.0f, 0.0f, 0.0f };
+		MeshFloat3 normal = { 0.0f, 0.0f, 0.0f };
+		float totalArea = 0.0f;
+
+		for (size_t t = cluster.Start; t < cluster.End; ++t)
+		{
+			const MeshFloat3& a = vertices[indices[t * 3 + 0]].Pos;
+			const MeshFloat3& b = vertices[indices[t * 3 + 1]].Pos;
+			const MeshFloat3& c = vertices[indices[t * 3 + 2]].Pos;
+
+			//Twice the area, pointing along the face normal
+			MeshFloat3 areaNormal = Cross(Subtract(b, a), Subtract(c, a));
+			float area = std::sqrt(Dot(areaNormal, areaNormal));
+
+			centroid.x += (a.x + b.x + c.x) * area;
+			centroid.y += (a.y + b.y + c.y) * area;
+			centroid.z += (a.z + b.z + c.z) * area;
+			normal.x += areaNormal.x;
+			normal.y += areaNormal.y;
+			normal.z += areaNormal.z;
+			totalArea += area;
+		}
+
+		if (totalArea > 0.0f)
+		{
+			float scale = 1.0f / (3.0f * totalArea);
+			centroid = { centroid.x * scale, centroid.y * scale, centroid.z * scale };
+			cluster.SortKey = Dot(Subtract(centroid, meshCentroid), Normalize(normal));
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const OverdrawCluster& a, const OverdrawCluster& b) { return a.SortKey > b.SortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	for (const OverdrawCluster& cluster : clusters)
+	{
+		output.insert(output.end(), indices.begin() + cluster.Start * 3, indices.begin() + cluster.End * 3);
+	}
+
+	indices.swap(output);
+}
+
+OverdrawStats MeshOptimizer::AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, uint32_t viewCount, uint32_t resolution)
+{
+	OverdrawStats stats = { 0, 0, 0.0f };
+
+	if (vertices.empty() || indices.size() < 3 || viewCount == 0 || resolution == 0)
+	{
+		return stats;
+	}
+
+	//Every view is scaled to fit the bounding sphere, so the mesh is the same size on screen from all of them
+	MeshFloat3 minimum = vertices[0].Pos;
+	MeshFloat3 maximum = vertices[0].Pos;
+
+	for (const MeshVertex& vertex : vertices)
+	{
+		minimum = { std::min(minimum.x, vertex.Pos.x), std::min(minimum.y, vertex.Pos.y), std::min(minimum.z, vertex.Pos.z) };
+		maximum = { std::max(maximum.x, vertex.Pos.x), std::max(maximum.y, vertex.Pos.y), std::max(maximum.z, vertex.Pos.z) };
+	}
+
+	MeshFloat3 center = { (minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f };
+	MeshFloat3 extent = Subtract(maximum, center);
+	float radius = std::sqrt(Dot(extent, extent));
+	float scale = radius > 0.0f ? 0.5f * resolution / radius : 0.0f;
+
+	std::vector<float> depth(resolution * resolution);
+	std::vector<MeshFloat3> projected(vertices.size());
+	const float goldenAngle = 2.39996323f;
+
+	for (uint32_t view = 0; view < viewCount; ++view)
+	{
+		//Directions on a Fibonacci sphere, roughly evenly spaced however many there are
+		float y = 1.0f - 2.0f * (view + 0.5f) / viewCount;
+		float ring = std::sqrt(std::max(0.0f, 1.0f - y * y));
+		MeshFloat3 forward = { ring * std::cos(goldenAngle * view), y, ring * std::sin(goldenAngle * view) };
+		MeshFloat3 up = std::fabs(forward.y) < 0.99f ? MeshFloat3{ 0.0f, 1.0f, 0.0f } : MeshFloat3{ 1.0f, 0.0f, 0.0f };
+		MeshFloat3 right = Normalize(Cross(up, forward));
+		up = Cross(forward, right);
+
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			MeshFloat3 offset = Subtract(vertices[i].Pos, center);
+			projected[i] = { Dot(offset, right) * scale + 0.5f * resolution, Dot(offset, up) * scale + 0.5f * resolution, Dot(offset, forward) };
+		}
+
+		std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			const MeshFloat3& a = projected[indices[t + 0]];
+			const MeshFloat3& b = projected[indices[t + 1]];
+			const MeshFloat3& c = projected[indices[t + 2]];
+
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+			if (area == 0.0f)
+			{
+				continue;
+			}
+
+			//No culling, so flip the edge functions of triangles wound the other way
+			float sign = area > 0.0f ? 1.0f : -1.0f;
+			float inverseArea = 1.0f / std::fabs(area);
+
+			int minX = std::max(0, (int)std::floor(std::min({ a.x, b.x, c.x })));
+			int maxX = std::min((int)resolution - 1, (int)std::ceil(std::max({ a.x, b.x, c.x })));
+			int minY = std::max(0, (int)std::floor(std::min({ a.y, b.y, c.y })));
+			int maxY = std::min((int)resolution - 1, (int)std::ceil(std::max({ a.y, b.y, c.y })));
+
+			for (int py = minY; py <= maxY; ++py)
+			{
+				float sampleY = py + 0.5f;
+
+				for (int px = minX; px <= maxX; ++px)
+				{
+					float sampleX = px + 0.5f;
+
+					//Pixel centres exactly on an edge are rare enough with float positions that no fill rule is needed
+					float wa = sign * ((c.x - b.x) * (sampleY - b.y) - (c.y - b.y) * (sampleX - b.x));
+					float wb = sign * ((a.x - c.x) * (sampleY - c.y) - (a.y - c.y) * (sampleX - c.x));
+					float wc = sign * ((b.x - a.x) * (sampleY - a.y) - (b.y - a.y) * (sampleX - a.x));
+
+					if (wa <= 0.0f || wb <= 0.0f || wc <= 0.0f)
+					{
+						continue;
+					}
+
+					float z = (wa * a.z + wb * b.z + wc * c.z) * inverseArea;
+					float& stored = depth[py * resolution + px];
+
+					if (z < stored)
+					{
+						stored = z;
+						++stats.PixelsShaded;
+					}
+				}
+			}
+		}
+
+		for (float value : depth)
+		{
+			if (value != std::numeric_limits<float>::infinity()) ++stats.PixelsCovered;
+		}
+	}
+
+	stats.Overdraw = stats.PixelsCovered ? (float)stats.PixelsShaded / stats.PixelsCovered : 0.0f;
+
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices)
+{
+	const uint32_t unused = 0xFFFFFFFF;
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<MeshVertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = (uint32_t)reordered.size();
+			reordered.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(reordered);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MeshTypes.h"
+
+//How well an index buffer uses the post-transform vertex cache
+struct VertexCacheStats
+{
+	uint32_t VerticesTransformed;	//Cache misses, i.e. how many times the vertex shader runs
+	float Acmr;						//Average cache miss ratio, transformed vertices per triangle. 0.5 is the best possible, 3 the worst
+	float Atvr;						//Average transformed vertex ratio, transformed vertices per unique vertex. 1 is the best possible
+};
+
+//How many times pixels are shaded when a mesh is drawn with depth testing, averaged over a set of views
+struct OverdrawStats
+{
+	uint64_t PixelsCovered;			//Pixels the mesh covers at least once
+	uint64_t PixelsShaded;			//Pixels that passed the depth test, including ones drawn over again later
+	float Overdraw;					//PixelsShaded / PixelsCovered, 1 means nothing was drawn over
+};
+
+//Offline mesh processing for the import pipeline. Like OBJParser this doesn't touch D3D, so it also
+//builds into the headless tools.
+namespace MeshOptimizer
+{
+	//The FIFO cache size used to report ACMR/ATVR. Close enough to what most GPUs behave like to compare orderings
+	const uint32_t DefaultCacheSize = 16;
+
+	//How much worse OptimizeOverdraw may make the ACMR of each part of the mesh, 1.05 allows 5%
+	const float DefaultOverdrawThreshold = 1.05f;
+
+	//Views AnalyzeOverdraw looks at the mesh from, spread evenly over a sphere around it
+	const uint32_t DefaultOverdrawViews = 16;
+
+	//Simulates a FIFO post-transform cache of cacheSize entries over a triangle list
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+	//Reorders triangles so that vertices are reused while they're still in the post-transform cache.
+	//This is Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", which doesn't depend on the exact cache size.
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	//Splits an index buffer that has already been through OptimizeVertexCache into clusters and sorts them so the ones
+	//facing out from the middle of the mesh, which tend to hide the others, are drawn first. That works from any view
+	//so it can be done offline. Clusters are split wherever the cache naturally starts over, and further at points
+	//where restarting the cache leaves their ACMR no more than threshold times worse.
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold = DefaultOverdrawThreshold);
+
+	//Software rasterizes the mesh with a depth test from viewCount orthographic views at resolution x resolution,
+	//in index buffer order and without culling, the way the framework draws it
+	OverdrawStats AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices,
+		uint32_t viewCount = DefaultOverdrawViews, uint32_t resolution = 256);
+
+	//Reorders vertices into the order the index buffer first uses them so vertex fetch walks memory forwards.
+	//Vertices no index refers to are dropped
+	void OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices);
+};
@@ -0,0 +1,271 @@
+#include "MeshReloader.h"
+#include "MeshImporter.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+MeshReloader::MeshReloader()
+{
+	_device = nullptr;
+	_textures = nullptr;
+	_pool = nullptr;
+	_importing = 0;
+	_started = false;
+	_frame = 0;
+	_completedFrames = 0;
+
+	for (int i = 0; i < MaxFramesInFlight; ++i)
+	{
+		_frameQueries[i] = nullptr;
+		_queryFrames[i] = 0;
+	}
+}
+
+MeshReloader::~MeshReloader()
+{
+	Stop();
+}
+
+void MeshReloader::Watch(const char* filename, MeshData* out, bool invertTexCoords, bool optimizeMesh, bool quantizeVertices, bool generateLods)
+{
+	WatchedMesh* mesh = new WatchedMesh();
+	mesh->Filename = filename;
+	mesh->Target = out;
+	mesh->Options = MeshImporter::OptionsFor(invertTexCoords, optimizeMesh, quantizeVertices, generateLods);
+	mesh->Reloading = false;
+	mesh->ReloadAgain = false;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_meshes.emplace_back(mesh);
+	}
+
+	_watcher.Watch(filename);
+}
+
+void MeshReloader::Start(ID3D11Device* device, TextureRegistry& textures, ThreadPool& pool)
+{
+	if (_started)
+	{
+		return;
+	}
+
+	_device = device;
+	_textures = &textures;
+	_pool = &pool;
+	_started = true;
+
+	//Without queries EndFrame falls back to assuming the GPU is never more than MaxFramesInFlight frames behind
+	D3D11_QUERY_DESC queryDesc;
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+
+	for (int i = 0; i < MaxFramesInFlight; ++i)
+	{
+		if (FAILED(_device->CreateQuery(&queryDesc, &_frameQueries[i])))
+		{
+			_frameQueries[i] = nullptr;
+		}
+	}
+
+	_watcher.Start([this](const std::string& filename) { Changed(filename); });
+}
+
+void MeshReloader::Start(ID3D11Device* device, TextureRegistry& textures)
+{
+	Start(device, textures, ThreadPool::Default());
+}
+
+void MeshReloader::Changed(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (std::unique_ptr<WatchedMesh>& mesh : _meshes)
+	{
+		if (mesh->Filename != filename)
+		{
+			continue;
+		}
+
+		//One import per mesh at a time, a change part way through gets another one straight after
+		if (mesh->Reloading)
+		{
+			mesh->ReloadAgain = true;
+			continue;
+		}
+
+		mesh->Reloading = true;
+		++_importing;
+
+		WatchedMesh* reloading = mesh.get();
+		_pool->Submit([this, reloading]() { Reload(*reloading); });
+	}
+}
+
+void MeshReloader::Reload(WatchedMesh& mesh)
+{
+	Clock::time_point start = Clock::now();
+	MeshImport import;
+	MeshData data;
+	char report[512];
+
+	//The cache no longer matches the OBJ, so this imports it again and writes a new one
+	bool loaded = MeshImporter::Import(mesh.Filename.c_str(), mesh.Options, import, *_pool);
+	double importMilliseconds = MillisecondsSince(start);
+
+	//ID3D11Device is free threaded, so the buffers can be made here too rather than on the render thread. The textures
+	//can't, the registry is only used from the render thread
+	Clock::time_point createStart = Clock::now();
+
+	if (loaded)
+	{
+		data = OBJLoader::CreateMesh(_device, import, nullptr);
+
+		if (!data.VertexBuffer || !data.IndexBuffer)
+		{
+			//No textures have been acquired, so this leaves the registry alone
+			OBJLoader::Release(data, *_textures);
+			loaded = false;
+		}
+	}
+
+	double createMilliseconds = MillisecondsSince(createStart);
+
+	if (!loaded)
+	{
+		sprintf_s(report, "%s: reload FAILED, keeping the mesh that's loaded\n", mesh.Filename.c_str());
+		OutputDebugStringA(report);
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (loaded)
+	{
+		_ready.push_back({ &mesh, data, import.Directory, importMilliseconds, createMilliseconds });
+	}
+
+	if (mesh.ReloadAgain)
+	{
+		mesh.ReloadAgain = false;
+		WatchedMesh* reloading = &mesh;
+		_pool->Submit([this, reloading]() { Reload(*reloading); });
+		return;
+	}
+
+	mesh.Reloading = false;
+	--_importing;
+	_importDone.notify_all();
+}
+
+void MeshReloader::BeginFrame()
+{
+	std::vector<ReadyMesh> ready;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		ready.swap(_ready);
+	}
+
+	char report[512];
+
+	for (ReadyMesh& mesh : ready)
+	{
+		//A map the old mesh uses too is only shared, the registry keeps one copy of it
+		mesh.Data.MaterialTextures = OBJLoader::CreateMaterialTextures(_device, mesh.Data.Materials, mesh.Directory, *_textures);
+
+		//Frames up to the last one ended may still be drawing with the old buffers
+		_retired.push_back({ *mesh.Mesh->Target, _frame > 0 ? _frame - 1 : 0 });
+		*mesh.Mesh->Target = mesh.Data;
+
+		sprintf_s(report, "%s: reloaded, import %.2f ms, create %.2f ms, swapped in at frame %llu\n", mesh.Mesh->Filename.c_str(),
+			mesh.ImportMilliseconds, mesh.CreateMilliseconds, (unsigned long long)_frame);
+		OutputDebugStringA(report);
+	}
+}
+
+void MeshReloader::EndFrame(ID3D11DeviceContext* context)
+{
+	//Only waits on queries without flushing, a frame that isn't done yet is just checked again next time
+	for (int i = 0; i < MaxFramesInFlight; ++i)
+	{
+		if (_frameQueries[i] && _queryFrames[i] != 0 && context->GetData(_frameQueries[i], nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK)
+		{
+			if (_queryFrames[i] > _completedFrames)
+			{
+				_completedFrames = _queryFrames[i];
+			}
+
+			_queryFrames[i] = 0;
+		}
+	}
+
+	ID3D11Query* query = _frameQueries[_frame % MaxFramesInFlight];
+
+	if (query && _queryFrames[_frame % MaxFramesInFlight] == 0)
+	{
+		context->End(query);
+		_queryFrames[_frame % MaxFramesInFlight] = _frame + 1;
+	}
+	else if (!query && _frame >= MaxFramesInFlight)
+	{
+		_completedFrames = _frame - MaxFramesInFlight + 1;
+	}
+
+	++_frame;
+
+	while (!_retired.empty() && _retired.front().LastFrame < _completedFrames)
+	{
+		OBJLoader::Release(_retired.front().Data, *_textures);
+		_retired.pop_front();
+	}
+}
+
+void MeshReloader::Stop()
+{
+	if (!_started)
+	{
+		return;
+	}
+
+	_watcher.Stop();
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_importDone.wait(lock, [this]() { return _importing == 0; });
+	}
+
+	for (ReadyMesh& mesh : _ready)
+	{
+		OBJLoader::Release(mesh.Data, *_textures);
+	}
+
+	for (RetiredMesh& mesh : _retired)
+	{
+		OBJLoader::Release(mesh.Data, *_textures);
+	}
+
+	for (int i = 0; i < MaxFramesInFlight; ++i)
+	{
+		if (_frameQueries[i])
+		{
+			_frameQueries[i]->Release();
+			_frameQueries[i] = nullptr;
+		}
+
+		_queryFrames[i] = 0;
+	}
+
+	_ready.clear();
+	_retired.clear();
+	_started = false;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <windows.h>
+#include <d3d11_1.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "FileWatcher.h"
+#include "OBJLoader.h"
+
+class ThreadPool;
+
+//Reloads meshes while the game is running when their OBJ files change. The FileWatcher notices the change, the import
+//(which rewrites the stale cache) and the new buffers are made on the thread pool, and BeginFrame acquires the material
+//textures from the TextureRegistry (which isn't thread safe) and swaps the finished MeshData in between frames, so the
+//render loop never waits on the import. The old buffers are kept until the GPU has finished every frame that could have
+//drawn with them, which EndFrame tracks with event queries.
+//
+//	reloader.Watch("car.obj", &carMeshData, true, true, true, true);
+//	reloader.Start(device, textures);
+//	...every frame: reloader.BeginFrame() before anything reads the meshes, reloader.EndFrame(context) after Present...
+//	reloader.Stop();
+class MeshReloader
+{
+private:
+	//Frames the GPU can be behind by before EndFrame has to guess, DXGI's default maximum frame latency is 3
+	static const int MaxFramesInFlight = 4;
+
+	struct WatchedMesh
+	{
+		std::string Filename;
+		MeshData* Target;
+		uint32_t Options;
+		bool Reloading;							//An import is queued or running, guarded by _mutex
+		bool ReloadAgain;						//The file changed again while it was
+	};
+
+	struct ReadyMesh
+	{
+		WatchedMesh* Mesh;
+		MeshData Data;							//Without its textures until BeginFrame
+		std::string Directory;					//The materials' maps are relative to it
+		double ImportMilliseconds;
+		double CreateMilliseconds;
+	};
+
+	struct RetiredMesh
+	{
+		MeshData Data;
+		uint64_t LastFrame;						//Frames up to this one may draw with it
+	};
+
+	ID3D11Device* _device;
+	TextureRegistry* _textures;
+	ThreadPool* _pool;
+	FileWatcher _watcher;
+	std::vector<std::unique_ptr<WatchedMesh>> _meshes;
+
+	std::mutex _mutex;
+	std::condition_variable _importDone;
+	std::vector<ReadyMesh> _ready;				//Imported, waiting for BeginFrame
+	unsigned int _importing;
+	bool _started;
+
+	std::deque<RetiredMesh> _retired;
+	uint64_t _frame;							//Frames ended so far, the one being built is number _frame
+	uint64_t _completedFrames;					//The GPU has finished every frame before this one
+	ID3D11Query* _frameQueries[MaxFramesInFlight];
+	uint64_t _queryFrames[MaxFramesInFlight];	//What _completedFrames becomes once each query is done, 0 if it isn't in use
+
+	void Changed(const std::string& filename);
+	void Reload(WatchedMesh& mesh);
+
+public:
+	MeshReloader();
+	~MeshReloader();
+
+	MeshReloader(const MeshReloader&) = delete;
+	MeshReloader& operator=(const MeshReloader&) = delete;
+
+	//out has to be a mesh the game draws and Releases itself, loaded with the same flags as OBJLoader::Load
+	void Watch(const char* filename, MeshData* out, bool invertTexCoords = true, bool optimizeMesh = true, bool quantizeVertices = false, bool generateLods = false);
+
+	//Starts watching. device has to stay valid until Stop, and mustn't have been created single threaded. textures has to
+	//outlive Stop too
+	void Start(ID3D11Device* device, TextureRegistry& textures, ThreadPool& pool);
+	void Start(ID3D11Device* device, TextureRegistry& textures);
+
+	//Swaps in any meshes that have finished reloading. Call it where no mesh is in use, before Update and Draw read them
+	void BeginFrame();
+
+	//Marks the end of a frame's commands so old meshes can be released once the GPU is past it. Call it after Present
+	void EndFrame(ID3D11DeviceContext* context);
+
+	//Stops watching, waits for any import in progress and releases everything it still holds. The GPU has to be idle
+	void Stop();
+};
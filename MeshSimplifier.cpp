@@ -0,0 +1,732 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Border and seam edges add a plane through the edge at right angles to its triangle, weighted this many times more
+	//than the triangles' own planes, so sliding a vertex along them is cheap but pulling it off them isn't
+	const double BoundaryWeight = 10.0;
+
+	//What a collapse costs for changing the normals and texture coordinates of the triangles around it, as a fraction of
+	//the squared length of the edge. Only used to order the collapses, the recorded error is purely geometric
+	const float NormalWeight = 0.5f;
+	const float TexCoordWeight = 1.0f;
+
+	//A collapse is refused if it turns any remaining triangle more than about 75 degrees
+	const double MaxFlipDot = 0.25;
+
+	//Vertices at the same position whose normals are within about 5 degrees of each other and whose texture coordinates
+	//match aren't treated as a seam. Exporters often leave tiny normal differences along edges that are meant to be smooth
+	const float SeamNormalDot = 0.996f;
+	const float SeamTexCoordEpsilon = 1e-5f;
+
+	//A level that doesn't get at least this much smaller than the one before isn't worth keeping
+	const float MinLodReduction = 0.9f;
+
+	inline MeshFloat3 Subtract(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	inline float Dot(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline MeshFloat3 Cross(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	inline uint64_t EdgeKey(uint32_t a, uint32_t b)
+	{
+		return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+	}
+
+	//Sum of squared distances to a set of weighted planes, p'Ap + 2b.p + c
+	struct Quadric
+	{
+		double A00, A11, A22, A01, A02, A12;
+		double B0, B1, B2;
+		double C;
+		double Weight;
+
+		void AddPlane(double nx, double ny, double nz, double d, double weight)
+		{
+			A00 += weight * nx * nx; A11 += weight * ny * ny; A22 += weight * nz * nz;
+			A01 += weight * nx * ny; A02 += weight * nx * nz; A12 += weight * ny * nz;
+			B0 += weight * nx * d; B1 += weight * ny * d; B2 += weight * nz * d;
+			C += weight * d * d;
+			Weight += weight;
+		}
+
+		void Add(const Quadric& q)
+		{
+			A00 += q.A00; A11 += q.A11; A22 += q.A22; A01 += q.A01; A02 += q.A02; A12 += q.A12;
+			B0 += q.B0; B1 += q.B1; B2 += q.B2; C += q.C; Weight += q.Weight;
+		}
+
+		//Weighted mean squared distance from p to the planes
+		double Error(const MeshFloat3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double sum = x * (A00 * x + A01 * y + A02 * z) + y * (A01 * x + A11 * y + A12 * z) + z * (A02 * x + A12 * y + A22 * z) +
+				2.0 * (B0 * x + B1 * y + B2 * z) + C;
+			return Weight > 0.0 ? std::max(sum, 0.0) / Weight : 0.0;
+		}
+	};
+
+	enum VertexKind : uint8_t
+	{
+		KindInterior,
+		KindBoundary,		//On an open border or an attribute seam, can only collapse along one
+		KindLocked,			//On a non-manifold edge, never collapses
+	};
+
+	struct Collapse
+	{
+		uint32_t From;
+		uint32_t To;
+		float Cost;
+		float Error;
+	};
+
+	//Collapses are done between positions rather than vertices. All the vertices at one position (its "wedge", more than
+	//one along seams) collapse together, each onto the vertex at the other position that it shares a triangle with
+	class Simplifier
+	{
+	private:
+		const std::vector<MeshVertex>& _vertices;
+		std::vector<uint32_t> _position;		//Vertex to the first vertex with the same position, which stands for all of them
+		std::vector<uint32_t> _wedge;			//Circular list through the vertices sharing a position
+		std::vector<uint32_t> _smooth;			//Vertex to the first vertex with the same position and near enough the same attributes
+		std::vector<Quadric> _quadrics;			//Per position, against the original mesh
+		float _error;
+
+		//Rebuilt each pass
+		std::vector<uint32_t> _firstTriangle;	//Position to its range in _triangles
+		std::vector<uint32_t> _triangles;
+		std::vector<uint8_t> _kind;
+		std::vector<uint64_t> _boundaryEdges;	//Sorted
+		std::vector<uint32_t> _stamp;
+		uint32_t _stampValue;
+		std::vector<uint32_t> _collapseSources;
+		std::vector<uint32_t> _collapseTargets;
+
+		const MeshFloat3& Position(uint32_t vertex) const { return _vertices[vertex].Pos; }
+
+		bool IsDegenerate(const uint32_t* triangle) const
+		{
+			uint32_t a = _position[triangle[0]], b = _position[triangle[1]], c = _position[triangle[2]];
+			return a == b || b == c || a == c;
+		}
+
+		void BuildWedges()
+		{
+			size_t count = _vertices.size();
+			std::vector<uint32_t> order(count);
+
+			for (size_t i = 0; i < count; ++i) order[i] = (uint32_t)i;
+
+			auto less = [this](uint32_t a, uint32_t b)
+			{
+				const MeshFloat3& p = Position(a);
+				const MeshFloat3& q = Position(b);
+				return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z != q.z ? p.z < q.z : a < b;
+			};
+
+			std::sort(order.begin(), order.end(), less);
+
+			_position.resize(count);
+			_wedge.resize(count);
+			_smooth.resize(count);
+
+			for (size_t i = 0; i < count;)
+			{
+				size_t end = i + 1;
+				const MeshFloat3& p = Position(order[i]);
+
+				while (end < count && Position(order[end]).x == p.x && Position(order[end]).y == p.y && Position(order[end]).z == p.z) ++end;
+
+				for (size_t j = i; j < end; ++j)
+				{
+					_position[order[j]] = order[i];
+					_wedge[order[j]] = order[j + 1 < end ? j + 1 : i];
+					_smooth[order[j]] = order[j];
+
+					const MeshVertex& a = _vertices[order[j]];
+
+					for (size_t k = i; k < j; ++k)
+					{
+						const MeshVertex& b = _vertices[order[k]];
+
+						if (_smooth[order[k]] == order[k] && Dot(a.Normal, b.Normal) >= SeamNormalDot &&
+							std::fabs(a.TexC.x - b.TexC.x) <= SeamTexCoordEpsilon && std::fabs(a.TexC.y - b.TexC.y) <= SeamTexCoordEpsilon)
+						{
+							_smooth[order[j]] = order[k];
+							break;
+						}
+					}
+				}
+
+				i = end;
+			}
+		}
+
+		//Finds border and seam edges, which vertices they make boundaries and which are locked, and which triangles use each position
+		void Analyze(const std::vector<uint32_t>& indices)
+		{
+			size_t count = _vertices.size();
+			std::vector<uint64_t> positionEdges;
+			std::vector<uint64_t> vertexEdges;
+			positionEdges.reserve(indices.size());
+			vertexEdges.reserve(indices.size());
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				if (IsDegenerate(&indices[i]))
+				{
+					continue;
+				}
+
+				for (int e = 0; e < 3; ++e)
+				{
+					uint32_t a = indices[i + e], b = indices[i + (e + 1) % 3];
+					positionEdges.push_back(EdgeKey(_position[a], _position[b]));
+					vertexEdges.push_back(EdgeKey(a, b));
+				}
+			}
+
+			std::sort(positionEdges.begin(), positionEdges.end());
+			std::sort(vertexEdges.begin(), vertexEdges.end());
+
+			_kind.assign(count, KindInterior);
+			_boundaryEdges.clear();
+
+			for (size_t i = 0; i < positionEdges.size();)
+			{
+				size_t end = i;
+				while (end < positionEdges.size() && positionEdges[end] == positionEdges[i]) ++end;
+
+				uint32_t a = (uint32_t)(positionEdges[i] >> 32), b = (uint32_t)positionEdges[i];
+				uint8_t kind = end - i == 1 ? KindBoundary : end - i > 2 ? KindLocked : KindInterior;
+
+				if (kind == KindBoundary)
+				{
+					_boundaryEdges.push_back(positionEdges[i]);
+				}
+
+				_kind[a] = std::max(_kind[a], kind);
+				_kind[b] = std::max(_kind[b], kind);
+				i = end;
+			}
+
+			//A vertex edge used once whose position edge is used twice has different attributes on each side, a seam
+			for (size_t i = 0; i < vertexEdges.size();)
+			{
+				size_t end = i;
+				while (end < vertexEdges.size() && vertexEdges[end] == vertexEdges[i]) ++end;
+
+				if (end - i == 1)
+				{
+					uint32_t a = _position[(uint32_t)(vertexEdges[i] >> 32)], b = _position[(uint32_t)vertexEdges[i]];
+					uint64_t key = EdgeKey(a, b);
+					auto range = std::equal_range(positionEdges.begin(), positionEdges.end(), key);
+
+					if (range.second - range.first == 2)
+					{
+						_boundaryEdges.push_back(key);
+						_kind[a] = std::max(_kind[a], (uint8_t)KindBoundary);
+						_kind[b] = std::max(_kind[b], (uint8_t)KindBoundary);
+					}
+				}
+
+				i = end;
+			}
+
+			std::sort(_boundaryEdges.begin(), _boundaryEdges.end());
+			_boundaryEdges.erase(std::unique(_boundaryEdges.begin(), _boundaryEdges.end()), _boundaryEdges.end());
+
+			_firstTriangle.assign(count + 1, 0);
+
+			for (uint32_t index : indices)
+			{
+				++_firstTriangle[_position[index] + 1];
+			}
+
+			for (size_t v = 0; v < count; ++v)
+			{
+				_firstTriangle[v + 1] += _firstTriangle[v];
+			}
+
+			_triangles.resize(indices.size());
+			std::vector<uint32_t> filled(_firstTriangle.begin(), _firstTriangle.end() - 1);
+
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				_triangles[filled[_position[indices[i]]]++] = (uint32_t)(i / 3);
+			}
+		}
+
+		bool IsBoundaryEdge(uint32_t a, uint32_t b) const
+		{
+			return std::binary_search(_boundaryEdges.begin(), _boundaryEdges.end(), EdgeKey(a, b));
+		}
+
+		//Which vertex at position to the vertex w collapses onto, or ~0u if there isn't exactly one
+		uint32_t CollapseTarget(const std::vector<uint32_t>& indices, uint32_t w, uint32_t to) const
+		{
+			uint32_t target = ~0u;
+
+			for (uint32_t t = _firstTriangle[_position[w]]; t < _firstTriangle[_position[w] + 1]; ++t)
+			{
+				const uint32_t* triangle = &indices[_triangles[t] * 3];
+
+				if (triangle[0] != w && triangle[1] != w && triangle[2] != w)
+				{
+					continue;
+				}
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					if (_position[triangle[corner]] == to)
+					{
+						if (target != ~0u && target != triangle[corner])
+						{
+							return ~0u;
+						}
+
+						target = triangle[corner];
+					}
+				}
+			}
+
+			return target;
+		}
+
+		bool UsesVertex(const std::vector<uint32_t>& indices, uint32_t w) const
+		{
+			for (uint32_t t = _firstTriangle[_position[w]]; t < _firstTriangle[_position[w] + 1]; ++t)
+			{
+				const uint32_t* triangle = &indices[_triangles[t] * 3];
+
+				if (triangle[0] == w || triangle[1] == w || triangle[2] == w)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		//Cost of the normal and texture coordinate changes, or a negative value if a vertex at from has nowhere to go
+		float AttributeCost(const std::vector<uint32_t>& indices, uint32_t from, uint32_t to, float edgeLengthSquared) const
+		{
+			float cost = 0.0f;
+			uint32_t w = from;
+
+			do
+			{
+				if (UsesVertex(indices, w))
+				{
+					uint32_t target = CollapseTarget(indices, w, to);
+
+					if (target == ~0u)
+					{
+						return -1.0f;
+					}
+
+					const MeshVertex& a = _vertices[w];
+					const MeshVertex& b = _vertices[target];
+					float du = a.TexC.x - b.TexC.x, dv = a.TexC.y - b.TexC.y;
+					cost += edgeLengthSquared * (NormalWeight * (1.0f - Dot(a.Normal, b.Normal)) + TexCoordWeight * (du * du + dv * dv));
+				}
+
+				w = _wedge[w];
+			} while (w != from);
+
+			return cost;
+		}
+
+		bool CanCollapse(const std::vector<uint32_t>& indices, uint32_t from, uint32_t to)
+		{
+			//Positions next to both ends of the edge. More than the triangles on the edge itself would pinch the surface
+			bool boundaryEdge = IsBoundaryEdge(from, to);
+			uint32_t shared = 0;
+
+			if (++_stampValue == 0)
+			{
+				std::fill(_stamp.begin(), _stamp.end(), 0);
+				_stampValue = 1;
+			}
+
+			for (uint32_t t = _firstTriangle[from]; t < _firstTriangle[from + 1]; ++t)
+			{
+				const uint32_t* triangle = &indices[_triangles[t] * 3];
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					_stamp[_position[triangle[corner]]] = _stampValue;
+				}
+			}
+
+			for (uint32_t t = _firstTriangle[to]; t < _firstTriangle[to + 1]; ++t)
+			{
+				const uint32_t* triangle = &indices[_triangles[t] * 3];
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					uint32_t p = _position[triangle[corner]];
+
+					if (p != from && p != to && _stamp[p] == _stampValue)
+					{
+						_stamp[p] = 0;
+						++shared;
+					}
+				}
+			}
+
+			if (shared > (boundaryEdge ? 1u : 2u))
+			{
+				return false;
+			}
+
+			//Moving from onto to mustn't flip any of the triangles that survive
+			const MeshFloat3& target = Position(to);
+
+			for (uint32_t t = _firstTriangle[from]; t < _firstTriangle[from + 1]; ++t)
+			{
+				const uint32_t* triangle = &indices[_triangles[t] * 3];
+				MeshFloat3 before[3];
+				MeshFloat3 after[3];
+				bool collapses = false;
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					uint32_t p = _position[triangle[corner]];
+					collapses |= p == to;
+					before[corner] = Position(p);
+					after[corner] = p == from ? target : before[corner];
+				}
+
+				if (collapses)
+				{
+					continue;
+				}
+
+				MeshFloat3 n0 = Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0]));
+				MeshFloat3 n1 = Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0]));
+				double d = (double)Dot(n0, n1);
+
+				if (d <= 0.0 || d * d < MaxFlipDot * MaxFlipDot * (double)Dot(n0, n0) * (double)Dot(n1, n1))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		//Returns how many triangles were removed
+		size_t ApplyCollapse(std::vector<uint32_t>& indices, uint32_t from, uint32_t to)
+		{
+			//Work out every vertex's target before any triangles change
+			_collapseSources.clear();
+			_collapseTargets.clear();
+			uint32_t w = from;
+
+			do
+			{
+				if (UsesVertex(indices, w))
+				{
+					_collapseSources.push_back(w);
+					_collapseTargets.push_back(CollapseTarget(indices, w, to));
+				}
+
+				w = _wedge[w];
+			} while (w != from);
+
+			size_t removed = 0;
+
+			for (uint32_t t = _firstTriangle[from]; t < _firstTriangle[from + 1]; ++t)
+			{
+				uint32_t* triangle = &indices[_triangles[t] * 3];
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					for (size_t s = 0; s < _collapseSources.size(); ++s)
+					{
+						if (triangle[corner] == _collapseSources[s])
+						{
+							triangle[corner] = _collapseTargets[s];
+						}
+					}
+				}
+
+				if (IsDegenerate(triangle))
+				{
+					++removed;
+				}
+			}
+
+			_quadrics[to].Add(_quadrics[from]);
+
+			return removed;
+		}
+
+		//Near identical vertices are merged, so the simplified levels may use a neighbouring vertex's normal
+		void WeldSmooth(std::vector<uint32_t>& indices) const
+		{
+			for (uint32_t& index : indices)
+			{
+				index = _smooth[index];
+			}
+		}
+
+		//Triangles that were collapsed away are left in place until the end of the pass
+		void RemoveDegenerate(std::vector<uint32_t>& indices) const
+		{
+			size_t write = 0;
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+
+				if (!IsDegenerate(&indices[i]))
+				{
+					indices[write++] = a;
+					indices[write++] = b;
+					indices[write++] = c;
+				}
+			}
+
+			indices.resize(write);
+		}
+
+	public:
+		Simplifier(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& sourceIndices)
+			: _vertices(vertices), _error(0.0f), _stampValue(0)
+		{
+			BuildWedges();
+			_quadrics.assign(vertices.size(), Quadric());
+			_stamp.assign(vertices.size(), 0);
+
+			std::vector<uint32_t> indices = sourceIndices;
+			WeldSmooth(indices);
+			Analyze(indices);
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				if (IsDegenerate(&indices[i]))
+				{
+					continue;
+				}
+
+				uint32_t p[3] = { _position[indices[i]], _position[indices[i + 1]], _position[indices[i + 2]] };
+				MeshFloat3 a = Position(p[0]), b = Position(p[1]), c = Position(p[2]);
+				MeshFloat3 normal = Cross(Subtract(b, a), Subtract(c, a));
+				double length = std::sqrt((double)Dot(normal, normal));
+
+				if (length == 0.0)
+				{
+					continue;
+				}
+
+				//Weighted by area so a big triangle counts for more than a sliver
+				double nx = normal.x / length, ny = normal.y / length, nz = normal.z / length;
+				double d = -(nx * a.x + ny * a.y + nz * a.z);
+				double area = length * 0.5;
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					_quadrics[p[corner]].AddPlane(nx, ny, nz, d, area);
+
+					uint32_t q = p[(corner + 1) % 3];
+
+					if (!IsBoundaryEdge(p[corner], q))
+					{
+						continue;
+					}
+
+					MeshFloat3 e0 = Position(p[corner]);
+					MeshFloat3 edge = Subtract(Position(q), e0);
+					MeshFloat3 side = Cross(edge, MeshFloat3{ (float)nx, (float)ny, (float)nz });
+					double sideLength = std::sqrt((double)Dot(side, side));
+
+					if (sideLength == 0.0)
+					{
+						continue;
+					}
+
+					double sx = side.x / sideLength, sy = side.y / sideLength, sz = side.z / sideLength;
+					double sd = -(sx * e0.x + sy * e0.y + sz * e0.z);
+					double weight = BoundaryWeight * Dot(edge, edge);
+
+					_quadrics[p[corner]].AddPlane(sx, sy, sz, sd, weight);
+					_quadrics[q].AddPlane(sx, sy, sz, sd, weight);
+				}
+			}
+		}
+
+		float Error() const { return _error; }
+
+		void Simplify(std::vector<uint32_t>& indices, size_t targetIndexCount)
+		{
+			WeldSmooth(indices);
+			RemoveDegenerate(indices);
+
+			std::vector<Collapse> collapses;
+			std::vector<uint8_t> locked(_vertices.size());
+
+			while (indices.size() > targetIndexCount)
+			{
+				Analyze(indices);
+
+				//Every edge is tried in both directions
+				std::vector<uint64_t> edges;
+				edges.reserve(indices.size());
+
+				for (size_t i = 0; i < indices.size(); i += 3)
+				{
+					for (int e = 0; e < 3; ++e)
+					{
+						edges.push_back(EdgeKey(_position[indices[i + e]], _position[indices[i + (e + 1) % 3]]));
+					}
+				}
+
+				std::sort(edges.begin(), edges.end());
+				edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+				collapses.clear();
+
+				for (uint64_t edge : edges)
+				{
+					uint32_t ends[2] = { (uint32_t)(edge >> 32), (uint32_t)edge };
+
+					for (int direction = 0; direction < 2; ++direction)
+					{
+						uint32_t from = ends[direction], to = ends[1 - direction];
+
+						if (_kind[from] == KindLocked || (_kind[from] == KindBoundary && !IsBoundaryEdge(from, to)))
+						{
+							continue;
+						}
+
+						MeshFloat3 edgeVector = Subtract(Position(to), Position(from));
+						float attributes = AttributeCost(indices, from, to, Dot(edgeVector, edgeVector));
+
+						if (attributes < 0.0f)
+						{
+							continue;
+						}
+
+						Quadric merged = _quadrics[from];
+						merged.Add(_quadrics[to]);
+						float error = (float)merged.Error(Position(to));
+
+						collapses.push_back({ from, to, error + attributes, error });
+					}
+				}
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+				//Each pass collapses the cheapest edges it can without two collapses touching the same triangles
+				std::fill(locked.begin(), locked.end(), 0);
+				size_t triangles = indices.size() / 3;
+				size_t targetTriangles = targetIndexCount / 3;
+				size_t collapsed = 0;
+
+				for (const Collapse& collapse : collapses)
+				{
+					if (triangles <= targetTriangles)
+					{
+						break;
+					}
+
+					if (locked[collapse.From] || locked[collapse.To] || !CanCollapse(indices, collapse.From, collapse.To))
+					{
+						continue;
+					}
+
+					for (uint32_t t = _firstTriangle[collapse.From]; t < _firstTriangle[collapse.From + 1]; ++t)
+					{
+						const uint32_t* triangle = &indices[_triangles[t] * 3];
+
+						for (int corner = 0; corner < 3; ++corner)
+						{
+							locked[_position[triangle[corner]]] = 1;
+						}
+					}
+
+					triangles -= ApplyCollapse(indices, collapse.From, collapse.To);
+					_error = std::max(_error, std::sqrt(collapse.Error));
+					++collapsed;
+				}
+
+				RemoveDegenerate(indices);
+
+				if (collapsed == 0)
+				{
+					break;
+				}
+			}
+		}
+	};
+}
+
+float MeshSimplifier::Simplify(const std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, size_t targetIndexCount)
+{
+	Simplifier simplifier(vertices, indices);
+	simplifier.Simplify(indices, targetIndexCount);
+	return simplifier.Error();
+}
+
+void MeshSimplifier::GenerateLods(const std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& outLods)
+{
+	outLods.clear();
+	outLods.push_back({ 0, (uint32_t)indices.size(), 0.0f });
+
+	//One simplifier for the whole chain so its quadrics, and so the errors, are always relative to the original mesh
+	std::vector<uint32_t> current = indices;
+	Simplifier simplifier(vertices, current);
+
+	while (outLods.size() < MaxLods)
+	{
+		size_t previous = current.size();
+		size_t target = previous / 6 * 3;
+
+		if (target / 3 < MinLodTriangles)
+		{
+			break;
+		}
+
+		simplifier.Simplify(current, target);
+
+		if (current.size() > previous * MinLodReduction)
+		{
+			break;
+		}
+
+		std::vector<uint32_t> lod = current;
+		MeshOptimizer::OptimizeVertexCache(lod, vertices.size());
+
+		outLods.push_back({ (uint32_t)indices.size(), (uint32_t)lod.size(), simplifier.Error() });
+		indices.insert(indices.end(), lod.begin(), lod.end());
+	}
+}
+
+size_t MeshSimplifier::SelectLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxPixelError)
+{
+	//The errors only grow from one level to the next
+	for (size_t lod = lods.size(); lod > 1; --lod)
+	{
+		if (lods[lod - 1].Error * pixelsPerUnit <= maxPixelError)
+		{
+			return lod - 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MeshTypes.h"
+
+//One level of detail of a mesh, a range of the mesh's index buffer. Every level uses the same vertex buffer
+struct MeshLod
+{
+	uint32_t IndexStart;
+	uint32_t IndexCount;
+	float Error;				//How far the surface may have moved from the full detail mesh, in model units. 0 for level 0
+};
+
+static_assert(sizeof(MeshLod) == 12, "MeshLod is part of the mesh cache format");
+
+//Quadric error metric simplification for the import pipeline. Like MeshOptimizer it doesn't touch D3D
+namespace MeshSimplifier
+{
+	//Levels GenerateLods makes at most, including the full detail mesh
+	const uint32_t MaxLods = 5;
+
+	//It stops once a level would have fewer triangles than this
+	const uint32_t MinLodTriangles = 64;
+
+	//How far on screen a simplified level may differ from the full mesh before a more detailed one is picked
+	const float DefaultMaxPixelError = 1.0f;
+
+	//Collapses edges until there are no more than targetIndexCount indices left or nothing more can be collapsed,
+	//and returns the error of the result. Vertices are never moved or created, so the result uses the same vertex buffer.
+	//Edge collapses are ordered by Garland and Heckbert's quadric error plus how much the normals and texture coordinates
+	//change. Open borders and UV/normal seams (vertices with the same position but different attributes) only collapse
+	//along themselves, so they keep their shape and the two sides of a seam stay together
+	float Simplify(const std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, size_t targetIndexCount);
+
+	//Appends up to MaxLods - 1 simplified copies of the mesh to the index buffer, each with about half the triangles of the
+	//one before, and fills outLods with their ranges starting with the original mesh. Each level is simplified from the
+	//last one but its error is measured against the original, and its triangles are put in vertex cache order
+	void GenerateLods(const std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& outLods);
+
+	//Picks the least detailed level whose error stays under maxPixelError on screen. pixelsPerUnit is how many pixels one
+	//model unit covers where the mesh is, see Camera::getProjectionScale
+	size_t SelectLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxPixelError = DefaultMaxPixelError);
+};
@@ -0,0 +1,159 @@
+#include "MeshStream.h"
+#include "ContentHash.h"
+#include "MeshImporter.h"
+#include <algorithm>
+
+namespace
+{
+	size_t LevelCount(const MeshImport& mesh)
+	{
+		return std::max<size_t>(mesh.Lods.size(), 1);
+	}
+
+	//A mesh without levels is one level covering all of it
+	MeshLod LevelRange(const MeshImport& mesh, uint32_t level)
+	{
+		return mesh.Lods.empty() ? MeshLod{ 0, mesh.IndexCount, 0.0f } : mesh.Lods[level];
+	}
+
+	uint64_t StageHash(const MeshImport& mesh, size_t stage)
+	{
+		MeshStreamRange range = MeshStream::StageRange(mesh, stage);
+		const char* vertices = (const char*)mesh.VertexData + (size_t)range.FirstVertex * mesh.VertexStride;
+		const char* indices = (const char*)mesh.IndexData + (size_t)range.IndexStart * mesh.IndexSize;
+
+		uint64_t hash = ContentHash(vertices, (size_t)range.VertexCount * mesh.VertexStride);
+		return ContentHash(indices, (size_t)range.IndexCount * mesh.IndexSize, hash);
+	}
+
+	template <typename Index>
+	bool IndicesBelow(const void* data, uint32_t start, uint32_t count, uint32_t vertexCount)
+	{
+		const Index* indices = (const Index*)data + start;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (indices[i] >= vertexCount)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+void MeshStream::OrderVertices(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, std::vector<MeshStreamStage>& outStages)
+{
+	const uint32_t unused = 0xFFFFFFFF;
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<MeshVertex> reordered;
+	reordered.reserve(vertices.size());
+	outStages.clear();
+
+	//Like MeshOptimizer::OptimizeVertexFetch, but visiting the levels coarsest first so each one's new vertices come after the last's
+	size_t levelCount = std::max<size_t>(lods.size(), 1);
+
+	for (size_t level = levelCount; level-- > 0;)
+	{
+		MeshLod range = lods.empty() ? MeshLod{ 0, (uint32_t)indices.size(), 0.0f } : lods[level];
+
+		for (uint32_t i = range.IndexStart; i < range.IndexStart + range.IndexCount; ++i)
+		{
+			uint32_t& index = indices[i];
+
+			if (remap[index] == unused)
+			{
+				remap[index] = (uint32_t)reordered.size();
+				reordered.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		outStages.push_back({ (uint32_t)level, (uint32_t)reordered.size(), 0 });
+	}
+
+	vertices.swap(reordered);
+}
+
+void MeshStream::HashStages(MeshImport& mesh)
+{
+	for (size_t stage = 0; stage < mesh.Stages.size(); ++stage)
+	{
+		mesh.Stages[stage].Hash = StageHash(mesh, stage);
+	}
+}
+
+MeshStreamRange MeshStream::StageRange(const MeshImport& mesh, size_t stage)
+{
+	const MeshStreamStage& current = mesh.Stages[stage];
+	MeshLod level = LevelRange(mesh, current.Lod);
+	MeshStreamRange range;
+
+	range.FirstVertex = stage > 0 ? mesh.Stages[stage - 1].VertexCount : 0;
+	range.VertexCount = current.VertexCount - range.FirstVertex;
+	range.IndexStart = level.IndexStart;
+	range.IndexCount = level.IndexCount;
+
+	return range;
+}
+
+bool MeshStream::CheckStage(const MeshImport& mesh, size_t stage)
+{
+	if (stage >= mesh.Stages.size() || !mesh.VertexData || !mesh.IndexData)
+	{
+		return false;
+	}
+
+	//The table itself isn't covered by any hash, so everything it points at is bounds checked before it's read
+	const MeshStreamStage& current = mesh.Stages[stage];
+	uint32_t firstVertex = stage > 0 ? mesh.Stages[stage - 1].VertexCount : 0;
+
+	if (current.Lod >= LevelCount(mesh) || current.VertexCount < firstVertex || current.VertexCount > mesh.VertexCount)
+	{
+		return false;
+	}
+
+	MeshLod level = LevelRange(mesh, current.Lod);
+	uint64_t levelEnd = (uint64_t)level.IndexStart + level.IndexCount;
+
+	if (levelEnd > mesh.IndexCount || level.IndexCount % 3 != 0)
+	{
+		return false;
+	}
+
+	size_t submeshesPerLevel = mesh.Submeshes.size() / LevelCount(mesh);
+
+	for (size_t i = current.Lod * submeshesPerLevel; i < (current.Lod + 1) * submeshesPerLevel; ++i)
+	{
+		const MeshSubmesh& submesh = mesh.Submeshes[i];
+
+		//DrawVisibleClusters indexes the clusters with ClusterStart and ClusterCount
+		if (submesh.IndexStart < level.IndexStart || (uint64_t)submesh.IndexStart + submesh.IndexCount > levelEnd ||
+			(uint64_t)submesh.ClusterStart + submesh.ClusterCount > mesh.Clusters.size())
+		{
+			return false;
+		}
+	}
+
+	//The clusters cover the full detail level
+	if (current.Lod == 0)
+	{
+		for (const MeshCluster& cluster : mesh.Clusters)
+		{
+			if (cluster.IndexStart < level.IndexStart || (uint64_t)cluster.IndexStart + cluster.IndexCount > levelEnd)
+			{
+				return false;
+			}
+		}
+	}
+
+	if (StageHash(mesh, stage) != current.Hash)
+	{
+		return false;
+	}
+
+	return mesh.IndexSize == sizeof(uint32_t) ? IndicesBelow<uint32_t>(mesh.IndexData, level.IndexStart, level.IndexCount, current.VertexCount) :
+		IndicesBelow<uint16_t>(mesh.IndexData, level.IndexStart, level.IndexCount, current.VertexCount);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MeshSimplifier.h"
+#include "MeshTypes.h"
+
+struct MeshImport;
+
+//One step of streaming a mesh in, coarsest level of detail first. A cache written with MeshOptionProgressive has its
+//vertices in the order the levels first use them, coarsest first, so each stage only adds vertices to the end of the
+//ones before it. Stage n is drawable as soon as vertices [0, VertexCount) and its level's indices have been read, the
+//base mesh being the coarsest level and every later stage refining it. The levels' indices are where MeshLod says,
+//full detail first as in any other cache.
+struct MeshStreamStage
+{
+	uint32_t Lod;				//The level of detail this stage makes drawable, 0 is the full detail mesh
+	uint32_t VertexCount;		//Vertices this and every earlier stage use
+	uint64_t Hash;				//ContentHash of the vertices the stage adds followed by the level's indices, as stored
+};
+
+static_assert(sizeof(MeshStreamStage) == 16, "MeshStreamStage is part of the mesh cache format");
+
+//What a stage adds to the buffers, in vertices and indices
+struct MeshStreamRange
+{
+	uint32_t FirstVertex;
+	uint32_t VertexCount;
+	uint32_t IndexStart;
+	uint32_t IndexCount;
+};
+
+//Progressive mesh layout for the import pipeline and the readers that stream it, see MeshStreamer.h. Doesn't touch D3D
+namespace MeshStream
+{
+	//Reorders the vertices into the order the levels first use them, coarsest level first, and fills outStages with one stage
+	//per level. The hashes are left for HashStages. Vertices no level uses are dropped. Without levels the whole mesh is one stage
+	void OrderVertices(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, std::vector<MeshStreamStage>& outStages);
+
+	//Fills in the stages' hashes from the vertex and index data the mesh will be stored with
+	void HashStages(MeshImport& mesh);
+
+	//The vertices and indices stage adds. Only meaningful for a stage CheckStage has accepted
+	MeshStreamRange StageRange(const MeshImport& mesh, size_t stage);
+
+	//Checks that the stage is a mesh that can be drawn on its own: its data matches its hash, its level's indices and
+	//submeshes lie inside the index buffer, the submeshes' clusters inside the clusters and every index refers to a vertex
+	//this or an earlier stage added.
+	//For a cache opened without verifying its payload this is what reads the stage's data in
+	bool CheckStage(const MeshImport& mesh, size_t stage);
+};
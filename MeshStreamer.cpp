@@ -0,0 +1,306 @@
+#include "MeshStreamer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+MeshStreamer::MeshStreamer()
+{
+	_device = nullptr;
+	_textures = nullptr;
+	_pool = nullptr;
+	_pack = nullptr;
+	_streaming = 0;
+	_stopping = false;
+	_started = false;
+}
+
+MeshStreamer::~MeshStreamer()
+{
+	Stop();
+}
+
+void MeshStreamer::Stream(const char* filename, MeshData* out, bool invertTexCoords, bool optimizeMesh, bool quantizeVertices, bool generateLods)
+{
+	StreamedMesh* mesh = new StreamedMesh();
+	mesh->Filename = filename;
+	mesh->Target = out;
+	mesh->Options = MeshImporter::OptionsFor(invertTexCoords, optimizeMesh, quantizeVertices, generateLods);
+	mesh->Import.reset(new MeshImport());
+	mesh->Data = MeshData();
+	mesh->StagesRead = 0;
+	mesh->Finished = false;
+	mesh->StagesShown = 0;
+	mesh->Done = false;
+	_meshes.emplace_back(mesh);
+}
+
+void MeshStreamer::SetPack(const AssetPack* pack)
+{
+	_pack = pack;
+}
+
+void MeshStreamer::Start(ID3D11Device* device, TextureRegistry& textures, ThreadPool& pool)
+{
+	if (_started)
+	{
+		return;
+	}
+
+	_device = device;
+	_textures = &textures;
+	_pool = &pool;
+	_stopping = false;
+	_started = true;
+
+	for (std::unique_ptr<StreamedMesh>& mesh : _meshes)
+	{
+		StreamedMesh* streaming = mesh.get();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			++_streaming;
+		}
+
+		_pool->Submit([this, streaming]() { StreamMesh(*streaming); });
+	}
+}
+
+void MeshStreamer::Start(ID3D11Device* device, TextureRegistry& textures)
+{
+	Start(device, textures, ThreadPool::Default());
+}
+
+void MeshStreamer::StreamMesh(StreamedMesh& mesh)
+{
+	MeshImport& import = *mesh.Import;
+	mesh.Started = Clock::now();
+	bool opened = false;
+	size_t stagesRead = 0;
+	char report[512];
+
+	//A stored pack entry is streamed straight out of the pack's mapping, a compressed one has to be decompressed whole first
+	if (_pack)
+	{
+		const AssetPackEntry* entry = _pack->Find((mesh.Filename + "Binary").c_str());
+		const char* data;
+		size_t size;
+
+		opened = entry && _pack->Read(*entry, data, size, import.PackedData) && MeshImporter::ImportFromMemory(data, size, mesh.Options, import, true);
+	}
+
+	if (!opened)
+	{
+		opened = MeshImporter::ImportStreaming(mesh.Filename.c_str(), mesh.Options, import, *_pool);
+	}
+
+	if (opened && import.Stages.empty())
+	{
+		//Nothing to stream, so it's made whole like AssetLoader would
+		mesh.Data = OBJLoader::CreateMesh(_device, import, nullptr);
+		stagesRead = mesh.Data.VertexBuffer && mesh.Data.IndexBuffer ? 1 : 0;
+	}
+	else if (opened)
+	{
+		if (!import.Log.empty())
+		{
+			OutputDebugStringA(import.Log.c_str());
+		}
+
+		DXGI_FORMAT indexFormat = import.IndexSize == sizeof(uint32_t) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+		mesh.Data = OBJLoader::CreateMeshData(_device, nullptr, import.VertexStride, import.VertexCount, nullptr, import.IndexCount, indexFormat);
+		mesh.Data.Quantized = import.Quantized;
+		mesh.Data.Quantization = import.Quantization;
+		mesh.Data.Bounds = import.Bounds;
+		mesh.Data.Materials = import.Materials;
+		mesh.Data.MaterialTextures.assign(import.Materials.size(), TextureRegistry::Invalid);
+
+		//Checking a stage reads it, so each one is handed over as soon as it's in. One that's damaged leaves the mesh at the stage before
+		for (size_t stage = 0; mesh.Data.VertexBuffer && mesh.Data.IndexBuffer && stage < import.Stages.size(); ++stage)
+		{
+			if (!MeshStream::CheckStage(import, stage))
+			{
+				sprintf_s(report, "%s: stream stage %u is damaged, rebuild the cache\n", mesh.Filename.c_str(), (unsigned int)stage);
+				OutputDebugStringA(report);
+				break;
+			}
+
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if (_stopping)
+			{
+				break;
+			}
+
+			mesh.StagesRead = ++stagesRead;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (stagesRead == 0 && !_stopping)
+	{
+		sprintf_s(report, "%s: streaming FAILED\n", mesh.Filename.c_str());
+		OutputDebugStringA(report);
+	}
+
+	mesh.StagesRead = stagesRead;
+	mesh.Finished = true;
+	--_streaming;
+	_streamDone.notify_all();
+}
+
+void MeshStreamer::Upload(ID3D11DeviceContext* context, StreamedMesh& mesh, size_t stage)
+{
+	const MeshImport& import = *mesh.Import;
+
+	if (import.Stages.empty())
+	{
+		return;
+	}
+
+	//Only the vertices and indices the stage adds, the rest of the buffers are either in already or not drawn from yet
+	MeshStreamRange range = MeshStream::StageRange(import, stage);
+	D3D11_BOX box = { 0, 0, 0, 0, 1, 1 };
+
+	if (range.VertexCount > 0)
+	{
+		box.left = range.FirstVertex * import.VertexStride;
+		box.right = (range.FirstVertex + range.VertexCount) * import.VertexStride;
+		context->UpdateSubresource(mesh.Data.VertexBuffer, 0, &box, (const char*)import.VertexData + box.left, 0, 0);
+	}
+
+	box.left = range.IndexStart * import.IndexSize;
+	box.right = (range.IndexStart + range.IndexCount) * import.IndexSize;
+	context->UpdateSubresource(mesh.Data.IndexBuffer, 0, &box, (const char*)import.IndexData + box.left, 0, 0);
+}
+
+void MeshStreamer::Show(StreamedMesh& mesh)
+{
+	const MeshImport& import = *mesh.Import;
+	MeshData shown = mesh.Data;
+
+	if (import.Stages.empty())
+	{
+		*mesh.Target = shown;
+		return;
+	}
+
+	//The levels that haven't arrived yet are pointed at the finest one that has, so whatever SelectLod picks can be drawn.
+	//The clusters only cover the full detail level, so they wait for it
+	uint32_t finest = import.Stages[mesh.StagesShown - 1].Lod;
+	size_t submeshesPerLevel = import.Submeshes.size() / std::max<size_t>(import.Lods.size(), 1);
+
+	shown.Lods = import.Lods;
+	shown.Submeshes = import.Submeshes;
+
+	for (uint32_t level = 0; level < finest; ++level)
+	{
+		shown.Lods[level] = import.Lods[finest];
+		std::copy(import.Submeshes.begin() + finest * submeshesPerLevel, import.Submeshes.begin() + (finest + 1) * submeshesPerLevel,
+			shown.Submeshes.begin() + level * submeshesPerLevel);
+	}
+
+	shown.IndexCount = 0;
+
+	if (finest == 0)
+	{
+		shown.Clusters = import.Clusters;
+		shown.IndexCount = import.Lods.empty() ? import.IndexCount : import.Lods[0].IndexCount;
+	}
+
+	*mesh.Target = shown;
+}
+
+void MeshStreamer::Update(ID3D11DeviceContext* context)
+{
+	char report[512];
+
+	for (std::unique_ptr<StreamedMesh>& streamed : _meshes)
+	{
+		StreamedMesh& mesh = *streamed;
+		size_t stagesRead;
+		bool finished;
+
+		if (mesh.Done)
+		{
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			stagesRead = mesh.StagesRead;
+			finished = mesh.Finished;
+		}
+
+		//Something else (a MeshReloader after an edit) has put its own mesh in Target, which then owns whatever was shown
+		bool replaced = mesh.StagesShown > 0 ? mesh.Target->VertexBuffer != mesh.Data.VertexBuffer : mesh.Target->VertexBuffer != nullptr;
+
+		if (!replaced && mesh.StagesShown < stagesRead)
+		{
+			const MeshImport& import = *mesh.Import;
+
+			//The registry can only be used from here, so the textures wait for the mesh's first stage
+			if (mesh.StagesShown == 0)
+			{
+				mesh.Data.MaterialTextures = OBJLoader::CreateMaterialTextures(_device, import.Materials, import.Directory, *_textures);
+			}
+
+			while (mesh.StagesShown < stagesRead)
+			{
+				Upload(context, mesh, mesh.StagesShown++);
+			}
+
+			Show(mesh);
+
+			sprintf_s(report, "%s: stage %u of %u drawable after %.2f ms, LOD %u\n", mesh.Filename.c_str(), (unsigned int)mesh.StagesShown,
+				(unsigned int)std::max<size_t>(import.Stages.size(), 1), MillisecondsSince(mesh.Started), import.Stages.empty() ? 0 : import.Stages[mesh.StagesShown - 1].Lod);
+			OutputDebugStringA(report);
+		}
+
+		//The import is kept until the worker has finished with it
+		if (finished && (replaced || mesh.StagesShown == stagesRead))
+		{
+			if (mesh.StagesShown == 0)
+			{
+				OBJLoader::Release(mesh.Data, *_textures);
+			}
+
+			mesh.Import.reset();
+			mesh.Done = true;
+		}
+	}
+}
+
+void MeshStreamer::Stop()
+{
+	if (!_started)
+	{
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_stopping = true;
+		_streamDone.wait(lock, [this]() { return _streaming == 0; });
+	}
+
+	//Meshes that have been shown belong to their targets now
+	for (std::unique_ptr<StreamedMesh>& mesh : _meshes)
+	{
+		if (mesh->StagesShown == 0 && !mesh->Done)
+		{
+			OBJLoader::Release(mesh->Data, *_textures);
+		}
+	}
+
+	_meshes.clear();
+	_started = false;
+}
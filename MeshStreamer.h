@@ -0,0 +1,89 @@
+#pragma once
+#include <windows.h>
+#include <d3d11_1.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "MeshImporter.h"
+#include "OBJLoader.h"
+
+class ThreadPool;
+
+//Streams meshes in coarsest level of detail first, so something can be drawn long before a big mesh has been read.
+//A worker opens the progressive cache without reading it (see MeshImporter::ImportStreaming), makes full size buffers and
+//then checks each stage in turn, which is what reads it from disk. Update uploads the stages that are ready into the
+//same buffers and moves the mesh up to the finest level it has, so the mesh is upgraded in place and the render loop
+//never waits. Until the full detail level arrives the finer levels are drawn with the finest one there is.
+//Meshes without stages (older caches) are created whole on the worker instead. The material textures come from the
+//TextureRegistry, which isn't thread safe, so Update acquires them when a mesh is first shown.
+//
+//	streamer.Stream("car.obj", &carMeshData, true, true, true, true);
+//	streamer.Start(device, textures);
+//	...every frame: streamer.Update(context) before anything reads the meshes...
+//	streamer.Stop();
+class MeshStreamer
+{
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct StreamedMesh
+	{
+		std::string Filename;
+		MeshData* Target;
+		uint32_t Options;
+
+		std::unique_ptr<MeshImport> Import;	//Points into the mapped cache until the last stage has been uploaded
+		MeshData Data;						//The buffers, sized for the whole mesh, and the material textures once shown
+		Clock::time_point Started;
+		size_t StagesRead;					//Checked by the worker and ready to upload, guarded by _mutex
+		bool Finished;						//The worker is done with it, guarded by _mutex
+		size_t StagesShown;					//Uploaded and in Target, render thread only from here down
+		bool Done;							//Everything that will be shown has been, or Target was replaced by something else
+	};
+
+	ID3D11Device* _device;
+	TextureRegistry* _textures;
+	ThreadPool* _pool;
+	const AssetPack* _pack;
+	std::vector<std::unique_ptr<StreamedMesh>> _meshes;
+
+	std::mutex _mutex;
+	std::condition_variable _streamDone;
+	unsigned int _streaming;
+	bool _stopping;
+	bool _started;
+
+	void StreamMesh(StreamedMesh& mesh);
+	void Upload(ID3D11DeviceContext* context, StreamedMesh& mesh, size_t stage);
+	void Show(StreamedMesh& mesh);
+
+public:
+	MeshStreamer();
+	~MeshStreamer();
+
+	MeshStreamer(const MeshStreamer&) = delete;
+	MeshStreamer& operator=(const MeshStreamer&) = delete;
+
+	//The flags are OBJLoader::Load's. out has to start empty, it's written by Update and Released by the game once
+	//anything has been shown in it
+	void Stream(const char* filename, MeshData* out, bool invertTexCoords = true, bool optimizeMesh = true, bool quantizeVertices = false, bool generateLods = false);
+
+	//Looks the meshes' caches up in pack first, like AssetLoader::SetPack. It has to stay open until Stop
+	void SetPack(const AssetPack* pack);
+
+	//Starts a worker per mesh. device has to stay valid until Stop, and mustn't have been created single threaded.
+	//textures has to outlive Stop too
+	void Start(ID3D11Device* device, TextureRegistry& textures, ThreadPool& pool);
+	void Start(ID3D11Device* device, TextureRegistry& textures);
+
+	//Uploads the stages that are ready and upgrades the meshes to them. Call it once a frame before anything reads the meshes
+	void Update(ID3D11DeviceContext* context);
+
+	//Stops streaming, waits for the workers and releases whatever hasn't been handed over to the meshes yet
+	void Stop();
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+//Plain data types shared by the mesh import code. These deliberately don't use DirectXMath or any
+//Windows headers so the parser and mesh processing can be compiled into headless tools as well.
+//They have the same memory layout as XMFLOAT2/XMFLOAT3.
+
+//16-bit indices can address this many vertices, bigger meshes need 32-bit indices
+const uint32_t MaxShortIndexedVertices = 65536;
+
+struct MeshFloat2
+{
+	float x;
+	float y;
+};
+
+struct MeshFloat3
+{
+	float x;
+	float y;
+	float z;
+};
+
+//Same layout as SimpleVertex in Structures.h, so arrays of these can be handed straight to CreateBuffer
+struct MeshVertex
+{
+	MeshFloat3 Pos;
+	MeshFloat3 Normal;
+	MeshFloat2 TexC;
+};
+
+static_assert(sizeof(MeshVertex) == 32, "MeshVertex must match the SimpleVertex input layout");
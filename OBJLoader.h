@@ -4,8 +4,16 @@
 #include <directxmath.h>
 #include <fstream>		//For loading in an external file
 #include <vector>		//For storing the XMFLOAT3/2 variables
-#include <map>			//For fast searching when re-creating the index buffer
+#include <string>
 #include "Structures.h"
+#include "TextureRegistry.h"
+#include "MeshBounds.h"
+#include "MeshClusters.h"
+#include "MeshImporter.h"
+#include "MeshMaterials.h"
+#include "MeshSimplifier.h"
+#include "OBJParser.h"
+#include "VertexQuantizer.h"
 
 using namespace DirectX;
 
@@ -15,7 +23,16 @@ struct MeshData
 	ID3D11Buffer * IndexBuffer;
 	UINT VBStride;
 	UINT VBOffset;
-	UINT IndexCount;
+	UINT IndexCount;			//Of the full detail mesh, any levels of detail come after it in the index buffer
+	DXGI_FORMAT IndexFormat;	//DXGI_FORMAT_R16_UINT unless the mesh has too many vertices for 16-bit indices
+	bool Quantized;				//The vertices are QuantizedVertex rather than SimpleVertex and need the quantized input layout
+	VertexQuantization Quantization;	//For decoding them in the vertex shader
+	std::vector<MeshCluster> Clusters;	//Cullable ranges of the index buffer, empty for meshes loaded from old caches
+	std::vector<MeshLod> Lods;			//Levels of detail starting with the full mesh, empty unless they were generated
+	std::vector<MeshSubmesh> Submeshes;	//Parts of the mesh by material, one set per level of detail, see MeshSubmesh
+	std::vector<MeshMaterial> Materials;
+	std::vector<size_t> MaterialTextures;	//The diffuse map of each material in the TextureRegistry, Invalid if it has none or it isn't a DDS file
+	MeshBounds Bounds;					//In model space, see MeshBounding::TransformBounds for world space
 };
 
 //struct SimpleVertex
@@ -32,13 +49,43 @@ struct MeshData
 
 namespace OBJLoader
 {
-	//The only method you'll need to call
-	MeshData Load(char* filename, ID3D11Device* _pd3dDevice, bool invertTexCoords = true);
+	//The only method you'll need to call. optimizeMesh reorders triangles and vertices for the vertex cache and to reduce overdraw
+	//when the OBJ is imported, the result goes in the binary cache so it's only done once.
+	//quantizeVertices packs the vertices into 16 byte QuantizedVertex, see VertexQuantizer.h.
+	//generateLods adds simplified levels of detail to pick from by distance, see MeshSimplifier.h
+	MeshData Load(char* filename, ID3D11Device* _pd3dDevice, TextureRegistry& textures, bool invertTexCoords = true, bool optimizeMesh = true, bool quantizeVertices = false, bool generateLods = false);
 
-	//Helper methods for the above method
-	//Searhes to see if a similar vertex already exists in the buffer -- if true, we re-use that index
-	bool FindSimilarVertex(const SimpleVertex& vertex, std::map<SimpleVertex, unsigned short>& vertToIndexMap, unsigned short& index);
+	//The helper methods for the above method are in MeshImporter.h (import steps and the binary cache) and OBJParser.h
+	//(parsing and re-creating the index buffer)
 
-	//Re-creates a single index buffer from the 3 given in the OBJ file
-	void CreateIndices(const std::vector<XMFLOAT3>& inVertices, const std::vector<XMFLOAT2>& inTexCoords, const std::vector<XMFLOAT3>& inNormals, std::vector<unsigned short>& outIndices, std::vector<XMFLOAT3>& outVertices, std::vector<XMFLOAT2>& outTexCoords, std::vector<XMFLOAT3>& outNormals);
+	//Creates the buffers for a mesh imported on another thread, see AssetLoader.h, and acquires its materials' textures
+	//from textures. The registry isn't thread safe, so a worker passes null and the render thread calls
+	//CreateMaterialTextures later. Writes the import's log to the debugger
+	MeshData CreateMesh(ID3D11Device* _pd3dDevice, const MeshImport& mesh, TextureRegistry* textures);
+
+	//Acquires the diffuse map of each material from textures, Invalid where it has none or it couldn't be loaded. Maps are
+	//relative to directory
+	std::vector<size_t> CreateMaterialTextures(ID3D11Device* _pd3dDevice, const std::vector<MeshMaterial>& materials, const std::string& directory, TextureRegistry& textures);
+
+	//Releases the buffers and the textures' references and empties meshData
+	void Release(MeshData& meshData, TextureRegistry& textures);
+
+	//How many submeshes each level of detail has
+	inline size_t SubmeshesPerLod(const MeshData& meshData)
+	{
+		return meshData.Submeshes.size() / (meshData.Lods.empty() ? 1 : meshData.Lods.size());
+	}
+
+	//Picks R16 indices whenever they can address every vertex, R32 otherwise
+	inline DXGI_FORMAT IndexFormatFor(size_t vertexCount)
+	{
+		return vertexCount > MaxShortIndexedVertices ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+	}
+
+	//Creates the vertex and index buffers for a mesh. indices must already be in indexFormat. Null vertices and indices leave
+	//the buffers empty, to be filled in with UpdateSubresource
+	MeshData CreateMeshData(ID3D11Device* _pd3dDevice, const void* vertices, UINT vertexStride, UINT numVertices, const void* indices, UINT numIndices, DXGI_FORMAT indexFormat);
+
+	//Reads the unversioned "<vertex count><index count><vertices><indices>" caches written before MeshCache.h
+	MeshData LoadLegacyBinary(const std::string& binaryFilename, ID3D11Device* _pd3dDevice, TextureRegistry& textures);
 };
\ No newline at end of file
@@ -0,0 +1,570 @@
+#include "OBJParser.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+void ObjData::Clear()
+{
+	Positions.clear();
+	TexCoords.clear();
+	Normals.clear();
+	Corners.clear();
+	Groups.clear();
+	MaterialLibraries.clear();
+}
+
+ObjMaterial::ObjMaterial()
+{
+	Ambient = { 0.2f, 0.2f, 0.2f };
+	Diffuse = { 0.8f, 0.8f, 0.8f };
+	Specular = { 1.0f, 1.0f, 1.0f };
+	SpecularPower = 0.0f;
+	Opacity = 1.0f;
+}
+
+namespace
+{
+	inline bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipBlanks(const char* p, const char* end)
+	{
+		while (p < end && IsBlank(*p)) ++p;
+		return p;
+	}
+
+	//Returns a pointer to the first character of the next line
+	inline const char* NextLine(const char* p, const char* end)
+	{
+		const char* newLine = (const char*)memchr(p, '\n', end - p);
+		return newLine ? newLine + 1 : end;
+	}
+
+	//True if the line at p starts with the keyword followed by a blank
+	inline bool IsRecord(const char* p, const char* end, const char* keyword, size_t length)
+	{
+		return (size_t)(end - p) > length && memcmp(p, keyword, length) == 0 && IsBlank(p[length]);
+	}
+
+	//The rest of the line with the blanks around it trimmed off. p is left at the end of the line
+	inline std::string ParseRestOfLine(const char*& p, const char* end)
+	{
+		p = SkipBlanks(p, end);
+		const char* start = p;
+
+		while (p < end && *p != '\n') ++p;
+
+		const char* last = p;
+		while (last > start && IsBlank(last[-1])) --last;
+
+		return std::string(start, last);
+	}
+
+	inline const char* ParseFloat(const char* p, const char* end, float& out)
+	{
+		p = SkipBlanks(p, end);
+
+		//from_chars doesn't accept a leading plus sign, some exporters write one
+		if (p < end && *p == '+') ++p;
+
+		out = 0.0f;
+		std::from_chars_result result = std::from_chars(p, end, out);
+
+		//Denormals that are out of range still consume their characters, anything else just leaves the value at zero
+		if (result.ec == std::errc::result_out_of_range)
+		{
+			out = 0.0f;
+		}
+
+		return result.ptr;
+	}
+
+	//Turns a 1-based (or negative, relative) OBJ index into a 0-based one
+	inline uint32_t ResolveIndex(int index, size_t count, bool& sawRelativeIndex)
+	{
+		if (index > 0) return (uint32_t)(index - 1);
+		if (index < 0)
+		{
+			sawRelativeIndex = true;
+			return (uint32_t)((int)count + index);
+		}
+		return ObjMissingIndex;
+	}
+
+	//Reads one "v", "v/t", "v//n" or "v/t/n" face corner. Returns false if there wasn't one
+	inline bool ParseCorner(const char*& p, const char* end, const ObjData& data, ObjFaceCorner& corner, bool& sawRelativeIndex)
+	{
+		p = SkipBlanks(p, end);
+
+		int position = 0;
+		int texCoord = 0;
+		int normal = 0;
+
+		std::from_chars_result result = std::from_chars(p, end, position);
+
+		if (result.ec != std::errc())
+		{
+			return false;
+		}
+
+		p = result.ptr;
+
+		if (p < end && *p == '/')
+		{
+			++p;
+
+			if (p < end && *p != '/')
+			{
+				p = std::from_chars(p, end, texCoord).ptr;
+			}
+
+			if (p < end && *p == '/')
+			{
+				++p;
+				p = std::from_chars(p, end, normal).ptr;
+			}
+		}
+
+		corner.Position = ResolveIndex(position, data.Positions.size(), sawRelativeIndex);
+		corner.TexCoord = ResolveIndex(texCoord, data.TexCoords.size(), sawRelativeIndex);
+		corner.Normal = ResolveIndex(normal, data.Normals.size(), sawRelativeIndex);
+
+		return true;
+	}
+
+	const uint32_t EmptySlot = 0xFFFFFFFF;
+
+	//Mixes the 8 words of a vertex's bits into one hash (a murmur style finalizer per word)
+	inline uint32_t HashVertex(const MeshVertex& vertex)
+	{
+		uint32_t words[sizeof(MeshVertex) / sizeof(uint32_t)];
+		memcpy(words, &vertex, sizeof(MeshVertex));
+
+		uint64_t hash = 0x9E3779B97F4A7C15ull;
+
+		for (uint32_t word : words)
+		{
+			hash ^= word;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 32;
+		}
+
+		return (uint32_t)hash;
+	}
+
+	//Looks up the attributes of a face corner, anything the corner doesn't reference is left as zero
+	inline MeshVertex MakeVertex(const ObjData& data, const ObjFaceCorner& corner)
+	{
+		MeshVertex vertex = {};
+
+		if (corner.Position < data.Positions.size()) vertex.Pos = data.Positions[corner.Position];
+		if (corner.Normal < data.Normals.size()) vertex.Normal = data.Normals[corner.Normal];
+		if (corner.TexCoord < data.TexCoords.size()) vertex.TexC = data.TexCoords[corner.TexCoord];
+
+		return vertex;
+	}
+
+	//An "o"/"g" or "usemtl" line. A chunk of the file doesn't know which group or material it starts in, so these are
+	//recorded as they come and only turned into ObjGroups once every chunk is parsed
+	struct GroupChange
+	{
+		uint32_t FirstCorner;
+		bool SetsName;			//Otherwise it sets the material
+		std::string Value;
+	};
+
+	void BuildGroups(const std::vector<GroupChange>& changes, size_t cornerCount, std::vector<ObjGroup>& outGroups)
+	{
+		std::string name;
+		std::string material;
+		uint32_t start = 0;
+		size_t change = 0;
+
+		outGroups.clear();
+
+		while (start < cornerCount)
+		{
+			uint32_t next = change < changes.size() ? changes[change].FirstCorner : (uint32_t)cornerCount;
+
+			if (next > start)
+			{
+				//Runs with the same names one after another (e.g. a repeated usemtl) are one group
+				ObjGroup* last = outGroups.empty() ? nullptr : &outGroups.back();
+
+				if (last && last->Name == name && last->Material == material)
+				{
+					last->CornerCount += next - start;
+				}
+				else
+				{
+					outGroups.push_back({ name, material, start, next - start });
+				}
+
+				start = next;
+			}
+
+			if (change < changes.size())
+			{
+				(changes[change].SetsName ? name : material) = changes[change].Value;
+				++change;
+			}
+		}
+	}
+
+	//Parses the whole lines in [p, end) and appends them to outData, with o/g/usemtl lines going into outChanges.
+	//Returns true if any face used a negative (relative) index, those are resolved against what is in outData so far
+	bool ParseLines(const char* p, const char* end, ObjData& outData, std::vector<GroupChange>& outChanges, bool invertTexCoords)
+	{
+		bool sawRelativeIndex = false;
+
+		while (p < end)
+		{
+			p = SkipBlanks(p, end);
+
+			if (p + 1 < end && p[0] == 'v' && IsBlank(p[1])) //Vertex position
+			{
+				MeshFloat3 vert;
+				p = ParseFloat(p + 1, end, vert.x);
+				p = ParseFloat(p, end, vert.y);
+				p = ParseFloat(p, end, vert.z);
+
+				outData.Positions.push_back(vert);
+			}
+			else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && IsBlank(p[2])) //Texture coordinate
+			{
+				MeshFloat2 texCoord;
+				p = ParseFloat(p + 2, end, texCoord.x);
+				p = ParseFloat(p, end, texCoord.y);
+
+				if (invertTexCoords) texCoord.y = 1.0f - texCoord.y;
+
+				outData.TexCoords.push_back(texCoord);
+			}
+			else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsBlank(p[2])) //Normal
+			{
+				MeshFloat3 normal;
+				p = ParseFloat(p + 2, end, normal.x);
+				p = ParseFloat(p, end, normal.y);
+				p = ParseFloat(p, end, normal.z);
+
+				outData.Normals.push_back(normal);
+			}
+			else if (p + 1 < end && p[0] == 'f' && IsBlank(p[1])) //Face
+			{
+				++p;
+
+				//Polygons with more than 3 corners are split into a triangle fan around the first corner
+				ObjFaceCorner first;
+				ObjFaceCorner previous;
+				ObjFaceCorner current;
+
+				if (ParseCorner(p, end, outData, first, sawRelativeIndex) && ParseCorner(p, end, outData, previous, sawRelativeIndex))
+				{
+					while (ParseCorner(p, end, outData, current, sawRelativeIndex))
+					{
+						outData.Corners.push_back(first);
+						outData.Corners.push_back(previous);
+						outData.Corners.push_back(current);
+
+						previous = current;
+					}
+				}
+			}
+			else if (IsRecord(p, end, "o", 1) || IsRecord(p, end, "g", 1)) //Object or group name
+			{
+				++p;
+				outChanges.push_back({ (uint32_t)outData.Corners.size(), true, ParseRestOfLine(p, end) });
+			}
+			else if (IsRecord(p, end, "usemtl", 6)) //Material for the faces that follow
+			{
+				p += 6;
+				outChanges.push_back({ (uint32_t)outData.Corners.size(), false, ParseRestOfLine(p, end) });
+			}
+			else if (IsRecord(p, end, "mtllib", 6)) //Material file
+			{
+				p += 6;
+				outData.MaterialLibraries.push_back(ParseRestOfLine(p, end));
+			}
+
+			p = NextLine(p, end);
+		}
+
+		return sawRelativeIndex;
+	}
+}
+
+bool OBJParser::ParseFile(const char* filename, ObjData& outData, bool invertTexCoords)
+{
+	MappedFile file;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	ParseBuffer(file.Data(), file.Size(), outData, invertTexCoords);
+
+	return true;
+}
+
+void OBJParser::ParseBuffer(const char* data, size_t size, ObjData& outData, bool invertTexCoords)
+{
+	outData.Clear();
+
+	if (!data || size == 0)
+	{
+		return;
+	}
+
+	std::vector<GroupChange> changes;
+	ParseLines(data, data + size, outData, changes, invertTexCoords);
+	BuildGroups(changes, outData.Corners.size(), outData.Groups);
+}
+
+bool OBJParser::ParseFileParallel(const char* filename, ObjData& outData, ThreadPool& pool, bool invertTexCoords)
+{
+	MappedFile file;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	ParseBufferParallel(file.Data(), file.Size(), outData, pool, invertTexCoords);
+
+	return true;
+}
+
+void OBJParser::ParseBufferParallel(const char* data, size_t size, ObjData& outData, ThreadPool& pool, bool invertTexCoords)
+{
+	size_t threads = pool.ThreadCount() + 1;
+
+	if (threads < 2 || size < ParallelParseMinBytes)
+	{
+		ParseBuffer(data, size, outData, invertTexCoords);
+		return;
+	}
+
+	//A few chunks per thread so one slow chunk doesn't hold everything up. Every chunk starts at the
+	//beginning of a line and ends just after a newline, so no record is ever split between chunks
+	size_t numChunks = threads * 4;
+	std::vector<const char*> boundaries(numChunks + 1);
+	const char* end = data + size;
+
+	boundaries[0] = data;
+	boundaries[numChunks] = end;
+
+	for (size_t i = 1; i < numChunks; ++i)
+	{
+		const char* split = data + size / numChunks * i;
+		if (split < boundaries[i - 1]) split = boundaries[i - 1];
+		boundaries[i] = split < end ? NextLine(split, end) : end;
+	}
+
+	std::vector<ObjData> chunks(numChunks);
+	std::vector<std::vector<GroupChange>> chunkChanges(numChunks);
+	std::vector<char> sawRelativeIndex(numChunks, 0);
+
+	pool.ParallelFor(numChunks, [&](size_t i)
+	{
+		sawRelativeIndex[i] = ParseLines(boundaries[i], boundaries[i + 1], chunks[i], chunkChanges[i], invertTexCoords) ? 1 : 0;
+	});
+
+	//Negative indices count back from the vertices seen so far, which a chunk can't know on its own.
+	//Hardly any exporter writes them, so rather than patching them up those files are just parsed serially
+	for (char relative : sawRelativeIndex)
+	{
+		if (relative)
+		{
+			ParseBuffer(data, size, outData, invertTexCoords);
+			return;
+		}
+	}
+
+	//Positive OBJ indices are already global, so merging is just placing each chunk's arrays at
+	//the prefix sum of the chunks before it
+	std::vector<size_t> positionStart(numChunks + 1, 0);
+	std::vector<size_t> texCoordStart(numChunks + 1, 0);
+	std::vector<size_t> normalStart(numChunks + 1, 0);
+	std::vector<size_t> cornerStart(numChunks + 1, 0);
+
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		positionStart[i + 1] = positionStart[i] + chunks[i].Positions.size();
+		texCoordStart[i + 1] = texCoordStart[i] + chunks[i].TexCoords.size();
+		normalStart[i + 1] = normalStart[i] + chunks[i].Normals.size();
+		cornerStart[i + 1] = cornerStart[i] + chunks[i].Corners.size();
+	}
+
+	//Like ParseBuffer, whatever outData held before is replaced rather than added to
+	outData.Clear();
+
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		outData.MaterialLibraries.insert(outData.MaterialLibraries.end(), chunks[i].MaterialLibraries.begin(), chunks[i].MaterialLibraries.end());
+	}
+
+	outData.Positions.resize(positionStart[numChunks]);
+	outData.TexCoords.resize(texCoordStart[numChunks]);
+	outData.Normals.resize(normalStart[numChunks]);
+	outData.Corners.resize(cornerStart[numChunks]);
+
+	pool.ParallelFor(numChunks, [&](size_t i)
+	{
+		std::copy(chunks[i].Positions.begin(), chunks[i].Positions.end(), outData.Positions.begin() + positionStart[i]);
+		std::copy(chunks[i].TexCoords.begin(), chunks[i].TexCoords.end(), outData.TexCoords.begin() + texCoordStart[i]);
+		std::copy(chunks[i].Normals.begin(), chunks[i].Normals.end(), outData.Normals.begin() + normalStart[i]);
+		std::copy(chunks[i].Corners.begin(), chunks[i].Corners.end(), outData.Corners.begin() + cornerStart[i]);
+
+		chunks[i].Clear();
+		chunks[i].Positions.shrink_to_fit();
+		chunks[i].TexCoords.shrink_to_fit();
+		chunks[i].Normals.shrink_to_fit();
+		chunks[i].Corners.shrink_to_fit();
+	});
+
+	//Groups only change a handful of times per file, so they're stitched together serially
+	std::vector<GroupChange> changes;
+
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		for (GroupChange& change : chunkChanges[i])
+		{
+			change.FirstCorner += (uint32_t)cornerStart[i];
+			changes.push_back(std::move(change));
+		}
+	}
+
+	BuildGroups(changes, outData.Corners.size(), outData.Groups);
+}
+
+void OBJParser::CreateIndices(const ObjData& data, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	size_t numCorners = data.Corners.size();
+
+	outVertices.clear();
+	outIndices.clear();
+	outIndices.reserve(numCorners);
+
+	//Open addressing table of indices into outVertices. It's sized so it is never more than half full,
+	//even if every corner turns out to be unique, which keeps the linear probes short
+	size_t capacity = 16;
+	while (capacity < numCorners * 2) capacity <<= 1;
+
+	std::vector<uint32_t> table(capacity, EmptySlot);
+	size_t mask = capacity - 1;
+
+	for (size_t i = 0; i < numCorners; ++i)
+	{
+		MeshVertex vertex = MakeVertex(data, data.Corners[i]);
+
+		size_t slot = HashVertex(vertex) & mask;
+
+		//Probe until we either find the same vertex or an empty slot to put it in
+		while (table[slot] != EmptySlot && memcmp(&outVertices[table[slot]], &vertex, sizeof(MeshVertex)) != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		if (table[slot] == EmptySlot)
+		{
+			table[slot] = (uint32_t)outVertices.size();
+			outVertices.push_back(vertex);
+		}
+
+		outIndices.push_back(table[slot]);
+	}
+}
+
+bool OBJParser::ParseMaterialFile(const char* filename, std::vector<ObjMaterial>& outMaterials)
+{
+	MappedFile file;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	ParseMaterialBuffer(file.Data(), file.Size(), outMaterials);
+
+	return true;
+}
+
+void OBJParser::ParseMaterialBuffer(const char* data, size_t size, std::vector<ObjMaterial>& outMaterials)
+{
+	if (!data || size == 0)
+	{
+		return;
+	}
+
+	const char* p = data;
+	const char* end = data + size;
+
+	//Records before the first newmtl have no material to go in
+	ObjMaterial* material = nullptr;
+
+	while (p < end)
+	{
+		p = SkipBlanks(p, end);
+
+		if (IsRecord(p, end, "newmtl", 6))
+		{
+			p += 6;
+			outMaterials.emplace_back();
+			material = &outMaterials.back();
+			material->Name = ParseRestOfLine(p, end);
+		}
+		else if (material && (IsRecord(p, end, "Ka", 2) || IsRecord(p, end, "Kd", 2) || IsRecord(p, end, "Ks", 2)))
+		{
+			MeshFloat3& colour = p[1] == 'a' ? material->Ambient : p[1] == 'd' ? material->Diffuse : material->Specular;
+			p = ParseFloat(p + 2, end, colour.x);
+
+			//"Kd 0.5" is a grey
+			const char* y = SkipBlanks(p, end);
+
+			if (y < end && *y != '\n')
+			{
+				p = ParseFloat(p, end, colour.y);
+				p = ParseFloat(p, end, colour.z);
+			}
+			else
+			{
+				colour.y = colour.z = colour.x;
+			}
+		}
+		else if (material && IsRecord(p, end, "Ns", 2))
+		{
+			p = ParseFloat(p + 2, end, material->SpecularPower);
+		}
+		else if (material && IsRecord(p, end, "d", 1))
+		{
+			p = ParseFloat(p + 1, end, material->Opacity);
+		}
+		else if (material && IsRecord(p, end, "Tr", 2))
+		{
+			float transparency;
+			p = ParseFloat(p + 2, end, transparency);
+			material->Opacity = 1.0f - transparency;
+		}
+		else if (material && IsRecord(p, end, "map_Kd", 6))
+		{
+			p += 6;
+			std::string map = ParseRestOfLine(p, end);
+
+			//Options like "-s 1 1 1" come before the file name, which is then the last thing on the line
+			if (!map.empty() && map[0] == '-')
+			{
+				size_t blank = map.find_last_of(" \t");
+				map = blank == std::string::npos ? std::string() : map.substr(blank + 1);
+			}
+
+			material->DiffuseMap = map;
+		}
+
+		p = NextLine(p, end);
+	}
+}
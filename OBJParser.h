@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MeshTypes.h"
+
+class ThreadPool;
+
+//Used in place of an index when a face corner doesn't reference a texture coordinate or normal (e.g. "f 1//3")
+const uint32_t ObjMissingIndex = 0xFFFFFFFF;
+
+//One corner of a face, each index is 0-based and already resolved (negative OBJ indices are relative to the end)
+struct ObjFaceCorner
+{
+	uint32_t Position;
+	uint32_t TexCoord;
+	uint32_t Normal;
+};
+
+//A run of faces that were under the same "o"/"g" and "usemtl" lines. Either name is empty if there wasn't one yet
+struct ObjGroup
+{
+	std::string Name;
+	std::string Material;
+	uint32_t FirstCorner;		//Always the start of a triangle
+	uint32_t CornerCount;
+};
+
+//A material from a .mtl file. Anything the file doesn't set keeps the defaults from the MTL specification
+struct ObjMaterial
+{
+	std::string Name;
+	MeshFloat3 Ambient;			//Ka
+	MeshFloat3 Diffuse;			//Kd
+	MeshFloat3 Specular;		//Ks
+	float SpecularPower;		//Ns
+	float Opacity;				//d, or 1 - Tr
+	std::string DiffuseMap;		//map_Kd, as written in the file
+
+	ObjMaterial();
+};
+
+//The raw contents of an OBJ file. Faces are triangulated, so every 3 corners make a triangle.
+struct ObjData
+{
+	std::vector<MeshFloat3> Positions;
+	std::vector<MeshFloat2> TexCoords;
+	std::vector<MeshFloat3> Normals;
+	std::vector<ObjFaceCorner> Corners;
+	std::vector<ObjGroup> Groups;				//Cover every corner in file order, empty runs are left out
+	std::vector<std::string> MaterialLibraries;	//From "mtllib" lines, relative to the OBJ file
+
+	void Clear();
+};
+
+namespace OBJParser
+{
+	//Files smaller than this aren't worth splitting up, the parallel functions just parse them serially
+	const size_t ParallelParseMinBytes = 1 << 20;
+
+	//Memory maps the file and parses it in place. Returns false if the file couldn't be opened
+	bool ParseFile(const char* filename, ObjData& outData, bool invertTexCoords = true);
+
+	//Parses v/vt/vn/f, o/g, usemtl and mtllib records from an in-memory OBJ file, every other record type is skipped.
+	//Numbers are read straight out of the buffer so no strings are allocated per token.
+	void ParseBuffer(const char* data, size_t size, ObjData& outData, bool invertTexCoords = true);
+
+	//Same as above, but the file is split into chunks at line boundaries which are parsed on the pool and then
+	//stitched back together. The result is identical to the serial parse.
+	bool ParseFileParallel(const char* filename, ObjData& outData, ThreadPool& pool, bool invertTexCoords = true);
+	void ParseBufferParallel(const char* data, size_t size, ObjData& outData, ThreadPool& pool, bool invertTexCoords = true);
+
+	//Re-creates a single index buffer from the 3 given in the OBJ file. Corners whose position, normal and
+	//texture coordinate are bit-for-bit identical are welded into one vertex in a single pass over the faces
+	void CreateIndices(const ObjData& data, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices);
+
+	//Reads the newmtl, Ka/Kd/Ks, Ns, d/Tr and map_Kd records of a .mtl file and appends its materials to outMaterials.
+	//Returns false if the file couldn't be opened
+	bool ParseMaterialFile(const char* filename, std::vector<ObjMaterial>& outMaterials);
+	void ParseMaterialBuffer(const char* data, size_t size, std::vector<ObjMaterial>& outMaterials);
+};
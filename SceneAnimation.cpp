@@ -0,0 +1,15 @@
+#include "SceneAnimation.h"
+
+using namespace DirectX;
+
+void SceneAnimation::BuildTransforms(float t, float carYaw, const SceneConfig& scene, SceneTransforms& out)
+{
+	XMStoreFloat4x4(&out.Sun, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixRotationY(t * 0.1f) * XMMatrixRotationX(t * 0.1f) * XMMatrixTranslation(scene.Sun.x, scene.Sun.y, scene.Sun.z));
+	XMStoreFloat4x4(&out.Planet1, XMMatrixRotationY(t * 0.3f) * XMMatrixTranslation(scene.Planet1.x, scene.Planet1.y, scene.Planet1.z) * XMMatrixRotationY(t));
+	XMStoreFloat4x4(&out.Planet2, XMMatrixRotationY(t * 0.7f) * XMMatrixTranslation(scene.Planet2.x, scene.Planet2.y, scene.Planet2.z) * XMMatrixRotationY(t * 0.3f));
+	XMStoreFloat4x4(&out.Moon1, XMMatrixRotationZ(t * 5.0f) * XMMatrixScaling(0.2f, 0.2f, 0.2f) * XMMatrixTranslation(2.0f, 0.0f, 0.0f) * XMMatrixRotationY(t) * XMMatrixTranslation(scene.Moon1.x, scene.Moon1.y, scene.Moon1.z) * XMMatrixRotationY(t));
+	XMStoreFloat4x4(&out.Moon2, XMMatrixScaling(0.15f, 0.15f, 0.15f) * XMMatrixTranslation(1.5f, 0.0f, 0.0f) * XMMatrixRotationY(t * 0.8f) * XMMatrixTranslation(scene.Moon2.x, scene.Moon2.y, scene.Moon2.z) * XMMatrixRotationY(t * 0.3f));
+	XMStoreFloat4x4(&out.Floor, XMMatrixTranslation(scene.Floor.x, scene.Floor.y, scene.Floor.z));
+	XMStoreFloat4x4(&out.Sphere, XMMatrixTranslation(scene.Sphere.x, scene.Sphere.y, scene.Sphere.z));
+	XMStoreFloat4x4(&out.Car, XMMatrixRotationY(carYaw) * XMMatrixScaling(0.05f, 0.05f, 0.05f) * XMMatrixTranslation(scene.Car.x, scene.Car.y, scene.Car.z));
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <DirectXMath.h>
+#include "SceneConfig.h"
+
+//World matrices of the scene's objects for one frame
+struct SceneTransforms
+{
+	DirectX::XMFLOAT4X4 Sun;
+	DirectX::XMFLOAT4X4 Planet1;
+	DirectX::XMFLOAT4X4 Planet2;
+	DirectX::XMFLOAT4X4 Moon1;
+	DirectX::XMFLOAT4X4 Moon2;
+	DirectX::XMFLOAT4X4 Floor;
+	DirectX::XMFLOAT4X4 Sphere;
+	DirectX::XMFLOAT4X4 Car;
+};
+
+namespace SceneAnimation
+{
+	//Spins the sun, planets and moons t seconds in and puts every object at its position in scene, the car turned
+	//carYaw radians about Y. Only needs DirectXMath, Application::Update calls it every frame
+	void BuildTransforms(float t, float carYaw, const SceneConfig& scene, SceneTransforms& out);
+};
@@ -0,0 +1,96 @@
+#include "SceneConfig.h"
+#include "rapidxml.hpp"
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	struct SceneObject
+	{
+		const char* Name;			//Before the "_x" in the position attribute
+		MeshFloat3 SceneConfig::* Position;
+	};
+
+	const SceneObject SceneObjects[] =
+	{
+		{ "car", &SceneConfig::Car },
+		{ "sun", &SceneConfig::Sun },
+		{ "planet1", &SceneConfig::Planet1 },
+		{ "planet2", &SceneConfig::Planet2 },
+		{ "moon1", &SceneConfig::Moon1 },
+		{ "moon2", &SceneConfig::Moon2 },
+		{ "floor", &SceneConfig::Floor },
+		{ "sphere", &SceneConfig::Sphere },
+	};
+
+	//The component "car_y" names, or null
+	float* FindComponent(const char* name, size_t length, SceneConfig& config)
+	{
+		if (length < 3 || name[length - 2] != '_')
+		{
+			return nullptr;
+		}
+
+		size_t objectLength = length - 2;
+
+		for (const SceneObject& object : SceneObjects)
+		{
+			if (strlen(object.Name) == objectLength && memcmp(object.Name, name, objectLength) == 0)
+			{
+				MeshFloat3& position = config.*object.Position;
+
+				switch (name[length - 1])
+				{
+				case 'x': return &position.x;
+				case 'y': return &position.y;
+				case 'z': return &position.z;
+				default: return nullptr;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+bool SceneConfigXml::Parse(char* text, SceneConfig& config)
+{
+	rapidxml::xml_document<> document;
+
+	try
+	{
+		document.parse<0>(text);
+	}
+	catch (const rapidxml::parse_error&)
+	{
+		return false;
+	}
+
+	rapidxml::xml_node<>* root = document.first_node("values");
+
+	if (!root)
+	{
+		return false;
+	}
+
+	for (rapidxml::xml_node<>* object = root->first_node("object"); object; object = object->next_sibling())
+	{
+		rapidxml::xml_attribute<>* position = object->first_attribute("position");
+		rapidxml::xml_attribute<>* value = object->first_attribute("value");
+
+		if (!position || !value)
+		{
+			continue;
+		}
+
+		float* component = FindComponent(position->value(), position->value_size(), config);
+
+		if (component)
+		{
+			//atof rather than strtof so the values are rounded the way they always were
+			*component = (float)atof(value->value());
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "MeshTypes.h"
+
+//Where values.xml puts the scene's objects. Each axis is its own node, <object position="car_x" value="0.0f"/>.
+//Doesn't use DirectXMath so the parsing can be built and benchmarked anywhere
+struct SceneConfig
+{
+	MeshFloat3 Car;
+	MeshFloat3 Sun;
+	MeshFloat3 Planet1;
+	MeshFloat3 Planet2;
+	MeshFloat3 Moon1;
+	MeshFloat3 Moon2;
+	MeshFloat3 Floor;
+	MeshFloat3 Sphere;
+};
+
+namespace SceneConfigXml
+{
+	//Parses text in place with rapidxml, so it's modified and has to end with a '\0'. Positions the file doesn't set
+	//keep the value they had in config, as do nodes with an unknown name or missing attributes.
+	//Returns false if the text isn't XML with a <values> root
+	bool Parse(char* text, SceneConfig& config);
+};
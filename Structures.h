@@ -12,11 +12,6 @@ struct SimpleVertex
 	XMFLOAT3 Normal;
 	XMFLOAT2 TexC;
 	//XMFLOAT4 Color;
-
-	bool operator<(const SimpleVertex other) const
-	{
-		return memcmp((void*)this, (void*)&other, sizeof(SimpleVertex)) > 0;
-	};
 };
 
 struct ConstantBuffer
@@ -35,4 +30,17 @@ struct ConstantBuffer
 	XMFLOAT3 EyePosW;
 	XMFLOAT3 LightVecW;
 	FLOAT buffer;
+	XMFLOAT4 TextureTransform;	//Scale (xy) and offset (zw) to the texture's tile in its array, see TextureArray.h
+	XMFLOAT4 TextureTile;		//The tile's width and height in texels, the array's gutter (0 for a slice to itself) and TextureArray::MaxMip
+	FLOAT TextureSlice;			//-1 to sample the texture bound on its own instead
+	FLOAT TextureArrayIndex;	//Which of the arrays bound from t1
+	XMFLOAT2 TexturePadding;
+};
+
+//Register b1, how the vertex shader turns a mesh's QuantizedVertex values back into real ones
+struct MeshDecodeBuffer
+{
+	XMFLOAT4 PositionScale;
+	XMFLOAT4 PositionOffset;
+	XMFLOAT4 TexCoordScaleOffset;	//xy scale, zw offset
 };
\ No newline at end of file
@@ -0,0 +1,512 @@
+#include "TextureArray.h"
+#include "rapidxml.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	//A row of tiles in a slice, as tall as the first one put in it
+	struct Shelf
+	{
+		uint32_t Slice;
+		uint32_t Y;
+		uint32_t Height;
+		uint32_t Used;
+	};
+
+	//A level's size, the way D3D rounds it
+	uint32_t LevelSize(uint32_t size, uint32_t mip)
+	{
+		return std::max(size >> mip, 1u);
+	}
+
+	//Levels down to 1x1
+	uint32_t FullMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t count = 1;
+
+		for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+		{
+			++count;
+		}
+
+		return count;
+	}
+
+	//The next level down, each texel the rounded average of the 2x2 above it. An odd last row or column is left out the
+	//way D3D's sizes round down, and a side that's already 1 texel is averaged with itself
+	void Downsample(const uint8_t* texels, uint32_t width, uint32_t height, uint8_t* half)
+	{
+		uint32_t halfWidth = std::max(width / 2, 1u), halfHeight = std::max(height / 2, 1u);
+
+		for (uint32_t y = 0; y < halfHeight; ++y)
+		{
+			const uint8_t* row0 = texels + (size_t)std::min(y * 2, height - 1) * width * 4;
+			const uint8_t* row1 = texels + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+			uint8_t* out = half + (size_t)y * halfWidth * 4;
+
+			for (uint32_t x = 0; x < halfWidth; ++x)
+			{
+				uint32_t x0 = std::min(x * 2, width - 1) * 4, x1 = std::min(x * 2 + 1, width - 1) * 4;
+
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					out[x * 4 + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+		}
+	}
+
+	bool SameName(const char* a, const char* b)
+	{
+		for (; *a && *b; ++a, ++b)
+		{
+			if (tolower((unsigned char)*a) != tolower((unsigned char)*b))
+			{
+				return false;
+			}
+		}
+
+		return *a == *b;
+	}
+
+	uint32_t Attribute(rapidxml::xml_node<>* node, const char* name, bool& found)
+	{
+		rapidxml::xml_attribute<>* attribute = node->first_attribute(name);
+		found = found && attribute != nullptr;
+		return attribute ? (uint32_t)strtoul(attribute->value(), nullptr, 10) : 0;
+	}
+}
+
+std::vector<TextureArrayGroup> TextureArray::Group(const std::vector<TextureArrayEntry>& entries, const std::vector<DXGI_FORMAT>& formats, uint32_t gutter,
+	uint32_t tileSlice)
+{
+	std::vector<TextureArrayGroup> groups;
+	std::vector<std::pair<uint32_t, uint32_t>> sizes;		//Of each group's textures, 0x0 for a tiled one
+
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const TextureArrayEntry& entry = entries[i];
+		bool small = gutter > 0 && entry.Width % gutter == 0 && entry.Height % gutter == 0 && entry.Width + gutter * 2 <= tileSlice / 2 &&
+			entry.Height + gutter * 2 <= tileSlice / 2;
+		std::pair<uint32_t, uint32_t> size = small ? std::make_pair(0u, 0u) : std::make_pair(entry.Width, entry.Height);
+		size_t group = 0;
+
+		while (group < groups.size() && (groups[group].Format != formats[i] || sizes[group] != size))
+		{
+			++group;
+		}
+
+		if (group == groups.size())
+		{
+			groups.push_back({ formats[i], small, {} });
+			sizes.push_back(size);
+		}
+
+		groups[group].Textures.push_back(i);
+	}
+
+	for (TextureArrayGroup& group : groups)
+	{
+		group.Tiled = group.Tiled && group.Textures.size() > 1;
+	}
+
+	return groups;
+}
+
+bool TextureArray::Pack(uint32_t gutter, uint32_t tileSlice, TextureArrayLayout& layout)
+{
+	if ((gutter & (gutter - 1)) != 0 || layout.Entries.empty())
+	{
+		return false;
+	}
+
+	//A slice each, the sampler does the wrapping
+	if (gutter == 0)
+	{
+		const TextureArrayEntry& first = layout.Entries[0];
+
+		for (uint32_t i = 0; i < layout.Entries.size(); ++i)
+		{
+			TextureArrayEntry& entry = layout.Entries[i];
+
+			if (entry.Width == 0 || entry.Height == 0 || entry.Width != first.Width || entry.Height != first.Height)
+			{
+				return false;
+			}
+
+			entry.Slice = i;
+			entry.X = 0;
+			entry.Y = 0;
+		}
+
+		layout.Width = first.Width;
+		layout.Height = first.Height;
+		layout.SliceCount = (uint32_t)layout.Entries.size();
+		layout.Gutter = 0;
+		layout.MipCount = FullMipCount(layout.Width, layout.Height);
+		return true;
+	}
+
+	//Slices stay a multiple of the gutter so every tile keeps to whole texels while there is one
+	uint32_t width = (tileSlice + gutter - 1) / gutter * gutter, height = width;
+
+	for (const TextureArrayEntry& entry : layout.Entries)
+	{
+		if (entry.Width == 0 || entry.Height == 0 || entry.Width % gutter != 0 || entry.Height % gutter != 0)
+		{
+			return false;
+		}
+
+		width = std::max(width, entry.Width + gutter * 2);
+		height = std::max(height, entry.Height + gutter * 2);
+	}
+
+	//Tallest first, so a shelf's first texture is the tallest it will hold
+	std::vector<size_t> order(layout.Entries.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&layout](size_t a, size_t b)
+	{
+		const TextureArrayEntry& ea = layout.Entries[a];
+		const TextureArrayEntry& eb = layout.Entries[b];
+		return ea.Height != eb.Height ? ea.Height > eb.Height : ea.Width > eb.Width;
+	});
+
+	std::vector<Shelf> shelves;
+	std::vector<uint32_t> sliceHeights;		//How far down each slice's shelves reach
+
+	for (size_t i : order)
+	{
+		TextureArrayEntry& entry = layout.Entries[i];
+		uint32_t paddedWidth = entry.Width + gutter * 2, paddedHeight = entry.Height + gutter * 2;
+		size_t shelf = 0;
+
+		while (shelf < shelves.size() && (paddedHeight > shelves[shelf].Height || shelves[shelf].Used + paddedWidth > width))
+		{
+			++shelf;
+		}
+
+		//A new shelf under the last one of the first slice with room, or a new slice
+		if (shelf == shelves.size())
+		{
+			uint32_t slice = 0;
+
+			while (slice < sliceHeights.size() && sliceHeights[slice] + paddedHeight > height)
+			{
+				++slice;
+			}
+
+			if (slice == sliceHeights.size())
+			{
+				sliceHeights.push_back(0);
+			}
+
+			shelves.push_back({ slice, sliceHeights[slice], paddedHeight, 0 });
+			sliceHeights[slice] += paddedHeight;
+		}
+
+		entry.Slice = shelves[shelf].Slice;
+		entry.X = shelves[shelf].Used + gutter;
+		entry.Y = shelves[shelf].Y + gutter;
+		shelves[shelf].Used += paddedWidth;
+	}
+
+	layout.Width = width;
+	layout.Height = height;
+	layout.SliceCount = (uint32_t)sliceHeights.size();
+	layout.Gutter = gutter;
+	layout.MipCount = FullMipCount(width, height);
+
+	//Levels no tile is sampled from aren't kept
+	uint32_t lastMip = 0;
+
+	for (const TextureArrayEntry& entry : layout.Entries)
+	{
+		lastMip = std::max(lastMip, MaxMip(layout, entry));
+	}
+
+	layout.MipCount = lastMip + 1;
+	return true;
+}
+
+void TextureArray::Compose(const TextureArrayLayout& layout, const std::vector<const uint8_t*>& texels, std::vector<uint8_t>& out)
+{
+	std::vector<size_t> levelOffsets;
+	size_t sliceBytes = 0;
+
+	for (uint32_t mip = 0; mip < layout.MipCount; ++mip)
+	{
+		levelOffsets.push_back(sliceBytes);
+		sliceBytes += (size_t)LevelSize(layout.Width, mip) * LevelSize(layout.Height, mip) * 4;
+	}
+
+	out.assign(sliceBytes * layout.SliceCount, 0);
+
+	//The levels each texture is placed in on its own, with its gutter while it has one
+	uint32_t placedMips = layout.MipCount;
+
+	if (layout.Gutter > 0)
+	{
+		placedMips = 1;
+
+		for (uint32_t g = layout.Gutter; g > 1 && placedMips < layout.MipCount; g /= 2)
+		{
+			++placedMips;
+		}
+	}
+
+	for (size_t i = 0; i < layout.Entries.size(); ++i)
+	{
+		const TextureArrayEntry& entry = layout.Entries[i];
+		std::vector<uint8_t> level(texels[i], texels[i] + (size_t)entry.Width * entry.Height * 4), half;
+
+		for (uint32_t mip = 0; mip < placedMips; ++mip)
+		{
+			//A tile's size, position and gutter are all multiples of 2^mip here, so they shrink with the slice exactly
+			uint32_t width = LevelSize(entry.Width, mip), height = LevelSize(entry.Height, mip), gutter = layout.Gutter >> mip;
+			uint32_t sliceWidth = LevelSize(layout.Width, mip);
+			uint8_t* slice = &out[sliceBytes * entry.Slice + levelOffsets[mip]];
+
+			if (mip > 0)
+			{
+				half.resize((size_t)width * height * 4);
+				Downsample(level.data(), LevelSize(entry.Width, mip - 1), LevelSize(entry.Height, mip - 1), half.data());
+				level.swap(half);
+			}
+
+			for (uint32_t y = 0; y < height + gutter * 2; ++y)
+			{
+				const uint8_t* source = &level[(size_t)((y + height - gutter) % height) * width * 4];
+				uint8_t* destination = slice + ((size_t)((entry.Y >> mip) - gutter + y) * sliceWidth + (entry.X >> mip) - gutter) * 4;
+
+				for (uint32_t x = 0; x < width + gutter * 2; ++x)
+				{
+					memcpy(destination + x * 4, source + (size_t)((x + width - gutter) % width) * 4, 4);
+				}
+			}
+		}
+	}
+
+	//Past the gutter the tiles no longer keep to whole texels, so the rest of the levels are the whole slice's
+	for (uint32_t slice = 0; slice < layout.SliceCount; ++slice)
+	{
+		for (uint32_t mip = placedMips; mip < layout.MipCount; ++mip)
+		{
+			uint8_t* base = &out[sliceBytes * slice];
+			Downsample(base + levelOffsets[mip - 1], LevelSize(layout.Width, mip - 1), LevelSize(layout.Height, mip - 1), base + levelOffsets[mip]);
+		}
+	}
+}
+
+void TextureArray::UVTransform(const TextureArrayLayout& layout, const TextureArrayEntry& entry, float* scaleOffset)
+{
+	scaleOffset[0] = (float)entry.Width / layout.Width;
+	scaleOffset[1] = (float)entry.Height / layout.Height;
+	scaleOffset[2] = (float)entry.X / layout.Width;
+	scaleOffset[3] = (float)entry.Y / layout.Height;
+}
+
+double TextureArray::EdgeInset(uint32_t gutter, uint32_t mip)
+{
+	return gutter == 0 ? 0.0 : std::max(1.5 * (double)(1u << mip) - gutter, 0.0);
+}
+
+uint32_t TextureArray::MaxMip(const TextureArrayLayout& layout, const TextureArrayEntry& entry)
+{
+	if (layout.Gutter == 0)
+	{
+		return layout.MipCount - 1;
+	}
+
+	uint32_t mip = 0;
+
+	while (mip + 1 < layout.MipCount && EdgeInset(layout.Gutter, mip + 1) <= std::min(entry.Width, entry.Height) / 2.0)
+	{
+		++mip;
+	}
+
+	return mip;
+}
+
+const TextureArrayEntry* TextureArray::Find(const TextureArrayLayout& layout, const char* filename)
+{
+	const char* name = filename;
+
+	for (const char* c = filename; *c; ++c)
+	{
+		if (*c == '/' || *c == '\\')
+		{
+			name = c + 1;
+		}
+	}
+
+	for (const TextureArrayEntry& entry : layout.Entries)
+	{
+		if (SameName(entry.Name.c_str(), name))
+		{
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool TextureArray::ReadTexels(const uint8_t* ddsData, size_t ddsDataSize, DXGI_FORMAT& format, uint32_t& width, uint32_t& height, std::vector<uint8_t>& texels)
+{
+	const DDS_HEADER* header;
+	const uint8_t* bitData;
+	size_t bitSize;
+
+	if (!DDSFormat::ParseHeader(ddsData, ddsDataSize, &header, &bitData, &bitSize))
+	{
+		return false;
+	}
+
+	const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+	format = dxt10 ? dxt10->dxgiFormat : DDSFormat::GetDXGIFormat(header->ddspf);
+
+	//Only formats that box filter a byte at a time
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+		break;
+
+	default:
+		return false;
+	}
+
+	if ((header->flags & DDS_HEADER_FLAGS_VOLUME) || (header->caps2 & DDS_CUBEMAP) || (dxt10 && dxt10->arraySize > 1))
+	{
+		return false;
+	}
+
+	size_t mipCount = std::max<uint32_t>(header->mipMapCount, 1);
+	std::vector<DDSSubresource> subresources(mipCount);
+	size_t twidth, theight, tdepth, skipMip;
+
+	if (DDSFormat::FillInitData(header->width, header->height, 1, mipCount, 1, format, 0, bitSize, bitData, twidth, theight, tdepth, skipMip,
+		subresources.data()) != DDS_LAYOUT_OK)
+	{
+		return false;
+	}
+
+	width = header->width;
+	height = header->height;
+	texels.resize((size_t)width * height * 4);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		memcpy(&texels[(size_t)y * width * 4], subresources[0].data + y * subresources[0].rowPitch, (size_t)width * 4);
+	}
+
+	return true;
+}
+
+std::string TextureArrayXml::Write(const std::vector<TextureArrayLayout>& layouts)
+{
+	char line[512];
+	std::string text = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<texturearrays>\n";
+
+	for (const TextureArrayLayout& layout : layouts)
+	{
+		snprintf(line, sizeof(line), "\t<texturearray file=\"%s\" format=\"%u\" width=\"%u\" height=\"%u\" slices=\"%u\" mips=\"%u\" gutter=\"%u\">\n",
+			layout.File.c_str(), (unsigned int)layout.Format, layout.Width, layout.Height, layout.SliceCount, layout.MipCount, layout.Gutter);
+		text += line;
+
+		for (const TextureArrayEntry& entry : layout.Entries)
+		{
+			snprintf(line, sizeof(line), "\t\t<texture name=\"%s\" slice=\"%u\" x=\"%u\" y=\"%u\" width=\"%u\" height=\"%u\"/>\n", entry.Name.c_str(),
+				entry.Slice, entry.X, entry.Y, entry.Width, entry.Height);
+			text += line;
+		}
+
+		text += "\t</texturearray>\n";
+	}
+
+	text += "</texturearrays>\n";
+	return text;
+}
+
+bool TextureArrayXml::Parse(char* text, std::vector<TextureArrayLayout>& layouts)
+{
+	rapidxml::xml_document<> document;
+
+	try
+	{
+		document.parse<0>(text);
+	}
+	catch (const rapidxml::parse_error&)
+	{
+		return false;
+	}
+
+	rapidxml::xml_node<>* root = document.first_node("texturearrays");
+	layouts.clear();
+
+	if (!root)
+	{
+		return false;
+	}
+
+	for (rapidxml::xml_node<>* node = root->first_node("texturearray"); node; node = node->next_sibling("texturearray"))
+	{
+		rapidxml::xml_attribute<>* file = node->first_attribute("file");
+
+		if (!file)
+		{
+			return false;
+		}
+
+		bool found = true;
+		TextureArrayLayout layout;
+		layout.File = file->value();
+		layout.Format = (DXGI_FORMAT)Attribute(node, "format", found);
+		layout.Width = Attribute(node, "width", found);
+		layout.Height = Attribute(node, "height", found);
+		layout.SliceCount = Attribute(node, "slices", found);
+		layout.MipCount = Attribute(node, "mips", found);
+		layout.Gutter = Attribute(node, "gutter", found);
+
+		for (rapidxml::xml_node<>* texture = node->first_node("texture"); texture; texture = texture->next_sibling("texture"))
+		{
+			rapidxml::xml_attribute<>* name = texture->first_attribute("name");
+			TextureArrayEntry entry;
+			entry.Name = name ? name->value() : "";
+			entry.Slice = Attribute(texture, "slice", found);
+			entry.X = Attribute(texture, "x", found);
+			entry.Y = Attribute(texture, "y", found);
+			entry.Width = Attribute(texture, "width", found);
+			entry.Height = Attribute(texture, "height", found);
+
+			//Without a gutter a texture fills its slice
+			bool fits = layout.Gutter == 0 ? entry.X == 0 && entry.Y == 0 && entry.Width == layout.Width && entry.Height == layout.Height :
+				entry.X >= layout.Gutter && entry.Y >= layout.Gutter && entry.X + entry.Width + layout.Gutter <= layout.Width &&
+				entry.Y + entry.Height + layout.Gutter <= layout.Height;
+
+			if (!name || entry.Slice >= layout.SliceCount || !fits)
+			{
+				return false;
+			}
+
+			layout.Entries.push_back(entry);
+		}
+
+		if (!found || layout.Width == 0 || layout.Height == 0 || layout.MipCount == 0 || (layout.Gutter & (layout.Gutter - 1)) != 0)
+		{
+			return false;
+		}
+
+		layouts.push_back(layout);
+	}
+
+	return !layouts.empty();
+}
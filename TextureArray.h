@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DDSFormat.h"
+
+//Where one texture went in its array
+struct TextureArrayEntry
+{
+	std::string Name;			//The source's file name without its directory, which Find looks it up by
+	uint32_t Slice;
+	uint32_t X;					//Top left of the texture in its slice, inside its gutter. 0 when it has the slice to itself
+	uint32_t Y;
+	uint32_t Width;
+	uint32_t Height;
+};
+
+//Same format textures in the slices of one Texture2DArray, so one bind serves every object drawn with any of them.
+//Textures of the same size each get a whole slice with their full mip chain, and the sampler wraps them as it would a
+//texture of their own. Small textures can share slices instead, as tiles each surrounded by a gutter of its own texels
+//wrapped around, which a shader wraps the texture coordinates into itself (see SampleDiffuse in DX11 Framework.fx).
+//The gutter is halved with every mip, and the levels past the last one with a gutter are made from the whole slice, so
+//the shader clamps the coordinates in from the tile's edges by as much of the filter's reach as the gutter no longer
+//covers (see EdgeInset), down to MaxMip, the last level where that leaves any of the tile.
+//Built offline by Tools/TextureArrayCompiler.cpp, which writes the arrays' DDS files and a manifest for TextureArrayXml.
+struct TextureArrayLayout
+{
+	std::string File;			//The array's DDS file, relative to the manifest
+	DXGI_FORMAT Format;
+	uint32_t Width;				//Of every slice
+	uint32_t Height;
+	uint32_t SliceCount;
+	uint32_t MipCount;
+	uint32_t Gutter;			//0 when every texture has a slice to itself
+	std::vector<TextureArrayEntry> Entries;
+};
+
+//Textures that can go in one array, see TextureArray::Group
+struct TextureArrayGroup
+{
+	DXGI_FORMAT Format;
+	bool Tiled;					//They share slices, otherwise they're all the same size and have one each
+	std::vector<size_t> Textures;
+};
+
+namespace TextureArray
+{
+	//Sorts textures into arrays: small ones, whose tiles with their gutter fit in a quarter of a tileSlice slice and whose
+	//sizes are multiples of the gutter, share slices with the other small ones of their format. Every other texture goes
+	//in an array of its format and size. formats[i] is the format of entries[i], whose Width and Height have to be set.
+	//A lone small texture isn't tiled, and gutter 0 tiles nothing
+	std::vector<TextureArrayGroup> Group(const std::vector<TextureArrayEntry>& entries, const std::vector<DXGI_FORMAT>& formats, uint32_t gutter,
+		uint32_t tileSlice);
+
+	//Places the textures in the entries (Name, Width and Height set). With gutter 0 they all have to be the same size and
+	//each gets a slice with its full mip chain. Otherwise they're tiles in tileSlice slices (or slices big enough for the
+	//largest) packed by a shelf packer, gutter has to be a power of two every width and height is a multiple of, and the
+	//array has the levels down to the largest MaxMip. Returns false if the textures don't meet that
+	bool Pack(uint32_t gutter, uint32_t tileSlice, TextureArrayLayout& layout);
+
+	//Every level of every slice, slice after slice with each one's levels in order, the way a DDS array holds them.
+	//texels[i] is the top level of layout.Entries[i], 4 bytes a texel in any channel order. Unused space is zero
+	void Compose(const TextureArrayLayout& layout, const std::vector<const uint8_t*>& texels, std::vector<uint8_t>& out);
+
+	//The scale (xy) and offset (zw) that take a texture's own 0..1 coordinates to its tile in the slice
+	void UVTransform(const TextureArrayLayout& layout, const TextureArrayEntry& entry, float* scaleOffset);
+
+	//How far in from a tile's edges, in its top level texels, coordinates have to be kept so bilinear filtering at mip
+	//doesn't reach past its gutter. The texels filtered are within a texel of the coordinate and each one averages the
+	//top level texels under it, so the reach is one and a half of mip's texels. 0 without a gutter
+	double EdgeInset(uint32_t gutter, uint32_t mip);
+
+	//The last level entry is sampled from: the array's last without a gutter, else the last where EdgeInset leaves the
+	//tile's centre
+	uint32_t MaxMip(const TextureArrayLayout& layout, const TextureArrayEntry& entry);
+
+	//The entry for filename, compared without its directory and ignoring case. Null if it isn't in the array
+	const TextureArrayEntry* Find(const TextureArrayLayout& layout, const char* filename);
+
+	//The top level of a DDS file with 4 bytes a texel, and its format. Returns false for anything else, including block
+	//compressed, cube, volume and array textures
+	bool ReadTexels(const uint8_t* ddsData, size_t ddsDataSize, DXGI_FORMAT& format, uint32_t& width, uint32_t& height, std::vector<uint8_t>& texels);
+};
+
+//The manifest that goes with the arrays' DDS files:
+//	<texturearrays>
+//		<texturearray file="TextureArray0.dds" format="87" width="512" height="512" slices="3" mips="10" gutter="0">
+//			<texture name="Crate_COLOR.dds" slice="0" x="0" y="0" width="512" height="512"/>
+//		</texturearray>
+//	</texturearrays>
+namespace TextureArrayXml
+{
+	std::string Write(const std::vector<TextureArrayLayout>& layouts);
+
+	//Parses text in place with rapidxml, so it's modified and has to end with a '\0'. Returns false if it isn't a manifest
+	//or a texture lies outside its slice
+	bool Parse(char* text, std::vector<TextureArrayLayout>& layouts);
+};
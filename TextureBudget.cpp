@@ -0,0 +1,153 @@
+#include "TextureBudget.h"
+#include <algorithm>
+
+TextureBudget::TextureBudget()
+{
+	_budget = 0;
+	_frame = 0;
+}
+
+std::vector<uint64_t> TextureBudget::MipBytes(const DDS_HEADER* header)
+{
+	std::vector<uint64_t> mipBytes;
+	DDSMetadata metadata;
+
+	if (DDSFormat::GetMetadata(header, metadata))
+	{
+		for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+		{
+			mipBytes.push_back(DDSFormat::GetMipBytes(metadata, mip));
+		}
+	}
+
+	return mipBytes;
+}
+
+size_t TextureBudget::Add(const std::vector<uint64_t>& mipBytes)
+{
+	size_t id;
+
+	if (_free.empty())
+	{
+		id = _entries.size();
+		_entries.emplace_back();
+	}
+	else
+	{
+		id = _free.back();
+		_free.pop_back();
+	}
+
+	Entry& entry = _entries[id];
+	entry.MipBytes = mipBytes;
+	entry.FirstMip = 0;
+	entry.LastUsed = _frame;
+	entry.Live = true;
+	return id;
+}
+
+void TextureBudget::Remove(size_t id)
+{
+	_entries[id].MipBytes.clear();
+	_entries[id].Live = false;
+	_free.push_back(id);
+}
+
+void TextureBudget::Touch(size_t id)
+{
+	_entries[id].LastUsed = _frame;
+}
+
+void TextureBudget::NextFrame()
+{
+	++_frame;
+}
+
+void TextureBudget::SetBudget(uint64_t bytes)
+{
+	_budget = bytes;
+}
+
+uint64_t TextureBudget::ResidentBytes(size_t id) const
+{
+	const Entry& entry = _entries[id];
+	uint64_t bytes = 0;
+
+	for (size_t mip = entry.FirstMip; mip < entry.MipBytes.size(); ++mip)
+	{
+		bytes += entry.MipBytes[mip];
+	}
+
+	return bytes;
+}
+
+uint64_t TextureBudget::ResidentBytes() const
+{
+	uint64_t bytes = 0;
+
+	for (size_t id = 0; id < _entries.size(); ++id)
+	{
+		bytes += _entries[id].Live ? ResidentBytes(id) : 0;
+	}
+
+	return bytes;
+}
+
+void TextureBudget::Plan(std::vector<TextureBudgetChange>& outChanges)
+{
+	outChanges.clear();
+
+	std::vector<size_t> order;
+	std::vector<uint32_t> firstMips(_entries.size(), 0);
+	uint64_t total = 0;
+
+	for (size_t id = 0; id < _entries.size(); ++id)
+	{
+		if (_entries[id].Live)
+		{
+			order.push_back(id);
+			firstMips[id] = _entries[id].FirstMip;
+			total += ResidentBytes(id);
+		}
+	}
+
+	//Least recently used first, ties by id so the same frame always gives the same plan
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b)
+	{
+		return _entries[a].LastUsed != _entries[b].LastUsed ? _entries[a].LastUsed < _entries[b].LastUsed : a < b;
+	});
+
+	//Each texture is taken down to its smallest level before the next one is touched, which frees the most for the
+	//fewest textures that look worse
+	for (size_t i = 0; _budget > 0 && total > _budget && i < order.size(); ++i)
+	{
+		const Entry& entry = _entries[order[i]];
+		uint32_t& firstMip = firstMips[order[i]];
+
+		while (total > _budget && firstMip + 1 < entry.MipBytes.size())
+		{
+			total -= entry.MipBytes[firstMip++];
+		}
+	}
+
+	//Levels only come back into room that's already free, so textures don't swap levels back and forth every frame
+	for (size_t i = order.size(); i-- > 0;)
+	{
+		const Entry& entry = _entries[order[i]];
+		uint32_t& firstMip = firstMips[order[i]];
+
+		while (firstMip > 0 && (_budget == 0 || total + entry.MipBytes[firstMip - 1] <= _budget))
+		{
+			total += entry.MipBytes[--firstMip];
+		}
+	}
+
+	for (size_t id : order)
+	{
+		if (firstMips[id] != _entries[id].FirstMip)
+		{
+			_entries[id].FirstMip = firstMips[id];
+			outChanges.push_back({ id, firstMips[id] });
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DDSFormat.h"
+
+//A texture that has to move to a different first mip to fit the budget
+struct TextureBudgetChange
+{
+	size_t Id;
+	uint32_t FirstMip;
+};
+
+//Decides which mips of which textures fit in a memory budget, dropping the biggest levels of the least recently used
+//textures first. It only does the accounting, TextureRegistry recreates the textures its plans change, so the policy can
+//be built and tested anywhere. Sizes come from the DDS header (see MipBytes), not from the GPU.
+//
+//	size_t id = budget.Add(TextureBudget::MipBytes(header));
+//	...every frame: budget.Touch(id) for the textures drawn, then budget.Plan(changes) and budget.NextFrame()...
+class TextureBudget
+{
+private:
+	struct Entry
+	{
+		std::vector<uint64_t> MipBytes;		//Largest level first
+		uint32_t FirstMip;					//The largest level kept
+		uint64_t LastUsed;					//Frame of the last Touch, or of Add
+		bool Live;
+	};
+
+	std::vector<Entry> _entries;
+	std::vector<size_t> _free;
+	uint64_t _budget;
+	uint64_t _frame;
+
+public:
+	TextureBudget();
+
+	//The bytes of each mip level of the texture, all its array slices and cube faces together. Empty if
+	//DDSFormat::GetMetadata can't make sense of the header
+	static std::vector<uint64_t> MipBytes(const DDS_HEADER* header);
+
+	//A texture with every level resident. Returns its id, which is reused once it's removed
+	size_t Add(const std::vector<uint64_t>& mipBytes);
+	void Remove(size_t id);
+
+	//The texture was drawn this frame
+	void Touch(size_t id);
+	void NextFrame();
+
+	//0 for no limit. Takes effect at the next Plan
+	void SetBudget(uint64_t bytes);
+	uint64_t Budget() const { return _budget; }
+
+	uint32_t FirstMip(size_t id) const { return _entries[id].FirstMip; }
+	uint32_t MipCount(size_t id) const { return (uint32_t)_entries[id].MipBytes.size(); }
+	uint64_t ResidentBytes(size_t id) const;
+	uint64_t ResidentBytes() const;
+
+	//Moves textures to the levels that fit and lists the ones that changed. Over budget the least recently used lose their
+	//biggest levels first, under it the most recently used get theirs back while they fit in the room that's left. The
+	//budget is only ever broken when even the smallest level of every texture doesn't fit
+	void Plan(std::vector<TextureBudgetChange>& outChanges);
+};
@@ -0,0 +1,100 @@
+#include "TextureInventory.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	bool IsDDS(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return extension == ".dds";
+	}
+}
+
+bool TextureInventory::Scan(const std::vector<std::string>& paths, ThreadPool& pool, std::vector<TextureInventoryEntry>& entries)
+{
+	std::vector<std::string> files;
+	bool found = true;
+
+	for (const std::string& path : paths)
+	{
+		std::error_code error;
+
+		if (std::filesystem::is_directory(path, error))
+		{
+			std::filesystem::recursive_directory_iterator it(path, std::filesystem::directory_options::skip_permission_denied, error), end;
+
+			for (; !error && it != end; it.increment(error))
+			{
+				std::error_code fileError;
+
+				if (it->is_regular_file(fileError) && IsDDS(it->path()))
+				{
+					files.push_back(it->path().string());
+				}
+			}
+
+			found = found && !error;
+		}
+		else if (std::filesystem::is_regular_file(path, error))
+		{
+			files.push_back(path);
+		}
+		else
+		{
+			found = false;
+		}
+	}
+
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+
+	entries.clear();
+	entries.resize(files.size());
+
+	pool.ParallelFor(files.size(), [&](size_t i)
+	{
+		entries[i] = Read(files[i]);
+	});
+
+	return found;
+}
+
+TextureInventoryEntry TextureInventory::Read(const std::string& path)
+{
+	TextureInventoryEntry entry = {};
+	entry.Path = path;
+	entry.Status = TextureInventoryUnreadable;
+
+	std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+
+	if (!file)
+	{
+		return entry;
+	}
+
+	uint8_t headers[DDS_MAX_HEADER_SIZE];
+	entry.FileSize = (uint64_t)file.tellg();
+	file.seekg(0);
+	file.read((char*)headers, sizeof(headers));
+
+	const DDS_HEADER* header;
+	const uint8_t* bitData;
+	size_t bitSize;
+
+	//bitData only says where the pixels would start, the rest of the file isn't there to check
+	if (!DDSFormat::ParseHeader(headers, (size_t)file.gcount(), &header, &bitData, &bitSize) || !DDSFormat::GetMetadata(header, entry.Metadata))
+	{
+		entry.Metadata = {};
+		entry.Status = TextureInventoryUnsupported;
+		return entry;
+	}
+
+	uint64_t headerBytes = (uint64_t)(bitData - headers);
+	entry.Status = entry.FileSize - headerBytes < entry.Metadata.totalBytes ? TextureInventoryTruncated : TextureInventoryOk;
+	return entry;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DDSFormat.h"
+
+class ThreadPool;
+
+enum TextureInventoryStatus
+{
+	TextureInventoryOk,
+	TextureInventoryTruncated,		//Shorter than its headers say, DDSTextureLoader would refuse it
+	TextureInventoryUnsupported,	//Not a DDS file, or one DDSFormat::GetMetadata rejects
+	TextureInventoryUnreadable,		//Couldn't be opened
+};
+
+//One .dds file a scan found
+struct TextureInventoryEntry
+{
+	std::string Path;
+	uint64_t FileSize;
+	TextureInventoryStatus Status;
+	DDSMetadata Metadata;			//Zero unless it's Ok or Truncated
+};
+
+//What a directory of textures holds and what it would cost on the GPU, from the headers alone: each file's first
+//DDS_MAX_HEADER_SIZE bytes are read and nothing else, so thousands are inventoried in milliseconds. Only uses the
+//standard library, see Tools/TextureScanner.cpp.
+namespace TextureInventory
+{
+	//Every .dds file (any case) under each directory, recursively, and any file named directly, sorted by path.
+	//The directories are walked on the calling thread and the headers read across the pool. Returns false if a path
+	//doesn't exist or a directory couldn't be walked, having scanned the rest
+	bool Scan(const std::vector<std::string>& paths, ThreadPool& pool, std::vector<TextureInventoryEntry>& entries);
+
+	//Reads one file's headers
+	TextureInventoryEntry Read(const std::string& path);
+};
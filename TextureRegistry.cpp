@@ -0,0 +1,196 @@
+#include "TextureRegistry.h"
+#include "ContentHash.h"
+#include "DDSTextureLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+//Meshes fill vectors with it, which takes it by reference
+const size_t TextureRegistry::Invalid;
+
+TextureRegistry::TextureRegistry()
+{
+}
+
+TextureRegistry::~TextureRegistry()
+{
+	Clear();
+}
+
+std::string TextureRegistry::PathKey(const char* filename)
+{
+	//Windows paths ignore case and take either slash
+	std::string key = filename;
+
+	for (char& c : key)
+	{
+		c = c == '/' ? '\\' : (char)tolower((unsigned char)c);
+	}
+
+	return key;
+}
+
+HRESULT TextureRegistry::Create(ID3D11Device* device, Texture& texture, uint32_t firstMip, ID3D11ShaderResourceView** out)
+{
+	//CreateDDSTextureFromMemory drops every level bigger than maxsize
+	size_t maxsize = firstMip == 0 ? 0 : std::max<size_t>(std::max<size_t>(texture.Width >> firstMip, 1), std::max<size_t>(texture.Height >> firstMip, 1));
+	return DirectX::CreateDDSTextureFromMemory(device, (const uint8_t*)texture.File.Data(), texture.File.Size(), nullptr, out, maxsize);
+}
+
+size_t TextureRegistry::Acquire(ID3D11Device* device, const char* filename)
+{
+	char report[512];
+	std::string key = PathKey(filename);
+	auto path = _paths.find(key);
+
+	if (path != _paths.end())
+	{
+		++_textures[path->second]->References;
+		return path->second;
+	}
+
+	std::unique_ptr<Texture> texture(new Texture());
+	const DDS_HEADER* header;
+	const uint8_t* bitData;
+	size_t bitSize;
+
+	if (!texture->File.Open(filename) ||
+		!DDSFormat::ParseHeader((const uint8_t*)texture->File.Data(), texture->File.Size(), &header, &bitData, &bitSize))
+	{
+		sprintf_s(report, "%s: not a DDS texture that could be opened\n", filename);
+		OutputDebugStringA(report);
+		return Invalid;
+	}
+
+	//Another path to a texture that's already loaded, or a copy of one
+	uint64_t hash = ContentHash(texture->File.Data(), texture->File.Size());
+	auto content = _contents.find(hash);
+
+	if (content != _contents.end())
+	{
+		Texture& shared = *_textures[content->second];
+		++shared.References;
+		_paths[key] = content->second;
+
+		sprintf_s(report, "%s: same contents as %s, sharing it\n", filename, shared.Filename.c_str());
+		OutputDebugStringA(report);
+		return content->second;
+	}
+
+	texture->Filename = filename;
+	texture->Hash = hash;
+	texture->Width = header->width;
+	texture->Height = header->height;
+	texture->View = nullptr;
+	texture->References = 1;
+
+	if (FAILED(Create(device, *texture, 0, &texture->View)))
+	{
+		sprintf_s(report, "%s: texture creation FAILED\n", filename);
+		OutputDebugStringA(report);
+		return Invalid;
+	}
+
+	//A format the header math doesn't know is still counted, as one level
+	std::vector<uint64_t> mipBytes = TextureBudget::MipBytes(header);
+
+	if (mipBytes.empty())
+	{
+		mipBytes.push_back(bitSize);
+	}
+
+	size_t handle = _budget.Add(mipBytes);
+
+	if (handle >= _textures.size())
+	{
+		_textures.resize(handle + 1);
+	}
+
+	_textures[handle] = std::move(texture);
+	_paths[key] = handle;
+	_contents[hash] = handle;
+	return handle;
+}
+
+void TextureRegistry::Release(size_t texture)
+{
+	if (texture == Invalid || --_textures[texture]->References > 0)
+	{
+		return;
+	}
+
+	for (auto path = _paths.begin(); path != _paths.end();)
+	{
+		path = path->second == texture ? _paths.erase(path) : std::next(path);
+	}
+
+	_contents.erase(_textures[texture]->Hash);
+
+	if (_textures[texture]->View) _textures[texture]->View->Release();
+
+	_textures[texture].reset();
+	_budget.Remove(texture);
+}
+
+ID3D11ShaderResourceView* TextureRegistry::Use(size_t texture)
+{
+	if (texture == Invalid)
+	{
+		return nullptr;
+	}
+
+	_budget.Touch(texture);
+	return _textures[texture]->View;
+}
+
+void TextureRegistry::SetBudget(uint64_t bytes)
+{
+	_budget.SetBudget(bytes);
+}
+
+void TextureRegistry::Update(ID3D11Device* device)
+{
+	char report[512];
+	_budget.Plan(_changes);
+
+	for (const TextureBudgetChange& change : _changes)
+	{
+		Texture& texture = *_textures[change.Id];
+		ID3D11ShaderResourceView* view = nullptr;
+
+		//The old view stays if the new one can't be made, which only costs memory
+		if (FAILED(Create(device, texture, change.FirstMip, &view)))
+		{
+			sprintf_s(report, "%s: couldn't be recreated from mip %u\n", texture.Filename.c_str(), change.FirstMip);
+			OutputDebugStringA(report);
+			continue;
+		}
+
+		texture.View->Release();
+		texture.View = view;
+
+		sprintf_s(report, "%s: now from mip %u of %u, %.1f MB of textures for a budget of %.1f MB\n", texture.Filename.c_str(), change.FirstMip,
+			_budget.MipCount(change.Id), _budget.ResidentBytes() / (1024.0 * 1024.0), _budget.Budget() / (1024.0 * 1024.0));
+		OutputDebugStringA(report);
+	}
+
+	_budget.NextFrame();
+}
+
+void TextureRegistry::Clear()
+{
+	for (size_t handle = 0; handle < _textures.size(); ++handle)
+	{
+		if (_textures[handle])
+		{
+			if (_textures[handle]->View) _textures[handle]->View->Release();
+
+			_textures[handle].reset();
+			_budget.Remove(handle);
+		}
+	}
+
+	_textures.clear();
+	_paths.clear();
+	_contents.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <windows.h>
+#include <d3d11_1.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "TextureBudget.h"
+
+//Owns the game's DDS textures and shares them. A texture is only created once per file, and once per content too, so
+//two paths to the same file or two copies of it share a view. Each Acquire is a reference that Release gives back.
+//The textures are kept to a GPU memory budget (see TextureBudget): when they don't fit, the least recently used are
+//recreated without their biggest mips, and they get them back when there's room again. That changes their views, so
+//they're looked up with Use every time they're bound rather than kept.
+//
+//	size_t floor = textures.Acquire(device, "asphalt.dds");
+//	...every frame: textures.Update(device), then ID3D11ShaderResourceView* view = textures.Use(floor) to draw with it...
+//	textures.Release(floor);
+class TextureRegistry
+{
+private:
+	struct Texture
+	{
+		std::string Filename;				//The path it was first acquired by
+		MappedFile File;					//Kept to recreate the texture from
+		uint64_t Hash;
+		uint32_t Width;
+		uint32_t Height;
+		ID3D11ShaderResourceView* View;
+		unsigned int References;
+	};
+
+	std::vector<std::unique_ptr<Texture>> _textures;	//By handle, which is the texture's TextureBudget id
+	std::unordered_map<std::string, size_t> _paths;
+	std::unordered_map<uint64_t, size_t> _contents;
+	TextureBudget _budget;
+	std::vector<TextureBudgetChange> _changes;
+
+	static std::string PathKey(const char* filename);
+	static HRESULT Create(ID3D11Device* device, Texture& texture, uint32_t firstMip, ID3D11ShaderResourceView** out);
+
+public:
+	static const size_t Invalid = (size_t)-1;
+
+	TextureRegistry();
+	~TextureRegistry();
+
+	TextureRegistry(const TextureRegistry&) = delete;
+	TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+	//A reference to the texture in filename, loading it if it isn't loaded yet. Invalid if it can't be
+	size_t Acquire(ID3D11Device* device, const char* filename);
+	void Release(size_t texture);
+
+	//The texture's current view, and marks it as used this frame. Null for Invalid
+	ID3D11ShaderResourceView* Use(size_t texture);
+
+	//Bytes of texture data the registry may keep on the GPU, 0 for no limit
+	void SetBudget(uint64_t bytes);
+	uint64_t ResidentBytes() const { return _budget.ResidentBytes(); }
+
+	//Moves the textures to the mips that fit the budget. Call it once a frame, before anything is drawn
+	void Update(ID3D11Device* device);
+
+	//Releases every texture, however many references are left
+	void Clear();
+};
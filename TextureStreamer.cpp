@@ -0,0 +1,335 @@
+#include "TextureStreamer.h"
+#include "DDSTextureLoader.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Reading a page of the mapping is what brings it in from disk
+	void ReadMips(const std::vector<DDSSubresource>& mips, size_t first, size_t end)
+	{
+		char touched = 0;
+
+		for (size_t mip = first; mip < end; ++mip)
+		{
+			const volatile uint8_t* data = mips[mip].data;
+
+			for (size_t offset = 0; offset < mips[mip].slicePitch; offset += 4096)
+			{
+				touched ^= data[offset];
+			}
+		}
+
+		(void)touched;
+	}
+}
+
+TextureStreamer::TextureStreamer()
+{
+	_device = nullptr;
+	_pool = nullptr;
+	_pack = nullptr;
+	_streaming = 0;
+	_stopping = false;
+	_started = false;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	Stop();
+}
+
+void TextureStreamer::Stream(const char* filename, ID3D11ShaderResourceView** out)
+{
+	StreamedTexture* texture = new StreamedTexture();
+	texture->Filename = filename;
+	texture->Target = out;
+	texture->Texture = nullptr;
+	texture->View = nullptr;
+	texture->MipCount = 0;
+	texture->TailMip = 0;
+	texture->MipsRead = 0;
+	texture->Finished = false;
+	texture->MipsShown = 0;
+	texture->Done = false;
+	_textures.emplace_back(texture);
+}
+
+void TextureStreamer::SetPack(const AssetPack* pack)
+{
+	_pack = pack;
+}
+
+void TextureStreamer::Start(ID3D11Device* device, ThreadPool& pool)
+{
+	if (_started)
+	{
+		return;
+	}
+
+	_device = device;
+	_pool = &pool;
+	_stopping = false;
+	_started = true;
+
+	for (std::unique_ptr<StreamedTexture>& texture : _textures)
+	{
+		StreamedTexture* streaming = texture.get();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			++_streaming;
+		}
+
+		_pool->Submit([this, streaming]() { StreamTexture(*streaming); });
+	}
+}
+
+void TextureStreamer::Start(ID3D11Device* device)
+{
+	Start(device, ThreadPool::Default());
+}
+
+bool TextureStreamer::CreateStreamed(StreamedTexture& texture, const uint8_t* data, size_t size)
+{
+	const DDS_HEADER* header;
+	const uint8_t* bitData;
+	size_t bitSize;
+
+	if (!DDSFormat::ParseHeader(data, size, &header, &bitData, &bitSize))
+	{
+		return false;
+	}
+
+	const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+	DXGI_FORMAT format = dxt10 ? dxt10->dxgiFormat : DDSFormat::GetDXGIFormat(header->ddspf);
+	size_t mipCount = header->mipMapCount;
+
+	//Only plain 2D textures with a mip chain are worth streaming, CreateDDSTextureFromMemory handles the rest
+	if (mipCount <= 1 || (header->flags & DDS_HEADER_FLAGS_VOLUME) || (header->caps2 & DDS_CUBEMAP) || DDSFormat::BitsPerPixel(format) == 0)
+	{
+		return false;
+	}
+
+	if (dxt10 && (dxt10->resourceDimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D || dxt10->arraySize > 1 || (dxt10->miscFlag & D3D11_RESOURCE_MISC_TEXTURECUBE)))
+	{
+		return false;
+	}
+
+	size_t width, height, depth, skipMip;
+	texture.Mips.resize(mipCount);
+
+	if (DDSFormat::FillInitData(header->width, header->height, 1, mipCount, 1, format, 0, bitSize, bitData, width, height, depth, skipMip,
+		texture.Mips.data()) != DDS_LAYOUT_OK)
+	{
+		texture.Mips.clear();
+		return false;
+	}
+
+	D3D11_TEXTURE2D_DESC desc;
+	desc.Width = header->width;
+	desc.Height = header->height;
+	desc.MipLevels = (UINT)mipCount;
+	desc.ArraySize = 1;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = 0;
+
+	//No initial data, every level is filled by Update
+	if (FAILED(_device->CreateTexture2D(&desc, nullptr, &texture.Texture)) ||
+		FAILED(_device->CreateShaderResourceView(texture.Texture, nullptr, &texture.View)))
+	{
+		Release(texture);
+		texture.Mips.clear();
+		return false;
+	}
+
+	texture.MipCount = mipCount;
+	texture.TailMip = 0;
+
+	while (texture.TailMip + 1 < mipCount && std::max(header->width >> texture.TailMip, header->height >> texture.TailMip) > TailSize)
+	{
+		++texture.TailMip;
+	}
+
+	return true;
+}
+
+bool TextureStreamer::SetMipsRead(StreamedTexture& texture, size_t mipsRead)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_stopping)
+	{
+		return false;
+	}
+
+	texture.MipsRead = mipsRead;
+	return true;
+}
+
+void TextureStreamer::StreamTexture(StreamedTexture& texture)
+{
+	texture.Started = Clock::now();
+	const char* data = nullptr;
+	size_t size = 0;
+
+	if (_pack)
+	{
+		const AssetPackEntry* entry = _pack->Find(texture.Filename.c_str());
+
+		if (!entry || !_pack->Read(*entry, data, size, texture.PackBuffer))
+		{
+			data = nullptr;
+		}
+	}
+
+	if (!data && texture.File.Open(texture.Filename.c_str()))
+	{
+		data = texture.File.Data();
+		size = texture.File.Size();
+	}
+
+	if (data && CreateStreamed(texture, (const uint8_t*)data, size))
+	{
+		//The tail first, then a level at a time up to the full resolution
+		size_t tail = texture.TailMip;
+
+		ReadMips(texture.Mips, tail, texture.MipCount);
+		bool reading = SetMipsRead(texture, texture.MipCount - tail);
+
+		for (size_t mip = tail; reading && mip-- > 0;)
+		{
+			ReadMips(texture.Mips, mip, mip + 1);
+			reading = SetMipsRead(texture, texture.MipCount - mip);
+		}
+	}
+	else if (data && SUCCEEDED(DirectX::CreateDDSTextureFromMemory(_device, (const uint8_t*)data, size, nullptr, &texture.View)))
+	{
+		texture.MipCount = 1;
+		SetMipsRead(texture, 1);
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (texture.MipsRead == 0 && !_stopping)
+	{
+		char report[512];
+		sprintf_s(report, "%s: streaming FAILED\n", texture.Filename.c_str());
+		OutputDebugStringA(report);
+	}
+
+	texture.Finished = true;
+	--_streaming;
+	_streamDone.notify_all();
+}
+
+void TextureStreamer::Upload(ID3D11DeviceContext* context, StreamedTexture& texture, size_t mip)
+{
+	const DDSSubresource& level = texture.Mips[mip];
+	context->UpdateSubresource(texture.Texture, (UINT)mip, nullptr, level.data, (UINT)level.rowPitch, (UINT)level.slicePitch);
+}
+
+void TextureStreamer::Release(StreamedTexture& texture)
+{
+	//The view keeps the texture alive for as long as it's used
+	if (texture.Texture) texture.Texture->Release();
+	if (texture.View) texture.View->Release();
+
+	texture.Texture = nullptr;
+	texture.View = nullptr;
+}
+
+void TextureStreamer::Update(ID3D11DeviceContext* context)
+{
+	char report[512];
+
+	for (std::unique_ptr<StreamedTexture>& streamed : _textures)
+	{
+		StreamedTexture& texture = *streamed;
+		size_t mipsRead;
+		bool finished;
+
+		if (texture.Done)
+		{
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			mipsRead = texture.MipsRead;
+			finished = texture.Finished;
+		}
+
+		if (texture.MipsShown < mipsRead)
+		{
+			//Smallest first, so the min LOD only ever covers levels that are in
+			while (!texture.Mips.empty() && texture.MipsShown < mipsRead)
+			{
+				Upload(context, texture, texture.MipCount - 1 - texture.MipsShown++);
+			}
+
+			texture.MipsShown = mipsRead;
+			size_t finest = texture.MipCount - texture.MipsShown;
+
+			if (texture.Texture)
+			{
+				context->SetResourceMinLOD(texture.Texture, (FLOAT)finest);
+			}
+
+			if (texture.View)
+			{
+				*texture.Target = texture.View;
+				texture.View = nullptr;
+			}
+
+			sprintf_s(report, "%s: mip %u of %u drawable after %.2f ms\n", texture.Filename.c_str(), (unsigned int)finest, (unsigned int)texture.MipCount,
+				MillisecondsSince(texture.Started));
+			OutputDebugStringA(report);
+		}
+
+		//The mapping is kept until the last level has been uploaded from it
+		if (finished && texture.MipsShown == mipsRead)
+		{
+			Release(texture);
+			texture.Mips.clear();
+			texture.File.Close();
+			texture.PackBuffer.clear();
+			texture.PackBuffer.shrink_to_fit();
+			texture.Done = true;
+		}
+	}
+}
+
+void TextureStreamer::Stop()
+{
+	if (!_started)
+	{
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_stopping = true;
+		_streamDone.wait(lock, [this]() { return _streaming == 0; });
+	}
+
+	//Views that have been shown belong to their targets now
+	for (std::unique_ptr<StreamedTexture>& texture : _textures)
+	{
+		Release(*texture);
+	}
+
+	_textures.clear();
+	_started = false;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <windows.h>
+#include <d3d11_1.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "DDSFormat.h"
+#include "MappedFile.h"
+
+class ThreadPool;
+
+//Streams DDS textures in smallest mip first, so a texture can be drawn before its full resolution has been read.
+//A worker maps the file, creates the texture with its whole mip chain but no data and reads the mip tail (the levels
+//no bigger than TailSize). Update uploads the tail and hands the view over, then the worker reads the bigger levels one
+//at a time and Update uploads each as it's ready. SetResourceMinLOD keeps the sampler off the levels that haven't been
+//uploaded yet, so the texture sharpens in place and the render loop never waits on the disk.
+//Anything that isn't a plain 2D texture with mips (cube maps, arrays, volumes) is created whole on the worker instead.
+//
+//	streamer.Stream("Crate_COLOR.dds", &crateTexture);
+//	streamer.Start(device);
+//	...every frame: streamer.Update(context) before anything draws with the textures...
+//	streamer.Stop();
+class TextureStreamer
+{
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	//Levels this size and smaller are read and uploaded together as the first stage
+	static const uint32_t TailSize = 64;
+
+	struct StreamedTexture
+	{
+		std::string Filename;
+		ID3D11ShaderResourceView** Target;
+
+		MappedFile File;
+		std::vector<char> PackBuffer;		//A compressed pack entry, decompressed
+		std::vector<DDSSubresource> Mips;	//Into File, the pack's mapping or PackBuffer. Empty for a texture created whole
+		ID3D11Texture2D* Texture;
+		ID3D11ShaderResourceView* View;		//Belongs to Target once it's been shown
+		Clock::time_point Started;
+		size_t MipCount;					//Set by the worker before any mips are read
+		size_t TailMip;						//The biggest level of the tail
+		size_t MipsRead;					//Smallest first, ready to upload, guarded by _mutex
+		bool Finished;						//The worker is done with it, guarded by _mutex
+		size_t MipsShown;					//Uploaded, render thread only from here down
+		bool Done;
+	};
+
+	ID3D11Device* _device;
+	ThreadPool* _pool;
+	const AssetPack* _pack;
+	std::vector<std::unique_ptr<StreamedTexture>> _textures;
+
+	std::mutex _mutex;
+	std::condition_variable _streamDone;
+	unsigned int _streaming;
+	bool _stopping;
+	bool _started;
+
+	void StreamTexture(StreamedTexture& texture);
+	bool CreateStreamed(StreamedTexture& texture, const uint8_t* data, size_t size);
+	bool SetMipsRead(StreamedTexture& texture, size_t mipsRead);
+	void Upload(ID3D11DeviceContext* context, StreamedTexture& texture, size_t mip);
+	static void Release(StreamedTexture& texture);
+
+public:
+	TextureStreamer();
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	//out has to start null, it's written by Update and Released by the game once it's been set
+	void Stream(const char* filename, ID3D11ShaderResourceView** out);
+
+	//Looks the textures up in pack first, like AssetLoader::SetPack. It has to stay open until Stop
+	void SetPack(const AssetPack* pack);
+
+	//Starts a worker per texture. device has to stay valid until Stop, and mustn't have been created single threaded
+	void Start(ID3D11Device* device, ThreadPool& pool);
+	void Start(ID3D11Device* device);
+
+	//Uploads the mips that are ready and lowers the textures' min LOD to them. Call it once a frame before drawing
+	void Update(ID3D11DeviceContext* context);
+
+	//Stops streaming, waits for the workers and releases whatever hasn't been handed over yet
+	void Stop();
+};
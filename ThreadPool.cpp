@@ -0,0 +1,140 @@
+#include "ThreadPool.h"
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	_activeTasks = 0;
+	_stopping = false;
+
+	if (threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0) threadCount = 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+
+	_taskAvailable.notify_all();
+
+	for (std::thread& worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_taskAvailable.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+			if (_tasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+			++_activeTasks;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			--_activeTasks;
+
+			if (_activeTasks == 0 && _tasks.empty())
+			{
+				_allDone.notify_all();
+			}
+		}
+	}
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push_back(std::move(task));
+	}
+
+	_taskAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_allDone.wait(lock, [this]() { return _activeTasks == 0 && _tasks.empty(); });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	//Shared between the caller and the helpers, a helper that only gets to run after everything
+	//is finished just finds no work left, so it has to outlive this call
+	struct Batch
+	{
+		std::atomic<size_t> Next;
+		std::atomic<size_t> Finished;
+		std::mutex Mutex;
+		std::condition_variable Done;
+	};
+
+	std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+	batch->Next = 0;
+	batch->Finished = 0;
+
+	const std::function<void(size_t)>* work = &function;
+
+	auto runItems = [batch, work, count]()
+	{
+		for (size_t i = batch->Next++; i < count; i = batch->Next++)
+		{
+			(*work)(i);
+
+			if (++batch->Finished == count)
+			{
+				std::lock_guard<std::mutex> lock(batch->Mutex);
+				batch->Done.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = count - 1 < _workers.size() ? count - 1 : _workers.size();
+
+	for (size_t i = 0; i < helpers; ++i)
+	{
+		Submit(runItems);
+	}
+
+	runItems();
+
+	std::unique_lock<std::mutex> lock(batch->Mutex);
+	batch->Done.wait(lock, [&]() { return batch->Finished == count; });
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
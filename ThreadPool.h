@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//A fixed set of worker threads that run queued tasks. Only uses the standard library so the asset code
+//that runs on it also works in the headless tools.
+class ThreadPool
+{
+private:
+	std::vector<std::thread> _workers;
+	std::deque<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _taskAvailable;
+	std::condition_variable _allDone;
+	size_t _activeTasks;
+	bool _stopping;
+
+	void WorkerLoop();
+
+public:
+	//0 threads means one per hardware thread
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int ThreadCount() const { return (unsigned int)_workers.size(); }
+
+	void Submit(std::function<void()> task);
+
+	//Blocks until every submitted task has finished
+	void Wait();
+
+	//Calls function(i) for every i in [0, count) spread across the pool and returns once they have all finished.
+	//The calling thread works through items too, so this is safe to call from inside a task.
+	void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+	//A pool shared by the engine, created the first time it's asked for
+	static ThreadPool& Default();
+};
@@ -0,0 +1,306 @@
+//Compiles OBJ files into the engine's binary mesh cache ahead of time, so a shipped build loads them without parsing
+//anything. It runs the same MeshImporter steps OBJLoader::Load would on first run and doesn't need D3D, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. AssetCompiler.cpp ../MeshImporter.cpp ../MeshCache.cpp ../MeshCodec.cpp ../MeshStream.cpp ../Lz4.cpp ../ContentHash.cpp ../OBJParser.cpp
+//		../MeshOptimizer.cpp ../MeshClusters.cpp ../MeshSimplifier.cpp ../MeshBounds.cpp ../VertexQuantizer.cpp ../MappedFile.cpp ../ThreadPool.cpp
+//		-pthread -o asset_compiler
+//
+//Usage: asset_compiler [options] <file.obj | directory> ...
+//	-o <directory>		Write the caches there instead of next to each OBJ file. OBJs found in a directory keep their path
+//						under it, so same named files in different folders don't collide
+//	-j <threads>		Worker threads, defaults to one per hardware thread
+//	--quantize			Store 16 byte QuantizedVertex vertices
+//	--lods				Generate levels of detail
+//	--compress			Store vertices and indices with MeshCodec, smaller on disk and decoded at load
+//	--progressive		Order the vertices so the levels of detail can be streamed in coarsest first, see MeshStream.h.
+//						Use with --lods, and it overrides --compress
+//	--no-optimize		Skip the vertex cache, overdraw and vertex fetch ordering
+//	--no-invert-uv		Keep the OBJ's texture coordinates the way up they are
+//	--force				Rebuild even if the cache is up to date
+//	--verbose			Print what each import reported
+//Directories are searched recursively for .obj files. Different OBJs that would still be written to the same cache are
+//reported and nothing is compiled. The options have to match the ones the game loads the mesh with
+//(Application uses --quantize --lods, plus --progressive for the car it streams), a cache built with other options is rebuilt
+//at runtime. --compress is the exception, the game reads compressed and uncompressed caches alike, and a --progressive cache
+//also does for a mesh that isn't streamed.
+//
+//A cache is up to date when it's valid, was built with the same options by this version of the importer and the hash of
+//its OBJ file's contents matches the one it was built from. Modification times aren't trusted, so checkouts and copies
+//don't cause rebuilds. Files are compiled in parallel, each one also using the pool for its own submeshes.
+//Exits with 1 if anything failed.
+
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	enum CompileResult
+	{
+		CompileUpToDate,
+		CompileBuilt,
+		CompileFailed,
+	};
+
+	struct Job
+	{
+		std::string Source;
+		std::string Output;
+		CompileResult Result;
+		double Milliseconds;
+		uint32_t Vertices;
+		uint32_t Triangles;
+		uint32_t Submeshes;
+		uint64_t OutputSize;
+		std::string Log;
+	};
+
+	bool IsUpToDate(const Job& job, uint32_t options)
+	{
+		MeshCacheView cache;
+
+		//Passing no source file just validates the cache itself, the source is compared by hash below
+		if (cache.Open(job.Output.c_str(), nullptr, options) != MeshCacheValid || cache.Header().Options != options)
+		{
+			return false;
+		}
+
+		MappedFile source;
+
+		if (!source.Open(job.Source.c_str()))
+		{
+			return false;
+		}
+
+		return ContentHash(source.Data(), source.Size()) == cache.Header().SourceHash;
+	}
+
+	void Compile(Job& job, uint32_t options, bool force, ThreadPool& pool)
+	{
+		Clock::time_point start = Clock::now();
+
+		if (!force && IsUpToDate(job, options))
+		{
+			job.Result = CompileUpToDate;
+		}
+		else
+		{
+			//Otherwise the importer would find the cache valid and use it
+			std::error_code error;
+			std::filesystem::remove(job.Output, error);
+
+			MeshImport mesh;
+			bool imported = MeshImporter::Import(job.Source.c_str(), options, mesh, pool, job.Output.c_str());
+
+			MeshCacheView written;
+			job.Result = imported && written.Open(job.Output.c_str(), nullptr, options) == MeshCacheValid ? CompileBuilt : CompileFailed;
+			job.Vertices = mesh.VertexCount;
+			job.Triangles = (mesh.Lods.empty() ? mesh.IndexCount : mesh.Lods[0].IndexCount) / 3;
+			job.Submeshes = (uint32_t)(mesh.Submeshes.size() / (mesh.Lods.empty() ? 1 : mesh.Lods.size()));
+			job.Log = mesh.Log;
+		}
+
+		std::error_code error;
+		job.OutputSize = std::filesystem::file_size(job.Output, error);
+
+		if (error)
+		{
+			job.OutputSize = 0;
+		}
+
+		job.Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	//relative is where the cache goes under -o, the OBJ's path below the directory it was found in
+	void AddJob(const std::filesystem::path& source, const std::filesystem::path& relative, const std::string& outputDirectory,
+		std::vector<std::unique_ptr<Job>>& jobs)
+	{
+		std::unique_ptr<Job> job(new Job());
+		job->Source = source.string();
+		job->Output = (outputDirectory.empty() ? job->Source : (std::filesystem::path(outputDirectory) / relative).lexically_normal().string()) + "Binary";
+		job->Result = CompileFailed;
+		job->Milliseconds = 0.0;
+		job->Vertices = 0;
+		job->Triangles = 0;
+		job->Submeshes = 0;
+		job->OutputSize = 0;
+		jobs.push_back(std::move(job));
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: asset_compiler [-o directory] [-j threads] [--quantize] [--lods] [--compress] [--progressive] [--no-optimize] [--no-invert-uv] [--force] [--verbose] <file.obj | directory> ...\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool invertTexCoords = true;
+	bool optimizeMesh = true;
+	bool quantizeVertices = false;
+	bool generateLods = false;
+	bool compressStreams = false;
+	bool progressive = false;
+	bool force = false;
+	bool verbose = false;
+	unsigned int threads = 0;
+	std::string outputDirectory;
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> sources;
+	std::vector<std::unique_ptr<Job>> jobs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-o" && i + 1 < argc) outputDirectory = argv[++i];
+		else if (argument == "-j" && i + 1 < argc) threads = (unsigned int)atoi(argv[++i]);
+		else if (argument == "--quantize") quantizeVertices = true;
+		else if (argument == "--lods") generateLods = true;
+		else if (argument == "--compress") compressStreams = true;
+		else if (argument == "--progressive") progressive = true;
+		else if (argument == "--no-optimize") optimizeMesh = false;
+		else if (argument == "--no-invert-uv") invertTexCoords = false;
+		else if (argument == "--force") force = true;
+		else if (argument == "--verbose") verbose = true;
+		else if (!argument.empty() && argument[0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if (std::filesystem::is_directory(argument))
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(argument))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".obj")
+				{
+					sources.emplace_back(entry.path(), entry.path().lexically_relative(argument));
+				}
+			}
+		}
+		else
+		{
+			sources.emplace_back(argument, std::filesystem::path(argument).filename());
+		}
+	}
+
+	//-o can come after the inputs, so the outputs are only worked out once every argument is read
+	for (const std::pair<std::filesystem::path, std::filesystem::path>& source : sources)
+	{
+		AddJob(source.first, source.second, outputDirectory, jobs);
+	}
+
+	if (jobs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	//The jobs run in parallel, so two of them writing one cache would race. The same OBJ named twice (a file and a
+	//directory it's in) is just compiled once
+	std::sort(jobs.begin(), jobs.end(), [](const std::unique_ptr<Job>& a, const std::unique_ptr<Job>& b) { return a->Output < b->Output; });
+	bool collided = false;
+
+	for (size_t i = 1; i < jobs.size(); ++i)
+	{
+		std::error_code error;
+
+		if (jobs[i]->Output == jobs[i - 1]->Output && !std::filesystem::equivalent(jobs[i]->Source, jobs[i - 1]->Source, error))
+		{
+			printf("FAILED     %s and %s would both be written to %s\n", jobs[i - 1]->Source.c_str(), jobs[i]->Source.c_str(), jobs[i]->Output.c_str());
+			collided = true;
+		}
+	}
+
+	if (collided)
+	{
+		return 1;
+	}
+
+	jobs.erase(std::unique(jobs.begin(), jobs.end(), [](const std::unique_ptr<Job>& a, const std::unique_ptr<Job>& b) { return a->Output == b->Output; }),
+		jobs.end());
+
+	for (const std::unique_ptr<Job>& job : jobs)
+	{
+		std::error_code error;
+		std::filesystem::path parent = std::filesystem::path(job->Output).parent_path();
+
+		if (!parent.empty())
+		{
+			std::filesystem::create_directories(parent, error);
+		}
+	}
+
+	uint32_t options = MeshImporter::OptionsFor(invertTexCoords, optimizeMesh, quantizeVertices, generateLods, compressStreams) |
+		(progressive ? MeshOptionProgressive : 0u);
+	ThreadPool pool(threads);
+	std::vector<std::future<void>> done;
+	Clock::time_point start = Clock::now();
+
+	//Biggest files first so one big mesh doesn't start last and hold everything up
+	std::stable_sort(jobs.begin(), jobs.end(), [](const std::unique_ptr<Job>& a, const std::unique_ptr<Job>& b)
+	{
+		std::error_code error;
+		return std::filesystem::file_size(a->Source, error) > std::filesystem::file_size(b->Source, error);
+	});
+
+	for (std::unique_ptr<Job>& job : jobs)
+	{
+		std::shared_ptr<std::promise<void>> promise(new std::promise<void>());
+		done.push_back(promise->get_future());
+		Job* compiling = job.get();
+
+		pool.Submit([compiling, promise, options, force, &pool]()
+		{
+			Compile(*compiling, options, force, pool);
+			promise->set_value();
+		});
+	}
+
+	for (std::future<void>& future : done)
+	{
+		future.wait();
+	}
+
+	double totalMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	unsigned int built = 0, upToDate = 0, failed = 0;
+	const char* resultNames[] = { "up to date", "built", "FAILED" };
+
+	for (const std::unique_ptr<Job>& job : jobs)
+	{
+		if (job->Result == CompileBuilt)
+		{
+			printf("%-10s %s -> %s, %u vertices, %u triangles, %u submeshes, %llu bytes, %.1f ms\n", resultNames[job->Result], job->Source.c_str(),
+				job->Output.c_str(), job->Vertices, job->Triangles, job->Submeshes, (unsigned long long)job->OutputSize, job->Milliseconds);
+		}
+		else
+		{
+			printf("%-10s %s -> %s, %.1f ms\n", resultNames[job->Result], job->Source.c_str(), job->Output.c_str(), job->Milliseconds);
+		}
+
+		if (verbose && !job->Log.empty())
+		{
+			printf("%s", job->Log.c_str());
+		}
+
+		built += job->Result == CompileBuilt;
+		upToDate += job->Result == CompileUpToDate;
+		failed += job->Result == CompileFailed;
+	}
+
+	printf("%u built, %u up to date, %u failed in %.1f ms on %u threads\n", built, upToDate, failed, totalMilliseconds, pool.ThreadCount());
+
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+//Packs assets into one AssetPack file that the game maps at startup instead of opening each file, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. AssetPacker.cpp ../AssetPack.cpp ../Lz4.cpp ../ContentHash.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o asset_packer
+//
+//Usage: asset_packer [options] <file | directory> ...
+//	-o <file>			The pack to write, defaults to Assets.pack
+//	-C <directory>		Name entries relative to this directory instead of the current one
+//	-j <threads>		Worker threads, defaults to one per hardware thread
+//	--no-compress		Store everything uncompressed so every entry can be used straight out of the mapped file
+//	--verify			Read the pack back and check every entry's hash
+//Directories are searched recursively. Entries are named by their path relative to -C (e.g. "car.objBinary"), which is
+//the name the game looks them up by. Files that don't shrink by an eighth with LZ4 are stored as they are, which
+//keeps already compressed data and big meshes that are fine to map directly from costing a decompress at load.
+//Exits with 1 if anything failed.
+
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct InputFile
+	{
+		std::string Path;
+		std::string Name;
+		MappedFile File;
+	};
+
+	void AddFile(const std::filesystem::path& path, const std::filesystem::path& root, const std::string& output, std::vector<std::unique_ptr<InputFile>>& files)
+	{
+		std::error_code error;
+
+		//Don't pack the pack into itself when it's written inside a directory being packed
+		if (std::filesystem::equivalent(path, output, error))
+		{
+			return;
+		}
+
+		std::unique_ptr<InputFile> file(new InputFile());
+		file->Path = path.string();
+		file->Name = std::filesystem::relative(path, root, error).generic_string();
+
+		if (error || file->Name.empty())
+		{
+			file->Name = path.filename().generic_string();
+		}
+
+		files.push_back(std::move(file));
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: asset_packer [-o file] [-C directory] [-j threads] [--no-compress] [--verify] <file | directory> ...\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string output = "Assets.pack";
+	std::filesystem::path root = std::filesystem::current_path();
+	unsigned int threads = 0;
+	bool compress = true;
+	bool verify = false;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-o" && i + 1 < argc) output = argv[++i];
+		else if (argument == "-C" && i + 1 < argc) root = argv[++i];
+		else if (argument == "-j" && i + 1 < argc) threads = (unsigned int)atoi(argv[++i]);
+		else if (argument == "--no-compress") compress = false;
+		else if (argument == "--verify") verify = true;
+		else if (!argument.empty() && argument[0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else inputs.push_back(argument);
+	}
+
+	std::vector<std::unique_ptr<InputFile>> files;
+
+	for (const std::string& input : inputs)
+	{
+		if (std::filesystem::is_directory(input))
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(input))
+			{
+				if (entry.is_regular_file())
+				{
+					AddFile(entry.path(), root, output, files);
+				}
+			}
+		}
+		else
+		{
+			AddFile(input, root, output, files);
+		}
+	}
+
+	if (files.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Clock::time_point start = Clock::now();
+	std::vector<AssetPackSource> sources;
+	uint64_t totalSize = 0;
+
+	for (std::unique_ptr<InputFile>& file : files)
+	{
+		if (!file->File.Open(file->Path.c_str()))
+		{
+			printf("FAILED     couldn't open %s\n", file->Path.c_str());
+			return 1;
+		}
+
+		sources.push_back({ file->Name, file->File.Data(), file->File.Size(), compress });
+		totalSize += file->File.Size();
+	}
+
+	ThreadPool pool(threads);
+
+	if (!AssetPackBuilder::Write(output.c_str(), sources, pool))
+	{
+		printf("FAILED     couldn't write %s, are two inputs packed under the same name?\n", output.c_str());
+		return 1;
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	AssetPack pack;
+
+	if (!pack.Open(output.c_str()))
+	{
+		printf("FAILED     %s doesn't open\n", output.c_str());
+		return 1;
+	}
+
+	unsigned int failed = 0;
+	const char* compressionNames[] = { "stored", "lz4" };
+
+	for (uint32_t i = 0; i < pack.EntryCount(); ++i)
+	{
+		const AssetPackEntry& entry = pack.Entry(i);
+		bool ok = !verify || pack.Verify(entry);
+
+		printf("%-10s %s, %llu -> %llu bytes, %s\n", ok ? "packed" : "FAILED", pack.EntryName(entry).c_str(), (unsigned long long)entry.Size,
+			(unsigned long long)entry.StoredSize, compressionNames[entry.Compression]);
+
+		failed += !ok;
+	}
+
+	std::error_code error;
+	uint64_t packSize = std::filesystem::file_size(output, error);
+
+	printf("%u files, %llu bytes -> %s, %llu bytes in %.1f ms on %u threads\n", pack.EntryCount(), (unsigned long long)totalSize, output.c_str(),
+		(unsigned long long)packSize, milliseconds, pool.ThreadCount());
+
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+//Packs DDS textures into Texture2DArrays, so the game binds them once a frame instead of a texture per object. Textures
+//of the same format and size share an array with a slice and the full mip chain each, small ones can share slices as tiles
+//(see TextureArray.h). Writes the arrays' DDS files and a manifest saying which array, slice and tile each texture went to.
+//It doesn't need D3D, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. TextureArrayCompiler.cpp ../TextureArray.cpp ../DDSFormat.cpp ../MappedFile.cpp -o texture_array_compiler
+//
+//Usage: texture_array_compiler [options] <file.dds | directory> ...
+//	-o <file.xml>		The manifest to write, defaults to TextureArray.xml. The arrays go next to it as TextureArray0.dds and on
+//	-t <texels>			Slice size for tiles, defaults to 256. Textures whose tile fits in a quarter of one are tiled, 0 tiles nothing
+//	-g <texels>			Gutter around each tile, a power of two, defaults to 4
+//Directories are searched recursively for .dds files. Textures have to be 8 bit RGBA, BGRA or BGRX, ones that aren't or
+//with a name already taken are left out and listed. Their mips are rebuilt from the top level with a box filter.
+//Application loads TextureArray.xml from its working directory if there is one, see Application::LoadTextureArrays.
+//Exits with 1 if the arrays couldn't be written.
+
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "TextureArray.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	//DDS header flags and caps the compiler writes, from DDS.h
+	const uint32_t HeaderFlags = 0x1 | DDS_HEIGHT | DDS_WIDTH | 0x8 | 0x1000 | 0x20000;	//CAPS | PITCH | PIXELFORMAT | MIPMAPCOUNT
+	const uint32_t HeaderCaps = 0x1000 | 0x8 | 0x400000;								//TEXTURE | COMPLEX | MIPMAP
+	const uint32_t ResourceDimensionTexture2D = 3;
+
+	bool WriteFile(const std::string& filename, const std::vector<const void*>& parts, const std::vector<size_t>& sizes)
+	{
+		//Written to a temporary file first so a running game never reads half an array
+		std::string temporaryFilename = filename + ".tmp";
+		std::ofstream out(temporaryFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		for (size_t i = 0; i < parts.size(); ++i)
+		{
+			out.write((const char*)parts[i], (std::streamsize)sizes[i]);
+		}
+
+		out.close();
+
+		if (!out.good())
+		{
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryFilename, filename, error);
+
+		return !error;
+	}
+
+	bool WriteArray(const std::string& filename, const TextureArrayLayout& layout, const std::vector<uint8_t>& texels)
+	{
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = HeaderFlags;
+		header.height = layout.Height;
+		header.width = layout.Width;
+		header.pitchOrLinearSize = layout.Width * 4;
+		header.mipMapCount = layout.MipCount;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		header.caps = HeaderCaps;
+
+		DDS_HEADER_DXT10 dxt10 = {};
+		dxt10.dxgiFormat = layout.Format;
+		dxt10.resourceDimension = ResourceDimensionTexture2D;
+		dxt10.arraySize = layout.SliceCount;
+
+		return WriteFile(filename, { &DDS_MAGIC, &header, &dxt10, texels.data() }, { sizeof(DDS_MAGIC), sizeof(header), sizeof(dxt10), texels.size() });
+	}
+
+	//Reads the array back the way the game will and checks every slice and level is where it should be
+	bool Verify(const std::string& filename, const TextureArrayLayout& layout)
+	{
+		MappedFile file;
+		const DDS_HEADER* header;
+		const uint8_t* bitData;
+		size_t bitSize;
+
+		if (!file.Open(filename.c_str()) || !DDSFormat::ParseHeader((const uint8_t*)file.Data(), file.Size(), &header, &bitData, &bitSize))
+		{
+			return false;
+		}
+
+		const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+		std::vector<DDSSubresource> subresources((size_t)layout.MipCount * layout.SliceCount);
+		size_t width, height, depth, skipMip;
+
+		if (!dxt10 || dxt10->arraySize != layout.SliceCount || DDSFormat::FillInitData(header->width, header->height, 1, header->mipMapCount,
+			dxt10->arraySize, dxt10->dxgiFormat, 0, bitSize, bitData, width, height, depth, skipMip, subresources.data()) != DDS_LAYOUT_OK)
+		{
+			return false;
+		}
+
+		const DDSSubresource& last = subresources.back();
+		return last.data + last.slicePitch == bitData + bitSize;
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: texture_array_compiler [-o file.xml] [-t texels] [-g gutter] <file.dds | directory> ...\n");
+	}
+
+	//An array this compiler wrote under stem, which is skipped when it's run again on the same directory
+	bool IsArray(const std::filesystem::path& path, const std::string& stem)
+	{
+		std::string name = path.stem().string();
+		return path.extension() == ".dds" && name.size() > stem.size() && name.compare(0, stem.size(), stem) == 0 &&
+			name.find_first_not_of("0123456789", stem.size()) == std::string::npos;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string output = "TextureArray.xml";
+	uint32_t tileSlice = 256, gutter = 4;
+	std::vector<std::filesystem::path> sources;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-o" && i + 1 < argc) output = argv[++i];
+		else if (argument == "-t" && i + 1 < argc) tileSlice = (uint32_t)atoi(argv[++i]);
+		else if (argument == "-g" && i + 1 < argc) gutter = (uint32_t)atoi(argv[++i]);
+		else if (!argument.empty() && argument[0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if (std::filesystem::is_directory(argument))
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(argument))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".dds")
+				{
+					sources.push_back(entry.path());
+				}
+			}
+		}
+		else
+		{
+			sources.push_back(argument);
+		}
+	}
+
+	if (sources.empty() || gutter == 0 || (gutter & (gutter - 1)) != 0)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Clock::time_point start = Clock::now();
+	std::filesystem::path manifestPath(output);
+	std::string stem = manifestPath.stem().string();
+	TextureArrayLayout all = {};
+	std::vector<DXGI_FORMAT> formats;
+	std::vector<std::vector<uint8_t>> texels;
+	uint64_t sourceBytes = 0;
+
+	for (const std::filesystem::path& source : sources)
+	{
+		//The arrays themselves are in the directory being packed when it's run twice
+		if (IsArray(source, stem))
+		{
+			continue;
+		}
+
+		MappedFile file;
+		DXGI_FORMAT format;
+		TextureArrayEntry entry = {};
+		std::vector<uint8_t> pixels;
+		entry.Name = source.filename().string();
+
+		if (!file.Open(source.string().c_str()) ||
+			!TextureArray::ReadTexels((const uint8_t*)file.Data(), file.Size(), format, entry.Width, entry.Height, pixels))
+		{
+			printf("left out  %s, not an 8 bit RGBA, BGRA or BGRX 2D texture\n", source.string().c_str());
+		}
+		else if (TextureArray::Find(all, entry.Name.c_str()))
+		{
+			printf("left out  %s, another %s is already in an array\n", source.string().c_str(), entry.Name.c_str());
+		}
+		else
+		{
+			all.Entries.push_back(entry);
+			formats.push_back(format);
+			texels.push_back(std::move(pixels));
+			sourceBytes += file.Size();
+		}
+	}
+
+	if (all.Entries.empty())
+	{
+		printf("Nothing to pack\n");
+		return 1;
+	}
+
+	std::vector<TextureArrayGroup> groups = TextureArray::Group(all.Entries, formats, tileSlice > 0 ? gutter : 0, tileSlice);
+	std::vector<TextureArrayLayout> layouts;
+	size_t arrayBytes = 0;
+
+	for (const TextureArrayGroup& group : groups)
+	{
+		TextureArrayLayout layout = {};
+		std::vector<const uint8_t*> tops;
+		layout.Format = group.Format;
+		layout.File = stem + std::to_string(layouts.size()) + ".dds";
+
+		for (size_t i : group.Textures)
+		{
+			layout.Entries.push_back(all.Entries[i]);
+			tops.push_back(texels[i].data());
+		}
+
+		std::filesystem::path arrayPath = manifestPath.parent_path() / layout.File;
+		std::vector<uint8_t> arrayTexels;
+
+		if (!TextureArray::Pack(group.Tiled ? gutter : 0, tileSlice, layout))
+		{
+			printf("FAILED    %s couldn't be packed\n", layout.File.c_str());
+			return 1;
+		}
+
+		TextureArray::Compose(layout, tops, arrayTexels);
+
+		if (!WriteArray(arrayPath.string(), layout, arrayTexels) || !Verify(arrayPath.string(), layout))
+		{
+			printf("FAILED    %s couldn't be written\n", arrayPath.string().c_str());
+			return 1;
+		}
+
+		for (const TextureArrayEntry& entry : layout.Entries)
+		{
+			float transform[4];
+			TextureArray::UVTransform(layout, entry, transform);
+			printf("packed    %s, %ux%u in %s slice %u at %u,%u, uv * (%.4f, %.4f) + (%.4f, %.4f), mips 0-%u\n", entry.Name.c_str(), entry.Width,
+				entry.Height, layout.File.c_str(), entry.Slice, entry.X, entry.Y, transform[0], transform[1], transform[2], transform[3],
+				TextureArray::MaxMip(layout, entry));
+		}
+
+		printf("%s: %u slices of %ux%u, %u mips, gutter %u, %zu bytes\n", layout.File.c_str(), layout.SliceCount, layout.Width, layout.Height,
+			layout.MipCount, layout.Gutter, arrayTexels.size());
+		arrayBytes += arrayTexels.size();
+		layouts.push_back(layout);
+	}
+
+	std::string manifest = TextureArrayXml::Write(layouts);
+
+	if (!WriteFile(manifestPath.string(), { manifest.data() }, { manifest.size() }))
+	{
+		printf("FAILED    %s couldn't be written\n", manifestPath.string().c_str());
+		return 1;
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	printf("%zu textures -> %zu arrays and %s: %zu bytes of texels against %llu in their own files, %.1f ms\n", all.Entries.size(), layouts.size(),
+		manifestPath.string().c_str(), arrayBytes, (unsigned long long)sourceBytes, milliseconds);
+
+	return 0;
+}
@@ -0,0 +1,579 @@
+//Compiles uncompressed DDS textures into block compressed ones ahead of time: regenerates the full mip chain, encodes every
+//level as BC1, BC3, BC5 or BC7 and reports how much quality that cost. It doesn't need D3D, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. TextureCompiler.cpp ../BlockCompression.cpp ../DDSFormat.cpp ../MappedFile.cpp ../ThreadPool.cpp -pthread -o texture_compiler
+//
+//Usage: texture_compiler [options] <file.dds | directory> ...
+//	-o <directory>		Write the textures there under the same names, instead of <name>_BC1.dds etc. next to each input
+//	-j <threads>		Worker threads, defaults to one per hardware thread
+//	--format <format>	bc1, bc3, bc5 or bc7 for every texture, instead of choosing per texture
+//	--normal			Treat every texture as a normal map
+//Directories are searched recursively for .dds files. Inputs have to be 8 bit RGBA or BGRA 2D textures whose size is a multiple
+//of 4, any that are already block compressed are skipped. Without --format normal maps become BC5, textures with any alpha
+//below 255 BC3 and the rest BC1. A texture is a normal map if its name has NRM or NORMAL in it, like Crate_NRM.dds and
+//asphalt_NORMAL.dds. BC5 keeps only X and Y, so a shader sampling one has to rebuild Z.
+//
+//Mips are box filtered from the level above, in linear space for _SRGB textures, and normal map mips are renormalised.
+//Each level's 4x4 blocks are encoded a row at a time across the pool (see BlockCompression.h for the endpoint search),
+//then decoded again for the report: the PSNR of the top level and of the whole chain, over the channels the format keeps.
+//Every texture written is read back with DDSFormat to check the mip chain fits the file.
+//Exits with 1 if anything failed.
+
+#include "BlockCompression.h"
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	//DDS header flags and caps the compiler writes, from DDS.h
+	const uint32_t HeaderFlags = 0x1 | DDS_HEIGHT | DDS_WIDTH | 0x1000 | 0x20000 | 0x80000;	//CAPS | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+	const uint32_t HeaderCaps = 0x1000 | 0x8 | 0x400000;										//TEXTURE | COMPLEX | MIPMAP
+	const uint32_t ResourceDimensionTexture2D = 3;
+
+	enum CompileResult
+	{
+		CompileBuilt,
+		CompileSkipped,
+		CompileFailed,
+	};
+
+	//One mip level, 4 bytes a pixel in RGBA order
+	struct Image
+	{
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<uint8_t> Pixels;
+	};
+
+	struct Job
+	{
+		std::string Source;
+		std::string Output;
+		CompileResult Result;
+		BlockFormat Format;
+		bool NormalMap;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t MipCount;
+		uint64_t InputSize;
+		uint64_t OutputSize;
+		double TopPsnr;
+		double ChainPsnr;
+		double Milliseconds;
+		std::string Error;
+	};
+
+	//The squared error of decoded blocks against the pixels they were encoded from
+	struct ErrorSum
+	{
+		double Squared;
+		uint64_t Samples;
+	};
+
+	const char* FormatNames[] = { "BC1", "BC3", "BC5", "BC7" };
+
+	DXGI_FORMAT ToDXGIFormat(BlockFormat format, bool srgb)
+	{
+		DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM };
+
+		//BC5 has no _SRGB variant, and MakeSRGB leaves it as it is
+		return srgb ? DDSFormat::MakeSRGB(formats[format]) : formats[format];
+	}
+
+	float ToLinear(uint8_t value)
+	{
+		float c = value / 255.0f;
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	uint8_t FromLinear(float value)
+	{
+		float c = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+		return (uint8_t)std::min(std::max(c * 255.0f + 0.5f, 0.0f), 255.0f);
+	}
+
+	//Half the size, each pixel the average of the 2x2 above it. An odd last row or column is averaged with itself
+	Image Downsample(const Image& source, bool normalMap, bool srgb)
+	{
+		Image mip;
+		mip.Width = std::max(source.Width / 2, 1u);
+		mip.Height = std::max(source.Height / 2, 1u);
+		mip.Pixels.resize((size_t)mip.Width * mip.Height * 4);
+
+		for (uint32_t y = 0; y < mip.Height; ++y)
+		{
+			for (uint32_t x = 0; x < mip.Width; ++x)
+			{
+				uint32_t xs[2] = { std::min(x * 2, source.Width - 1), std::min(x * 2 + 1, source.Width - 1) };
+				uint32_t ys[2] = { std::min(y * 2, source.Height - 1), std::min(y * 2 + 1, source.Height - 1) };
+				float sum[4] = {};
+
+				for (uint32_t sy : ys)
+				{
+					for (uint32_t sx : xs)
+					{
+						const uint8_t* pixel = &source.Pixels[((size_t)sy * source.Width + sx) * 4];
+
+						for (int c = 0; c < 4; ++c)
+						{
+							if (normalMap && c < 3)
+							{
+								sum[c] += pixel[c] / 127.5f - 1.0f;
+							}
+							else
+							{
+								sum[c] += srgb && c < 3 ? ToLinear(pixel[c]) : pixel[c] / 255.0f;
+							}
+						}
+					}
+				}
+
+				uint8_t* out = &mip.Pixels[((size_t)y * mip.Width + x) * 4];
+
+				if (normalMap)
+				{
+					float length = sqrtf(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+
+					//Normals that cancel out point straight up
+					if (length < 1e-6f)
+					{
+						sum[0] = sum[1] = 0.0f;
+						sum[2] = length = 1.0f;
+					}
+
+					for (int c = 0; c < 3; ++c)
+					{
+						out[c] = (uint8_t)std::min(std::max((sum[c] / length + 1.0f) * 127.5f + 0.5f, 0.0f), 255.0f);
+					}
+				}
+				else
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						out[c] = srgb ? FromLinear(sum[c] / 4.0f) : (uint8_t)(sum[c] / 4.0f * 255.0f + 0.5f);
+					}
+				}
+
+				out[3] = (uint8_t)(sum[3] / 4.0f * 255.0f + 0.5f);
+			}
+		}
+
+		return mip;
+	}
+
+	//Encodes a level into blocks, then decodes them again and adds up the error over the channels the format keeps
+	void Encode(const Image& image, BlockFormat format, ThreadPool& pool, std::vector<uint8_t>& outBlocks, ErrorSum& error)
+	{
+		size_t blockSize = BlockCompression::BlockSize(format);
+		uint32_t blocksWide = (image.Width + 3) / 4, blocksHigh = (image.Height + 3) / 4;
+		int channels = format == BlockBC1 ? 3 : format == BlockBC5 ? 2 : 4;
+		size_t offset = outBlocks.size();
+		std::vector<double> rowErrors(blocksHigh, 0.0);
+
+		outBlocks.resize(offset + blockSize * blocksWide * blocksHigh);
+
+		pool.ParallelFor(blocksHigh, [&](size_t by)
+		{
+			uint8_t pixels[64], decoded[64];
+
+			for (uint32_t bx = 0; bx < blocksWide; ++bx)
+			{
+				//Levels smaller than a block repeat their edge pixels to fill it
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					uint32_t x = std::min(bx * 4 + i % 4, image.Width - 1), y = std::min((uint32_t)by * 4 + i / 4, image.Height - 1);
+					memcpy(&pixels[i * 4], &image.Pixels[((size_t)y * image.Width + x) * 4], 4);
+				}
+
+				uint8_t* block = &outBlocks[offset + (by * blocksWide + bx) * blockSize];
+				BlockCompression::Encode(format, pixels, block);
+				BlockCompression::Decode(format, block, decoded);
+
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					if (bx * 4 + i % 4 < image.Width && by * 4 + i / 4 < image.Height)
+					{
+						for (int c = 0; c < channels; ++c)
+						{
+							double d = (double)pixels[i * 4 + c] - decoded[i * 4 + c];
+							rowErrors[by] += d * d;
+						}
+					}
+				}
+			}
+		});
+
+		for (double rowError : rowErrors)
+		{
+			error.Squared += rowError;
+		}
+
+		error.Samples += (uint64_t)image.Width * image.Height * channels;
+	}
+
+	double Psnr(const ErrorSum& error)
+	{
+		if (error.Squared == 0.0)
+		{
+			return INFINITY;
+		}
+
+		return 10.0 * log10(255.0 * 255.0 / (error.Squared / error.Samples));
+	}
+
+	//Reads the top level of an 8 bit RGBA or BGRA texture. Returns CompileSkipped for block compressed inputs
+	CompileResult Load(Job& job, Image& image, bool& srgb)
+	{
+		MappedFile file;
+		const DDS_HEADER* header;
+		const uint8_t* bitData;
+		size_t bitSize;
+
+		if (!file.Open(job.Source.c_str()) || !DDSFormat::ParseHeader((const uint8_t*)file.Data(), file.Size(), &header, &bitData, &bitSize))
+		{
+			job.Error = "not a DDS file";
+			return CompileFailed;
+		}
+
+		job.InputSize = file.Size();
+		const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+		DXGI_FORMAT format = dxt10 ? dxt10->dxgiFormat : DDSFormat::GetDXGIFormat(header->ddspf);
+		bool bgra = format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8X8_UNORM ||
+			format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+		bool opaque = format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+		srgb = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+
+		if ((format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) || (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB))
+		{
+			job.Error = "already block compressed";
+			return CompileSkipped;
+		}
+
+		if (!bgra && format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+		{
+			job.Error = "not an 8 bit RGBA or BGRA texture";
+			return CompileFailed;
+		}
+
+		if ((header->flags & DDS_HEADER_FLAGS_VOLUME) || (header->caps2 & DDS_CUBEMAP) || (dxt10 && dxt10->arraySize > 1))
+		{
+			job.Error = "not a single 2D texture";
+			return CompileFailed;
+		}
+
+		//D3D only creates block compressed textures whose top level is made of whole blocks
+		if (header->width % 4 != 0 || header->height % 4 != 0)
+		{
+			job.Error = "not a multiple of 4 in size";
+			return CompileFailed;
+		}
+
+		size_t mipCount = std::max<uint32_t>(header->mipMapCount, 1);
+		std::vector<DDSSubresource> subresources(mipCount);
+		size_t width, height, depth, skipMip;
+
+		if (DDSFormat::FillInitData(header->width, header->height, 1, mipCount, 1, format, 0, bitSize, bitData, width, height, depth, skipMip,
+			subresources.data()) != DDS_LAYOUT_OK)
+		{
+			job.Error = "truncated";
+			return CompileFailed;
+		}
+
+		image.Width = header->width;
+		image.Height = header->height;
+		image.Pixels.resize((size_t)image.Width * image.Height * 4);
+
+		for (uint32_t y = 0; y < image.Height; ++y)
+		{
+			const uint8_t* row = subresources[0].data + y * subresources[0].rowPitch;
+			uint8_t* out = &image.Pixels[(size_t)y * image.Width * 4];
+
+			for (uint32_t x = 0; x < image.Width; ++x, row += 4, out += 4)
+			{
+				out[0] = bgra ? row[2] : row[0];
+				out[1] = row[1];
+				out[2] = bgra ? row[0] : row[2];
+				out[3] = opaque ? 255 : row[3];
+			}
+		}
+
+		return CompileBuilt;
+	}
+
+	bool Write(const std::string& filename, const Image& top, uint32_t mipCount, DXGI_FORMAT format, const std::vector<uint8_t>& blocks)
+	{
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = HeaderFlags;
+		header.height = top.Height;
+		header.width = top.Width;
+		header.mipMapCount = mipCount;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		header.caps = HeaderCaps;
+
+		size_t topBytes;
+		DDSFormat::GetSurfaceInfo(top.Width, top.Height, format, &topBytes, nullptr, nullptr);
+		header.pitchOrLinearSize = (uint32_t)topBytes;
+
+		DDS_HEADER_DXT10 dxt10 = {};
+		dxt10.dxgiFormat = format;
+		dxt10.resourceDimension = ResourceDimensionTexture2D;
+		dxt10.arraySize = 1;
+
+		//Written to a temporary file first so a running game that reloads it never reads half a texture
+		std::string temporaryFilename = filename + ".tmp";
+		std::ofstream out(temporaryFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write((const char*)&DDS_MAGIC, sizeof(DDS_MAGIC));
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)&dxt10, sizeof(dxt10));
+		out.write((const char*)blocks.data(), (std::streamsize)blocks.size());
+		out.close();
+
+		if (!out.good())
+		{
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryFilename, filename, error);
+
+		return !error;
+	}
+
+	//Reads the written texture back the way the game will and checks every level is where it should be
+	bool Verify(const Job& job, DXGI_FORMAT format)
+	{
+		MappedFile file;
+		const DDS_HEADER* header;
+		const uint8_t* bitData;
+		size_t bitSize;
+
+		if (!file.Open(job.Output.c_str()) || !DDSFormat::ParseHeader((const uint8_t*)file.Data(), file.Size(), &header, &bitData, &bitSize))
+		{
+			return false;
+		}
+
+		const DDS_HEADER_DXT10* dxt10 = DDSFormat::GetDXT10Header(header);
+		std::vector<DDSSubresource> subresources(job.MipCount);
+		size_t width, height, depth, skipMip;
+
+		if (!dxt10 || dxt10->dxgiFormat != format || header->mipMapCount != job.MipCount || DDSFormat::FillInitData(header->width, header->height, 1,
+			job.MipCount, 1, format, 0, bitSize, bitData, width, height, depth, skipMip, subresources.data()) != DDS_LAYOUT_OK)
+		{
+			return false;
+		}
+
+		const DDSSubresource& last = subresources.back();
+		return last.data + last.slicePitch == bitData + bitSize;
+	}
+
+	void Compile(Job& job, bool forceFormat, BlockFormat forcedFormat, bool forceNormal, ThreadPool& pool)
+	{
+		Clock::time_point start = Clock::now();
+		Image image;
+		bool srgb = false;
+
+		job.Result = Load(job, image, srgb);
+
+		if (job.Result == CompileBuilt)
+		{
+			std::string name = std::filesystem::path(job.Source).filename().string();
+			std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)toupper((unsigned char)c); });
+			job.NormalMap = forceNormal || name.find("NRM") != std::string::npos || name.find("NORMAL") != std::string::npos;
+
+			bool translucent = false;
+
+			for (size_t i = 3; i < image.Pixels.size() && !translucent; i += 4)
+			{
+				translucent = image.Pixels[i] < 255;
+			}
+
+			job.Format = forceFormat ? forcedFormat : job.NormalMap ? BlockBC5 : translucent ? BlockBC3 : BlockBC1;
+			job.Width = image.Width;
+			job.Height = image.Height;
+			job.MipCount = 1;
+
+			//Next to the input the format goes in the name, so the uncompressed original isn't overwritten
+			if (job.Output.empty())
+			{
+				std::filesystem::path source(job.Source);
+				job.Output = (source.parent_path() / (source.stem().string() + "_" + FormatNames[job.Format] + source.extension().string())).string();
+			}
+
+			DXGI_FORMAT format = ToDXGIFormat(job.Format, srgb);
+			std::vector<uint8_t> blocks;
+			ErrorSum top = {}, chain = {};
+
+			Encode(image, job.Format, pool, blocks, top);
+			chain = top;
+
+			for (Image mip = image; mip.Width > 1 || mip.Height > 1; ++job.MipCount)
+			{
+				mip = Downsample(mip, job.NormalMap, srgb);
+				Encode(mip, job.Format, pool, blocks, chain);
+			}
+
+			job.TopPsnr = Psnr(top);
+			job.ChainPsnr = Psnr(chain);
+
+			if (!Write(job.Output, image, job.MipCount, format, blocks) || !Verify(job, format))
+			{
+				job.Error = "couldn't be written";
+				job.Result = CompileFailed;
+			}
+
+			std::error_code error;
+			job.OutputSize = std::filesystem::file_size(job.Output, error);
+
+			if (error)
+			{
+				job.OutputSize = 0;
+			}
+		}
+
+		job.Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void AddJob(const std::filesystem::path& source, const std::string& outputDirectory, std::vector<std::unique_ptr<Job>>& jobs)
+	{
+		std::unique_ptr<Job> job(new Job());
+		job->Source = source.string();
+
+		//Without an output directory Compile names it once the format is chosen
+		job->Output = outputDirectory.empty() ? std::string() : (std::filesystem::path(outputDirectory) / source.filename()).string();
+
+		job->Result = CompileFailed;
+		job->Format = BlockBC1;
+		job->NormalMap = false;
+		job->Width = 0;
+		job->Height = 0;
+		job->MipCount = 0;
+		job->InputSize = 0;
+		job->OutputSize = 0;
+		job->TopPsnr = 0.0;
+		job->ChainPsnr = 0.0;
+		job->Milliseconds = 0.0;
+		jobs.push_back(std::move(job));
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: texture_compiler [-o directory] [-j threads] [--format bc1|bc3|bc5|bc7] [--normal] <file.dds | directory> ...\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool forceFormat = false;
+	bool forceNormal = false;
+	BlockFormat forcedFormat = BlockBC1;
+	unsigned int threads = 0;
+	std::string outputDirectory;
+	std::vector<std::unique_ptr<Job>> jobs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-o" && i + 1 < argc) outputDirectory = argv[++i];
+		else if (argument == "-j" && i + 1 < argc) threads = (unsigned int)atoi(argv[++i]);
+		else if (argument == "--normal") forceNormal = true;
+		else if (argument == "--format" && i + 1 < argc)
+		{
+			std::string name = argv[++i];
+			std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)toupper((unsigned char)c); });
+			const char** found = std::find_if(std::begin(FormatNames), std::end(FormatNames), [&](const char* format) { return name == format; });
+
+			if (found == std::end(FormatNames))
+			{
+				PrintUsage();
+				return 1;
+			}
+
+			forceFormat = true;
+			forcedFormat = (BlockFormat)(found - std::begin(FormatNames));
+		}
+		else if (!argument.empty() && argument[0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if (std::filesystem::is_directory(argument))
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(argument))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".dds")
+				{
+					AddJob(entry.path(), outputDirectory, jobs);
+				}
+			}
+		}
+		else
+		{
+			AddJob(argument, outputDirectory, jobs);
+		}
+	}
+
+	if (jobs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (!outputDirectory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(outputDirectory, error);
+	}
+
+	ThreadPool pool(threads);
+	Clock::time_point start = Clock::now();
+
+	//One texture at a time, each spreading its blocks over every thread, so the report comes out in order
+	for (std::unique_ptr<Job>& job : jobs)
+	{
+		Compile(*job, forceFormat, forcedFormat, forceNormal, pool);
+	}
+
+	double totalMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	unsigned int built = 0, skipped = 0, failed = 0;
+	const char* resultNames[] = { "built", "skipped", "FAILED" };
+
+	for (const std::unique_ptr<Job>& job : jobs)
+	{
+		if (job->Result == CompileBuilt)
+		{
+			printf("%-10s %s -> %s, %ux%u %s%s, %u mips, %llu -> %llu bytes (%.1f:1), PSNR %.2f dB top, %.2f dB all mips, %.1f ms\n",
+				resultNames[job->Result], job->Source.c_str(), job->Output.c_str(), job->Width, job->Height, FormatNames[job->Format],
+				job->NormalMap ? " normal map" : "", job->MipCount, (unsigned long long)job->InputSize, (unsigned long long)job->OutputSize,
+				job->OutputSize > 0 ? (double)job->InputSize / job->OutputSize : 0.0, job->TopPsnr, job->ChainPsnr, job->Milliseconds);
+		}
+		else
+		{
+			printf("%-10s %s, %s\n", resultNames[job->Result], job->Source.c_str(), job->Error.c_str());
+		}
+
+		built += job->Result == CompileBuilt;
+		skipped += job->Result == CompileSkipped;
+		failed += job->Result == CompileFailed;
+	}
+
+	printf("%u built, %u skipped, %u failed in %.1f ms on %u threads\n", built, skipped, failed, totalMilliseconds, pool.ThreadCount());
+
+	return failed > 0 ? 1 : 0;
+}
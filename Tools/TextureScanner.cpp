@@ -0,0 +1,192 @@
+//Lists what DDS textures a directory holds and what they'd take on the GPU, reading only each file's headers, so it gets
+//through thousands of textures in milliseconds. Useful for checking an asset drop against a memory budget before it's
+//loaded. It doesn't need D3D, e.g. on Linux:
+//	g++ -O2 -std=c++17 -I.. TextureScanner.cpp ../TextureInventory.cpp ../DDSFormat.cpp ../ThreadPool.cpp -pthread -o texture_scanner
+//
+//Usage: texture_scanner [options] <file.dds | directory> ...
+//	-j <threads>		Worker threads reading headers, defaults to one per hardware thread
+//	-q					Only print the totals and the files that aren't ok
+//Directories are searched recursively for .dds files. Each texture's line has its dimensions, format, mip count, array
+//size (or cube count), the bytes its pixels take with every level and slice, and its file size. Then the totals by format.
+//GPU sizes are the data as laid out in the file, which is what DDSTextureLoader uploads, not counting driver padding.
+//Exits with 1 if a path doesn't exist or any file is truncated or not a texture DDSTextureLoader would load.
+
+#include "DDSFormat.h"
+#include "TextureInventory.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct FormatName
+	{
+		DXGI_FORMAT Format;
+		const char* Name;
+	};
+
+	//The formats textures are usually shipped in, others are printed by number
+	const FormatName FormatNames[] =
+	{
+		{ DXGI_FORMAT_R8G8B8A8_UNORM, "RGBA8" },
+		{ DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, "RGBA8_SRGB" },
+		{ DXGI_FORMAT_B8G8R8A8_UNORM, "BGRA8" },
+		{ DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, "BGRA8_SRGB" },
+		{ DXGI_FORMAT_B8G8R8X8_UNORM, "BGRX8" },
+		{ DXGI_FORMAT_R8_UNORM, "R8" },
+		{ DXGI_FORMAT_R8G8_UNORM, "RG8" },
+		{ DXGI_FORMAT_R16G16B16A16_FLOAT, "RGBA16F" },
+		{ DXGI_FORMAT_R32G32B32A32_FLOAT, "RGBA32F" },
+		{ DXGI_FORMAT_BC1_UNORM, "BC1" },
+		{ DXGI_FORMAT_BC1_UNORM_SRGB, "BC1_SRGB" },
+		{ DXGI_FORMAT_BC2_UNORM, "BC2" },
+		{ DXGI_FORMAT_BC3_UNORM, "BC3" },
+		{ DXGI_FORMAT_BC3_UNORM_SRGB, "BC3_SRGB" },
+		{ DXGI_FORMAT_BC4_UNORM, "BC4" },
+		{ DXGI_FORMAT_BC5_UNORM, "BC5" },
+		{ DXGI_FORMAT_BC5_SNORM, "BC5_SNORM" },
+		{ DXGI_FORMAT_BC6H_UF16, "BC6H" },
+		{ DXGI_FORMAT_BC7_UNORM, "BC7" },
+		{ DXGI_FORMAT_BC7_UNORM_SRGB, "BC7_SRGB" },
+	};
+
+	std::string Name(DXGI_FORMAT format)
+	{
+		for (const FormatName& name : FormatNames)
+		{
+			if (name.Format == format)
+			{
+				return name.Name;
+			}
+		}
+
+		return "format " + std::to_string((unsigned int)format);
+	}
+
+	std::string Shape(const DDSMetadata& metadata)
+	{
+		char text[64];
+
+		if (metadata.dimension == DDS_DIMENSION_TEXTURE3D)
+		{
+			snprintf(text, sizeof(text), "%zux%zux%zu", metadata.width, metadata.height, metadata.depth);
+		}
+		else if (metadata.isCubeMap)
+		{
+			snprintf(text, sizeof(text), "%zux%zu cube x%zu", metadata.width, metadata.height, metadata.arraySize / 6);
+		}
+		else if (metadata.arraySize > 1)
+		{
+			snprintf(text, sizeof(text), "%zux%zu [%zu]", metadata.width, metadata.height, metadata.arraySize);
+		}
+		else
+		{
+			snprintf(text, sizeof(text), "%zux%zu", metadata.width, metadata.height);
+		}
+
+		return text;
+	}
+
+	struct Totals
+	{
+		size_t Count;
+		uint64_t GpuBytes;
+		uint64_t FileBytes;
+	};
+
+	void PrintUsage()
+	{
+		printf("Usage: texture_scanner [-j threads] [-q] <file.dds | directory> ...\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int threads = 0;
+	bool quiet = false;
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "-j" && i + 1 < argc) threads = (unsigned int)atoi(argv[++i]);
+		else if (argument == "-q") quiet = true;
+		else if (!argument.empty() && argument[0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else paths.push_back(argument);
+	}
+
+	if (paths.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	ThreadPool pool(threads);
+	std::vector<TextureInventoryEntry> entries;
+	Clock::time_point start = Clock::now();
+	bool found = TextureInventory::Scan(paths, pool, entries);
+	double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	const char* statusNames[] = { "ok", "TRUNCATED", "UNSUPPORTED", "UNREADABLE" };
+	std::map<std::string, Totals> byFormat;
+	Totals total = {};
+	size_t failed = 0;
+
+	for (const TextureInventoryEntry& entry : entries)
+	{
+		if (entry.Status != TextureInventoryOk)
+		{
+			++failed;
+		}
+
+		if (entry.Status == TextureInventoryOk || entry.Status == TextureInventoryTruncated)
+		{
+			const DDSMetadata& metadata = entry.Metadata;
+			Totals& totals = byFormat[Name(metadata.format)];
+			++totals.Count;
+			totals.GpuBytes += metadata.totalBytes;
+			totals.FileBytes += entry.FileSize;
+
+			if (!quiet || entry.Status != TextureInventoryOk)
+			{
+				printf("%-11s %-22s %-12s %2zu mips %12llu bytes, file %12llu  %s\n", statusNames[entry.Status], Shape(metadata).c_str(),
+					Name(metadata.format).c_str(), metadata.mipLevels, (unsigned long long)metadata.totalBytes, (unsigned long long)entry.FileSize,
+					entry.Path.c_str());
+			}
+		}
+		else
+		{
+			printf("%-11s %s\n", statusNames[entry.Status], entry.Path.c_str());
+		}
+	}
+
+	for (const std::pair<const std::string, Totals>& format : byFormat)
+	{
+		printf("%-12s %6zu textures %14llu bytes on the GPU, %14llu in files\n", format.first.c_str(), format.second.Count,
+			(unsigned long long)format.second.GpuBytes, (unsigned long long)format.second.FileBytes);
+		total.Count += format.second.Count;
+		total.GpuBytes += format.second.GpuBytes;
+		total.FileBytes += format.second.FileBytes;
+	}
+
+	printf("%zu textures, %.1f MB on the GPU, %.1f MB in files, %zu not ok, %.1f ms on %u thread%s\n", total.Count, total.GpuBytes / (1024.0 * 1024.0),
+		total.FileBytes / (1024.0 * 1024.0), failed, milliseconds, pool.ThreadCount(), pool.ThreadCount() == 1 ? "" : "s");
+
+	if (!found)
+	{
+		printf("FAILED    a path doesn't exist or couldn't be searched\n");
+	}
+
+	return found && failed == 0 ? 0 : 1;
+}
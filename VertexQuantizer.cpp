@@ -0,0 +1,191 @@
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float UnormMax = 65535.0f;
+	const float SnormMax = 32767.0f;
+
+	inline uint16_t QuantizeUnorm(float value, float offset, float scale)
+	{
+		if (scale <= 0.0f)
+		{
+			return 0;
+		}
+
+		float unorm = (value - offset) / scale;
+		return (uint16_t)std::min(std::max(unorm + 0.5f, 0.0f), UnormMax);
+	}
+
+	//D3D maps both -32768 and -32767 to -1
+	inline float DecodeSnorm(int16_t value)
+	{
+		return std::max(value / SnormMax, -1.0f);
+	}
+
+	inline MeshFloat3 Normalize(const MeshFloat3& n)
+	{
+		float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+		return length > 0.0f ? MeshFloat3{ n.x / length, n.y / length, n.z / length } : MeshFloat3{ 0.0f, 0.0f, 0.0f };
+	}
+
+	//In radians. atan2 of the cross and dot products stays accurate for tiny angles where acos of a float dot product
+	//can't resolve anything under about 0.02 degrees
+	inline double AngleBetween(const MeshFloat3& a, const MeshFloat3& b)
+	{
+		double cx = (double)a.y * b.z - (double)a.z * b.y;
+		double cy = (double)a.z * b.x - (double)a.x * b.z;
+		double cz = (double)a.x * b.y - (double)a.y * b.x;
+		double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+		return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot);
+	}
+
+	//The octahedron is unfolded onto a square, the bottom half folded out over the corners. Same as DecodeOctahedral in the .fx file
+	MeshFloat3 DecodeOctahedral(float x, float y)
+	{
+		MeshFloat3 n = { x, y, 1.0f - std::fabs(x) - std::fabs(y) };
+		float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return Normalize(n);
+	}
+
+	void EncodeOctahedral(const MeshFloat3& normal, int16_t out[2])
+	{
+		float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+
+		if (sum == 0.0f)
+		{
+			out[0] = out[1] = 0;
+			return;
+		}
+
+		float x = normal.x / sum;
+		float y = normal.y / sum;
+
+		if (normal.z < 0.0f)
+		{
+			float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		//Rounding each component separately isn't always the closest direction, so try all 4 neighbouring grid points
+		float baseX = std::floor(x * SnormMax);
+		float baseY = std::floor(y * SnormMax);
+		double bestAngle = 4.0;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			float candidateX = std::min(std::max(baseX + (i & 1), -SnormMax), SnormMax);
+			float candidateY = std::min(std::max(baseY + (i >> 1), -SnormMax), SnormMax);
+			MeshFloat3 decoded = DecodeOctahedral(candidateX / SnormMax, candidateY / SnormMax);
+			double angle = AngleBetween(decoded, normal);
+
+			if (angle < bestAngle)
+			{
+				bestAngle = angle;
+				out[0] = (int16_t)candidateX;
+				out[1] = (int16_t)candidateY;
+			}
+		}
+	}
+}
+
+VertexQuantization VertexQuantizer::ComputeQuantization(const std::vector<MeshVertex>& vertices)
+{
+	VertexQuantization quantization = {};
+
+	if (vertices.empty())
+	{
+		return quantization;
+	}
+
+	MeshFloat3 minimum = vertices[0].Pos;
+	MeshFloat3 maximum = vertices[0].Pos;
+	MeshFloat2 texMinimum = vertices[0].TexC;
+	MeshFloat2 texMaximum = vertices[0].TexC;
+
+	for (const MeshVertex& vertex : vertices)
+	{
+		minimum = { std::min(minimum.x, vertex.Pos.x), std::min(minimum.y, vertex.Pos.y), std::min(minimum.z, vertex.Pos.z) };
+		maximum = { std::max(maximum.x, vertex.Pos.x), std::max(maximum.y, vertex.Pos.y), std::max(maximum.z, vertex.Pos.z) };
+		texMinimum = { std::min(texMinimum.x, vertex.TexC.x), std::min(texMinimum.y, vertex.TexC.y) };
+		texMaximum = { std::max(texMaximum.x, vertex.TexC.x), std::max(texMaximum.y, vertex.TexC.y) };
+	}
+
+	//Each axis gets its own scale so flat or thin meshes don't waste precision on an axis they barely use
+	quantization.PositionOffset = minimum;
+	quantization.PositionScale = { (maximum.x - minimum.x) / UnormMax, (maximum.y - minimum.y) / UnormMax, (maximum.z - minimum.z) / UnormMax };
+	quantization.TexCoordOffset = texMinimum;
+	quantization.TexCoordScale = { (texMaximum.x - texMinimum.x) / UnormMax, (texMaximum.y - texMinimum.y) / UnormMax };
+
+	return quantization;
+}
+
+void VertexQuantizer::Quantize(const std::vector<MeshVertex>& vertices, const VertexQuantization& quantization, std::vector<QuantizedVertex>& outVertices)
+{
+	const VertexQuantization& q = quantization;
+	outVertices.resize(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const MeshVertex& vertex = vertices[i];
+		QuantizedVertex& out = outVertices[i];
+
+		out.Pos[0] = QuantizeUnorm(vertex.Pos.x, q.PositionOffset.x, q.PositionScale.x);
+		out.Pos[1] = QuantizeUnorm(vertex.Pos.y, q.PositionOffset.y, q.PositionScale.y);
+		out.Pos[2] = QuantizeUnorm(vertex.Pos.z, q.PositionOffset.z, q.PositionScale.z);
+		out.Pos[3] = 0;
+		EncodeOctahedral(vertex.Normal, out.Normal);
+		out.TexC[0] = QuantizeUnorm(vertex.TexC.x, q.TexCoordOffset.x, q.TexCoordScale.x);
+		out.TexC[1] = QuantizeUnorm(vertex.TexC.y, q.TexCoordOffset.y, q.TexCoordScale.y);
+	}
+}
+
+MeshVertex VertexQuantizer::Dequantize(const QuantizedVertex& vertex, const VertexQuantization& quantization)
+{
+	const VertexQuantization& q = quantization;
+	MeshVertex out;
+
+	out.Pos = { q.PositionOffset.x + vertex.Pos[0] * q.PositionScale.x, q.PositionOffset.y + vertex.Pos[1] * q.PositionScale.y, q.PositionOffset.z + vertex.Pos[2] * q.PositionScale.z };
+	out.Normal = DecodeOctahedral(DecodeSnorm(vertex.Normal[0]), DecodeSnorm(vertex.Normal[1]));
+	out.TexC = { q.TexCoordOffset.x + vertex.TexC[0] * q.TexCoordScale.x, q.TexCoordOffset.y + vertex.TexC[1] * q.TexCoordScale.y };
+
+	return out;
+}
+
+QuantizationError VertexQuantizer::MeasureError(const std::vector<MeshVertex>& vertices, const std::vector<QuantizedVertex>& quantized, const VertexQuantization& quantization)
+{
+	QuantizationError error = { 0.0f, 0.0f, 0.0f, 0.0f };
+	double maxAngle = 0.0;
+
+	for (size_t i = 0; i < vertices.size() && i < quantized.size(); ++i)
+	{
+		const MeshVertex& original = vertices[i];
+		MeshVertex decoded = Dequantize(quantized[i], quantization);
+
+		float dx = decoded.Pos.x - original.Pos.x;
+		float dy = decoded.Pos.y - original.Pos.y;
+		float dz = decoded.Pos.z - original.Pos.z;
+		error.MaxPosition = std::max(error.MaxPosition, std::sqrt(dx * dx + dy * dy + dz * dz));
+
+		//Missing normals were zero to begin with and have no direction to keep
+		if (original.Normal.x != 0.0f || original.Normal.y != 0.0f || original.Normal.z != 0.0f)
+		{
+			maxAngle = std::max(maxAngle, AngleBetween(original.Normal, decoded.Normal));
+		}
+
+		error.MaxTexCoord = std::max(error.MaxTexCoord, std::max(std::fabs(decoded.TexC.x - original.TexC.x), std::fabs(decoded.TexC.y - original.TexC.y)));
+	}
+
+	const VertexQuantization& q = quantization;
+	float diagonal = UnormMax * std::sqrt(q.PositionScale.x * q.PositionScale.x + q.PositionScale.y * q.PositionScale.y + q.PositionScale.z * q.PositionScale.z);
+
+	error.MaxPositionRelative = diagonal > 0.0f ? error.MaxPosition / diagonal : 0.0f;
+	error.MaxNormalDegrees = (float)(maxAngle * 57.29577951308232);
+
+	return error;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MeshTypes.h"
+
+//A MeshVertex packed into 16 bytes instead of 32. Matches the quantized input layout in Application.cpp:
+//	POSITION	R16G16B16A16_UNORM	position inside the mesh bounds, w is unused padding
+//	NORMAL		R16G16_SNORM		octahedral encoded unit normal
+//	TEXCOORD	R16G16_UNORM		texture coordinate inside the mesh's UV bounds
+struct QuantizedVertex
+{
+	uint16_t Pos[4];
+	int16_t Normal[2];
+	uint16_t TexC[2];
+};
+
+static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must match the quantized input layout");
+
+//How to turn a mesh's QuantizedVertex values back into real ones, value = offset + unorm * scale.
+//Stored next to the vertices in the mesh cache and handed to the vertex shader in a constant buffer
+struct VertexQuantization
+{
+	MeshFloat3 PositionOffset;
+	MeshFloat3 PositionScale;
+	MeshFloat2 TexCoordOffset;
+	MeshFloat2 TexCoordScale;
+};
+
+static_assert(sizeof(VertexQuantization) == 40, "VertexQuantization is part of the mesh cache format");
+
+//The largest difference between a mesh and its quantized version
+struct QuantizationError
+{
+	float MaxPosition;			//Distance in model units
+	float MaxPositionRelative;	//MaxPosition as a fraction of the bounding box diagonal
+	float MaxNormalDegrees;		//Angle between the original and decoded normal
+	float MaxTexCoord;			//Per component
+};
+
+namespace VertexQuantizer
+{
+	//Fits the quantization grid to the bounds of the mesh's positions and texture coordinates
+	VertexQuantization ComputeQuantization(const std::vector<MeshVertex>& vertices);
+
+	void Quantize(const std::vector<MeshVertex>& vertices, const VertexQuantization& quantization, std::vector<QuantizedVertex>& outVertices);
+
+	//Decodes a vertex exactly like the quantized vertex shader does
+	MeshVertex Dequantize(const QuantizedVertex& vertex, const VertexQuantization& quantization);
+
+	QuantizationError MeasureError(const std::vector<MeshVertex>& vertices, const std::vector<QuantizedVertex>& quantized, const VertexQuantization& quantization);
+};